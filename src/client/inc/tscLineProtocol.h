@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSCLINEPROTOCOL_H
+#define TDENGINE_TSCLINEPROTOCOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+#include "taos.h"
+
+#define TSDB_LINE_MIN_BINARY_LEN  64    // the minimum width of the binary columns and tags created for the points
+#define TSDB_LINE_BATCH_SIZE      8192  // maximum number of points sent in one round of submit
+
+/*
+ * the key and the binary value point to the buffer the point is parsed from, they are not null-terminated
+ */
+typedef struct SLineKv {
+  char   *key;
+  int16_t keyLen;
+  int8_t  type;    // TSDB_DATA_TYPE_BIGINT, TSDB_DATA_TYPE_DOUBLE, TSDB_DATA_TYPE_BOOL or TSDB_DATA_TYPE_BINARY
+  int16_t len;     // length of the binary value
+  union {
+    int64_t i;
+    double  d;
+    char   *s;
+  };
+} SLineKv;
+
+typedef struct SLinePoint {
+  char    *stable;
+  int16_t  stableLen;
+  int16_t  numOfTags;
+  int16_t  numOfFields;
+  int16_t  numOfAlloc;
+  int64_t  ts;   // in nanoseconds, 0 for the current time
+  SLineKv *kvs;  // the tags in the order of their keys, followed by the fields
+} SLinePoint;
+
+/**
+ * parse one line of the influxdb line protocol, the names are unescaped and converted to lower case in place.
+ *
+ * @param line    the line without the line break
+ * @param len
+ * @param tsUnit  nanoseconds per unit of the timestamp in the line
+ * @param pPoint  destroyed by tscDestroyLinePoint even if the parse fails
+ * @return        TSDB_CODE_TSC_LINE_SYNTAX_ERROR if the line is malformed
+ */
+int32_t tscParseLine(char *line, int32_t len, int64_t tsUnit, SLinePoint *pPoint);
+
+void tscDestroyLinePoint(SLinePoint *pPoint);
+
+/**
+ * append a tag or field, the tags must all be added before the fields
+ */
+SLineKv *tscAddLineKv(SLinePoint *pPoint, bool isTag);
+
+/**
+ * sort the tags by their keys and check for the duplicated ones
+ */
+int32_t tscSortLineTags(SLinePoint *pPoint);
+
+/**
+ * write the points into the database without building any sql string. The rows are packed into the submit blocks
+ * according to the cached table meta. The super tables are created, and the missing columns and tags are added on
+ * demand, and the child tables, named after the md5 of the measurement and tags, are created along with the meta
+ * retrieval.
+ *
+ * @param taos
+ * @param db            the database name
+ * @param pPoints
+ * @param numOfPoints
+ * @param affectedRows  the number of rows written
+ * @return
+ */
+int32_t tscInsertLinePoints(TAOS *taos, const char *db, SLinePoint *pPoints, int32_t numOfPoints, int32_t *affectedRows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSCLINEPROTOCOL_H
@@ -297,6 +297,7 @@ typedef struct {
   uint64_t              qhandle;
   int64_t               uid;
   int64_t               useconds;
+  int64_t               memUsage;  // bytes of memory taken by the query in vnode
   int64_t               offset;  // offset value from vnode during projection query of stable
   int32_t               row;
   int16_t               numOfCols;
@@ -18,6 +18,8 @@
 #include "qExtbuffer.h"
 #include "qFill.h"
 #include "qHistogram.h"
+#include "qHll.h"
+#include "qTDigest.h"
 #include "qPercentile.h"
 #include "qSyntaxtreefunction.h"
 #include "qTsbuf.h"
@@ -121,6 +123,9 @@ typedef struct SPercentileInfo {
   double      minval;
   double      maxval;
   int64_t     numOfElems;
+  char *      pSelectBuf;    // values of the first scan, the percentile is selected from them if they are all kept
+  int64_t     selectCap;     // capacity of pSelectBuf in number of values, -1 if the bucket is used
+  int64_t     numOfSelect;
 } SPercentileInfo;
 
 typedef struct STopBotInfo {
@@ -135,10 +140,16 @@ typedef struct SLeastsquareInfo {
   int64_t num;
 } SLeastsquareInfo;
 
+// only one of them is used, according to the algorithm of the query
 typedef struct SAPercentileInfo {
   SHistogramInfo *pHisto;
+  STDigest       *pTDigest;
 } SAPercentileInfo;
 
+#define APERCT_HISTO_BYTES (sizeof(SHistogramInfo) + sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1))
+#define APERCT_INTER_BYTES \
+  (sizeof(SAPercentileInfo) + ((APERCT_HISTO_BYTES > sizeof(STDigest)) ? APERCT_HISTO_BYTES : sizeof(STDigest)))
+
 typedef struct STSCompInfo {
   STSBuf *pTSBuf;
 } STSCompInfo;
@@ -238,7 +249,7 @@ int32_t getResultDataInfo(int32_t dataType, int32_t dataBytes, int32_t functionI
       return TSDB_CODE_SUCCESS;
     } else if (functionId == TSDB_FUNC_APERCT) {
       *type = TSDB_DATA_TYPE_BINARY;
-      *bytes = sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1) + sizeof(SHistogramInfo) + sizeof(SAPercentileInfo);
+      *bytes = APERCT_INTER_BYTES;
       *interBytes = *bytes;
       
       return TSDB_CODE_SUCCESS;
@@ -253,6 +264,11 @@ int32_t getResultDataInfo(int32_t dataType, int32_t dataBytes, int32_t functionI
       *bytes = sizeof(STwaInfo);
       *interBytes = *bytes;
       return TSDB_CODE_SUCCESS;
+    } else if (functionId == TSDB_FUNC_HLL) {
+      *type = TSDB_DATA_TYPE_BINARY;
+      *bytes = sizeof(SHllInfo);
+      *interBytes = *bytes;
+      return TSDB_CODE_SUCCESS;
     }
   }
   
@@ -269,14 +285,18 @@ int32_t getResultDataInfo(int32_t dataType, int32_t dataBytes, int32_t functionI
   } else if (functionId == TSDB_FUNC_APERCT) {
     *type = TSDB_DATA_TYPE_DOUBLE;
     *bytes = sizeof(double);
-    *interBytes =
-        sizeof(SAPercentileInfo) + sizeof(SHistogramInfo) + sizeof(SHistBin) * (MAX_HISTOGRAM_BIN + 1);
+    *interBytes = APERCT_INTER_BYTES;
     return TSDB_CODE_SUCCESS;
   } else if (functionId == TSDB_FUNC_TWA) {
     *type = TSDB_DATA_TYPE_DOUBLE;
     *bytes = sizeof(double);
     *interBytes = sizeof(STwaInfo);
     return TSDB_CODE_SUCCESS;
+  } else if (functionId == TSDB_FUNC_HLL) {
+    *type = TSDB_DATA_TYPE_BIGINT;
+    *bytes = sizeof(int64_t);
+    *interBytes = sizeof(SHllInfo);
+    return TSDB_CODE_SUCCESS;
   }
   
   if (functionId == TSDB_FUNC_AVG) {
@@ -2448,10 +2468,73 @@ static bool percentile_function_setup(SQLFunctionCtx *pCtx) {
   pInfo->minval = DBL_MAX;
   pInfo->maxval = -DBL_MAX;
   pInfo->numOfElems = 0;
+  pInfo->selectCap = (tsPercentileSelectBuffer > 0) ? 0 : -1;
 
   return true;
 }
 
+static void percentileFreeSelectBuf(SQLFunctionCtx *pCtx, SPercentileInfo *pInfo) {
+  if (pInfo->selectCap > 0) {
+    qReleaseMem(pCtx->pMemAcct, pInfo->selectCap * pCtx->inputBytes);
+  }
+
+  taosTFree(pInfo->pSelectBuf);
+  pInfo->selectCap = -1;
+  pInfo->numOfSelect = 0;
+}
+
+/*
+ * keep the values of the first scan in a buffer of the input type, so that the percentile is selected from them in
+ * the finalizer and the second scan into the buckets is saved. Once the buffer grows above the cap or the memory
+ * budget of the query, it is dropped and the buckets are used as usual.
+ */
+static void percentileCollect(SQLFunctionCtx *pCtx, SPercentileInfo *pInfo, int32_t start, int32_t num) {
+  int32_t bytes = pCtx->inputBytes;
+
+  if (pCtx->preAggVals.isSet && !pCtx->preAggVals.dataBlockLoaded) {
+    percentileFreeSelectBuf(pCtx, pInfo);
+    return;
+  }
+
+  if (pInfo->numOfSelect + num > pInfo->selectCap) {
+    int64_t maxCap = (int64_t)tsPercentileSelectBuffer * 1024 * 1024 / bytes;
+    int64_t cap = MAX(pInfo->selectCap * 2, pInfo->numOfSelect + num);
+    cap = MIN(MAX(cap, 4096), maxCap);
+
+    if (pInfo->numOfSelect + num > cap || qMemOverBudget(pCtx->pMemAcct, (cap - pInfo->selectCap) * bytes)) {
+      percentileFreeSelectBuf(pCtx, pInfo);
+      return;
+    }
+
+    char *p = realloc(pInfo->pSelectBuf, (size_t)(cap * bytes));
+    if (p == NULL) {
+      percentileFreeSelectBuf(pCtx, pInfo);
+      return;
+    }
+
+    qAcquireMem(pCtx->pMemAcct, (cap - pInfo->selectCap) * bytes);
+    pInfo->pSelectBuf = p;
+    pInfo->selectCap = cap;
+  }
+
+  char *data = GET_INPUT_CHAR_INDEX(pCtx, start);
+  char *dst = pInfo->pSelectBuf + pInfo->numOfSelect * bytes;
+
+  if (!pCtx->hasNull) {
+    memcpy(dst, data, (size_t)num * bytes);
+    pInfo->numOfSelect += num;
+    return;
+  }
+
+  for (int32_t i = 0; i < num; ++i, data += bytes) {
+    if (!isNull(data, pCtx->inputType)) {
+      memcpy(dst, data, bytes);
+      dst += bytes;
+      pInfo->numOfSelect += 1;
+    }
+  }
+}
+
 static void percentile_function(SQLFunctionCtx *pCtx) {
   int32_t notNullElems = 0;
   
@@ -2460,13 +2543,26 @@ static void percentile_function(SQLFunctionCtx *pCtx) {
 
   // the first stage, only acquire the min/max value
   if (pInfo->stage == 0) {
+    if (pInfo->selectCap >= 0) {
+      percentileCollect(pCtx, pInfo, 0, pCtx->size);
+    }
+
     if (pCtx->preAggVals.isSet) {
-      if (pInfo->minval > pCtx->preAggVals.statis.min) {
-        pInfo->minval = (double)pCtx->preAggVals.statis.min;
+      double tmin = 0.0, tmax = 0.0;
+      if (pCtx->inputType == TSDB_DATA_TYPE_DOUBLE || pCtx->inputType == TSDB_DATA_TYPE_FLOAT) {
+        tmin = GET_DOUBLE_VAL((const char *)&(pCtx->preAggVals.statis.min));
+        tmax = GET_DOUBLE_VAL((const char *)&(pCtx->preAggVals.statis.max));
+      } else {
+        tmin = (double)pCtx->preAggVals.statis.min;
+        tmax = (double)pCtx->preAggVals.statis.max;
       }
 
-      if (pInfo->maxval < pCtx->preAggVals.statis.max) {
-        pInfo->maxval = (double)pCtx->preAggVals.statis.max;
+      if (pInfo->minval > tmin) {
+        pInfo->minval = tmin;
+      }
+
+      if (pInfo->maxval < tmax) {
+        pInfo->maxval = tmax;
       }
 
       pInfo->numOfElems += (pCtx->size - pCtx->preAggVals.statis.numOfNull);
@@ -2541,6 +2637,10 @@ static void percentile_function_f(SQLFunctionCtx *pCtx, int32_t index) {
   SPercentileInfo *pInfo = (SPercentileInfo *)pResInfo->interResultBuf;
 
   if (pInfo->stage == 0) {
+    if (pInfo->selectCap >= 0) {
+      percentileCollect(pCtx, pInfo, index, 1);
+    }
+
     // TODO extract functions
     double v = 0;
     switch (pCtx->inputType) {
@@ -2585,10 +2685,20 @@ static void percentile_function_f(SQLFunctionCtx *pCtx, int32_t index) {
 static void percentile_finalizer(SQLFunctionCtx *pCtx) {
   double v = pCtx->param[0].nType == TSDB_DATA_TYPE_INT ? pCtx->param[0].i64Key : pCtx->param[0].dKey;
   
-  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
-  tMemBucket * pMemBucket = ((SPercentileInfo *)pResInfo->interResultBuf)->pMemBucket;
+  SResultInfo *    pResInfo = GET_RES_INFO(pCtx);
+  SPercentileInfo *pInfo = pResInfo->interResultBuf;
+
+  if (pInfo->pSelectBuf != NULL) {
+    *(double *)pCtx->aOutputBuf = tPercentileSelect(pInfo->pSelectBuf, pInfo->numOfSelect, pCtx->inputType, v);
+
+    percentileFreeSelectBuf(pCtx, pInfo);
+    doFinalizer(pCtx);
+    return;
+  }
+
+  tMemBucket *pMemBucket = pInfo->pMemBucket;
   
-  if (pMemBucket->total > 0) {  // check for null
+  if (pMemBucket != NULL && pMemBucket->total > 0) {  // check for null
     *(double *)pCtx->aOutputBuf = getPercentile(pMemBucket, v);
   } else {
     setNull(pCtx->aOutputBuf, pCtx->outputType, pCtx->outputBytes);
@@ -2603,13 +2713,24 @@ static void percentile_next_step(SQLFunctionCtx *pCtx) {
   SPercentileInfo *pInfo = pResInfo->interResultBuf;
 
   if (pInfo->stage == 0) {
+    // all values are kept, no need to scan again
+    if (pInfo->numOfSelect > 0) {
+      SET_VAL(pCtx, pInfo->numOfSelect, 1);
+      pResInfo->hasResult = DATA_SET_FLAG;
+      pResInfo->complete = true;
+      return;
+    }
+
+    percentileFreeSelectBuf(pCtx, pInfo);
+
     // all data are null, set it completed
     if (pInfo->numOfElems == 0) {
       pResInfo->complete = true;
+      return;
     }
 
     pInfo->stage += 1;
-    pInfo->pMemBucket = tMemBucketCreate(pCtx->inputBytes, pCtx->inputType, pInfo->minval, pInfo->maxval);
+    pInfo->pMemBucket = tMemBucketCreate(pCtx->inputBytes, pCtx->inputType, pInfo->minval, pInfo->maxval, pCtx->pMemAcct);
   } else {
     pResInfo->complete = true;
   }
@@ -2626,19 +2747,104 @@ static SAPercentileInfo *getAPerctInfo(SQLFunctionCtx *pCtx) {
   }
 }
 
+// the optional second parameter is the algorithm, the histogram is the default one
+static int32_t getAPerctAlgo(SQLFunctionCtx *pCtx) {
+  return (pCtx->numOfParams > 1) ? (int32_t)pCtx->param[1].i64Key : APERCT_ALGO_HISTOGRAM;
+}
+
+// the t-digest holds no pointers, it is always right after the header, wherever the buffer is copied
+static STDigest *getAPerctTDigest(SAPercentileInfo *pInfo) {
+  return (STDigest *)((char *)pInfo + sizeof(SAPercentileInfo));
+}
+
 static bool apercentile_function_setup(SQLFunctionCtx *pCtx) {
   if (!function_setup(pCtx)) {
     return false;
   }
   
   SAPercentileInfo *pInfo = getAPerctInfo(pCtx);
+  if (getAPerctAlgo(pCtx) == APERCT_ALGO_TDIGEST) {
+    tTDigestInit(getAPerctTDigest(pInfo));
+    return true;
+  }
   
   char *tmp = (char *)pInfo + sizeof(SAPercentileInfo);
   pInfo->pHisto = tHistogramCreateFrom(tmp, MAX_HISTOGRAM_BIN);
   return true;
 }
 
+#define CONVERT_TO_DOUBLE(_type, _vals, _data, _num) \
+  do {                                               \
+    const _type *p = (const _type *)(_data);         \
+    for (int32_t k = 0; k < (_num); ++k) {           \
+      (_vals)[k] = (double)p[k];                     \
+    }                                                \
+  } while (0)
+
+/*
+ * the values of a block are converted to double in a plain loop of each type, which the compiler vectorizes, and the
+ * null values are squeezed out afterwards only when there are, then the batch is sorted and merged into the digest
+ */
+static void apercentile_tdigest_function(SQLFunctionCtx *pCtx) {
+  int32_t notNullElems = 0;
+
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  STDigest *   pDigest = getAPerctTDigest(getAPerctInfo(pCtx));
+
+  double vals[TDIGEST_BATCH_SIZE];
+
+  for (int32_t start = 0; start < pCtx->size; start += TDIGEST_BATCH_SIZE) {
+    int32_t num = MIN(pCtx->size - start, TDIGEST_BATCH_SIZE);
+    char *  data = GET_INPUT_CHAR_INDEX(pCtx, start);
+
+    switch (pCtx->inputType) {
+      case TSDB_DATA_TYPE_TINYINT:
+        CONVERT_TO_DOUBLE(int8_t, vals, data, num);
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        CONVERT_TO_DOUBLE(int16_t, vals, data, num);
+        break;
+      case TSDB_DATA_TYPE_BIGINT:
+        CONVERT_TO_DOUBLE(int64_t, vals, data, num);
+        break;
+      case TSDB_DATA_TYPE_FLOAT:
+        CONVERT_TO_DOUBLE(float, vals, data, num);
+        break;
+      case TSDB_DATA_TYPE_DOUBLE:
+        CONVERT_TO_DOUBLE(double, vals, data, num);
+        break;
+      default:
+        CONVERT_TO_DOUBLE(int32_t, vals, data, num);
+        break;
+    }
+
+    int32_t n = num;
+    if (pCtx->hasNull) {
+      n = 0;
+      for (int32_t i = 0; i < num; ++i) {
+        if (!isNull(data + i * pCtx->inputBytes, pCtx->inputType)) {
+          vals[n++] = vals[i];
+        }
+      }
+    }
+
+    tTDigestAddBatch(pDigest, vals, n);
+    notNullElems += n;
+  }
+
+  SET_VAL(pCtx, notNullElems, 1);
+
+  if (notNullElems > 0) {
+    pResInfo->hasResult = DATA_SET_FLAG;
+  }
+}
+
 static void apercentile_function(SQLFunctionCtx *pCtx) {
+  if (getAPerctAlgo(pCtx) == APERCT_ALGO_TDIGEST) {
+    apercentile_tdigest_function(pCtx);
+    return;
+  }
+
   int32_t notNullElems = 0;
   
   SResultInfo *     pResInfo = GET_RES_INFO(pCtx);
@@ -2719,16 +2925,37 @@ static void apercentile_function_f(SQLFunctionCtx *pCtx, int32_t index) {
       break;
   }
   
-  tHistogramAdd(&pInfo->pHisto, v);
+  if (getAPerctAlgo(pCtx) == APERCT_ALGO_TDIGEST) {
+    tTDigestAddBatch(getAPerctTDigest(pInfo), &v, 1);
+  } else {
+    tHistogramAdd(&pInfo->pHisto, v);
+  }
   
   SET_VAL(pCtx, 1, 1);
   pResInfo->hasResult = DATA_SET_FLAG;
 }
 
+static void apercentile_tdigest_merge(SQLFunctionCtx *pCtx) {
+  STDigest *pInput = getAPerctTDigest((SAPercentileInfo *)GET_INPUT_CHAR(pCtx));
+  if (pInput->total <= 0) {
+    return;
+  }
+
+  tTDigestMerge(getAPerctTDigest(getAPerctInfo(pCtx)), pInput);
+
+  SET_VAL(pCtx, 1, 1);
+  GET_RES_INFO(pCtx)->hasResult = DATA_SET_FLAG;
+}
+
 static void apercentile_func_merge(SQLFunctionCtx *pCtx) {
   SResultInfo *pResInfo = GET_RES_INFO(pCtx);
   assert(pResInfo->superTableQ);
   
+  if (getAPerctAlgo(pCtx) == APERCT_ALGO_TDIGEST) {
+    apercentile_tdigest_merge(pCtx);
+    return;
+  }
+  
   SAPercentileInfo *pInput = (SAPercentileInfo *)GET_INPUT_CHAR(pCtx);
   
   pInput->pHisto = (SHistogramInfo*) ((char *)pInput + sizeof(SAPercentileInfo));
@@ -2761,6 +2988,11 @@ static void apercentile_func_merge(SQLFunctionCtx *pCtx) {
 }
 
 static void apercentile_func_second_merge(SQLFunctionCtx *pCtx) {
+  if (getAPerctAlgo(pCtx) == APERCT_ALGO_TDIGEST) {
+    apercentile_tdigest_merge(pCtx);
+    return;
+  }
+  
   SAPercentileInfo *pInput = (SAPercentileInfo *)GET_INPUT_CHAR(pCtx);
   
   pInput->pHisto = (SHistogramInfo*) ((char *)pInput + sizeof(SAPercentileInfo));
@@ -2795,7 +3027,15 @@ static void apercentile_finalizer(SQLFunctionCtx *pCtx) {
   SResultInfo *     pResInfo = GET_RES_INFO(pCtx);
   SAPercentileInfo *pOutput = pResInfo->interResultBuf;
   
-  if (pCtx->currentStage == SECONDARY_STAGE_MERGE) {
+  if (getAPerctAlgo(pCtx) == APERCT_ALGO_TDIGEST) {
+    STDigest *pDigest = getAPerctTDigest(pOutput);
+    if (pDigest->total <= 0) {
+      setNull(pCtx->aOutputBuf, pCtx->outputType, pCtx->outputBytes);
+      return;
+    }
+    
+    *(double *)pCtx->aOutputBuf = tTDigestQuantile(pDigest, v / 100);
+  } else if (pCtx->currentStage == SECONDARY_STAGE_MERGE) {
     if (pResInfo->hasResult == DATA_SET_FLAG) {  // check for null
       assert(pOutput->pHisto->numOfElems > 0);
       
@@ -4515,6 +4755,187 @@ static void sumrate_finalizer(SQLFunctionCtx *pCtx) {
   doFinalizer(pCtx);
 }
 
+/////////////////////////////////////////////////////////////////////////////////
+/*
+ * the sketch is kept in the output buffer for super table query, so that it is shipped to the client as the
+ * intermediate result and merged there, and it is kept in the intermediate buffer otherwise
+ */
+static SHllInfo *getHllInfo(SQLFunctionCtx *pCtx) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+
+  if (pResInfo->superTableQ && pCtx->currentStage != SECONDARY_STAGE_MERGE) {
+    return (SHllInfo *)pCtx->aOutputBuf;
+  } else {
+    return pResInfo->interResultBuf;
+  }
+}
+
+static void hll_add(SQLFunctionCtx *pCtx, SHllInfo *pInfo, char *data) {
+  if (pCtx->inputType == TSDB_DATA_TYPE_BINARY || pCtx->inputType == TSDB_DATA_TYPE_NCHAR) {
+    tHllAdd(pInfo, varDataVal(data), varDataLen(data));
+  } else {
+    tHllAdd(pInfo, data, pCtx->inputBytes);
+  }
+}
+
+static void hll_function(SQLFunctionCtx *pCtx) {
+  int32_t notNullElems = 0;
+
+  SHllInfo *pInfo = getHllInfo(pCtx);
+
+  for (int32_t i = 0; i < pCtx->size; ++i) {
+    char *data = GET_INPUT_CHAR_INDEX(pCtx, i);
+    if (pCtx->hasNull && isNull(data, pCtx->inputType)) {
+      continue;
+    }
+
+    notNullElems += 1;
+    hll_add(pCtx, pInfo, data);
+  }
+
+  SET_VAL(pCtx, notNullElems, 1);
+
+  if (notNullElems > 0) {
+    GET_RES_INFO(pCtx)->hasResult = DATA_SET_FLAG;
+  }
+}
+
+static void hll_function_f(SQLFunctionCtx *pCtx, int32_t index) {
+  char *data = GET_INPUT_CHAR_INDEX(pCtx, index);
+  if (pCtx->hasNull && isNull(data, pCtx->inputType)) {
+    return;
+  }
+
+  hll_add(pCtx, getHllInfo(pCtx), data);
+
+  SET_VAL(pCtx, 1, 1);
+  GET_RES_INFO(pCtx)->hasResult = DATA_SET_FLAG;
+}
+
+/*
+ * the first merge is executed at the vnode side, the secondary merge at the client side, both take the maximum of
+ * each register of the sketch in the input buffer
+ */
+static void hll_func_merge(SQLFunctionCtx *pCtx) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  assert(pResInfo->superTableQ);
+
+  tHllMerge(getHllInfo(pCtx), (SHllInfo *)GET_INPUT_CHAR(pCtx));
+
+  SET_VAL(pCtx, 1, 1);
+  pResInfo->hasResult = DATA_SET_FLAG;
+}
+
+// the distinct count is 0 rather than NULL if there is no data, the same as count
+static void hll_finalizer(SQLFunctionCtx *pCtx) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+
+  *(int64_t *)pCtx->aOutputBuf = tHllCount((SHllInfo *)pResInfo->interResultBuf);
+  doFinalizer(pCtx);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+bool isGroupStateMergeable(int32_t functionId) {
+  switch (functionId) {
+    case TSDB_FUNC_COUNT:
+    case TSDB_FUNC_SUM:
+    case TSDB_FUNC_AVG:
+    case TSDB_FUNC_MIN:
+    case TSDB_FUNC_MAX:
+    case TSDB_FUNC_SPREAD:
+    case TSDB_FUNC_PRJ:
+    case TSDB_FUNC_TAGPRJ:
+    case TSDB_FUNC_TAG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#define MERGE_MIN_MAX(_type, _dst, _src, _isMin)                          \
+  do {                                                                    \
+    _type _v = *(_type *)(_src);                                          \
+    if ((_isMin) ? (_v < *(_type *)(_dst)) : (_v > *(_type *)(_dst))) { \
+      *(_type *)(_dst) = _v;                                              \
+    }                                                                     \
+  } while (0)
+
+static void minMax_state_merge(SQLFunctionCtx *pCtx, const char *pSrcOutput, int32_t isMin) {
+  switch (pCtx->inputType) {
+    case TSDB_DATA_TYPE_TINYINT:  MERGE_MIN_MAX(int8_t, pCtx->aOutputBuf, pSrcOutput, isMin);  break;
+    case TSDB_DATA_TYPE_SMALLINT: MERGE_MIN_MAX(int16_t, pCtx->aOutputBuf, pSrcOutput, isMin); break;
+    case TSDB_DATA_TYPE_INT:      MERGE_MIN_MAX(int32_t, pCtx->aOutputBuf, pSrcOutput, isMin); break;
+    case TSDB_DATA_TYPE_BIGINT:   MERGE_MIN_MAX(int64_t, pCtx->aOutputBuf, pSrcOutput, isMin); break;
+    case TSDB_DATA_TYPE_FLOAT:    MERGE_MIN_MAX(float, pCtx->aOutputBuf, pSrcOutput, isMin);   break;
+    case TSDB_DATA_TYPE_DOUBLE:   MERGE_MIN_MAX(double, pCtx->aOutputBuf, pSrcOutput, isMin);  break;
+    default:
+      tscError("illegal data type:%d in min/max query", pCtx->inputType);
+  }
+}
+
+/*
+ * Merge the state of a group, the result info, the intermediate buffer and the output value, into the state of the
+ * same group in the output buffer of pCtx before the finalizer is called. Only the functions whose state is a fixed
+ * size value, see isGroupStateMergeable, are supported.
+ */
+void mergeGroupState(SQLFunctionCtx *pCtx, const SResultInfo *pSrcInfo, const char *pSrcOutput) {
+  SResultInfo *pResInfo = GET_RES_INFO(pCtx);
+  assert(isGroupStateMergeable(pCtx->functionId) && !pResInfo->superTableQ);
+
+  if (!pSrcInfo->initialized) {
+    return;
+  }
+
+  bool hasResult = (pSrcInfo->hasResult == DATA_SET_FLAG);
+
+  switch (pCtx->functionId) {
+    case TSDB_FUNC_COUNT:
+      *(int64_t *)pCtx->aOutputBuf += *(int64_t *)pSrcOutput;
+      break;
+    case TSDB_FUNC_SUM:
+      if (pCtx->inputType >= TSDB_DATA_TYPE_TINYINT && pCtx->inputType <= TSDB_DATA_TYPE_BIGINT) {
+        *(int64_t *)pCtx->aOutputBuf += *(int64_t *)pSrcOutput;
+      } else {
+        *(double *)pCtx->aOutputBuf += *(double *)pSrcOutput;
+      }
+      break;
+    case TSDB_FUNC_AVG: {
+      SAvgInfo *pAvgInfo = (SAvgInfo *)pResInfo->interResultBuf;
+      SAvgInfo *pSrc = (SAvgInfo *)pSrcInfo->interResultBuf;
+
+      pAvgInfo->sum += pSrc->sum;
+      pAvgInfo->num += pSrc->num;
+      break;
+    }
+    case TSDB_FUNC_MIN:
+    case TSDB_FUNC_MAX:
+      if (hasResult) {
+        minMax_state_merge(pCtx, pSrcOutput, pCtx->functionId == TSDB_FUNC_MIN);
+      }
+      break;
+    case TSDB_FUNC_SPREAD: {
+      SSpreadInfo *pInfo = (SSpreadInfo *)pResInfo->interResultBuf;
+      SSpreadInfo *pSrc = (SSpreadInfo *)pSrcInfo->interResultBuf;
+
+      if (pSrc->hasResult == DATA_SET_FLAG) {
+        pInfo->min = MIN(pInfo->min, pSrc->min);
+        pInfo->max = MAX(pInfo->max, pSrc->max);
+        pInfo->hasResult = DATA_SET_FLAG;
+      }
+      break;
+    }
+    default:  // the projections keep the value of the group, the one of the state merged is taken only if none is kept
+      if (pResInfo->numOfRes == 0 && pSrcInfo->numOfRes > 0) {
+        memcpy(pCtx->aOutputBuf, pSrcOutput, (size_t)pCtx->outputBytes);
+      }
+  }
+
+  if (hasResult) {
+    pResInfo->hasResult = DATA_SET_FLAG;
+  }
+
+  pResInfo->numOfRes = MAX(pResInfo->numOfRes, pSrcInfo->numOfRes);
+}
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -4537,8 +4958,8 @@ int32_t functionCompatList[] = {
     4,         -1,       -1,         1,        1,      1,          1,           1,        1,     -1,
     //  tag,       colprj,  tagprj,   arithmetic, diff, first_dist, last_dist,    interp      rate   irate
     1,          1,        1,         1,       -1,      1,          1,           5,        1,      1,
-    // sum_rate, sum_irate, avg_rate, avg_irate
-    1,          1,        1,         1,
+    // sum_rate, sum_irate, avg_rate, avg_irate, tid_tag, histogram, hll
+    1,          1,        1,         1,        1,         -1,       1,
 };
 
 SQLAggFuncElem aAggs[] = {{
@@ -5069,4 +5490,34 @@ SQLAggFuncElem aAggs[] = {{
                               noop1,
                               noop1,
                               dataBlockRequired,
+                          },
+                          {
+                              // 35, reserved
+                              "histogram",
+                              TSDB_FUNC_HISTOGRAM,
+                              TSDB_FUNC_HISTOGRAM,
+                              0,
+                              function_setup,
+                              noop1,
+                              noop2,
+                              no_next_step,
+                              noop1,
+                              noop1,
+                              noop1,
+                              dataBlockRequired,
+                          },
+                          {
+                              // 36
+                              "hll",
+                              TSDB_FUNC_HLL,
+                              TSDB_FUNC_HLL,
+                              TSDB_BASE_FUNC_SO,
+                              function_setup,
+                              hll_function,
+                              hll_function_f,
+                              no_next_step,
+                              hll_finalizer,
+                              hll_func_merge,
+                              hll_func_merge,
+                              dataBlockRequired,
                           }};
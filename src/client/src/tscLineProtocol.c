@@ -0,0 +1,1203 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "hash.h"
+#include "taosmsg.h"
+#include "tcache.h"
+#include "tdataformat.h"
+#include "tmd5.h"
+#include "tscLog.h"
+#include "tscSubquery.h"
+#include "tscUtil.h"
+#include "tschemautil.h"
+#include "tsclient.h"
+#include "tscLineProtocol.h"
+
+typedef struct SLineSTable {
+  char        name[TSDB_TABLE_FNAME_LEN];  // full name of the super table
+  STableMeta *pMeta;
+  SArray     *pTags;    // SArray<SLineKv>, the tags of all the points, with the maximum length of the binary values
+  SArray     *pFields;  // SArray<SLineKv>, the fields of all the points
+} SLineSTable;
+
+typedef struct SLineInsertInfo {
+  STscObj      *pObj;
+  char          db[TSDB_DB_NAME_LEN];
+  SHashObj     *pSTableHash;    // name of super table -> SLineSTable*
+  SArray       *pSTables;       // SArray<SLineSTable*>
+  SLineSTable **pPointSTables;  // the super table of each point
+  STagData     *pTagData;
+} SLineInsertInfo;
+
+typedef struct SLineMetaSupporter {
+  tsem_t      rspSem;
+  int32_t     code;
+  STableMeta *pMeta;
+} SLineMetaSupporter;
+
+static bool lineIsEscapedChar(char c) { return c == ',' || c == '=' || c == ' ' || c == '"' || c == '\\'; }
+
+/*
+ * read a measurement, tag key, tag value or field key until one of the unescaped delimiters, the escape characters are
+ * removed in place
+ */
+static char *lineReadName(char *p, char *end, const char *delims, char **pName, int16_t *len) {
+  char *dst = p;
+  *pName = p;
+
+  while (p < end && strchr(delims, *p) == NULL) {
+    if (*p == '\\' && p + 1 < end && lineIsEscapedChar(p[1])) {
+      ++p;
+    }
+
+    *dst++ = *p++;
+  }
+
+  *len = (int16_t)MIN(dst - *pName, INT16_MAX);
+  return p;
+}
+
+static void lineToLower(char *name, int16_t len) {
+  for (int16_t i = 0; i < len; ++i) {
+    name[i] = (char)tolower(name[i]);
+  }
+}
+
+static char *lineReadString(char *p, char *end, SLineKv *pKv) {
+  char *dst = ++p;
+  pKv->s = p;
+
+  while (p < end && *p != '"') {
+    if (*p == '\\' && p + 1 < end && (p[1] == '"' || p[1] == '\\')) {
+      ++p;
+    }
+
+    *dst++ = *p++;
+  }
+
+  if (p >= end || dst - pKv->s > TSDB_MAX_BINARY_LEN) {
+    return NULL;
+  }
+
+  pKv->type = TSDB_DATA_TYPE_BINARY;
+  pKv->len = (int16_t)(dst - pKv->s);
+  return p + 1;
+}
+
+static bool lineParseBool(const char *s, int32_t len, bool *val) {
+  if ((len == 1 && (s[0] == 't' || s[0] == 'T')) || (len == 4 && (strncmp(s, "true", 4) == 0 ||
+      strncmp(s, "True", 4) == 0 || strncmp(s, "TRUE", 4) == 0))) {
+    *val = true;
+    return true;
+  }
+
+  if ((len == 1 && (s[0] == 'f' || s[0] == 'F')) || (len == 5 && (strncmp(s, "false", 5) == 0 ||
+      strncmp(s, "False", 5) == 0 || strncmp(s, "FALSE", 5) == 0))) {
+    *val = false;
+    return true;
+  }
+
+  return false;
+}
+
+static bool lineParseInt(const char *s, int32_t len, int64_t *val) {
+  char buf[32];
+  if (len <= 0 || len >= tListLen(buf)) {
+    return false;
+  }
+
+  memcpy(buf, s, len);
+  buf[len] = 0;
+
+  char *endPos = NULL;
+  errno = 0;
+  *val = strtoll(buf, &endPos, 10);
+  return errno == 0 && *endPos == 0;
+}
+
+static bool lineParseDouble(const char *s, int32_t len, double *val) {
+  char buf[64];
+  if (len <= 0 || len >= tListLen(buf)) {
+    return false;
+  }
+
+  memcpy(buf, s, len);
+  buf[len] = 0;
+
+  char *endPos = NULL;
+  errno = 0;
+  *val = strtod(buf, &endPos);
+  return errno == 0 && *endPos == 0;
+}
+
+// 1.5 is a double, 1i and 1u are integers, and t, true, f, false are boolean values
+static int32_t lineParseFieldValue(char *s, int32_t len, SLineKv *pKv) {
+  bool b = false;
+  if (lineParseBool(s, len, &b)) {
+    pKv->type = TSDB_DATA_TYPE_BOOL;
+    pKv->i = b;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (len > 1 && (s[len - 1] == 'i' || s[len - 1] == 'u')) {
+    if (!lineParseInt(s, len - 1, &pKv->i) || (s[len - 1] == 'u' && pKv->i < 0)) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    pKv->type = TSDB_DATA_TYPE_BIGINT;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (!lineParseDouble(s, len, &pKv->d)) {
+    return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+  }
+
+  pKv->type = TSDB_DATA_TYPE_DOUBLE;
+  return TSDB_CODE_SUCCESS;
+}
+
+SLineKv *tscAddLineKv(SLinePoint *pPoint, bool isTag) {
+  assert(!isTag || pPoint->numOfFields == 0);
+
+  int32_t num = pPoint->numOfTags + pPoint->numOfFields;
+  if (num >= pPoint->numOfAlloc) {
+    int32_t  size = (pPoint->numOfAlloc == 0) ? 8 : pPoint->numOfAlloc * 2;
+    SLineKv *tmp = realloc(pPoint->kvs, size * sizeof(SLineKv));
+    if (tmp == NULL) {
+      return NULL;
+    }
+
+    pPoint->kvs = tmp;
+    pPoint->numOfAlloc = (int16_t)size;
+  }
+
+  if (isTag) {
+    pPoint->numOfTags++;
+  } else {
+    pPoint->numOfFields++;
+  }
+
+  SLineKv *pKv = pPoint->kvs + num;
+  memset(pKv, 0, sizeof(SLineKv));
+  return pKv;
+}
+
+static int32_t lineCompareKey(const void *pLeft, const void *pRight) {
+  const SLineKv *p1 = pLeft;
+  const SLineKv *p2 = pRight;
+
+  int32_t ret = memcmp(p1->key, p2->key, MIN(p1->keyLen, p2->keyLen));
+  if (ret != 0) {
+    return ret;
+  }
+
+  return p1->keyLen - p2->keyLen;
+}
+
+int32_t tscSortLineTags(SLinePoint *pPoint) {
+  qsort(pPoint->kvs, pPoint->numOfTags, sizeof(SLineKv), lineCompareKey);
+
+  for (int32_t i = 1; i < pPoint->numOfTags; ++i) {
+    if (lineCompareKey(&pPoint->kvs[i - 1], &pPoint->kvs[i]) == 0) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+void tscDestroyLinePoint(SLinePoint *pPoint) {
+  taosTFree(pPoint->kvs);
+  pPoint->numOfAlloc = 0;
+  pPoint->numOfTags = 0;
+  pPoint->numOfFields = 0;
+}
+
+/*
+ * measurement[,tag_key=tag_value...] field_key=field_value[,field_key=field_value...] [timestamp]
+ */
+int32_t tscParseLine(char *line, int32_t len, int64_t tsUnit, SLinePoint *pPoint) {
+  while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ' || line[len - 1] == '\t')) {
+    --len;
+  }
+
+  char *p = line;
+  char *end = line + len;
+
+  p = lineReadName(p, end, ", ", &pPoint->stable, &pPoint->stableLen);
+  if (pPoint->stableLen == 0) {
+    return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+  }
+
+  lineToLower(pPoint->stable, pPoint->stableLen);
+
+  while (p < end && *p == ',') {
+    if (pPoint->numOfTags >= TSDB_MAX_TAGS) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    SLineKv *pKv = tscAddLineKv(pPoint, true);
+    if (pKv == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+
+    p = lineReadName(p + 1, end, "=, ", &pKv->key, &pKv->keyLen);
+    if (p >= end || *p != '=' || pKv->keyLen == 0) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    lineToLower(pKv->key, pKv->keyLen);
+
+    p = lineReadName(p + 1, end, ", ", &pKv->s, &pKv->len);
+    if (pKv->len == 0) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    pKv->type = TSDB_DATA_TYPE_BINARY;
+  }
+
+  if (p >= end || *p != ' ') {
+    return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+  }
+
+  while (p < end && *p == ' ') {
+    ++p;
+  }
+
+  while (1) {
+    if (pPoint->numOfFields >= TSDB_MAX_COLUMNS - 1) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    SLineKv *pKv = tscAddLineKv(pPoint, false);
+    if (pKv == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+
+    p = lineReadName(p, end, "=, ", &pKv->key, &pKv->keyLen);
+    if (p >= end || *p != '=' || pKv->keyLen == 0) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    lineToLower(pKv->key, pKv->keyLen);
+
+    if (++p < end && *p == '"') {
+      p = lineReadString(p, end, pKv);
+      if (p == NULL) {
+        return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+      }
+    } else {
+      char *v = p;
+      while (p < end && *p != ',' && *p != ' ') {
+        ++p;
+      }
+
+      int32_t code = lineParseFieldValue(v, (int32_t)(p - v), pKv);
+      if (code != TSDB_CODE_SUCCESS) {
+        return code;
+      }
+    }
+
+    if (p >= end || *p != ',') {
+      break;
+    }
+
+    ++p;
+  }
+
+  pPoint->ts = 0;
+  if (p < end) {
+    if (*p != ' ') {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    while (p < end && *p == ' ') {
+      ++p;
+    }
+
+    int64_t ts = 0;
+    if (!lineParseInt(p, (int32_t)(end - p), &ts) || ts < 0 || ts > INT64_MAX / tsUnit) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    pPoint->ts = ts * tsUnit;
+  }
+
+  return tscSortLineTags(pPoint);
+}
+
+static bool lineIsValidName(const char *name, int32_t len) {
+  if (len <= 0 || !(isalpha(name[0]) || name[0] == '_')) {
+    return false;
+  }
+
+  for (int32_t i = 1; i < len; ++i) {
+    if (!(isalnum(name[i]) || name[i] == '_')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static int32_t lineFindSchema(SSchema *pSchema, int32_t numOfCols, const char *key, int16_t len) {
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    if (strncmp(pSchema[i].name, key, len) == 0 && pSchema[i].name[len] == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static bool lineKvToInt(SLineKv *pKv, int64_t *val) {
+  switch (pKv->type) {
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_BOOL:
+      *val = pKv->i;
+      return true;
+    case TSDB_DATA_TYPE_DOUBLE:
+      *val = (int64_t)pKv->d;
+      return pKv->d > INT64_MIN && pKv->d < INT64_MAX && *val == pKv->d;
+    default:
+      return lineParseInt(pKv->s, pKv->len, val);
+  }
+}
+
+static bool lineKvToDouble(SLineKv *pKv, double *val) {
+  switch (pKv->type) {
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_BOOL:
+      *val = (double)pKv->i;
+      return true;
+    case TSDB_DATA_TYPE_DOUBLE:
+      *val = pKv->d;
+      return true;
+    default:
+      return lineParseDouble(pKv->s, pKv->len, val);
+  }
+}
+
+/*
+ * the values are converted to the type of the column, as long as no information is lost. The tag values in the line
+ * protocol are always strings, which are converted for the existing numeric tags.
+ */
+static int32_t lineSetColumnVal(SSchema *pSchema, SLineKv *pKv, char *payload) {
+  int64_t iv = 0;
+  double  dv = 0;
+  bool    bv = false;
+
+  switch (pSchema->type) {
+    case TSDB_DATA_TYPE_BOOL:
+      if (pKv->type == TSDB_DATA_TYPE_BINARY) {
+        if (!lineParseBool(pKv->s, pKv->len, &bv)) {
+          return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+        }
+      } else if (pKv->type == TSDB_DATA_TYPE_DOUBLE || pKv->i < 0 || pKv->i > 1) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      } else {
+        bv = (pKv->i != 0);
+      }
+
+      *(int8_t *)payload = bv ? TSDB_TRUE : TSDB_FALSE;
+      break;
+
+    case TSDB_DATA_TYPE_TINYINT:
+      if (!lineKvToInt(pKv, &iv) || iv <= INT8_MIN || iv > INT8_MAX) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      *(int8_t *)payload = (int8_t)iv;
+      break;
+
+    case TSDB_DATA_TYPE_SMALLINT:
+      if (!lineKvToInt(pKv, &iv) || iv <= INT16_MIN || iv > INT16_MAX) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      *(int16_t *)payload = (int16_t)iv;
+      break;
+
+    case TSDB_DATA_TYPE_INT:
+      if (!lineKvToInt(pKv, &iv) || iv <= INT32_MIN || iv > INT32_MAX) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      *(int32_t *)payload = (int32_t)iv;
+      break;
+
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      if (!lineKvToInt(pKv, &iv) || iv == INT64_MIN) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      *(int64_t *)payload = iv;
+      break;
+
+    case TSDB_DATA_TYPE_FLOAT:
+      if (!lineKvToDouble(pKv, &dv) || fabs(dv) > FLT_MAX) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      SET_FLOAT_VAL(payload, (float)dv);
+      break;
+
+    case TSDB_DATA_TYPE_DOUBLE:
+      if (!lineKvToDouble(pKv, &dv)) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      SET_DOUBLE_VAL(payload, dv);
+      break;
+
+    case TSDB_DATA_TYPE_BINARY:
+      if (pKv->type != TSDB_DATA_TYPE_BINARY || pKv->len + VARSTR_HEADER_SIZE > pSchema->bytes) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      STR_WITH_SIZE_TO_VARSTR(payload, pKv->s, pKv->len);
+      break;
+
+    case TSDB_DATA_TYPE_NCHAR: {
+      size_t output = 0;
+      if (pKv->type != TSDB_DATA_TYPE_BINARY ||
+          !taosMbsToUcs4(pKv->s, pKv->len, varDataVal(payload), pSchema->bytes - VARSTR_HEADER_SIZE, &output)) {
+        return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+      }
+
+      varDataSetLen(payload, output);
+      break;
+    }
+
+    default:
+      return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void lineSetFullName(char *fullName, STscObj *pObj, const char *db, const char *name, int32_t len) {
+  snprintf(fullName, TSDB_TABLE_FNAME_LEN, "%s%s%s%s%.*s", pObj->acctId, TS_PATH_DELIMITER, db, TS_PATH_DELIMITER, len,
+           name);
+}
+
+// the child table is named after the measurement and the sorted tags, so the same series always go to the same table
+static void lineSetChildTableName(char *fullName, STscObj *pObj, const char *db, SLinePoint *pPoint) {
+  MD5_CTX context;
+  MD5Init(&context);
+  MD5Update(&context, (uint8_t *)pPoint->stable, pPoint->stableLen);
+
+  for (int32_t i = 0; i < pPoint->numOfTags; ++i) {
+    SLineKv *pKv = pPoint->kvs + i;
+    MD5Update(&context, (uint8_t *)",", 1);
+    MD5Update(&context, (uint8_t *)pKv->key, pKv->keyLen);
+    MD5Update(&context, (uint8_t *)"=", 1);
+
+    if (pKv->type == TSDB_DATA_TYPE_BINARY) {
+      MD5Update(&context, (uint8_t *)pKv->s, pKv->len);
+    } else {
+      MD5Update(&context, (uint8_t *)&pKv->i, sizeof(pKv->i));
+    }
+  }
+
+  MD5Final(&context);
+
+  char name[TSDB_TABLE_NAME_LEN] = "t_";
+  for (int32_t i = 0; i < tListLen(context.digest); ++i) {
+    sprintf(name + 2 + i * 2, "%02x", context.digest[i]);
+  }
+
+  lineSetFullName(fullName, pObj, db, name, (int32_t)strlen(name));
+}
+
+static void lineTableMetaCallback(void *param, TAOS_RES *tres, int code) {
+  SLineMetaSupporter *pSupporter = param;
+  SSqlObj *           pSql = (SSqlObj *)tres;
+
+  pSupporter->code = pSql->res.code;
+  if (pSupporter->code == TSDB_CODE_SUCCESS) {
+    STableMetaInfo *pTableMetaInfo = tscGetTableMetaInfoFromCmd(&pSql->cmd, 0, 0);
+    if (pTableMetaInfo->pTableMeta == NULL) {
+      pSupporter->code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    } else {
+      pSupporter->pMeta = taosCacheAcquireByData(tscMetaCache, pTableMetaInfo->pTableMeta);
+    }
+  }
+
+  tsem_post(&pSupporter->rspSem);
+}
+
+/*
+ * retrieve the table meta from mnode and wait for it, the table is created if the tag data is provided. The meta is
+ * put into the cache and a reference of it is returned.
+ */
+static int32_t lineFetchTableMeta(STscObj *pObj, const char *name, STagData *pTagData, STableMeta **ppMeta) {
+  SSqlObj *pNew = calloc(1, sizeof(SSqlObj));
+  if (pNew == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  pNew->pTscObj = pObj;
+  pNew->signature = pNew;
+  pNew->cmd.command = TSDB_SQL_META;
+
+  registerSqlObj(pNew);
+
+  int32_t code = tscAddSubqueryInfo(&pNew->cmd);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscAllocPayload(&pNew->cmd, TSDB_DEFAULT_PAYLOAD_SIZE + sizeof(STagData));
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    taos_free_result(pNew);
+    return code;
+  }
+
+  SQueryInfo *    pQueryInfo = tscGetQueryInfoDetailSafely(&pNew->cmd, 0);
+  STableMetaInfo *pTableMetaInfo = tscAddEmptyMetaInfo(pQueryInfo);
+  tstrncpy(pTableMetaInfo->name, name, sizeof(pTableMetaInfo->name));
+
+  if (pTagData != NULL) {
+    pNew->cmd.autoCreated = true;
+    memcpy(&pNew->cmd.tagData, pTagData, sizeof(STagData));
+  }
+
+  SLineMetaSupporter supporter = {.code = TSDB_CODE_SUCCESS, .pMeta = NULL};
+  tsem_init(&supporter.rspSem, 0, 0);
+
+  pNew->fp = lineTableMetaCallback;
+  pNew->param = &supporter;
+
+  tscDebug("%p new pSqlObj:%p to get line table meta:%s, auto create:%d", pObj, pNew, name, pNew->cmd.autoCreated);
+
+  // the sql object is freed automatically once the callback returns
+  code = tscProcessSql(pNew);
+  if (code == TSDB_CODE_SUCCESS) {
+    tsem_wait(&supporter.rspSem);
+    code = supporter.code;
+    *ppMeta = supporter.pMeta;
+  } else {
+    taos_free_result(pNew);
+  }
+
+  tsem_destroy(&supporter.rspSem);
+  return code;
+}
+
+static int32_t lineGetTableMeta(STscObj *pObj, const char *name, STableMeta **ppMeta) {
+  *ppMeta = taosCacheAcquireByKey(tscMetaCache, name, strlen(name));
+  if (*ppMeta != NULL) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  return lineFetchTableMeta(pObj, name, NULL, ppMeta);
+}
+
+static int32_t lineExecSql(STscObj *pObj, const char *sql) {
+  TAOS_RES *res = taos_query(pObj, sql);
+  int32_t   code = taos_errno(res);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tscError("%p failed to execute:%s, reason:%s", pObj, sql, taos_errstr(res));
+  } else {
+    tscDebug("%p execute:%s", pObj, sql);
+  }
+
+  taos_free_result(res);
+  return code;
+}
+
+static int32_t lineBinaryWidth(int16_t len) {
+  int32_t width = TSDB_LINE_MIN_BINARY_LEN;
+  while (width < len) {
+    width *= 2;
+  }
+
+  return MIN(width, TSDB_MAX_BINARY_LEN);
+}
+
+static int32_t lineColumnDef(char *buf, SLineKv *pKv) {
+  switch (pKv->type) {
+    case TSDB_DATA_TYPE_BIGINT:
+      return sprintf(buf, "%.*s bigint", pKv->keyLen, pKv->key);
+    case TSDB_DATA_TYPE_DOUBLE:
+      return sprintf(buf, "%.*s double", pKv->keyLen, pKv->key);
+    case TSDB_DATA_TYPE_BOOL:
+      return sprintf(buf, "%.*s bool", pKv->keyLen, pKv->key);
+    default:
+      return sprintf(buf, "%.*s binary(%d)", pKv->keyLen, pKv->key, lineBinaryWidth(pKv->len));
+  }
+}
+
+static int32_t lineCreateSTable(SLineInsertInfo *pInfo, SLineSTable *pSTable, const char *name, int32_t len) {
+  size_t numOfFields = taosArrayGetSize(pSTable->pFields);
+  size_t numOfTags = taosArrayGetSize(pSTable->pTags);
+
+  char *sql = malloc(TSDB_TABLE_FNAME_LEN * 2 + (numOfFields + numOfTags) * (TSDB_COL_NAME_LEN + 32));
+  if (sql == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  int32_t pos = sprintf(sql, "create table if not exists %s.%.*s (ts timestamp", pInfo->db, len, name);
+  for (int32_t i = 0; i < numOfFields; ++i) {
+    pos += sprintf(sql + pos, ", ");
+    pos += lineColumnDef(sql + pos, taosArrayGet(pSTable->pFields, i));
+  }
+
+  pos += sprintf(sql + pos, ") tags (");
+  for (int32_t i = 0; i < numOfTags; ++i) {
+    pos += sprintf(sql + pos, (i == 0) ? "" : ", ");
+    pos += lineColumnDef(sql + pos, taosArrayGet(pSTable->pTags, i));
+  }
+
+  sprintf(sql + pos, ")");
+
+  int32_t code = lineExecSql(pInfo->pObj, sql);
+  free(sql);
+  return code;
+}
+
+// add the columns or tags that are not in the super table yet
+static int32_t lineAlterSTable(SLineInsertInfo *pInfo, SLineSTable *pSTable, bool isTag, bool *altered) {
+  STableMeta *pMeta = pSTable->pMeta;
+  SArray *    pKvs = isTag ? pSTable->pTags : pSTable->pFields;
+
+  SSchema *pSchema = isTag ? tscGetTableTagSchema(pMeta) : tscGetTableSchema(pMeta);
+  int32_t  numOfCols = isTag ? tscGetNumOfTags(pMeta) : tscGetNumOfColumns(pMeta);
+
+  const char *stable = strrchr(pSTable->name, TS_PATH_DELIMITER[0]) + 1;
+
+  for (int32_t i = 0; i < taosArrayGetSize(pKvs); ++i) {
+    SLineKv *pKv = taosArrayGet(pKvs, i);
+    if (lineFindSchema(pSchema, numOfCols, pKv->key, pKv->keyLen) >= 0) {
+      continue;
+    }
+
+    if (!lineIsValidName(pKv->key, pKv->keyLen)) {
+      return TSDB_CODE_TSC_LINE_INVALID_NAME;
+    }
+
+    char sql[TSDB_TABLE_FNAME_LEN + TSDB_COL_NAME_LEN + 64];
+    int32_t pos = sprintf(sql, "alter table %s.%s add %s ", pInfo->db, stable, isTag ? "tag" : "column");
+    lineColumnDef(sql + pos, pKv);
+
+    // the column may have been added by others in the meanwhile
+    int32_t code = lineExecSql(pInfo->pObj, sql);
+    if (code != TSDB_CODE_SUCCESS && code != TSDB_CODE_MND_FIELD_ALREAY_EXIST && code != TSDB_CODE_MND_TAG_ALREAY_EXIST) {
+      return code;
+    }
+
+    *altered = true;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+/*
+ * make sure that the super table exists and has all the columns and tags of the points, this is only done by sql
+ * statements since it is rare, all the data still go through the submit blocks
+ */
+static int32_t lineEnsureSTable(SLineInsertInfo *pInfo, SLineSTable *pSTable) {
+  const char *stable = strrchr(pSTable->name, TS_PATH_DELIMITER[0]) + 1;
+  int32_t     len = (int32_t)strlen(stable);
+
+  int32_t code = lineGetTableMeta(pInfo->pObj, pSTable->name, &pSTable->pMeta);
+  if (code == TSDB_CODE_MND_DB_NOT_SELECTED || code == TSDB_CODE_MND_INVALID_DB) {
+    char sql[TSDB_DB_NAME_LEN + 64];
+    sprintf(sql, "create database if not exists %s", pInfo->db);
+
+    code = lineExecSql(pInfo->pObj, sql);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = lineFetchTableMeta(pInfo->pObj, pSTable->name, NULL, &pSTable->pMeta);
+    }
+  }
+
+  if (code == TSDB_CODE_MND_INVALID_TABLE_NAME) {
+    if (!lineIsValidName(stable, len)) {
+      return TSDB_CODE_TSC_LINE_INVALID_NAME;
+    }
+
+    for (int32_t i = 0; i < taosArrayGetSize(pSTable->pFields); ++i) {
+      SLineKv *pKv = taosArrayGet(pSTable->pFields, i);
+      if (!lineIsValidName(pKv->key, pKv->keyLen)) {
+        return TSDB_CODE_TSC_LINE_INVALID_NAME;
+      }
+    }
+
+    for (int32_t i = 0; i < taosArrayGetSize(pSTable->pTags); ++i) {
+      SLineKv *pKv = taosArrayGet(pSTable->pTags, i);
+      if (!lineIsValidName(pKv->key, pKv->keyLen)) {
+        return TSDB_CODE_TSC_LINE_INVALID_NAME;
+      }
+    }
+
+    code = lineCreateSTable(pInfo, pSTable, stable, len);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = lineFetchTableMeta(pInfo->pObj, pSTable->name, NULL, &pSTable->pMeta);
+    }
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  if (pSTable->pMeta->tableType != TSDB_SUPER_TABLE) {
+    tscError("%p %s is not a super table", pInfo->pObj, pSTable->name);
+    return TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+  }
+
+  bool altered = false;
+  code = lineAlterSTable(pInfo, pSTable, false, &altered);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = lineAlterSTable(pInfo, pSTable, true, &altered);
+  }
+
+  if (altered) {
+    taosCacheRelease(tscMetaCache, (void **)&pSTable->pMeta, true);
+    int32_t ret = lineFetchTableMeta(pInfo->pObj, pSTable->name, NULL, &pSTable->pMeta);
+    code = (code == TSDB_CODE_SUCCESS) ? ret : code;
+  }
+
+  return code;
+}
+
+static int32_t lineMergeKv(SArray *pKvs, SLineKv *pKv) {
+  for (int32_t i = 0; i < taosArrayGetSize(pKvs); ++i) {
+    SLineKv *pExist = taosArrayGet(pKvs, i);
+    if (lineCompareKey(pExist, pKv) == 0) {
+      if (pKv->type == TSDB_DATA_TYPE_BINARY && pExist->type == TSDB_DATA_TYPE_BINARY) {
+        pExist->len = MAX(pExist->len, pKv->len);
+      }
+
+      return TSDB_CODE_SUCCESS;
+    }
+  }
+
+  if (pKv->keyLen >= TSDB_COL_NAME_LEN) {
+    return TSDB_CODE_TSC_LINE_INVALID_NAME;
+  }
+
+  return (taosArrayPush(pKvs, pKv) == NULL) ? TSDB_CODE_TSC_OUT_OF_MEMORY : TSDB_CODE_SUCCESS;
+}
+
+// group the points by the super tables, and collect the tags and fields of each super table
+static int32_t lineCollectSTables(SLineInsertInfo *pInfo, SLinePoint *pPoints, int32_t numOfPoints) {
+  for (int32_t i = 0; i < numOfPoints; ++i) {
+    SLinePoint *pPoint = pPoints + i;
+    if (pPoint->stableLen <= 0 || pPoint->stableLen >= TSDB_TABLE_NAME_LEN) {
+      return TSDB_CODE_TSC_LINE_INVALID_NAME;
+    }
+
+    if (pPoint->numOfTags <= 0) {
+      return TSDB_CODE_TSC_LINE_NO_TAGS;
+    }
+
+    if (pPoint->numOfFields <= 0) {
+      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+    }
+
+    SLineSTable **ppSTable = taosHashGet(pInfo->pSTableHash, pPoint->stable, pPoint->stableLen);
+    SLineSTable * pSTable = (ppSTable == NULL) ? NULL : *ppSTable;
+
+    if (pSTable == NULL) {
+      pSTable = calloc(1, sizeof(SLineSTable));
+      if (pSTable == NULL) {
+        return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      }
+
+      taosArrayPush(pInfo->pSTables, &pSTable);
+      pSTable->pTags = taosArrayInit(pPoint->numOfTags, sizeof(SLineKv));
+      pSTable->pFields = taosArrayInit(pPoint->numOfFields, sizeof(SLineKv));
+      if (pSTable->pTags == NULL || pSTable->pFields == NULL) {
+        return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      }
+
+      lineSetFullName(pSTable->name, pInfo->pObj, pInfo->db, pPoint->stable, pPoint->stableLen);
+      taosHashPut(pInfo->pSTableHash, pPoint->stable, pPoint->stableLen, &pSTable, POINTER_BYTES);
+    }
+
+    pInfo->pPointSTables[i] = pSTable;
+
+    for (int32_t j = 0; j < pPoint->numOfTags + pPoint->numOfFields; ++j) {
+      SArray *pKvs = (j < pPoint->numOfTags) ? pSTable->pTags : pSTable->pFields;
+      int32_t code = lineMergeKv(pKvs, pPoint->kvs + j);
+      if (code != TSDB_CODE_SUCCESS) {
+        return code;
+      }
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t lineBuildTagData(SLineSTable *pSTable, SLinePoint *pPoint, STagData *pTag) {
+  STableMeta *pMeta = pSTable->pMeta;
+  SSchema *   pTagSchema = tscGetTableTagSchema(pMeta);
+  int32_t     numOfTags = tscGetNumOfTags(pMeta);
+
+  SKVRowBuilder kvRowBuilder = {0};
+  if (tdInitKVRowBuilder(&kvRowBuilder) < 0) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  char tagVal[TSDB_MAX_TAGS_LEN];
+  for (int32_t i = 0; i < pPoint->numOfTags; ++i) {
+    SLineKv *pKv = pPoint->kvs + i;
+
+    int32_t index = lineFindSchema(pTagSchema, numOfTags, pKv->key, pKv->keyLen);
+    int32_t code = (index < 0) ? TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH : lineSetColumnVal(pTagSchema + index, pKv, tagVal);
+    if (code != TSDB_CODE_SUCCESS) {
+      tdDestroyKVRowBuilder(&kvRowBuilder);
+      return code;
+    }
+
+    tdAddColToKVRow(&kvRowBuilder, pTagSchema[index].colId, pTagSchema[index].type, tagVal);
+  }
+
+  SKVRow row = tdGetKVRowFromBuilder(&kvRowBuilder);
+  tdDestroyKVRowBuilder(&kvRowBuilder);
+  if (row == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  tdSortKVRowByColIdx(row);
+
+  tstrncpy(pTag->name, pSTable->name, sizeof(pTag->name));
+  pTag->dataLen = htonl(kvRowLen(row));
+  kvRowCpy(pTag->data, row);
+
+  free(row);
+  return TSDB_CODE_SUCCESS;
+}
+
+/*
+ * the child table meta is usually in the cache, otherwise it is retrieved from mnode and the child table is created
+ * with the tags of the point if it does not exist
+ */
+static int32_t lineGetChildTableMeta(SLineInsertInfo *pInfo, SLineSTable *pSTable, SLinePoint *pPoint,
+                                     const char *name, STableMeta **ppMeta) {
+  STableMeta *pMeta = taosCacheAcquireByKey(tscMetaCache, name, strlen(name));
+  if (pMeta != NULL) {
+    // the schema of the super table has been changed by the points
+    if (pMeta->sversion >= pSTable->pMeta->sversion) {
+      *ppMeta = pMeta;
+      return TSDB_CODE_SUCCESS;
+    }
+
+    taosCacheRelease(tscMetaCache, (void **)&pMeta, true);
+  }
+
+  int32_t code = lineBuildTagData(pSTable, pPoint, pInfo->pTagData);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  code = lineFetchTableMeta(pInfo->pObj, name, pInfo->pTagData, ppMeta);
+  if (code == TSDB_CODE_SUCCESS && strcmp((*ppMeta)->sTableId, pSTable->name) != 0) {
+    tscError("%p table:%s does not belong to super table:%s", pInfo->pObj, name, pSTable->name);
+    taosCacheRelease(tscMetaCache, (void **)ppMeta, false);
+    code = TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH;
+  }
+
+  return code;
+}
+
+// write one row into the data block in the same layout as the parsed sql values, the absent columns are null
+static int32_t lineAppendRow(STableDataBlocks *pBlock, STableMeta *pMeta, SLinePoint *pPoint, TSKEY ts) {
+  STableComInfo tinfo = tscGetTableInfo(pMeta);
+  SSchema *     pSchema = tscGetTableSchema(pMeta);
+
+  int32_t maxRows = 0;
+  int32_t code = tscAllocateMemIfNeed(pBlock, tinfo.rowSize, &maxRows);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  char *  row = pBlock->pData + pBlock->size;
+  int16_t offset[TSDB_MAX_COLUMNS];
+
+  *(TSKEY *)row = ts;
+  offset[0] = 0;
+
+  for (int32_t i = 1; i < tinfo.numOfColumns; ++i) {
+    offset[i] = offset[i - 1] + pSchema[i - 1].bytes;
+
+    char *ptr = row + offset[i];
+    if (pSchema[i].type == TSDB_DATA_TYPE_BINARY) {
+      varDataSetLen(ptr, sizeof(int8_t));
+      *(uint8_t *)varDataVal(ptr) = TSDB_DATA_BINARY_NULL;
+    } else if (pSchema[i].type == TSDB_DATA_TYPE_NCHAR) {
+      varDataSetLen(ptr, sizeof(int32_t));
+      *(uint32_t *)varDataVal(ptr) = TSDB_DATA_NCHAR_NULL;
+    } else {
+      setNull(ptr, pSchema[i].type, pSchema[i].bytes);
+    }
+  }
+
+  for (int32_t i = 0; i < pPoint->numOfFields; ++i) {
+    SLineKv *pKv = pPoint->kvs + pPoint->numOfTags + i;
+
+    // the first column is the timestamp of the point
+    int32_t index = lineFindSchema(pSchema + 1, tinfo.numOfColumns - 1, pKv->key, pKv->keyLen) + 1;
+    code = (index <= 0) ? TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH : lineSetColumnVal(pSchema + index, pKv, row + offset[index]);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  if (ts <= pBlock->prevTS) {
+    pBlock->ordered = false;
+  }
+
+  pBlock->prevTS = ts;
+  pBlock->size += tinfo.rowSize;
+  return TSDB_CODE_SUCCESS;
+}
+
+static TSKEY lineConvertTimestamp(int64_t ts, int32_t precision) {
+  if (ts == 0) {
+    return taosGetTimestamp(precision);
+  }
+
+  if (precision == TSDB_TIME_PRECISION_MICRO) {
+    return ts / 1000;
+  } else if (precision == TSDB_TIME_PRECISION_NANO) {
+    return ts;
+  } else {
+    return ts / 1000000;
+  }
+}
+
+static void lineReleaseChildTableMetas(SHashObj *pChildTables, bool remove) {
+  SHashMutableIterator *pIter = taosHashCreateIter(pChildTables);
+  while (taosHashIterNext(pIter)) {
+    STableMeta **ppMeta = taosHashIterGet(pIter);
+    taosCacheRelease(tscMetaCache, (void **)ppMeta, remove);
+  }
+
+  taosHashDestroyIter(pIter);
+  taosHashCleanup(pChildTables);
+}
+
+static bool lineShouldRenewMeta(int32_t code) {
+  return code == TSDB_CODE_TDB_INVALID_TABLE_ID || code == TSDB_CODE_VND_INVALID_VGROUP_ID ||
+         code == TSDB_CODE_RPC_NETWORK_UNAVAIL || code == TSDB_CODE_APP_NOT_READY ||
+         code == TSDB_CODE_TDB_TABLE_RECONFIGURE;
+}
+
+/*
+ * pack the points into the submit blocks of the child tables, and send them to the vnodes in the same way as the
+ * insert statement does
+ */
+static int32_t lineSubmit(SLineInsertInfo *pInfo, int32_t start, int32_t numOfPoints, SLinePoint *pPoints,
+                          bool submitSchema, int32_t *affectedRows) {
+  SSqlObj *pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  SSqlCmd *pCmd = &pSql->cmd;
+  SSqlRes *pRes = &pSql->res;
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  pSql->signature = pSql;
+  pSql->pTscObj = pInfo->pObj;
+
+  // there is no sql string to be parsed again with the renewed table meta, the retry is done here instead
+  pSql->maxRetry = 0;
+  pSql->sqlstr = strdup("");
+
+  pCmd->command = TSDB_SQL_INSERT;
+  pCmd->submitSchema = submitSchema;
+  pCmd->parseFinished = 1;
+
+  registerSqlObj(pSql);
+
+  SHashObj *pChildTables = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
+  pCmd->pTableList = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, false);
+  pCmd->pDataBlocks = taosArrayInit(4, POINTER_BYTES);
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  if (pSql->sqlstr == NULL || pChildTables == NULL || pCmd->pTableList == NULL || pCmd->pDataBlocks == NULL ||
+      tscAddSubqueryInfo(pCmd) != TSDB_CODE_SUCCESS) {
+    code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    goto _end;
+  }
+
+  STableMetaInfo *pTableMetaInfo = tscAddEmptyMetaInfo(tscGetQueryInfoDetailSafely(pCmd, 0));
+  tstrncpy(pTableMetaInfo->name, pInfo->pPointSTables[start]->name, sizeof(pTableMetaInfo->name));
+
+  char name[TSDB_TABLE_FNAME_LEN];
+  for (int32_t i = start; i < start + numOfPoints; ++i) {
+    SLinePoint * pPoint = pPoints + i;
+    SLineSTable *pSTable = pInfo->pPointSTables[i];
+
+    lineSetChildTableName(name, pInfo->pObj, pInfo->db, pPoint);
+
+    STableMeta **ppMeta = taosHashGet(pChildTables, name, strlen(name));
+    STableMeta * pMeta = (ppMeta == NULL) ? NULL : *ppMeta;
+    if (pMeta == NULL) {
+      code = lineGetChildTableMeta(pInfo, pSTable, pPoint, name, &pMeta);
+      if (code != TSDB_CODE_SUCCESS) {
+        goto _end;
+      }
+
+      taosHashPut(pChildTables, name, strlen(name), &pMeta, POINTER_BYTES);
+    }
+
+    STableComInfo     tinfo = tscGetTableInfo(pMeta);
+    STableDataBlocks *pBlock = NULL;
+
+    code = tscGetDataBlockFromList(pCmd->pTableList, pCmd->pDataBlocks, pMeta->id.uid, TSDB_DEFAULT_PAYLOAD_SIZE,
+                                   sizeof(SSubmitBlk), tinfo.rowSize, name, pMeta, &pBlock);
+    if (code != TSDB_CODE_SUCCESS) {
+      goto _end;
+    }
+
+    code = lineAppendRow(pBlock, pMeta, pPoint, lineConvertTimestamp(pPoint->ts, tinfo.precision));
+    if (code != TSDB_CODE_SUCCESS) {
+      tscError("%p failed to write point of %.*s into table:%s, code:%s", pInfo->pObj, pPoint->stableLen,
+               pPoint->stable, name, tstrerror(code));
+      goto _end;
+    }
+  }
+
+  for (int32_t i = 0; i < taosArrayGetSize(pCmd->pDataBlocks); ++i) {
+    STableDataBlocks *pBlock = taosArrayGetP(pCmd->pDataBlocks, i);
+    SSubmitBlk *      pBlocks = (SSubmitBlk *)pBlock->pData;
+
+    pBlocks->tid = pBlock->pTableMeta->id.tid;
+    pBlocks->uid = pBlock->pTableMeta->id.uid;
+    pBlocks->sversion = pBlock->pTableMeta->sversion;
+    pBlocks->numOfRows = (int16_t)((pBlock->size - sizeof(SSubmitBlk)) / pBlock->rowSize);
+
+    pBlock->vgId = pBlock->pTableMeta->vgroupInfo.vgId;
+    pBlock->numOfTables = 1;
+  }
+
+  code = tscMergeTableDataBlocks(pSql, pCmd->pDataBlocks);
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _end;
+  }
+
+  pSql->fetchFp = waitForQueryRsp;
+  pSql->fp = (void(*)())tscHandleMultivnodeInsert;
+
+  code = tscHandleMultivnodeInsert(pSql);
+  if (code == TSDB_CODE_SUCCESS) {
+    tsem_wait(&pSql->rspSem);
+    code = pRes->code;
+    *affectedRows = (int32_t)pRes->numOfRows;
+  }
+
+  tscDebug("%p submit %d line points in %d vnodes, affected rows:%d, code:%s", pInfo->pObj, numOfPoints,
+           pSql->numOfSubs, *affectedRows, tstrerror(code));
+
+_end:
+  // the table meta may be out of date, and will be retrieved again in the next try
+  lineReleaseChildTableMetas(pChildTables, lineShouldRenewMeta(code));
+  taos_free_result(pSql);
+  return code;
+}
+
+int32_t tscInsertLinePoints(TAOS *taos, const char *db, SLinePoint *pPoints, int32_t numOfPoints, int32_t *affectedRows) {
+  STscObj *pObj = (STscObj *)taos;
+  if (pObj == NULL || pObj->signature != pObj) {
+    return TSDB_CODE_TSC_DISCONNECTED;
+  }
+
+  *affectedRows = 0;
+  if (numOfPoints <= 0) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (db == NULL || strlen(db) == 0 || strlen(db) >= TSDB_DB_NAME_LEN) {
+    return TSDB_CODE_TSC_INVALID_DB_LENGTH;
+  }
+
+  // the db name comes from the url and is put into the sql to create the database and tables
+  if (!lineIsValidName(db, (int32_t)strlen(db))) {
+    return TSDB_CODE_TSC_LINE_INVALID_DB;
+  }
+
+  SLineInsertInfo info = {.pObj = pObj};
+  strtolower(info.db, db);
+
+  info.pSTableHash = taosHashInit(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
+  info.pSTables = taosArrayInit(4, POINTER_BYTES);
+  info.pPointSTables = calloc(numOfPoints, POINTER_BYTES);
+  info.pTagData = calloc(1, sizeof(STagData));
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  if (info.pSTableHash == NULL || info.pSTables == NULL || info.pPointSTables == NULL || info.pTagData == NULL) {
+    code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    goto _end;
+  }
+
+  code = lineCollectSTables(&info, pPoints, numOfPoints);
+  for (int32_t i = 0; code == TSDB_CODE_SUCCESS && i < taosArrayGetSize(info.pSTables); ++i) {
+    code = lineEnsureSTable(&info, taosArrayGetP(info.pSTables, i));
+  }
+
+  for (int32_t start = 0; code == TSDB_CODE_SUCCESS && start < numOfPoints; start += TSDB_LINE_BATCH_SIZE) {
+    int32_t num = MIN(numOfPoints - start, TSDB_LINE_BATCH_SIZE);
+    bool    submitSchema = false;
+
+    for (int32_t retry = 0;; ++retry) {
+      int32_t rows = 0;
+      code = lineSubmit(&info, start, num, pPoints, submitSchema, &rows);
+      if (code == TSDB_CODE_SUCCESS) {
+        *affectedRows += rows;
+        break;
+      }
+
+      if (!lineShouldRenewMeta(code) || retry >= TSDB_MAX_REPLICA) {
+        break;
+      }
+
+      tscWarn("%p failed to submit line points, renew table meta and retry:%d, code:%s", pObj, retry + 1,
+              tstrerror(code));
+
+      // the vnode needs the schema to update its local table schema
+      if (code == TSDB_CODE_TDB_TABLE_RECONFIGURE) {
+        submitSchema = true;
+      }
+
+      if (code == TSDB_CODE_APP_NOT_READY || code == TSDB_CODE_VND_INVALID_VGROUP_ID) {
+        taosMsleep(100 * (retry + 1));
+      }
+    }
+  }
+
+_end:
+  for (int32_t i = 0; info.pSTables != NULL && i < taosArrayGetSize(info.pSTables); ++i) {
+    SLineSTable *pSTable = taosArrayGetP(info.pSTables, i);
+    if (pSTable->pMeta != NULL) {
+      taosCacheRelease(tscMetaCache, (void **)&pSTable->pMeta, false);
+    }
+
+    taosArrayDestroy(pSTable->pTags);
+    taosArrayDestroy(pSTable->pFields);
+    free(pSTable);
+  }
+
+  taosHashCleanup(info.pSTableHash);
+  taosArrayDestroy(info.pSTables);
+  taosTFree(info.pPointSTables);
+  taosTFree(info.pTagData);
+  return code;
+}
@@ -97,6 +97,12 @@ static void tscInitSqlContext(SSqlCmd *pCmd, SLocalReducer *pReducer, tOrderDesc
       pCtx->param[2].i64Key = pQueryInfo->order.order;
       pCtx->param[2].nType  = TSDB_DATA_TYPE_BIGINT;
       pCtx->param[1].i64Key = pQueryInfo->order.orderColId;
+    } else if (functionId == TSDB_FUNC_APERCT) {
+      // the percentile and the algorithm are required by the secondary merge and the finalizer
+      pCtx->numOfParams = pExpr->numOfParams;
+      for (int32_t j = 0; j < pExpr->numOfParams; ++j) {
+        tVariantAssign(&pCtx->param[j], &pExpr->param[j]);
+      }
     }
 
     SResultInfo *pResInfo = &pReducer->pResInfo[i];
@@ -2115,6 +2115,7 @@ int tscProcessRetrieveRspFromNode(SSqlObj *pSql) {
   pRes->precision = htons(pRetrieve->precision);
   pRes->offset    = htobe64(pRetrieve->offset);
   pRes->useconds  = htobe64(pRetrieve->useconds);
+  pRes->memUsage  = htobe64(pRetrieve->memUsage);
   pRes->completed = (pRetrieve->completed == 1);
   pRes->data      = pRetrieve->data;
   
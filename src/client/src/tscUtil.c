@@ -1816,7 +1816,7 @@ SSqlObj* createSimpleSubObj(SSqlObj* pSql, void (*fp)(), void* param, int32_t cm
   pNew->fp = fp;
   pNew->fetchFp = fp;
   pNew->param = param;
-  pNew->maxRetry = TSDB_MAX_REPLICA;
+  pNew->maxRetry = pSql->maxRetry;
 
   pNew->sqlstr = strdup(pSql->sqlstr);
   if (pNew->sqlstr == NULL) {
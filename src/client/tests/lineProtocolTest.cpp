@@ -0,0 +1,85 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <string>
+
+#include "taos.h"
+#include "taosdef.h"
+#include "taoserror.h"
+
+extern "C" {
+#include "tscLineProtocol.h"
+}
+
+namespace {
+std::string kvKey(SLineKv* pKv) { return std::string(pKv->key, pKv->keyLen); }
+std::string kvStr(SLineKv* pKv) { return std::string(pKv->s, pKv->len); }
+
+int32_t parse(const char* line, SLinePoint* pPoint, int64_t tsUnit = 1) {
+  static char buf[1024];
+  strcpy(buf, line);
+  memset(pPoint, 0, sizeof(SLinePoint));
+  return tscParseLine(buf, (int32_t)strlen(buf), tsUnit, pPoint);
+}
+}  // namespace
+
+TEST(testCase, line_parse) {
+  SLinePoint point;
+  ASSERT_EQ(parse("CPU,region=us\\ west,host=a usage=1.5,n=-3i,u=4u,ok=t,s=\"a \\\"b\\\",c\" 1600000000000000000\r",
+                  &point),
+            TSDB_CODE_SUCCESS);
+
+  EXPECT_EQ(std::string(point.stable, point.stableLen), "cpu");
+  EXPECT_EQ(point.ts, 1600000000000000000LL);
+  ASSERT_EQ(point.numOfTags, 2);
+  ASSERT_EQ(point.numOfFields, 5);
+
+  // the tags are sorted by their keys
+  EXPECT_EQ(kvKey(&point.kvs[0]), "host");
+  EXPECT_EQ(kvStr(&point.kvs[0]), "a");
+  EXPECT_EQ(kvKey(&point.kvs[1]), "region");
+  EXPECT_EQ(kvStr(&point.kvs[1]), "us west");
+
+  SLineKv* fields = point.kvs + point.numOfTags;
+  EXPECT_EQ(fields[0].type, TSDB_DATA_TYPE_DOUBLE);
+  EXPECT_DOUBLE_EQ(fields[0].d, 1.5);
+  EXPECT_EQ(fields[1].type, TSDB_DATA_TYPE_BIGINT);
+  EXPECT_EQ(fields[1].i, -3);
+  EXPECT_EQ(fields[2].type, TSDB_DATA_TYPE_BIGINT);
+  EXPECT_EQ(fields[2].i, 4);
+  EXPECT_EQ(fields[3].type, TSDB_DATA_TYPE_BOOL);
+  EXPECT_EQ(fields[3].i, 1);
+  EXPECT_EQ(fields[4].type, TSDB_DATA_TYPE_BINARY);
+  EXPECT_EQ(kvStr(&fields[4]), "a \"b\",c");
+  tscDestroyLinePoint(&point);
+
+  // no timestamp, and the timestamp in seconds
+  ASSERT_EQ(parse("mem,host=a free=1", &point), TSDB_CODE_SUCCESS);
+  EXPECT_EQ(point.ts, 0);
+  tscDestroyLinePoint(&point);
+
+  ASSERT_EQ(parse("mem,host=a free=1 1600000000", &point, 1000000000), TSDB_CODE_SUCCESS);
+  EXPECT_EQ(point.ts, 1600000000000000000LL);
+  tscDestroyLinePoint(&point);
+}
+
+TEST(testCase, line_parse_error) {
+  const char* lines[] = {
+      "cpu",                                  // no fields
+      "cpu,host=a",                           // no fields
+      ",host=a v=1",                          // no measurement
+      "cpu,host v=1",                         // tag without value
+      "cpu,host=a,host=b v=1",                // duplicated tags
+      "cpu,host=a v=abc",                     // invalid value
+      "cpu,host=a v=1x",                      // invalid value
+      "cpu,host=a v=-1u",                     // negative unsigned value
+      "cpu,host=a v=\"abc",                   // unterminated string
+      "cpu,host=a v=1 16x",                   // invalid timestamp
+      "cpu,host=a v=1 9223372036854775807",   // timestamp overflow in seconds
+  };
+
+  for (auto line : lines) {
+    SLinePoint point;
+    EXPECT_EQ(parse(line, &point, 1000000000), TSDB_CODE_TSC_LINE_SYNTAX_ERROR) << line;
+    tscDestroyLinePoint(&point);
+  }
+}
@@ -44,6 +44,15 @@ extern int32_t  tsShellActivityTimer;
 extern uint32_t tsMaxTmrCtrl;
 extern float    tsNumOfThreadsPerCore;
 extern float    tsRatioOfQueryThreads;
+extern int32_t  tsNumOfCommitThreads;
+extern int32_t  tsBlockCacheSize;
+extern int32_t  tsPrefetchBlocks;
+extern int32_t  tsPrefetchSize;
+extern int32_t  tsNumOfScanThreads;
+extern int32_t  tsQueryMemBudget;
+extern int32_t  tsQueryMemLimit;
+extern int32_t  tsTagIndexMinTables;
+extern int32_t  tsPercentileSelectBuffer;
 extern int8_t   tsDaylight;
 extern char     tsTimezone[];
 extern char     tsLocale[];
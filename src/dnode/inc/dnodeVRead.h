@@ -23,6 +23,7 @@ extern "C" {
 int32_t dnodeInitVnodeRead();
 void    dnodeCleanupVnodeRead();
 void    dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg);
+void    dnodeGetReadQueueStat(SDnodeReadQueueStat *pStat);
 
 #ifdef __cplusplus
 }
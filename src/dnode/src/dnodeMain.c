@@ -19,6 +19,7 @@
 #include "tutil.h"
 #include "tconfig.h"
 #include "tglobal.h"
+#include "tscompression.h"
 #include "dnode.h"
 #include "dnodeInt.h"
 #include "dnodeMgmt.h"
@@ -96,6 +97,7 @@ int32_t dnodeInitSystem() {
   tscEmbedded  = 1;
   taosBlockSIGPIPE();
   taosResolveCRC();
+  taosResolveDecompress(true);
   taosInitGlobalCfg();
   taosReadGlobalLogCfg();
   taosSetCoreDump();
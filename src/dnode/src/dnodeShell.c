@@ -21,6 +21,7 @@
 #include "tglobal.h"
 #include "tutil.h"
 #include "http.h"
+#include "tsdb.h"
 #include "mnode.h"
 #include "dnode.h"
 #include "dnodeInt.h"
@@ -217,6 +218,15 @@ SDnodeStatisInfo dnodeGetStatisInfo() {
     info.httpReqNum   = httpGetReqCount();
     info.queryReqNum  = atomic_exchange_32(&tsDnodeQueryReqNum, 0);
     info.submitReqNum = atomic_exchange_32(&tsDnodeSubmitReqNum, 0);
+
+    STsdbBlockCacheStat cacheStat;
+    tsdbGetBlockCacheStat(&cacheStat);
+    info.blockCacheHits      = cacheStat.hits;
+    info.blockCacheMisses    = cacheStat.misses;
+    info.blockCacheEvictions = cacheStat.evictions;
+    info.blockCacheSize      = cacheStat.size;
+
+    dnodeGetReadQueueStat(info.readQueue);
   }
 
   return info;
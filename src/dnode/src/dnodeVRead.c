@@ -21,72 +21,178 @@
 #include "tqueue.h"
 #include "twal.h"
 #include "tglobal.h"
+#include "dnode.h"
 #include "dnodeInt.h"
 #include "dnodeMgmt.h"
 #include "dnodeVRead.h"
 #include "vnode.h"
 
+/*
+ * Read messages are served by two worker pools. Retrieve and query creation messages, and the execution of queries
+ * which only touch tags or the last row, are short work; the execution of the other queries is long work. Each vnode
+ * has a queue for each kind of work, and the qset of a pool reads its queues in turn, so the queries of one vnode
+ * can not starve the others, and short work never waits behind a full scan.
+ *
+ * A pool grows when the queued messages outnumber its idle workers or a message waited too long, and shrinks back to
+ * its minimum, one worker per interval, when its queues are drained.
+ */
+#define DNODE_READ_GROW_WAIT_US     (50 * 1000)
+#define DNODE_READ_SHRINK_INTERVAL  1000  // ms
+
+typedef struct SReadWorkerPool SReadWorkerPool;
+
 typedef struct {
   pthread_t  thread;    // thread
   int32_t    workerId;  // worker ID
+  int8_t     running;   // thread is started and not exited
+  SReadWorkerPool *pPool;
 } SReadWorker;
 
-typedef struct {
+struct SReadWorkerPool {
+  const char *name;
   int32_t    max;       // max number of workers
   int32_t    min;       // min number of workers
   int32_t    num;       // current number of workers
+  int32_t    busy;      // number of workers processing a message
+  int32_t    retiring;  // number of workers asked to exit
+  int64_t    adjustTime;
+  int64_t    waitHistogram[TSDB_READ_WAIT_BUCKETS];
+  taos_qset  qset;
   SReadWorker *readWorker;
   pthread_mutex_t mutex;
-} SReadWorkerPool;
+};
+
+typedef struct {
+  taos_queue queue[TSDB_READ_WORK_TYPES];
+} SVReadQueue;
 
 static void *dnodeProcessReadQueue(void *param);
-static void  dnodeHandleIdleReadWorker(SReadWorker *);
+static void  dnodeHandleIdleReadWorker(SReadWorkerPool *pPool);
+static void  dnodeCheckReadWorkers(SReadWorkerPool *pPool, int64_t waitUs);
 
 // module global variable
-static SReadWorkerPool readPool;
-static taos_qset       readQset;
+static SReadWorkerPool readPool[TSDB_READ_WORK_TYPES];
+
+static int32_t dnodeInitReadWorkerPool(SReadWorkerPool *pPool, const char *name, int32_t min, int32_t max) {
+  pPool->name = name;
+  pPool->min = min;
+  pPool->max = max;
+  pPool->qset = taosOpenQset();
+  pPool->readWorker = (SReadWorker *)calloc(sizeof(SReadWorker), pPool->max);
+  pthread_mutex_init(&pPool->mutex, NULL);
+
+  if (pPool->qset == NULL || pPool->readWorker == NULL) return -1;
+  for (int i = 0; i < pPool->max; ++i) {
+    SReadWorker *pWorker = pPool->readWorker + i;
+    pWorker->workerId = i;
+    pWorker->pPool = pPool;
+  }
+
+  dInfo("dnode %s read is opened, min worker:%d max worker:%d", name, pPool->min, pPool->max);
+  return 0;
+}
 
 int32_t dnodeInitVnodeRead() {
-  readQset = taosOpenQset();
+  int32_t min = tsNumOfCores;
+  int32_t max = tsNumOfCores * tsNumOfThreadsPerCore;
+  if (max <= min * 2) max = 2 * min;
 
-  readPool.min = tsNumOfCores;
-  readPool.max = tsNumOfCores * tsNumOfThreadsPerCore;
-  if (readPool.max <= readPool.min * 2) readPool.max = 2 * readPool.min;
-  readPool.readWorker = (SReadWorker *)calloc(sizeof(SReadWorker), readPool.max);
-  pthread_mutex_init(&readPool.mutex, NULL);
+  if (dnodeInitReadWorkerPool(&readPool[TSDB_READ_LONG_WORK], "long", min, max) != 0) return -1;
 
-  if (readPool.readWorker == NULL) return -1;
-  for (int i = 0; i < readPool.max; ++i) {
-    SReadWorker *pWorker = readPool.readWorker + i;
-    pWorker->workerId = i;
-  }
+  min = MAX(tsNumOfCores / 4, 1);
+  if (dnodeInitReadWorkerPool(&readPool[TSDB_READ_SHORT_WORK], "short", min, MAX(tsNumOfCores, 2)) != 0) return -1;
 
-  dInfo("dnode read is opened, min worker:%d max worker:%d", readPool.min, readPool.max);
   return 0;
 }
 
-void dnodeCleanupVnodeRead() {
-  for (int i = 0; i < readPool.max; ++i) {
-    SReadWorker *pWorker = readPool.readWorker + i;
-    if (pWorker->thread) {
-      taosQsetThreadResume(readQset);
+static void dnodeLogReadWaitHistogram(SReadWorkerPool *pPool) {
+  char    buf[256];
+  int32_t len = 0;
+  int32_t limit = 1;
+
+  for (int i = 0; i < TSDB_READ_WAIT_BUCKETS; ++i, limit *= 4) {
+    if (i < TSDB_READ_WAIT_BUCKETS - 1) {
+      len += snprintf(buf + len, sizeof(buf) - len, " <%dms:%" PRId64, limit, pPool->waitHistogram[i]);
+    } else {
+      len += snprintf(buf + len, sizeof(buf) - len, " more:%" PRId64, pPool->waitHistogram[i]);
     }
   }
 
-  for (int i = 0; i < readPool.max; ++i) {
-    SReadWorker *pWorker = readPool.readWorker + i;
+  dInfo("dnode %s read queue wait time,%s", pPool->name, buf);
+}
+
+static void dnodeCleanupReadWorkerPool(SReadWorkerPool *pPool) {
+  if (pPool->readWorker == NULL) return;
+
+  // a worker woken up by one resume may exit before the others are checked, so resume as many as are running
+  pthread_mutex_lock(&pPool->mutex);
+  int32_t num = pPool->num;
+  pthread_mutex_unlock(&pPool->mutex);
+
+  for (int i = 0; i < num; ++i) {
+    taosQsetThreadResume(pPool->qset);
+  }
+
+  for (int i = 0; i < pPool->max; ++i) {
+    SReadWorker *pWorker = pPool->readWorker + i;
     if (pWorker->thread) {
       pthread_join(pWorker->thread, NULL);
     }
   }
 
-  free(readPool.readWorker);
-  taosCloseQset(readQset);
-  pthread_mutex_destroy(&readPool.mutex);
+  dnodeLogReadWaitHistogram(pPool);
+
+  free(pPool->readWorker);
+  pPool->readWorker = NULL;
+  taosCloseQset(pPool->qset);
+  pthread_mutex_destroy(&pPool->mutex);
+}
+
+void dnodeCleanupVnodeRead() {
+  for (int i = 0; i < TSDB_READ_WORK_TYPES; ++i) {
+    dnodeCleanupReadWorkerPool(readPool + i);
+  }
 
   dInfo("dnode read is closed");
 }
 
+// called with the pool mutex held
+static void dnodeLaunchReadWorker(SReadWorkerPool *pPool) {
+  SReadWorker *pWorker = NULL;
+  for (int i = 0; i < pPool->max; ++i) {
+    if (!pPool->readWorker[i].running) {
+      pWorker = pPool->readWorker + i;
+      break;
+    }
+  }
+
+  if (pWorker == NULL) return;
+
+  // the worker that used the slot has exited
+  if (pWorker->thread) {
+    pthread_join(pWorker->thread, NULL);
+    pWorker->thread = 0;
+  }
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  pWorker->running = 1;
+  int32_t code = pthread_create(&pWorker->thread, &thAttr, dnodeProcessReadQueue, pWorker);
+  if (code != 0) {
+    dError("failed to create thread to process %s read queue, reason:%s", pPool->name, strerror(code));
+    pWorker->running = 0;
+    pWorker->thread = 0;
+  } else {
+    pPool->num++;
+    pPool->adjustTime = taosGetTimestampMs();
+    dDebug("%s read worker:%d is launched, total:%d", pPool->name, pWorker->workerId, pPool->num);
+  }
+
+  pthread_attr_destroy(&thAttr);
+}
+
 void dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg) {
   int32_t     queuedMsgNum = 0;
   int32_t     leftLen      = pMsg->contLen;
@@ -97,9 +203,9 @@ void dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg) {
     pHead->vgId    = htonl(pHead->vgId);
     pHead->contLen = htonl(pHead->contLen);
 
-    taos_queue queue = vnodeAcquireRqueue(pHead->vgId);
+    SVReadQueue *pQueue = vnodeAcquireRqueue(pHead->vgId);
 
-    if (queue == NULL) {
+    if (pQueue == NULL) {
       leftLen -= pHead->contLen;
       pCont -= pHead->contLen;
       continue;
@@ -110,13 +216,16 @@ void dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg) {
     pRead->rpcMsg      = *pMsg;
     pRead->pCont       = pCont;
     pRead->contLen     = pHead->contLen;
+    pRead->queuedTime  = taosGetTimestampUs();
 
     // next vnode
     leftLen -= pHead->contLen;
     pCont -= pHead->contLen;
     queuedMsgNum++;
 
-    taosWriteQitem(queue, TAOS_QTYPE_RPC, pRead);
+    // query creation and retrieve messages are short, the execution of a query is queued by the vnode itself
+    taosWriteQitem(pQueue->queue[TSDB_READ_SHORT_WORK], TAOS_QTYPE_RPC, pRead);
+    dnodeCheckReadWorkers(&readPool[TSDB_READ_SHORT_WORK], 0);
   }
 
   if (queuedMsgNum == 0) {
@@ -133,44 +242,54 @@ void dnodeDispatchToVnodeReadQueue(SRpcMsg *pMsg) {
 }
 
 void *dnodeAllocateVnodeRqueue(void *pVnode) {
-  pthread_mutex_lock(&readPool.mutex);
-  taos_queue queue = taosOpenQueue();
-  if (queue == NULL) {
-    pthread_mutex_unlock(&readPool.mutex);
-    return NULL;
-  }
-
-  taosAddIntoQset(readQset, queue, pVnode);
-
-  // spawn a thread to process queue
-  if (readPool.num < readPool.max) {
-    do {
-      SReadWorker *pWorker = readPool.readWorker + readPool.num;
+  SVReadQueue *pQueue = calloc(1, sizeof(SVReadQueue));
+  if (pQueue == NULL) return NULL;
+
+  for (int i = 0; i < TSDB_READ_WORK_TYPES; ++i) {
+    SReadWorkerPool *pPool = readPool + i;
+
+    pthread_mutex_lock(&pPool->mutex);
+    pQueue->queue[i] = taosOpenQueue();
+    if (pQueue->queue[i] == NULL) {
+      pthread_mutex_unlock(&pPool->mutex);
+      dnodeFreeVnodeRqueue(pQueue);
+      return NULL;
+    }
 
-      pthread_attr_t thAttr;
-      pthread_attr_init(&thAttr);
-      pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+    taosAddIntoQset(pPool->qset, pQueue->queue[i], pVnode);
 
-      if (pthread_create(&pWorker->thread, &thAttr, dnodeProcessReadQueue, pWorker) != 0) {
-        dError("failed to create thread to process read queue, reason:%s", strerror(errno));
-      }
+    // spawn threads to process queue
+    while (pPool->num < pPool->min) {
+      int32_t num = pPool->num;
+      dnodeLaunchReadWorker(pPool);
+      if (pPool->num == num) break;
+    }
 
-      pthread_attr_destroy(&thAttr);
-      readPool.num++;
-      dDebug("read worker:%d is launched, total:%d", pWorker->workerId, readPool.num);
-    } while (readPool.num < readPool.min);
+    pthread_mutex_unlock(&pPool->mutex);
   }
 
-  pthread_mutex_unlock(&readPool.mutex);
-  dDebug("pVnode:%p, read queue:%p is allocated", pVnode, queue);
+  dDebug("pVnode:%p, read queue:%p is allocated", pVnode, pQueue);
 
-  return queue;
+  return pQueue;
 }
 
 void dnodeFreeVnodeRqueue(void *rqueue) {
-  taosCloseQueue(rqueue);
+  SVReadQueue *pQueue = rqueue;
+  if (pQueue == NULL) return;
+
+  for (int i = 0; i < TSDB_READ_WORK_TYPES; ++i) {
+    taosCloseQueue(pQueue->queue[i]);
+  }
+
+  free(pQueue);
+}
+
+void dnodePutItemIntoReadQueue(void *rqueue, void *pRead, int32_t workType) {
+  SVReadQueue *pQueue = rqueue;
 
-  // dynamically adjust the number of threads
+  ((SReadMsg *)pRead)->queuedTime = taosGetTimestampUs();
+  taosWriteQitem(pQueue->queue[workType], TAOS_QTYPE_QUERY, pRead);
+  dnodeCheckReadWorkers(&readPool[workType], 0);
 }
 
 void dnodeSendRpcReadRsp(void *pVnode, SReadMsg *pRead, int32_t code) {
@@ -192,19 +311,57 @@ void dnodeDispatchNonRspMsg(void *pVnode, SReadMsg *pRead, int32_t code) {
   return;
 }
 
+void dnodeGetReadQueueStat(SDnodeReadQueueStat *pStat) {
+  for (int i = 0; i < TSDB_READ_WORK_TYPES; ++i) {
+    SReadWorkerPool *pPool = readPool + i;
+
+    memset(pStat + i, 0, sizeof(SDnodeReadQueueStat));
+    if (pPool->readWorker == NULL) continue;
+
+    pStat[i].workers = pPool->num;
+    pStat[i].queued = taosGetQsetItemsNumber(pPool->qset);
+    for (int j = 0; j < TSDB_READ_WAIT_BUCKETS; ++j) {
+      pStat[i].waitHistogram[j] = atomic_load_64(&pPool->waitHistogram[j]);
+    }
+  }
+}
+
+// bucket i counts the waits shorter than 4^i ms, the last bucket counts the rest
+static void dnodeRecordReadWait(SReadWorkerPool *pPool, int64_t waitUs) {
+  int64_t waitMs = waitUs / 1000;
+  int64_t limit = 1;
+  int32_t bucket = 0;
+
+  while (bucket < TSDB_READ_WAIT_BUCKETS - 1 && waitMs >= limit) {
+    limit *= 4;
+    bucket++;
+  }
+
+  atomic_add_fetch_64(&pPool->waitHistogram[bucket], 1);
+}
+
 static void *dnodeProcessReadQueue(void *param) {
-  SReadMsg    *pReadMsg;
-  int          type;
-  void        *pVnode;
+  SReadWorker     *pWorker = param;
+  SReadWorkerPool *pPool = pWorker->pPool;
+  SReadMsg        *pReadMsg;
+  int              type;
+  void            *pVnode;
 
   while (1) {
-    if (taosReadQitemFromQset(readQset, &type, (void **)&pReadMsg, &pVnode) == 0) {
-      dDebug("dnodeProcessReadQueee: got no message from qset, exiting...");
+    if (taosReadQitemFromQset(pPool->qset, &type, (void **)&pReadMsg, &pVnode) == 0) {
+      dDebug("dnodeProcessReadQueee: %s read worker:%d got no message from qset, exiting...", pPool->name,
+             pWorker->workerId);
       break;
     }
 
-    dDebug("%p, msg:%s will be processed in vread queue, qtype:%d, msg:%p", pReadMsg->rpcMsg.ahandle,
-           taosMsg[pReadMsg->rpcMsg.msgType], type, pReadMsg);
+    int64_t waitUs = taosGetTimestampUs() - pReadMsg->queuedTime;
+    dnodeRecordReadWait(pPool, waitUs);
+
+    atomic_add_fetch_32(&pPool->busy, 1);
+    dnodeCheckReadWorkers(pPool, waitUs);
+
+    dDebug("%p, msg:%s will be processed in vread queue, qtype:%d, msg:%p, wait:%" PRId64 "us",
+           pReadMsg->rpcMsg.ahandle, taosMsg[pReadMsg->rpcMsg.msgType], type, pReadMsg, waitUs);
 
     int32_t code = vnodeProcessRead(pVnode, pReadMsg);
 
@@ -219,23 +376,48 @@ static void *dnodeProcessReadQueue(void *param) {
     }
 
     taosFreeQitem(pReadMsg);
+
+    atomic_sub_fetch_32(&pPool->busy, 1);
+    dnodeHandleIdleReadWorker(pPool);
   }
 
+  pthread_mutex_lock(&pPool->mutex);
+  if (pPool->retiring > 0) pPool->retiring--;
+  pPool->num--;
+  pWorker->running = 0;
+  dDebug("%s read worker:%d is released, total:%d", pPool->name, pWorker->workerId, pPool->num);
+  pthread_mutex_unlock(&pPool->mutex);
+
   return NULL;
 }
 
+static void dnodeCheckReadWorkers(SReadWorkerPool *pPool, int64_t waitUs) {
+  if (pPool->num >= pPool->max) return;
 
-UNUSED_FUNC
-static void dnodeHandleIdleReadWorker(SReadWorker *pWorker) {
-  int32_t num = taosGetQueueNumber(readQset);
+  int32_t queued = taosGetQsetItemsNumber(pPool->qset);
+  int32_t idle = pPool->num - pPool->retiring - pPool->busy;
+  if (queued <= idle && waitUs < DNODE_READ_GROW_WAIT_US) return;
 
-  if (num == 0 || (num <= readPool.min && readPool.num > readPool.min)) {
-    readPool.num--;
-    dDebug("read worker:%d is released, total:%d", pWorker->workerId, readPool.num);
-    pthread_exit(NULL);
-  } else {
-    usleep(30000);
-    sched_yield();
+  pthread_mutex_lock(&pPool->mutex);
+  if (pPool->num < pPool->max) {
+    dDebug("%s read queue, queued:%d idle workers:%d wait:%" PRId64 "us, add a worker", pPool->name, queued, idle,
+           waitUs);
+    dnodeLaunchReadWorker(pPool);
   }
+  pthread_mutex_unlock(&pPool->mutex);
 }
 
+// a retired worker is woken up by a resume of the qset, and exits as it gets no message
+static void dnodeHandleIdleReadWorker(SReadWorkerPool *pPool) {
+  if (pPool->num - pPool->retiring <= pPool->min) return;
+  if (taosGetQsetItemsNumber(pPool->qset) > 0) return;
+
+  pthread_mutex_lock(&pPool->mutex);
+  int64_t now = taosGetTimestampMs();
+  if (pPool->num - pPool->retiring > pPool->min && now - pPool->adjustTime >= DNODE_READ_SHRINK_INTERVAL) {
+    pPool->retiring++;
+    pPool->adjustTime = now;
+    taosQsetThreadResume(pPool->qset);
+  }
+  pthread_mutex_unlock(&pPool->mutex);
+}
@@ -250,7 +250,14 @@ static void *dnodeProcessWriteQueue(void *param) {
       }
     }
 
-    walFsync(vnodeGetWal(pVnode));
+    // a write is only acknowledged once the batch has reached the WAL, if it fails only the
+    // entries above the durable version are failed, the WAL has dropped them
+    int32_t  walCode = walFsync(vnodeGetWal(pVnode));
+    uint64_t walVer = 0;
+    if (walCode != 0) {
+      walVer = walGetDurableVersion(vnodeGetWal(pVnode));
+      dError("failed to write wal, msgs above version %" PRIu64 " are failed, reason:%s", walVer, tstrerror(walCode));
+    }
 
     // browse all items, and process them one by one
     taosResetQitems(pWorker->qall);
@@ -258,10 +265,12 @@ static void *dnodeProcessWriteQueue(void *param) {
       taosGetQitem(pWorker->qall, &type, &item);
       if (type == TAOS_QTYPE_RPC) {
         pWrite = (SWriteMsg *)item;
+        pHead = (SWalHead *)(pWrite->pCont - sizeof(SWalHead));
+        if (walCode != 0 && pWrite->rpcMsg.code >= 0 && pHead->version > walVer) pWrite->rpcMsg.code = walCode;
         dnodeSendRpcVnodeWriteRsp(pVnode, item, pWrite->rpcMsg.code); 
       } else if (type == TAOS_QTYPE_FWD) {
         pHead = (SWalHead *)item;
-        vnodeConfirmForward(pVnode, pHead->version, 0);
+        vnodeConfirmForward(pVnode, pHead->version, (walCode != 0 && pHead->version > walVer) ? walCode : 0);
         taosFreeQitem(item);
         vnodeRelease(pVnode);
       } else {
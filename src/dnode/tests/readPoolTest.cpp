@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "os.h"
+#include "taoserror.h"
+#include "taosmsg.h"
+#include "tglobal.h"
+#include "tqueue.h"
+#include "trpc.h"
+
+extern "C" {
+#include "dnode.h"
+#include "dnodeVRead.h"
+#include "vnode.h"
+}
+
+namespace {
+
+// the messages are held by vnodeProcessRead until the gate opens
+std::mutex              gateMutex;
+std::condition_variable gateCond;
+bool                    gateOpen = true;
+std::atomic<int>        processing(0);
+std::atomic<int>        processed(0);
+std::atomic<int>        peakProcessing(0);
+
+int numOfWorkers(int32_t workType) {
+  SDnodeReadQueueStat stat[TSDB_READ_WORK_TYPES];
+  dnodeGetReadQueueStat(stat);
+  return stat[workType].workers;
+}
+
+bool waitFor(std::function<bool()> cond, int timeoutMs = 5000) {
+  for (int i = 0; i < timeoutMs / 10; ++i) {
+    if (cond()) return true;
+    taosMsleep(10);
+  }
+  return cond();
+}
+
+void setGate(bool open) {
+  std::lock_guard<std::mutex> lock(gateMutex);
+  gateOpen = open;
+  gateCond.notify_all();
+}
+
+}  // namespace
+
+// the vnode functions used by the read workers
+extern "C" {
+void *vnodeAcquireRqueue(int32_t vgId) { return NULL; }
+void  vnodeRelease(void *pVnode) {}
+
+int32_t vnodeProcessRead(void *pVnode, SReadMsg *pRead) {
+  int num = ++processing;
+  int peak = peakProcessing.load();
+  while (num > peak && !peakProcessing.compare_exchange_weak(peak, num)) {
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(gateMutex);
+    gateCond.wait(lock, [] { return gateOpen; });
+  }
+
+  --processing;
+  ++processed;
+  return TSDB_CODE_QRY_NOT_READY;
+}
+}
+
+class ReadPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // the long pool has 2 to 4 workers, the short pool 1 to 2
+    tsNumOfCores = 2;
+    tsNumOfThreadsPerCore = 1.0;
+    processing = 0;
+    processed = 0;
+    peakProcessing = 0;
+    setGate(true);
+
+    ASSERT_EQ(dnodeInitVnodeRead(), 0);
+    rqueue = dnodeAllocateVnodeRqueue(this);
+    ASSERT_NE(rqueue, nullptr);
+  }
+
+  void TearDown() override {
+    setGate(true);
+    dnodeFreeVnodeRqueue(rqueue);
+    dnodeCleanupVnodeRead();
+  }
+
+  void putMsgs(int32_t workType, int num) {
+    for (int i = 0; i < num; ++i) {
+      SReadMsg *pRead = (SReadMsg *)taosAllocateQitem(sizeof(SReadMsg));
+      memset(pRead, 0, sizeof(SReadMsg));
+      dnodePutItemIntoReadQueue(rqueue, pRead, workType);
+    }
+  }
+
+  void *rqueue = NULL;
+};
+
+TEST_F(ReadPoolTest, startWithMinWorkers) {
+  EXPECT_EQ(numOfWorkers(TSDB_READ_LONG_WORK), 2);
+  EXPECT_EQ(numOfWorkers(TSDB_READ_SHORT_WORK), 1);
+
+  putMsgs(TSDB_READ_LONG_WORK, 2);
+  ASSERT_TRUE(waitFor([] { return processed == 2; }));
+
+  // the queued messages never outnumbered the idle workers
+  EXPECT_EQ(numOfWorkers(TSDB_READ_LONG_WORK), 2);
+}
+
+TEST_F(ReadPoolTest, growUpToMaxWorkers) {
+  setGate(false);
+  putMsgs(TSDB_READ_LONG_WORK, 10);
+
+  // the workers are added while the messages queue up behind the busy ones, but no more than the max
+  ASSERT_TRUE(waitFor([] { return processing == 4; }));
+  EXPECT_EQ(numOfWorkers(TSDB_READ_LONG_WORK), 4);
+  EXPECT_EQ(numOfWorkers(TSDB_READ_SHORT_WORK), 1);
+
+  setGate(true);
+  ASSERT_TRUE(waitFor([] { return processed == 10; }));
+  EXPECT_EQ(peakProcessing, 4);
+  EXPECT_EQ(numOfWorkers(TSDB_READ_LONG_WORK), 4);
+}
+
+TEST_F(ReadPoolTest, shrinkBackToMinWorkers) {
+  setGate(false);
+  putMsgs(TSDB_READ_LONG_WORK, 8);
+  ASSERT_TRUE(waitFor([] { return processing == 4; }));
+  setGate(true);
+  ASSERT_TRUE(waitFor([] { return processed == 8; }));
+
+  // a worker retires after a message once the queues are drained, no more than one per interval
+  int expected = 4;
+  for (int i = 0; i < 3; ++i) {
+    taosMsleep(1100);
+
+    int done = processed;
+    putMsgs(TSDB_READ_LONG_WORK, 1);
+    ASSERT_TRUE(waitFor([done] { return processed == done + 1; }));
+
+    expected = MAX(expected - 1, 2);
+    ASSERT_TRUE(waitFor([expected] { return numOfWorkers(TSDB_READ_LONG_WORK) == expected; }))
+        << "workers:" << numOfWorkers(TSDB_READ_LONG_WORK) << " expected:" << expected;
+  }
+
+  EXPECT_EQ(numOfWorkers(TSDB_READ_LONG_WORK), 2);
+}
@@ -22,10 +22,26 @@ extern "C" {
 
 #include "trpc.h"
 
+#define TSDB_READ_SHORT_WORK    0  // retrieve, query creation, tags and last row queries
+#define TSDB_READ_LONG_WORK     1  // execution of the other queries
+#define TSDB_READ_WORK_TYPES    2
+#define TSDB_READ_WAIT_BUCKETS  8
+
+typedef struct {
+  int32_t workers;
+  int32_t queued;
+  int64_t waitHistogram[TSDB_READ_WAIT_BUCKETS];  // bucket i counts waits below 4^i ms, the last one the rest
+} SDnodeReadQueueStat;
+
 typedef struct {
   int32_t queryReqNum;
   int32_t submitReqNum;
   int32_t httpReqNum;
+  int64_t blockCacheHits;
+  int64_t blockCacheMisses;
+  int64_t blockCacheEvictions;
+  int64_t blockCacheSize;
+  SDnodeReadQueueStat readQueue[TSDB_READ_WORK_TYPES];
 } SDnodeStatisInfo;
 
 typedef enum {
@@ -54,6 +70,7 @@ void *dnodeAllocateVnodeWqueue(void *pVnode);
 void  dnodeFreeVnodeWqueue(void *queue);
 void *dnodeAllocateVnodeRqueue(void *pVnode);
 void  dnodeFreeVnodeRqueue(void *rqueue);
+void  dnodePutItemIntoReadQueue(void *rqueue, void *pRead, int32_t workType);
 void  dnodeSendRpcVnodeWriteRsp(void *pVnode, void *param, int32_t code);
 
 int32_t dnodeAllocateMnodePqueue();
@@ -78,6 +78,13 @@ int32_t qKillQuery(qinfo_t qinfo);
 
 int32_t qQueryCompleted(qinfo_t qinfo);
 
+/**
+ * queries of tags or the last row only, which are cheap to execute
+ * @param qinfo
+ * @return
+ */
+bool qIsShortQuery(qinfo_t qinfo);
+
 
 /**
  * destroy query info structure
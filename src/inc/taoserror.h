@@ -101,6 +101,11 @@ TAOS_DEFINE_ERROR(TSDB_CODE_TSC_CONN_KILLED,              0, 0x0215, "Connection
 TAOS_DEFINE_ERROR(TSDB_CODE_TSC_SQL_SYNTAX_ERROR,         0, 0x0216, "Syntax error in SQL")
 TAOS_DEFINE_ERROR(TSDB_CODE_TSC_DB_NOT_SELECTED,          0, 0x0217, "Database not specified or available")
 TAOS_DEFINE_ERROR(TSDB_CODE_TSC_INVALID_TABLE_NAME,       0, 0x0218, "Table does not exist")
+TAOS_DEFINE_ERROR(TSDB_CODE_TSC_LINE_SYNTAX_ERROR,        0, 0x0219, "Syntax error in line protocol")
+TAOS_DEFINE_ERROR(TSDB_CODE_TSC_LINE_INVALID_NAME,        0, 0x021A, "Invalid measurement, tag or field name in line protocol")
+TAOS_DEFINE_ERROR(TSDB_CODE_TSC_LINE_SCHEMA_MISMATCH,     0, 0x021B, "Line protocol value does not match the table schema")
+TAOS_DEFINE_ERROR(TSDB_CODE_TSC_LINE_NO_TAGS,             0, 0x021C, "Line protocol point has no tags")
+TAOS_DEFINE_ERROR(TSDB_CODE_TSC_LINE_INVALID_DB,          0, 0x021D, "Invalid database name in line protocol")
 
 // mnode
 TAOS_DEFINE_ERROR(TSDB_CODE_MND_MSG_NOT_PROCESSED,        0, 0x0300, "Message not processed")
@@ -227,6 +232,8 @@ TAOS_DEFINE_ERROR(TSDB_CODE_QRY_NOT_READY,                0, 0x0707, "Query not
 TAOS_DEFINE_ERROR(TSDB_CODE_QRY_HAS_RSP,                  0, 0x0708, "Query should response")
 TAOS_DEFINE_ERROR(TSDB_CODE_QRY_IN_EXEC,                  0, 0x0709, "Multiple retrieval of this query")
 TAOS_DEFINE_ERROR(TSDB_CODE_QRY_TOO_MANY_TIMEWINDOW,      0, 0x070A, "Too many time window in query")
+TAOS_DEFINE_ERROR(TSDB_CODE_QRY_EXCEED_MEM_LIMIT,         0, 0x070B, "Query memory exceeds the limit")
+TAOS_DEFINE_ERROR(TSDB_CODE_QRY_TOO_MANY_GROUPS,          0, 0x070C, "Too many groups for the query memory budget")
 
 // grant
 TAOS_DEFINE_ERROR(TSDB_CODE_GRANT_EXPIRED,                0, 0x0800, "License expired")
@@ -350,6 +357,10 @@ TAOS_DEFINE_ERROR(TSDB_CODE_HTTP_OP_TAG_VALUE_TOO_LONG,   0, 0x11A4, "tag value
 TAOS_DEFINE_ERROR(TSDB_CODE_HTTP_OP_VALUE_NULL,           0, 0x11A5, "value not find")
 TAOS_DEFINE_ERROR(TSDB_CODE_HTTP_OP_VALUE_TYPE,           0, 0x11A6, "value type should be boolean, number or string")
 
+TAOS_DEFINE_ERROR(TSDB_CODE_HTTP_LINE_DB_NOT_INPUT,       0, 0x11B0, "database name can not be null")
+TAOS_DEFINE_ERROR(TSDB_CODE_HTTP_LINE_DB_TOO_LONG,        0, 0x11B1, "database name too long")
+TAOS_DEFINE_ERROR(TSDB_CODE_HTTP_LINE_INVALID_PRECISION,  0, 0x11B2, "precision should be ns, us, ms or s")
+
 #ifdef TAOS_ERROR_C
 };
 #endif
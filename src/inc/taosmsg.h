@@ -497,6 +497,7 @@ typedef struct SRetrieveTableRsp {
   int16_t precision;
   int64_t offset;     // updated offset value for multi-vnode projection query
   int64_t useconds;
+  int64_t memUsage;   // bytes of memory taken by the query, added in 2.0.5.0
   char    data[];
 } SRetrieveTableRsp;
 
@@ -506,6 +507,11 @@ typedef struct {
   int64_t totalStorage;
   int64_t compStorage;
   int64_t pointsWritten;
+  int64_t rowsAppended;  // rows written to the memtable in key order
+  int64_t rowsInserted;  // out-of-order rows written to the memtable
+  int64_t walReplayEntries;  // WAL entries replayed when the vnode is opened
+  int64_t walReplayBytes;
+  int64_t walReplayTime;     // ms spent in replaying the WAL
   uint8_t status;
   uint8_t role;
   uint8_t replica;
@@ -740,6 +746,7 @@ typedef struct {
   uint32_t queryId;
   int64_t  useconds;
   int64_t  stime;
+  int64_t  memUsage;  // added in 2.0.5.0
 } SQueryDesc;
 
 typedef struct {
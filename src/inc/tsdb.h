@@ -72,6 +72,8 @@ typedef struct {
   int64_t totalStorage;  // total bytes occupie
   int64_t compStorage;
   int64_t pointsWritten;  // total data points written
+  int64_t rowsAppended;   // rows appended to memtable in key order
+  int64_t rowsInserted;   // out-of-order rows inserted into memtable by searching
 } STsdbStat;
 
 typedef void TSDB_REPO_T;  // use void to hide implementation details from outside
@@ -154,6 +156,7 @@ int32_t tsdbInsertData(TSDB_REPO_T *repo, SSubmitMsg *pMsg, SShellSubmitRspMsg *
 // -- FOR QUERY TIME SERIES DATA
 
 typedef void *TsdbQueryHandleT;  // Use void to hide implementation details
+typedef void *TsdbMemSnapshotT;  // snapshot of the memory tables shared by several query handles
 
 // query condition to build vnode iterator
 typedef struct STsdbQueryCond {
@@ -194,6 +197,29 @@ typedef struct {
  */
 TsdbQueryHandleT *tsdbQueryTables(TSDB_REPO_T *tsdb, STsdbQueryCond *pCond, STableGroupInfo *tableInfoGroup, void *qinfo);
 
+/**
+ * Take a snapshot of the memory tables, so that the query handles created with it read the same data in memory
+ *
+ * @param tsdb       tsdb handle
+ * @return           NULL if out of memory
+ */
+TsdbMemSnapshotT tsdbTakeQueryMemSnapshot(TSDB_REPO_T *tsdb);
+
+/**
+ * Release the snapshot, after all the query handles created with it are cleaned up
+ *
+ * @param snapshot
+ */
+void tsdbReleaseQueryMemSnapshot(TsdbMemSnapshotT snapshot);
+
+/**
+ * Same as tsdbQueryTables, but the memory tables are read from the snapshot instead of a snapshot of its own
+ *
+ * @param snapshot   snapshot taken by tsdbTakeQueryMemSnapshot, it must outlive the query handle
+ */
+TsdbQueryHandleT *tsdbQueryTablesInSnapshot(TSDB_REPO_T *tsdb, STsdbQueryCond *pCond, STableGroupInfo *tableInfoGroup,
+                                            void *qinfo, TsdbMemSnapshotT snapshot);
+
 /**
  * Get the last row of the given query time window for all the tables in STableGroupInfo object.
  * Note that only one data block with only row will be returned while invoking retrieve data block function for
@@ -265,6 +291,16 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT *pQueryHandle, SDataSta
  */
 SArray *tsdbRetrieveDataBlock(TsdbQueryHandleT *pQueryHandle, SArray *pColumnIdList);
 
+/**
+ * Check if only the columns in the column id list of the last tsdbRetrieveDataBlock are loaded for current data
+ * block, which is the case for a file block without sub-blocks. The other columns are loaded by the next
+ * tsdbRetrieveDataBlock that requires them.
+ *
+ * @param pQueryHandle      query handle
+ * @return
+ */
+bool tsdbIsDataBlockPartlyLoaded(TsdbQueryHandleT *pQueryHandle);
+
 /**
  * Get the qualified table id for a super table according to the tag query expression.
  * @param stableid. super table sid
@@ -299,6 +335,28 @@ int32_t tsdbGetOneTableGroup(TSDB_REPO_T *tsdb, uint64_t uid, TSKEY startKey, ST
  */
 int32_t tsdbGetTableGroupFromIdList(TSDB_REPO_T* tsdb, SArray* pTableIdList, STableGroupInfo* pGroupInfo);
 
+typedef struct {
+  int64_t blockLoadTime;   // us, loading the data of file blocks
+  int64_t readTime;        // us of blockLoadTime blocked in reading files, i.e. not covered by the prefetch
+  int64_t prefetchBlocks;  // file blocks read ahead
+  int64_t prefetchBytes;
+  int32_t prefetchDepth;   // max number of blocks read ahead of the block being loaded
+} STsdbQueryCost;
+
+/**
+ * add the file I/O cost accumulated by the query handle since the last call to pCost
+ * @param queryHandle
+ * @param pCost
+ */
+void tsdbRetrieveQueryCost(TsdbQueryHandleT queryHandle, STsdbQueryCost *pCost);
+
+/**
+ * get the bytes of the buffers allocated by the query handle, which grows as the tables are scanned
+ * @param queryHandle
+ * @return
+ */
+int64_t tsdbGetQueryHandleMemSize(TsdbQueryHandleT queryHandle);
+
 /**
  * clean up the query handle
  * @param queryHandle
@@ -311,8 +369,33 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle);
  * @param totalPoints. total data point written
  * @param totalStorage. total bytes took by the tsdb
  * @param compStorage. total bytes took by the tsdb after compressed
+ * @param rowsAppended. rows appended to memtable in key order
+ * @param rowsInserted. out-of-order rows inserted to memtable
+ */
+void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage,
+                    int64_t *rowsAppended, int64_t *rowsInserted);
+
+// -- FOR BLOCK CACHE
+
+// statistics of the decompressed block cache shared by all the repositories of a dnode
+typedef struct {
+  int64_t hits;
+  int64_t misses;
+  int64_t evictions;
+  int64_t size;      // bytes of the cached column data
+  int64_t capacity;  // 0 if the cache is disabled
+  int32_t entries;
+} STsdbBlockCacheStat;
+
+/**
+ * init the decompressed block cache, must be called before any repository is opened
+ * @param capacity. max bytes of column data to cache, 0 to disable the cache
+ *
+ * @return 0 for success, -1 for failure and the error number is set
  */
-void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage);
+int32_t tsdbInitBlockCache(int64_t capacity);
+void    tsdbCleanupBlockCache();
+void    tsdbGetBlockCacheStat(STsdbBlockCacheStat *pStat);
 
 #ifdef __cplusplus
 }
@@ -231,6 +231,7 @@
 #define TK_BIN                            305   // bin format data 0b111
 #define TK_FILE                           306
 #define TK_QUESTION                       307   // denoting the placeholder of "?",when invoking statement bind query
+#define TK_HLL                            308   // sql function that is not a keyword, see tSQLExprCreateFunction
 
 #endif
 
@@ -48,9 +48,11 @@ int     walAlter(twalh pWal, const SWalCfg *pCfg);
 void    walClose(twalh);
 int     walRenew(twalh);
 int     walWrite(twalh, SWalHead *);
-void    walFsync(twalh);
+int     walFsync(twalh);
+uint64_t walGetDurableVersion(twalh);
 int     walRestore(twalh, void *pVnode, FWalWrite writeFp);
 int     walGetWalFile(twalh, char *name, uint32_t *index);
+void    walGetRestoreStat(twalh, int64_t *entries, int64_t *bytes, int64_t *elapsed);
 
 extern int wDebugFlag;
 
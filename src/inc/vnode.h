@@ -38,6 +38,7 @@ typedef struct {
   SRspRet  rspRet;
   void    *pCont;
   int32_t  contLen;
+  int64_t  queuedTime;  // us
   SRpcMsg  rpcMsg;
 } SReadMsg;
 
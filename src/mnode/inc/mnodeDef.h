@@ -151,6 +151,11 @@ typedef struct SVgObj {
   int64_t        totalStorage;
   int64_t        compStorage;
   int64_t        pointsWritten;
+  int64_t        rowsAppended;  // rows written to the memtable of the master vnode in key order
+  int64_t        rowsInserted;  // out-of-order rows written to the memtable of the master vnode
+  int64_t        walReplayEntries;  // WAL replayed when the master vnode was opened
+  int64_t        walReplayBytes;
+  int64_t        walReplayTime;
   struct SDbObj *pDb;
   void *         idPool;
 } SVgObj;
@@ -1067,7 +1067,14 @@ static void *sdbWorkerFp(void *param) {
       }
     }
 
-    walFsync(tsSdbObj.wal);
+    // an operation is only confirmed once the batch has reached the WAL, if it fails only the
+    // entries above the durable version are failed, the WAL has dropped them
+    int32_t  walCode = walFsync(tsSdbObj.wal);
+    uint64_t walVer = 0;
+    if (walCode != 0) {
+      walVer = walGetDurableVersion(tsSdbObj.wal);
+      sdbError("failed to write wal, msgs above version %" PRIu64 " are failed, reason:%s", walVer, tstrerror(walCode));
+    }
 
     // browse all items, and process them one by one
     taosResetQitems(tsSdbWriteQall);
@@ -1076,9 +1083,12 @@ static void *sdbWorkerFp(void *param) {
 
       if (type == TAOS_QTYPE_RPC) {
         pOper = (SSdbOper *)item;
+        pHead = (void *)pOper + sizeof(SSdbOper) + SDB_SYNC_HACK;
+        if (walCode != 0 && pOper->retCode == 0 && pHead->version > walVer) pOper->retCode = walCode;
         sdbConfirmForward(NULL, pOper, pOper->retCode);
       } else if (type == TAOS_QTYPE_FWD) {
         pHead = (SWalHead *)item;
+        if (walCode != 0 && pHead->len == 0 && pHead->version > walVer) pHead->len = walCode;
         syncConfirmForward(tsSdbObj.sync, pHead->version, pHead->len);
         taosFreeQitem(item);
       } else {
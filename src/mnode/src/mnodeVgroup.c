@@ -331,6 +331,11 @@ void mnodeUpdateVgroupStatus(SVgObj *pVgroup, SDnodeObj *pDnode, SVnodeLoad *pVl
     pVgroup->totalStorage = htobe64(pVload->totalStorage);
     pVgroup->compStorage = htobe64(pVload->compStorage);
     pVgroup->pointsWritten = htobe64(pVload->pointsWritten);
+    pVgroup->rowsAppended = htobe64(pVload->rowsAppended);
+    pVgroup->rowsInserted = htobe64(pVload->rowsInserted);
+    pVgroup->walReplayEntries = htobe64(pVload->walReplayEntries);
+    pVgroup->walReplayBytes = htobe64(pVload->walReplayBytes);
+    pVgroup->walReplayTime = htobe64(pVload->walReplayTime);
   }
 
   if (pVload->cfgVersion != pVgroup->pDb->cfgVersion || pVload->replica != pVgroup->numOfVnodes) {
@@ -672,6 +677,38 @@ static int32_t mnodeGetVgroupMeta(STableMetaMsg *pMeta, SShowObj *pShow, void *p
     cols++;
   }
 
+  // the rows written to the memtable of the master vnode in key order and out of order
+  pShow->bytes[cols] = 8;
+  pSchema[cols].type = TSDB_DATA_TYPE_BIGINT;
+  strcpy(pSchema[cols].name, "rowsAppended");
+  pSchema[cols].bytes = htons(pShow->bytes[cols]);
+  cols++;
+
+  pShow->bytes[cols] = 8;
+  pSchema[cols].type = TSDB_DATA_TYPE_BIGINT;
+  strcpy(pSchema[cols].name, "rowsInserted");
+  pSchema[cols].bytes = htons(pShow->bytes[cols]);
+  cols++;
+
+  // the WAL replayed when the master vnode was opened, time in ms
+  pShow->bytes[cols] = 8;
+  pSchema[cols].type = TSDB_DATA_TYPE_BIGINT;
+  strcpy(pSchema[cols].name, "replayEntries");
+  pSchema[cols].bytes = htons(pShow->bytes[cols]);
+  cols++;
+
+  pShow->bytes[cols] = 8;
+  pSchema[cols].type = TSDB_DATA_TYPE_BIGINT;
+  strcpy(pSchema[cols].name, "replayBytes");
+  pSchema[cols].bytes = htons(pShow->bytes[cols]);
+  cols++;
+
+  pShow->bytes[cols] = 8;
+  pSchema[cols].type = TSDB_DATA_TYPE_BIGINT;
+  strcpy(pSchema[cols].name, "replayTime");
+  pSchema[cols].bytes = htons(pShow->bytes[cols]);
+  cols++;
+
   pMeta->numOfColumns = htons(cols);
   pShow->numOfColumns = cols;
 
@@ -768,6 +805,26 @@ static int32_t mnodeRetrieveVgroups(SShowObj *pShow, char *data, int32_t rows, v
       cols++;
     }
 
+    pWrite = data + pShow->offset[cols] * rows + pShow->bytes[cols] * numOfRows;
+    *(int64_t *)pWrite = pVgroup->rowsAppended;
+    cols++;
+
+    pWrite = data + pShow->offset[cols] * rows + pShow->bytes[cols] * numOfRows;
+    *(int64_t *)pWrite = pVgroup->rowsInserted;
+    cols++;
+
+    pWrite = data + pShow->offset[cols] * rows + pShow->bytes[cols] * numOfRows;
+    *(int64_t *)pWrite = pVgroup->walReplayEntries;
+    cols++;
+
+    pWrite = data + pShow->offset[cols] * rows + pShow->bytes[cols] * numOfRows;
+    *(int64_t *)pWrite = pVgroup->walReplayBytes;
+    cols++;
+
+    pWrite = data + pShow->offset[cols] * rows + pShow->bytes[cols] * numOfRows;
+    *(int64_t *)pWrite = pVgroup->walReplayTime;
+    cols++;
+
     mnodeDecVgroupRef(pVgroup);
     numOfRows++;
   }
@@ -74,6 +74,7 @@ extern "C" {
 #define TAOS_OS_FUNC_FILE_SENDIFLE
   #define taosFSendFile(outfile, infile, offset, count) taosFSendFileImp(outfile, infile, offset, size)
   #define taosTSendFile(dfd, sfd, offset, size) taosTSendFileImp(dfd, sfd, offset, size)
+#define TAOS_OS_FUNC_FILE_READAHEAD
 
 #define TAOS_OS_FUNC_SEMPHONE
   #define tsem_t dispatch_semaphore_t
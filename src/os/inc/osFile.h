@@ -35,6 +35,16 @@ int     taosFSendFileImp(FILE* out_file, FILE* in_file, int64_t* offset, int32_t
 #define taosTWrite(fd, buf, count) taosTWriteImp(fd, buf, count)
 #define taosLSeek(fd, offset, whence) lseek(fd, offset, whence)
 
+// positional reads, they do not move the file offset so threads can share the fd
+ssize_t taosTPReadImp(int fd, void *buf, size_t count, int64_t offset);
+ssize_t taosTPReadvImp(int fd, struct iovec *iov, int iovcnt, int64_t offset);
+#define taosTPRead(fd, buf, count, offset) taosTPReadImp(fd, buf, count, offset)
+#define taosTPReadv(fd, iov, iovcnt, offset) taosTPReadvImp(fd, iov, iovcnt, offset)
+
+// ask the kernel to read the range into the page cache in the background, it is only a hint
+int32_t taosReadAheadImp(int fd, int64_t offset, int64_t len);
+#define taosReadAhead(fd, offset, len) taosReadAheadImp(fd, offset, len)
+
 #ifdef TAOS_RANDOM_FILE_FAIL
   void taosSetRandomFileFailFactor(int factor);
   void taosSetRandomFileFailOutput(const char *path);
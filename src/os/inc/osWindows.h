@@ -67,6 +67,12 @@ extern "C" {
 #define TAOS_OS_FUNC_FILE_GETTMPFILEPATH
 #define TAOS_OS_FUNC_FILE_FTRUNCATE
   extern int taosFtruncate(int fd, int64_t length); 
+#define TAOS_OS_FUNC_FILE_PREAD
+  struct iovec {
+    void * iov_base;
+    size_t iov_len;
+  };
+#define TAOS_OS_FUNC_FILE_READAHEAD
 
 #define TAOS_OS_FUNC_MATH
   #define SWAP(a, b, c)      \
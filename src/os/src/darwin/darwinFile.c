@@ -57,4 +57,10 @@ int taosFSendFileImp(FILE* out_file, FILE* in_file, int64_t* offset, int32_t cou
 ssize_t taosTSendFileImp(int dfd, int sfd, off_t *offset, size_t size) {
   uError("not implemented yet");
   return -1;
-}
\ No newline at end of file
+}
+int32_t taosReadAheadImp(int fd, int64_t offset, int64_t len) {
+  struct radvisory ra;
+  ra.ra_offset = (off_t)offset;
+  ra.ra_count = (int)len;
+  return fcntl(fd, F_RDADVISE, &ra);
+}
@@ -88,6 +88,73 @@ ssize_t taosTReadImp(int fd, void *buf, size_t count) {
   return (ssize_t)count;
 }
 
+#ifndef TAOS_OS_FUNC_FILE_PREAD
+ssize_t taosTPReadImp(int fd, void *buf, size_t count, int64_t offset) {
+  size_t  leftbytes = count;
+  ssize_t readbytes;
+  char *  tbuf = (char *)buf;
+
+  while (leftbytes > 0) {
+    readbytes = pread(fd, (void *)tbuf, leftbytes, (off_t)offset);
+    if (readbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else {
+        return -1;
+      }
+    } else if (readbytes == 0) {
+      return (ssize_t)(count - leftbytes);
+    }
+
+    leftbytes -= readbytes;
+    tbuf += readbytes;
+    offset += readbytes;
+  }
+
+  return (ssize_t)count;
+}
+
+// NOTE: the iov array is modified when the read is short
+ssize_t taosTPReadvImp(int fd, struct iovec *iov, int iovcnt, int64_t offset) {
+  ssize_t total = 0;
+
+  while (iovcnt > 0) {
+    ssize_t readbytes = preadv(fd, iov, iovcnt, (off_t)offset);
+    if (readbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else {
+        return -1;
+      }
+    } else if (readbytes == 0) {
+      return total;
+    }
+
+    total += readbytes;
+    offset += readbytes;
+
+    // skip the filled buffers and continue with the rest
+    while (iovcnt > 0 && (size_t)readbytes >= iov->iov_len) {
+      readbytes -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = (char *)iov->iov_base + readbytes;
+      iov->iov_len -= readbytes;
+    }
+  }
+
+  return total;
+}
+#endif
+
+#ifndef TAOS_OS_FUNC_FILE_READAHEAD
+int32_t taosReadAheadImp(int fd, int64_t offset, int64_t len) {
+  return posix_fadvise(fd, (off_t)offset, (off_t)len, POSIX_FADV_WILLNEED);
+}
+#endif
+
 ssize_t taosTWriteImp(int fd, void *buf, size_t n) {
   size_t  nleft = n;
   ssize_t nwritten = 0;
@@ -83,4 +83,23 @@ ssize_t taosTSendFileImp(int dfd, int sfd, off_t *offset, size_t size) {
 int taosFtruncate(int fd, int64_t length) {
   uError("taosFtruncate no implemented yet");
   return 0;
-}
\ No newline at end of file
+}
+
+// not atomic, the fd can not be shared by threads on windows
+ssize_t taosTPReadImp(int fd, void *buf, size_t count, int64_t offset) {
+  if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+  return taosTReadImp(fd, buf, count);
+}
+
+ssize_t taosTPReadvImp(int fd, struct iovec *iov, int iovcnt, int64_t offset) {
+  ssize_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    ssize_t readbytes = taosTPReadImp(fd, iov[i].iov_base, iov[i].iov_len, offset + total);
+    if (readbytes < 0) return -1;
+    total += readbytes;
+    if ((size_t)readbytes < iov[i].iov_len) break;
+  }
+  return total;
+}
+
+int32_t taosReadAheadImp(int fd, int64_t offset, int64_t len) { return 0; }
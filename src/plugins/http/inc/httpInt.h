@@ -46,7 +46,8 @@ typedef enum HttpReqType {
   HTTP_REQTYPE_LOGIN = 1,
   HTTP_REQTYPE_HEARTBEAT = 2,
   HTTP_REQTYPE_SINGLE_SQL = 3,
-  HTTP_REQTYPE_MULTI_SQL = 4
+  HTTP_REQTYPE_MULTI_SQL = 4,
+  HTTP_REQTYPE_LINE = 5
 } HttpReqType;
 
 typedef enum {
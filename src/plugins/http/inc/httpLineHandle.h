@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_LINE_HANDLE_H
+#define TDENGINE_LINE_HANDLE_H
+
+#include "http.h"
+#include "httpInt.h"
+#include "httpUtil.h"
+#include "httpResp.h"
+
+#define LINE_ROOT_URL_POS       0
+#define LINE_DB_URL_POS         1
+#define LINE_PRECISION_URL_POS  2
+
+void lineInitHandle(HttpServer *pServer);
+
+bool lineProcessRequest(struct HttpContext *pContext);
+
+/*
+ * parse and write the points in one of the http worker threads, since it waits for the response of the vnodes
+ */
+void lineProcessCmd(struct HttpContext *pContext);
+
+#endif
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taosdef.h"
+#include "taoserror.h"
+#include "httpInt.h"
+#include "httpContext.h"
+#include "httpLineHandle.h"
+#include "httpQueue.h"
+#include "httpRestJson.h"
+#include "httpSession.h"
+#include "tscLineProtocol.h"
+#include "cJSON.h"
+
+/*
+ * POST /line/<db>[/<precision>] writes the points in the body into the database without building any sql string.
+ *
+ * the body is either the influxdb line protocol, one point per line, with the timestamps in nanoseconds by default:
+ *   cpu,host=server01,region=us-west usage_idle=98.5,usage_user=1i 1600000000000000000
+ *
+ * or the json of telegraf, with the timestamps in seconds by default:
+ *   {"name": "cpu", "timestamp": 1600000000, "tags": {"host": "server01"}, "fields": {"usage_idle": 98.5}}
+ *   {"metrics": [{...}, {...}]}
+ */
+
+static HttpDecodeMethod lineDecodeMethod = {"line", lineProcessRequest};
+static HttpEncodeMethod lineEncodeMethod = {
+  .startJsonFp          = restStartSqlJson,
+  .stopJsonFp           = restStopSqlJson,
+  .buildQueryJsonFp     = NULL,
+  .buildAffectRowJsonFp = restBuildSqlAffectRowsJson,
+  .initJsonFp           = NULL,
+  .cleanJsonFp          = NULL,
+  .checkFinishedFp      = NULL,
+  .setNextCmdFp         = NULL
+};
+
+typedef struct {
+  SLinePoint *points;
+  int32_t     numOfPoints;
+  int32_t     numOfAlloc;
+} SLinePoints;
+
+void lineInitHandle(HttpServer *pServer) { httpAddMethod(pServer, &lineDecodeMethod); }
+
+static int64_t lineGetTsUnit(HttpContext *pContext, int64_t defaultUnit) {
+  HttpParser *pParser = pContext->parser;
+  if (pParser->path[LINE_PRECISION_URL_POS].pos <= 0) {
+    return defaultUnit;
+  }
+
+  char *precision = pParser->path[LINE_PRECISION_URL_POS].str;
+  if (strcmp(precision, "ns") == 0) {
+    return 1;
+  } else if (strcmp(precision, "us") == 0) {
+    return 1000;
+  } else if (strcmp(precision, "ms") == 0) {
+    return 1000000;
+  } else if (strcmp(precision, "s") == 0) {
+    return 1000000000;
+  }
+
+  return -1;
+}
+
+static SLinePoint *lineNewPoint(SLinePoints *pPoints) {
+  if (pPoints->numOfPoints >= pPoints->numOfAlloc) {
+    int32_t     size = (pPoints->numOfAlloc == 0) ? 64 : pPoints->numOfAlloc * 2;
+    SLinePoint *tmp = realloc(pPoints->points, size * sizeof(SLinePoint));
+    if (tmp == NULL) {
+      return NULL;
+    }
+
+    pPoints->points = tmp;
+    pPoints->numOfAlloc = size;
+  }
+
+  SLinePoint *pPoint = pPoints->points + pPoints->numOfPoints++;
+  memset(pPoint, 0, sizeof(SLinePoint));
+  return pPoint;
+}
+
+static void lineFreePoints(SLinePoints *pPoints) {
+  for (int32_t i = 0; i < pPoints->numOfPoints; ++i) {
+    tscDestroyLinePoint(pPoints->points + i);
+  }
+
+  taosTFree(pPoints->points);
+}
+
+static int32_t lineParseText(HttpContext *pContext, char *body, int64_t tsUnit, SLinePoints *pPoints) {
+  int32_t lineNo = 0;
+  char *  line = body;
+
+  while (line != NULL && *line != 0) {
+    char *  next = strchr(line, '\n');
+    int32_t len = (next == NULL) ? (int32_t)strlen(line) : (int32_t)(next - line);
+    ++lineNo;
+
+    while (len > 0 && (*line == ' ' || *line == '\t')) {
+      ++line;
+      --len;
+    }
+
+    // the empty lines and the comments
+    if (len > 0 && *line != '#' && *line != '\r') {
+      SLinePoint *pPoint = lineNewPoint(pPoints);
+      if (pPoint == NULL) {
+        return TSDB_CODE_HTTP_NO_ENOUGH_MEMORY;
+      }
+
+      int32_t code = tscParseLine(line, len, tsUnit, pPoint);
+      if (code != TSDB_CODE_SUCCESS) {
+        httpError("context:%p, fd:%d, failed to parse line:%d, code:%s", pContext, pContext->fd, lineNo,
+                  tstrerror(code));
+        return code;
+      }
+    }
+
+    line = (next == NULL) ? NULL : next + 1;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t lineAddJsonKv(SLinePoint *pPoint, cJSON *item, bool isTag) {
+  if (item->string == NULL || strlen(item->string) == 0) {
+    return isTag ? TSDB_CODE_HTTP_TG_TAG_NAME_NULL : TSDB_CODE_HTTP_TG_FIELD_NAME_NULL;
+  }
+
+  if (strlen(item->string) >= TSDB_COL_NAME_LEN) {
+    return isTag ? TSDB_CODE_HTTP_TG_TAG_NAME_SIZE : TSDB_CODE_HTTP_TG_FIELD_NAME_SIZE;
+  }
+
+  // the null values are absent
+  if (item->type == cJSON_NULL) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  SLineKv *pKv = tscAddLineKv(pPoint, isTag);
+  if (pKv == NULL) {
+    return TSDB_CODE_HTTP_NO_ENOUGH_MEMORY;
+  }
+
+  strtolower(item->string, item->string);
+  pKv->key = item->string;
+  pKv->keyLen = (int16_t)strlen(item->string);
+
+  if (item->type == cJSON_True || item->type == cJSON_False) {
+    pKv->type = TSDB_DATA_TYPE_BOOL;
+    pKv->i = (item->type == cJSON_True);
+  } else if (item->type == cJSON_Number) {
+    // the numbers of json are all double, so that a column keeps the same type whatever the values are
+    pKv->type = TSDB_DATA_TYPE_DOUBLE;
+    pKv->d = item->valuedouble;
+  } else if (item->type == cJSON_String) {
+    size_t len = strlen(item->valuestring);
+    if (len > TSDB_MAX_BINARY_LEN) {
+      return isTag ? TSDB_CODE_HTTP_TG_TAG_VALUE_TYPE : TSDB_CODE_HTTP_TG_FIELD_VALUE_TYPE;
+    }
+
+    pKv->type = TSDB_DATA_TYPE_BINARY;
+    pKv->s = item->valuestring;
+    pKv->len = (int16_t)len;
+  } else {
+    return isTag ? TSDB_CODE_HTTP_TG_TAG_VALUE_TYPE : TSDB_CODE_HTTP_TG_FIELD_VALUE_TYPE;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t lineParseJsonMetric(cJSON *metric, int64_t tsUnit, SLinePoints *pPoints) {
+  cJSON *name = cJSON_GetObjectItem(metric, "name");
+  if (name == NULL || name->type != cJSON_String || name->valuestring == NULL || strlen(name->valuestring) == 0) {
+    return TSDB_CODE_HTTP_TG_METRIC_NAME_NULL;
+  }
+
+  if (strlen(name->valuestring) >= TSDB_TABLE_NAME_LEN) {
+    return TSDB_CODE_HTTP_TG_METRIC_NAME_LONG;
+  }
+
+  cJSON *timestamp = cJSON_GetObjectItem(metric, "timestamp");
+  if (timestamp == NULL) {
+    return TSDB_CODE_HTTP_TG_TIMESTAMP_NULL;
+  }
+
+  if (timestamp->type != cJSON_Number) {
+    return TSDB_CODE_HTTP_TG_TIMESTAMP_TYPE;
+  }
+
+  if (timestamp->valueint <= 0 || timestamp->valueint > INT64_MAX / tsUnit) {
+    return TSDB_CODE_HTTP_TG_TIMESTAMP_VAL_NULL;
+  }
+
+  cJSON *tags = cJSON_GetObjectItem(metric, "tags");
+  if (tags == NULL || tags->type != cJSON_Object) {
+    return TSDB_CODE_HTTP_TG_TAGS_NULL;
+  }
+
+  int32_t numOfTags = cJSON_GetArraySize(tags);
+  if (numOfTags <= 0) {
+    return TSDB_CODE_HTTP_TG_TAGS_SIZE_0;
+  }
+
+  if (numOfTags > TSDB_MAX_TAGS) {
+    return TSDB_CODE_HTTP_TG_TAGS_SIZE_LONG;
+  }
+
+  cJSON *fields = cJSON_GetObjectItem(metric, "fields");
+  if (fields == NULL || fields->type != cJSON_Object) {
+    return TSDB_CODE_HTTP_TG_FIELDS_NULL;
+  }
+
+  int32_t numOfFields = cJSON_GetArraySize(fields);
+  if (numOfFields <= 0) {
+    return TSDB_CODE_HTTP_TG_FIELDS_SIZE_0;
+  }
+
+  if (numOfFields >= TSDB_MAX_COLUMNS) {
+    return TSDB_CODE_HTTP_TG_FIELDS_SIZE_LONG;
+  }
+
+  SLinePoint *pPoint = lineNewPoint(pPoints);
+  if (pPoint == NULL) {
+    return TSDB_CODE_HTTP_NO_ENOUGH_MEMORY;
+  }
+
+  strtolower(name->valuestring, name->valuestring);
+  pPoint->stable = name->valuestring;
+  pPoint->stableLen = (int16_t)strlen(name->valuestring);
+  pPoint->ts = (int64_t)timestamp->valueint * tsUnit;
+
+  for (int32_t i = 0; i < numOfTags; ++i) {
+    int32_t code = lineAddJsonKv(pPoint, cJSON_GetArrayItem(tags, i), true);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  for (int32_t i = 0; i < numOfFields; ++i) {
+    int32_t code = lineAddJsonKv(pPoint, cJSON_GetArrayItem(fields, i), false);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  return tscSortLineTags(pPoint);
+}
+
+static int32_t lineParseJson(cJSON *root, int64_t tsUnit, SLinePoints *pPoints) {
+  cJSON *metrics = cJSON_GetObjectItem(root, "metrics");
+  if (metrics == NULL) {
+    return lineParseJsonMetric(root, tsUnit, pPoints);
+  }
+
+  int32_t size = cJSON_GetArraySize(metrics);
+  if (size <= 0) {
+    return TSDB_CODE_HTTP_TG_METRICS_NULL;
+  }
+
+  for (int32_t i = 0; i < size; ++i) {
+    cJSON *metric = cJSON_GetArrayItem(metrics, i);
+    if (metric == NULL) {
+      continue;
+    }
+
+    int32_t code = lineParseJsonMetric(metric, tsUnit, pPoints);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void lineSendAffectRowsResp(HttpContext *pContext, int32_t affectedRows) {
+  HttpEncodeMethod *encode = pContext->encodeMethod;
+  HttpSqlCmd *      cmd = &pContext->singleCmd;
+
+  (encode->startJsonFp)(pContext, cmd, NULL);
+  (encode->buildAffectRowJsonFp)(pContext, cmd, affectedRows);
+  (encode->stopJsonFp)(pContext, cmd);
+
+  httpCloseContextByApp(pContext);
+}
+
+static void lineProcessInsert(void *param, void *result, int32_t numOfRows) {
+  HttpContext *pContext = param;
+  HttpParser * pParser = pContext->parser;
+
+  char *  db = pParser->path[LINE_DB_URL_POS].str;
+  char *  body = pParser->body.str;
+  cJSON * root = NULL;
+  int32_t affectedRows = 0;
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  SLinePoints points = {0};
+
+  while (*body == ' ' || *body == '\t' || *body == '\r' || *body == '\n') {
+    ++body;
+  }
+
+  if (*body == '{') {
+    // the names and values of the points refer to the json, which is kept until the points are written
+    root = cJSON_Parse(body);
+    code = (root == NULL) ? TSDB_CODE_HTTP_TG_INVALID_JSON : lineParseJson(root, lineGetTsUnit(pContext, 1000000000), &points);
+  } else {
+    code = lineParseText(pContext, body, lineGetTsUnit(pContext, 1), &points);
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscInsertLinePoints(pContext->session->taos, db, points.points, points.numOfPoints, &affectedRows);
+  }
+
+  httpDebug("context:%p, fd:%d, user:%s, write %d points into db:%s, affected rows:%d, code:%s", pContext,
+            pContext->fd, pContext->user, points.numOfPoints, db, affectedRows, tstrerror(code));
+
+  lineFreePoints(&points);
+  cJSON_Delete(root);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    httpSendErrorResp(pContext, code);
+  } else {
+    lineSendAffectRowsResp(pContext, affectedRows);
+  }
+}
+
+void lineProcessCmd(HttpContext *pContext) { httpDispatchToResultQueue(pContext, NULL, 0, lineProcessInsert); }
+
+bool lineProcessRequest(struct HttpContext *pContext) {
+  if (strlen(pContext->user) == 0 || strlen(pContext->pass) == 0) {
+    httpSendErrorResp(pContext, TSDB_CODE_HTTP_NO_AUTH_INFO);
+    return false;
+  }
+
+  HttpParser *pParser = pContext->parser;
+  if (pParser->path[LINE_DB_URL_POS].pos <= 0) {
+    httpSendErrorResp(pContext, TSDB_CODE_HTTP_LINE_DB_NOT_INPUT);
+    return false;
+  }
+
+  if (pParser->path[LINE_DB_URL_POS].pos >= TSDB_DB_NAME_LEN) {
+    httpSendErrorResp(pContext, TSDB_CODE_HTTP_LINE_DB_TOO_LONG);
+    return false;
+  }
+
+  if (lineGetTsUnit(pContext, 1) < 0) {
+    httpSendErrorResp(pContext, TSDB_CODE_HTTP_LINE_INVALID_PRECISION);
+    return false;
+  }
+
+  if (pParser->body.str == NULL) {
+    httpSendErrorResp(pContext, TSDB_CODE_HTTP_NO_MSG_INPUT);
+    return false;
+  }
+
+  httpDebug("context:%p, fd:%d, user:%s, process line msg, db:%s", pContext, pContext->fd, pContext->user,
+            pParser->path[LINE_DB_URL_POS].str);
+
+  pContext->reqType = HTTP_REQTYPE_LINE;
+  pContext->encodeMethod = &lineEncodeMethod;
+  return true;
+}
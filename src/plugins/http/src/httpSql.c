@@ -26,6 +26,7 @@
 #include "httpAuth.h"
 #include "httpSession.h"
 #include "httpQueue.h"
+#include "httpLineHandle.h"
 
 void *taos_connect_a(char *ip, char *user, char *pass, char *db, uint16_t port, void (*fp)(void *, TAOS_RES *, int),
                      void *param, void **taos);
@@ -366,6 +367,9 @@ void httpExecCmd(HttpContext *pContext) {
     case HTTP_REQTYPE_HEARTBEAT:
       httpProcessHeartBeatCmd(pContext);
       break;
+    case HTTP_REQTYPE_LINE:
+      lineProcessCmd(pContext);
+      break;
     case HTTP_REQTYPE_OTHERS:
       httpCloseContextByApp(pContext);
       break;
@@ -30,6 +30,7 @@
 #include "httpGcHandle.h"
 #include "httpRestHandle.h"
 #include "httpTgHandle.h"
+#include "httpLineHandle.h"
 
 #ifndef _ADMIN
 void adminInitHandle(HttpServer* pServer) {}
@@ -55,6 +56,7 @@ int32_t httpInitSystem() {
   adminInitHandle(&tsHttpServer);
   gcInitHandle(&tsHttpServer);
   tgInitHandle(&tsHttpServer);
+  lineInitHandle(&tsHttpServer);
   opInitHandle(&tsHttpServer);
 
   return 0;
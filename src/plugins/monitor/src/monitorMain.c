@@ -47,6 +47,11 @@ typedef enum {
   MON_CMD_CREATE_TB_DN,
   MON_CMD_CREATE_TB_ACCT_ROOT,
   MON_CMD_CREATE_TB_SLOWQUERY,
+  MON_CMD_CREATE_MT_BLOCK_CACHE,
+  MON_CMD_CREATE_TB_BLOCK_CACHE,
+  MON_CMD_CREATE_MT_READ_QUEUE,
+  MON_CMD_CREATE_TB_READ_QUEUE_SHORT,
+  MON_CMD_CREATE_TB_READ_QUEUE_LONG,
   MON_CMD_MAX
 } EMonitorCommand;
 
@@ -224,6 +229,27 @@ static void monitorBuildMonitorSql(char *sql, int32_t cmd) {
              "create table if not exists %s.slowquery(ts timestamp, username "
              "binary(%d), created_time timestamp, time bigint, sql binary(%d))",
              tsMonitorDbName, TSDB_TABLE_FNAME_LEN - 1, TSDB_SLOW_QUERY_SQL_LEN);
+  } else if (cmd == MON_CMD_CREATE_MT_BLOCK_CACHE) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.blockcache(ts timestamp"
+             ", hits bigint, misses bigint, evictions bigint, size bigint"
+             ") tags (dnodeid int, fqdn binary(%d))",
+             tsMonitorDbName, TSDB_FQDN_LEN);
+  } else if (cmd == MON_CMD_CREATE_TB_BLOCK_CACHE) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.blockcache_dn%d using %s.blockcache tags(%d, '%s')",
+             tsMonitorDbName, dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MON_CMD_CREATE_MT_READ_QUEUE) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.readqueue(ts timestamp"
+             ", workers int, queued int"
+             ", wait_1ms bigint, wait_4ms bigint, wait_16ms bigint, wait_64ms bigint"
+             ", wait_256ms bigint, wait_1s bigint, wait_4s bigint, wait_more bigint"
+             ") tags (dnodeid int, fqdn binary(%d), work binary(8))",
+             tsMonitorDbName, TSDB_FQDN_LEN);
+  } else if (cmd == MON_CMD_CREATE_TB_READ_QUEUE_SHORT || cmd == MON_CMD_CREATE_TB_READ_QUEUE_LONG) {
+    const char *work = (cmd == MON_CMD_CREATE_TB_READ_QUEUE_SHORT) ? "short" : "long";
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.readqueue_%s_dn%d using %s.readqueue tags(%d, '%s', '%s')",
+             tsMonitorDbName, work, dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp, work);
   } else if (cmd == MON_CMD_CREATE_TB_LOG) {
     snprintf(sql, SQL_LENGTH,
              "create table if not exists %s.log(ts timestamp, level tinyint, "
@@ -300,9 +326,8 @@ static int32_t monitorBuildBandSql(char *sql) {
   return sprintf(sql, ", %f", bandSpeedKb);
 }
 
-static int32_t monitorBuildReqSql(char *sql) {
-  SDnodeStatisInfo info = dnodeGetStatisInfo();
-  return sprintf(sql, ", %d, %d, %d)", info.httpReqNum, info.queryReqNum, info.submitReqNum);
+static int32_t monitorBuildReqSql(char *sql, SDnodeStatisInfo *pInfo) {
+  return sprintf(sql, ", %d, %d, %d)", pInfo->httpReqNum, pInfo->queryReqNum, pInfo->submitReqNum);
 }
 
 static int32_t monitorBuildIoSql(char *sql) {
@@ -315,9 +340,55 @@ static int32_t monitorBuildIoSql(char *sql) {
   return sprintf(sql, ", %f, %f", readKB, writeKB);
 }
 
+// hits, misses and evictions are accumulated since taosd starts, size is in bytes
+static void monitorSaveBlockCacheInfo(int64_t ts, SDnodeStatisInfo *pInfo) {
+  char *sql = tsMonitor.sql;
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.blockcache_dn%d values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ")",
+           tsMonitorDbName, dnodeGetDnodeId(), ts, pInfo->blockCacheHits, pInfo->blockCacheMisses,
+           pInfo->blockCacheEvictions, pInfo->blockCacheSize);
+
+  void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
+  int   code = taos_errno(res);
+  taos_free_result(res);
+
+  if (code != 0) {
+    monitorError("failed to save block cache info, reason:%s, sql:%s", tstrerror(code), tsMonitor.sql);
+  } else {
+    monitorDebug("successfully to save block cache info, sql:%s", tsMonitor.sql);
+  }
+}
+
+// the wait time histograms are accumulated since taosd starts
+static void monitorSaveReadQueueInfo(int64_t ts, SDnodeStatisInfo *pInfo) {
+  for (int32_t i = 0; i < TSDB_READ_WORK_TYPES; ++i) {
+    SDnodeReadQueueStat *pStat = pInfo->readQueue + i;
+    char *               sql = tsMonitor.sql;
+
+    int32_t pos = snprintf(sql, SQL_LENGTH, "insert into %s.readqueue_%s_dn%d values(%" PRId64 ", %d, %d",
+                           tsMonitorDbName, (i == TSDB_READ_SHORT_WORK) ? "short" : "long", dnodeGetDnodeId(), ts,
+                           pStat->workers, pStat->queued);
+    for (int32_t j = 0; j < TSDB_READ_WAIT_BUCKETS; ++j) {
+      pos += snprintf(sql + pos, SQL_LENGTH - pos, ", %" PRId64, pStat->waitHistogram[j]);
+    }
+    snprintf(sql + pos, SQL_LENGTH - pos, ")");
+
+    void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
+    int   code = taos_errno(res);
+    taos_free_result(res);
+
+    if (code != 0) {
+      monitorError("failed to save read queue info, reason:%s, sql:%s", tstrerror(code), tsMonitor.sql);
+    } else {
+      monitorDebug("successfully to save read queue info, sql:%s", tsMonitor.sql);
+    }
+  }
+}
+
 static void monitorSaveSystemInfo() {
-  int64_t ts = taosGetTimestampUs();
-  char *  sql = tsMonitor.sql;
+  int64_t          ts = taosGetTimestampUs();
+  char *           sql = tsMonitor.sql;
+  SDnodeStatisInfo info = dnodeGetStatisInfo();
   int32_t pos = snprintf(sql, SQL_LENGTH, "insert into %s.dn%d values(%" PRId64, tsMonitorDbName, dnodeGetDnodeId(), ts);
 
   pos += monitorBuildCpuSql(sql + pos);
@@ -325,7 +396,7 @@ static void monitorSaveSystemInfo() {
   pos += monitorBuildDiskSql(sql + pos);
   pos += monitorBuildBandSql(sql + pos);
   pos += monitorBuildIoSql(sql + pos);
-  pos += monitorBuildReqSql(sql + pos);
+  pos += monitorBuildReqSql(sql + pos, &info);
 
   void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
   int   code = taos_errno(res);
@@ -336,6 +407,9 @@ static void monitorSaveSystemInfo() {
   } else {
     monitorDebug("successfully to save system info, sql:%s", tsMonitor.sql);
   }
+
+  monitorSaveBlockCacheInfo(ts, &info);
+  monitorSaveReadQueueInfo(ts, &info);
 }
 
 static void montiorExecSqlCb(void *param, TAOS_RES *result, int32_t code) {
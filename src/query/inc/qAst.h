@@ -30,6 +30,7 @@ extern "C" {
 
 struct tExprNode;
 struct SSchema;
+struct tQueryInfo;
 
 enum {
   TSQL_NODE_DUMMY = 0x0,
@@ -40,6 +41,7 @@ enum {
 
 typedef bool (*__result_filter_fn_t)(const void *, void *);
 typedef void (*__do_filter_suppl_fn_t)(void *, void *);
+typedef bool (*__index_query_fn_t)(void *, struct tQueryInfo *, SArray *);
 
 /**
  * this structure is used to filter data in tags, so the offset of filtered tag column in tagdata string is required
@@ -53,9 +55,11 @@ typedef struct tQueryInfo {
 } tQueryInfo;
 
 typedef struct SExprTraverseSupp {
-  __result_filter_fn_t   nodeFilterFn;
+  __result_filter_fn_t   nodeFilterFn;  // called with the table to check
   __do_filter_suppl_fn_t setupInfoFn;
   void *                 pExtInfo;
+  __index_query_fn_t     indexQueryFn;  // query a leaf by a tag index, returns false if no index serves it
+  void *                 pIndexInfo;
 } SExprTraverseSupp;
 
 typedef struct tExprNode {
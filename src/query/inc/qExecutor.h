@@ -71,9 +71,28 @@ typedef struct SResultRec {
   int32_t threshold;  // result size threshold in rows.
 } SResultRec;
 
+/*
+ * Open addressing hash table from the fixed-width keys (integers and timestamps) to the result slots. It takes the
+ * place of SHashObj when the window results are keyed by such values, so that looking up the group of a row costs no
+ * key copy, no lock and no allocation of a hash node.
+ */
+typedef struct SGroupKeyHash {
+  int64_t* keys;
+  int32_t* slots;     // result slot of the key, -1 for an empty entry
+  int32_t  capacity;  // power of 2
+  int32_t  size;
+  int32_t  shift;     // 64 - log2(capacity)
+} SGroupKeyHash;
+
 typedef struct SWindowResInfo {
   SWindowResult* pResult;    // result list
-  SHashObj*      hashList;   // hash list for quick access
+  SHashObj*      hashList;   // hash list for quick access of binary/nchar keys
+  SGroupKeyHash  keyHash;    // hash list for quick access of the other keys
+  SArray*        pInfoBuf;   // memory chunks that the SResultInfo of the results are allocated from
+  char*          pFreeInfo;  // free space of the last chunk
+  int32_t        numOfFreeInfo;
+  SQueryMemAcct* pMemAcct;   // memory accounting of the query
+  int64_t        resultSize; // bytes of pResult accounted in pMemAcct
   int16_t        type;       // data type for hash key
   int32_t        capacity;   // max capacity
   int32_t        curIndex;   // current start active index
@@ -84,6 +103,22 @@ typedef struct SWindowResInfo {
   int64_t        interval;   // time window interval
 } SWindowResInfo;
 
+/*
+ * The states of the groups of a group by on a normal column are spilled to the partitions of a disk based buffer by
+ * the hash of their keys when they outgrow the memory budget. Once the data is scanned, the partitions are merged and
+ * returned one after another. A spilled record holds the key, and the SResultInfo, the intermediate buffer and the
+ * output value of each function of the group.
+ */
+typedef struct SGroupSpillInfo {
+  SDiskbasedResultBuf* pBuf;
+  int32_t              keySize;
+  int32_t              recordSize;
+  int32_t              numOfPartitions;
+  int32_t              nextPartition;  // the next partition to merge
+  bool                 merging;        // no more groups are spilled once the partitions are merged
+  int64_t              numOfSpilled;   // number of records spilled
+} SGroupSpillInfo;
+
 typedef struct SColumnFilterElem {
   int16_t           bytes;  // column length
   __filter_func_t   fp;
@@ -92,6 +127,7 @@ typedef struct SColumnFilterElem {
 
 typedef struct SSingleColumnFilterInfo {
   void*              pData;
+  bool               hasNull;   // false if the current data block has no NULL value in this column
   int32_t            numOfFilters;
   SColumnInfo        info;
   SColumnFilterElem* pFilters;
@@ -123,10 +159,17 @@ typedef struct SQueryCostInfo {
   uint32_t loadBlocks;
   uint32_t loadBlockStatis;
   uint32_t discardBlocks;
+  uint32_t qualifiedBlocks;  // blocks whose rows all satisfy the filters, known from the block statistics
+  uint32_t partialLoadBlocks;  // blocks whose filter columns are loaded and evaluated before the other columns
   uint64_t elapsedTime;
   uint64_t firstStageMergeTime;
   uint64_t internalSupSize;
   uint64_t numOfTimeWindows;
+  uint64_t loadStallTime;    // the part of loadFileBlockTime blocked in reading files
+  uint64_t prefetchBlocks;
+  uint64_t prefetchSize;
+  uint32_t prefetchDepth;    // max number of file blocks read ahead of the block being loaded
+  uint32_t scanWorkers;      // number of workers scanning the tables in parallel
 } SQueryCostInfo;
 
 typedef struct SQuery {
@@ -163,6 +206,7 @@ typedef struct SQueryRuntimeEnv {
   SQLFunctionCtx*      pCtx;
   int32_t              numOfRowsPerPage;
   int16_t              offset[TSDB_MAX_COLUMNS];
+  int8_t               colHasNull[TSDB_MAX_COLUMNS];  // NULL flag of each column of the current data block
   uint16_t             scanFlag;         // denotes reversed scan of data or not
   SFillInfo*           pFillInfo;
   SWindowResInfo       windowResInfo;
@@ -173,11 +217,16 @@ typedef struct SQueryRuntimeEnv {
   void*                pSecQueryHandle;  // another thread for
   bool                 stableQuery;      // super table query or not
   bool                 topBotQuery;      // false
+  bool                 allRowsQualified; // all rows of the current data block satisfy the filters
+  int8_t*              pFilterSel;       // selection vector of the current data block by its filter columns, or NULL
   bool                 groupbyNormalCol; // denote if this is a groupby normal column query
   bool                 hasTagResults;    // if there are tag values in final result or not
   int32_t              interBufSize;     // intermediate buffer sizse
   int32_t              prevGroupId;      // previous executed group id
   SDiskbasedResultBuf* pResultBuf;       // query result buffer based on blocked-wised disk file
+  SGroupSpillInfo*     pGroupSpill;      // the spilled states of a group by on a normal column, NULL if none
+  SQueryMemAcct*       pMemAcct;         // memory accounting of the query, shared with the scan workers
+  int64_t              tsdbMemSize;      // bytes of the buffers of pQueryHandle accounted in pMemAcct
 } SQueryRuntimeEnv;
 
 enum {
@@ -187,6 +236,7 @@ enum {
 
 typedef struct SQInfo {
   void*            signature;
+  struct SQInfo*   pParent;  // the query that a scan worker belongs to, NULL for the query itself
   int32_t          code;   // error code to returned to client
   int64_t          owner; // if it is in execution
   void*            tsdb;
@@ -194,6 +244,7 @@ typedef struct SQInfo {
   STableGroupInfo  tableGroupInfo;       // table <tid, last_key> list  SArray<STableKeyInfo>
   STableGroupInfo  tableqinfoGroupInfo;  // this is a group array list, including SArray<STableQueryInfo*> structure
   SQueryRuntimeEnv runtimeEnv;
+  SQueryMemAcct    memAcct;
   SArray*          arrTableIdInfo;
   int32_t          groupIndex;
 
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_QHLL_H
+#define TDENGINE_QHLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+#define HLL_BUCKET_BITS 12  // the standard error is 1.04/sqrt(HLL_BUCKETS), about 1.6%
+#define HLL_BUCKETS     (1 << HLL_BUCKET_BITS)
+
+/*
+ * HyperLogLog sketch of the distinct values of a column. It is a plain array of registers, so that it can be
+ * shipped as the intermediate result of a query and two sketches are merged by taking the maximum of each register.
+ */
+typedef struct SHllInfo {
+  uint8_t buckets[HLL_BUCKETS];  // the maximum rank of the hashes that fall into each bucket
+} SHllInfo;
+
+void    tHllAdd(SHllInfo* pHll, const void* data, int32_t len);
+void    tHllMerge(SHllInfo* pDst, const SHllInfo* pSrc);
+int64_t tHllCount(const SHllInfo* pHll);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_QHLL_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_QMEMACCT_H
+#define TDENGINE_QMEMACCT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+/*
+ * Memory accounting of one query, shared by the query and its scan workers. Above the budget the disk based result
+ * buffers flush pages to disk instead of taking more memory. Above the limit the allocations still succeed, but the
+ * limit is marked as exceeded and the query fails at the next data block.
+ */
+typedef struct SQueryMemAcct {
+  int64_t used;      // bytes in use
+  int64_t peak;      // max bytes in use
+  int64_t budget;    // soft limit in bytes, 0 for no budget
+  int64_t limit;     // hard limit in bytes, 0 for no limit
+  int8_t  exceeded;  // the hard limit has been exceeded
+} SQueryMemAcct;
+
+void qInitMemAcct(SQueryMemAcct *pAcct, int64_t budget, int64_t limit);
+
+/**
+ * account the memory of size bytes, returns false if the hard limit is exceeded
+ */
+bool qAcquireMem(SQueryMemAcct *pAcct, int64_t size);
+
+void qReleaseMem(SQueryMemAcct *pAcct, int64_t size);
+
+/**
+ * check if the budget is exceeded after size bytes more memory is taken
+ */
+bool qMemOverBudget(SQueryMemAcct *pAcct, int64_t size);
+
+bool qMemLimitExceeded(SQueryMemAcct *pAcct);
+
+int64_t qGetMemUsage(SQueryMemAcct *pAcct);
+
+/**
+ * allocate and free the memory accounted in pAcct, pAcct may be NULL
+ */
+void *qMemCalloc(SQueryMemAcct *pAcct, size_t size);
+
+void qMemFree(SQueryMemAcct *pAcct, void *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_QMEMACCT_H
@@ -64,7 +64,7 @@ typedef struct tMemBucket {
   __perc_hash_func_t hashFunc;
 } tMemBucket;
 
-tMemBucket *tMemBucketCreate(int16_t nElemSize, int16_t dataType, double minval, double maxval);
+tMemBucket *tMemBucketCreate(int16_t nElemSize, int16_t dataType, double minval, double maxval, SQueryMemAcct *pMemAcct);
 
 void tMemBucketDestroy(tMemBucket *pBucket);
 
@@ -72,4 +72,14 @@ int32_t tMemBucketPut(tMemBucket *pBucket, const void *data, size_t size);
 
 double getPercentile(tMemBucket *pMemBucket, double percent);
 
+/**
+ * exact percentile of the values in a contiguous buffer of the given type, by selection instead of buckets
+ * @param pData   the values, reordered in place
+ * @param num
+ * @param type
+ * @param percent in [0, 100]
+ * @return        the same value as getPercentile
+ */
+double tPercentileSelect(void *pData, int64_t num, int16_t type, double percent);
+
 #endif  // TDENGINE_QPERCENTILE_H
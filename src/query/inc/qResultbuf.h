@@ -24,6 +24,7 @@ extern "C" {
 #include "hash.h"
 #include "os.h"
 #include "qExtbuffer.h"
+#include "qMemAcct.h"
 #include "tlockfree.h"
 
 typedef struct SArray* SIDList;
@@ -72,6 +73,7 @@ typedef struct SDiskbasedResultBuf {
   SArray*   pFree;               // free area in file
   bool      comp;                // compressed before flushed to disk
   int32_t   nextPos;             // next page flush position
+  SQueryMemAcct* pMemAcct;       // memory accounting of the query the pages belong to, may be NULL
 
   const void*      handle;       // for debug purpose
   SResultBufStatis statis;
@@ -90,7 +92,7 @@ typedef struct SDiskbasedResultBuf {
  * @return
  */
 int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t rowSize, int32_t pagesize,
-                                    int32_t inMemBufSize, const void* handle);
+                                    int32_t inMemBufSize, const void* handle, SQueryMemAcct* pMemAcct);
 
 /**
  *
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_QTDIGEST_H
+#define TDENGINE_QTDIGEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+#define TDIGEST_COMPRESSION    400
+#define TDIGEST_MAX_CENTROIDS  (TDIGEST_COMPRESSION + 2)  // no more than compression + 1 centroids after merge
+#define TDIGEST_BATCH_SIZE     1024                       // number of values sorted and merged at a time
+
+typedef struct SCentroid {
+  double  mean;
+  int64_t weight;
+} SCentroid;
+
+/*
+ * merging t-digest, the centroids are kept in the order of their means. It holds no pointers, so that it can be
+ * shipped as the intermediate result of a query as is.
+ */
+typedef struct STDigest {
+  int64_t   total;
+  double    min;
+  double    max;
+  int32_t   numOfCentroids;
+  SCentroid centroids[TDIGEST_MAX_CENTROIDS];
+} STDigest;
+
+void tTDigestInit(STDigest *pDigest);
+
+/**
+ * add a batch of values, the values are sorted in place
+ * @param pDigest
+ * @param vals
+ * @param num     no more than TDIGEST_BATCH_SIZE is suggested, larger batches are not less accurate but slower
+ */
+void tTDigestAddBatch(STDigest *pDigest, double *vals, int32_t num);
+
+void tTDigestMerge(STDigest *pDst, const STDigest *pSrc);
+
+/**
+ * @param pDigest
+ * @param q       the quantile in [0, 1]
+ * @return        NAN if the digest is empty
+ */
+double tTDigestQuantile(const STDigest *pDigest, double q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_QTDIGEST_H
@@ -20,6 +20,11 @@ int32_t getOutputInterResultBufSize(SQuery* pQuery);
 void clearTimeWindowResBuf(SQueryRuntimeEnv* pRuntimeEnv, SWindowResult* pOneOutputRes);
 void copyTimeWindowResBuf(SQueryRuntimeEnv* pRuntimeEnv, SWindowResult* dst, const SWindowResult* src);
 
+int32_t *getWindowResSlot(SWindowResInfo *pWindowResInfo, const char *pData, int16_t bytes);
+int32_t  putWindowResSlot(SWindowResInfo *pWindowResInfo, const char *pData, int16_t bytes, int32_t slot);
+char *   allocWindowResultInfo(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo);
+int64_t  getGroupStateSize(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int16_t keyBytes);
+
 int32_t initWindowResInfo(SWindowResInfo* pWindowResInfo, SQueryRuntimeEnv* pRuntimeEnv, int32_t size,
                           int32_t threshold, int16_t type);
 
@@ -43,7 +48,7 @@ static FORCE_INLINE SWindowResult *getWindowResult(SWindowResInfo *pWindowResInf
 
 bool isWindowResClosed(SWindowResInfo *pWindowResInfo, int32_t slot);
 
-int32_t createQueryResultInfo(SQuery *pQuery, SWindowResult *pResultRow, bool isSTableQuery, size_t interBufSize);
+int32_t createQueryResultInfo(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, SWindowResult *pResultRow);
 
 static FORCE_INLINE char *getPosInResultPage(SQueryRuntimeEnv *pRuntimeEnv, int32_t columnIndex, SWindowResult *pResult,
     tFilePage* page) {
@@ -62,4 +67,6 @@ bool notNull_filter(SColumnFilterElem *pFilter, char* minval, char* maxval);
 __filter_func_t *getRangeFilterFuncArray(int32_t type);
 __filter_func_t *getValueFilterFuncArray(int32_t type);
 
+void doFilterColumnDataBlock(SSingleColumnFilterInfo *pFilterInfo, int32_t numOfRows, int8_t *pSel, int8_t *pBuf);
+
 #endif  // TDENGINE_QUERYUTIL_H
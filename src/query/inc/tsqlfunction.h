@@ -111,6 +111,10 @@ extern "C" {
 #define MAX_INTERVAL_TIME_WINDOW 1000000  // maximum allowed time windows in final results
 #define TOP_BOTTOM_QUERY_LIMIT   100
 
+// the algorithms of apercentile, selected by the optional third parameter
+#define APERCT_ALGO_HISTOGRAM    0  // "default"
+#define APERCT_ALGO_TDIGEST      1  // "t-digest", more accurate at the tails
+
 enum {
   MASTER_SCAN           = 0x0u,
   REVERSE_SCAN          = 0x1u,
@@ -192,6 +196,7 @@ typedef struct SQLFunctionCtx {
   SResultInfo *resultInfo;
 
   SExtTagsInfo tagInfo;
+  struct SQueryMemAcct *pMemAcct;  // memory accounting of the query, NULL if the memory is not accounted
 } SQLFunctionCtx;
 
 typedef struct SQLAggFuncElem {
@@ -265,6 +270,10 @@ extern int32_t functionCompatList[]; // compatible check array list
 
 bool topbot_datablock_filter(SQLFunctionCtx *pCtx, int32_t functionId, const char *minval, const char *maxval);
 
+// the state of a group of these functions is a fixed size value, the states of the same group can be merged
+bool isGroupStateMergeable(int32_t functionId);
+void mergeGroupState(SQLFunctionCtx *pCtx, const SResultInfo *pSrcInfo, const char *pSrcOutput);
+
 /**
  * the numOfRes should be kept, since it may be used later
  * and allow the ResultInfo to be re initialized
@@ -530,80 +530,81 @@ static void tQueryIndexColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo, SArr
   tSkipListDestroyIter(iter);
 }
 
+static int32_t compareTableKeyInfoByAddr(const void *p1, const void *p2) {
+  const STableKeyInfo *pInfo1 = p1;
+  const STableKeyInfo *pInfo2 = p2;
+
+  if (pInfo1->pTable == pInfo2->pTable) {
+    return 0;
+  }
+
+  return (pInfo1->pTable < pInfo2->pTable) ? -1 : 1;
+}
+
+/*
+ * The union of the qualified tables of two branches, both the arrays are sorted according to the table address and
+ * the duplicated tables are removed.
+ */
 int32_t merge(SArray *pLeft, SArray *pRight, SArray *pFinalRes) {
-//  assert(pFinalRes->pRes == 0);
-//
-//  pFinalRes->pRes = calloc((size_t)(pLeft->num + pRight->num), POINTER_BYTES);
-//  pFinalRes->num = 0;
-//
-//  // sort according to address
-//  tSkipListNode **pLeftNodes = (tSkipListNode **)pLeft->pRes;
-//  qsort(pLeftNodes, pLeft->num, sizeof(pLeft->pRes[0]), compareByAddr);
-//
-//  tSkipListNode **pRightNodes = (tSkipListNode **)pRight->pRes;
-//  qsort(pRightNodes, pRight->num, sizeof(pRight->pRes[0]), compareByAddr);
-//
-//  int32_t i = 0, j = 0;
-//
-//  // merge two sorted arrays in O(n) time
-//  while (i < pLeft->num && j < pRight->num) {
-//    int64_t ret = (int64_t)pLeftNodes[i] - (int64_t)pRightNodes[j];
-//
-//    if (ret < 0) {
-//      pFinalRes->pRes[pFinalRes->num++] = pLeftNodes[i++];
-//    } else if (ret > 0) {
-//      pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j++];
-//    } else {  // pNode->key > pkey[i]
-//      pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j++];
-//      i++;
-//    }
-//  }
-//
-//  while (i < pLeft->num) {
-//    pFinalRes->pRes[pFinalRes->num++] = pLeftNodes[i++];
-//  }
-//
-//  while (j < pRight->num) {
-//    pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j++];
-//  }
-//
-//  return pFinalRes->num;
-  return 0;
+  taosArraySort(pLeft, compareTableKeyInfoByAddr);
+  taosArraySort(pRight, compareTableKeyInfoByAddr);
+
+  size_t  lsize = taosArrayGetSize(pLeft);
+  size_t  rsize = taosArrayGetSize(pRight);
+  int32_t i = 0, j = 0;
+
+  // merge two sorted arrays in O(n) time
+  while (i < lsize || j < rsize) {
+    STableKeyInfo *pInfo = NULL;
+
+    if (j >= rsize) {
+      pInfo = taosArrayGet(pLeft, i++);
+    } else if (i >= lsize) {
+      pInfo = taosArrayGet(pRight, j++);
+    } else {
+      int32_t ret = compareTableKeyInfoByAddr(taosArrayGet(pLeft, i), taosArrayGet(pRight, j));
+      if (ret < 0) {
+        pInfo = taosArrayGet(pLeft, i++);
+      } else if (ret > 0) {
+        pInfo = taosArrayGet(pRight, j++);
+      } else {
+        pInfo = taosArrayGet(pLeft, i++);
+        j++;
+      }
+    }
+
+    size_t size = taosArrayGetSize(pFinalRes);
+    if (size == 0 || ((STableKeyInfo *)taosArrayGet(pFinalRes, size - 1))->pTable != pInfo->pTable) {
+      taosArrayPush(pFinalRes, pInfo);
+    }
+  }
+
+  return (int32_t)taosArrayGetSize(pFinalRes);
 }
 
 int32_t intersect(SArray *pLeft, SArray *pRight, SArray *pFinalRes) {
-//  int64_t num = MIN(pLeft->num, pRight->num);
-//
-//  assert(pFinalRes->pRes == 0);
-//
-//  pFinalRes->pRes = calloc(num, POINTER_BYTES);
-//  pFinalRes->num = 0;
-//
-//  // sort according to address
-//  tSkipListNode **pLeftNodes = (tSkipListNode **)pLeft->pRes;
-//  qsort(pLeftNodes, pLeft->num, sizeof(pLeft->pRes[0]), compareByAddr);
-//
-//  tSkipListNode **pRightNodes = (tSkipListNode **)pRight->pRes;
-//  qsort(pRightNodes, pRight->num, sizeof(pRight->pRes[0]), compareByAddr);
-//
-//  int32_t i = 0, j = 0;
-//  // merge two sorted arrays in O(n) time
-//  while (i < pLeft->num && j < pRight->num) {
-//    int64_t ret = (int64_t)pLeftNodes[i] - (int64_t)pRightNodes[j];
-//
-//    if (ret < 0) {
-//      i++;
-//    } else if (ret > 0) {
-//      j++;
-//    } else {  // pNode->key > pkey[i]
-//      pFinalRes->pRes[pFinalRes->num++] = pRightNodes[j];
-//      i++;
-//      j++;
-//    }
-//  }
-//
-//  return pFinalRes->num;
- return 0;
+  taosArraySort(pLeft, compareTableKeyInfoByAddr);
+  taosArraySort(pRight, compareTableKeyInfoByAddr);
+
+  size_t  lsize = taosArrayGetSize(pLeft);
+  size_t  rsize = taosArrayGetSize(pRight);
+  int32_t i = 0, j = 0;
+
+  // merge two sorted arrays in O(n) time
+  while (i < lsize && j < rsize) {
+    int32_t ret = compareTableKeyInfoByAddr(taosArrayGet(pLeft, i), taosArrayGet(pRight, j));
+    if (ret < 0) {
+      i++;
+    } else if (ret > 0) {
+      j++;
+    } else {
+      taosArrayPush(pFinalRes, taosArrayGet(pLeft, i));
+      i++;
+      j++;
+    }
+  }
+
+  return (int32_t)taosArrayGetSize(pFinalRes);
 }
 
 /*
@@ -613,9 +614,9 @@ static void tArrayTraverse(tExprNode *pExpr, __result_filter_fn_t fp, SArray *pR
   assert(pExpr->_node.pLeft->nodeType == TSQL_NODE_COL && pExpr->_node.pRight->nodeType == TSQL_NODE_VALUE && fp != NULL);
 
   //  scan the result array list and check for each item in the list
-  for (int32_t i = 0; i < taosArrayGetSize(pResult); ++i) {
-    void* item = taosArrayGet(pResult, i);
-    if (fp(item, pExpr->_node.info)) {
+  for (int32_t i = 0; i < taosArrayGetSize(pResult);) {
+    STableKeyInfo* pInfo = taosArrayGet(pResult, i);
+    if (fp(pInfo->pTable, pExpr->_node.info)) {
       i++;
     } else {
       taosArrayRemove(pResult, i);
@@ -665,12 +666,12 @@ static bool filterItem(tExprNode *pExpr, const void *pItem, SExprTraverseSupp *p
 static void exprTreeTraverseImpl(tExprNode *pExpr, SArray *pResult, SExprTraverseSupp *param) {
   size_t size = taosArrayGetSize(pResult);
   
-  SArray* array = taosArrayInit(size, POINTER_BYTES);
+  SArray* array = taosArrayInit(size, sizeof(STableKeyInfo));
   for (int32_t i = 0; i < size; ++i) {
-    void *pItem = taosArrayGetP(pResult, i);
+    STableKeyInfo *pInfo = taosArrayGet(pResult, i);
 
-    if (filterItem(pExpr, pItem, param)) {
-      taosArrayPush(array, &pItem);
+    if (filterItem(pExpr, pInfo->pTable, param)) {
+      taosArrayPush(array, pInfo);
     }
   }
   
@@ -683,8 +684,10 @@ static void tSQLBinaryTraverseOnSkipList(tExprNode *pExpr, SArray *pResult, SSki
 
   while (tSkipListIterNext(iter)) {
     SSkipListNode *pNode = tSkipListIterGet(iter);
-    if (filterItem(pExpr, pNode, param)) {
-      taosArrayPush(pResult, SL_GET_NODE_DATA(pNode));
+    void *         pTable = *(void **)SL_GET_NODE_DATA(pNode);
+    if (filterItem(pExpr, pTable, param)) {
+      STableKeyInfo info = {.pTable = pTable, .lastKey = TSKEY_INITIAL_VAL};
+      taosArrayPush(pResult, &info);
     }
   }
   tSkipListDestroyIter(iter);
@@ -709,7 +712,7 @@ static void tQueryIndexlessColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo,
         addToResult = !pQueryInfo->compare(name, pQueryInfo->q);
       }
     } else {
-      addToResult = filterFp(pNode, pQueryInfo);
+      addToResult = filterFp(*(void**) pData, pQueryInfo);
     }
 
     if (addToResult) {
@@ -721,12 +724,75 @@ static void tQueryIndexlessColumn(SSkipList* pSkipList, tQueryInfo* pQueryInfo,
   tSkipListDestroyIter(iter);
 }
 
+/*
+ * Evaluate the expression by the tag indexes. A conjunction is served if either of its children is, and the tables
+ * qualified by that child are then filtered by the other one; a disjunction is served only if both children are.
+ * The result is not touched if the expression can not be served.
+ */
+static bool tExprTreeIndexTraverse(tExprNode *pExpr, SSkipList *pSkipList, SArray *result, SExprTraverseSupp *param) {
+  tExprNode *pLeft  = pExpr->_node.pLeft;
+  tExprNode *pRight = pExpr->_node.pRight;
+
+  if (pLeft->nodeType == TSQL_NODE_COL && pRight->nodeType == TSQL_NODE_VALUE) {
+    param->setupInfoFn(pExpr, param->pExtInfo);
+
+    tQueryInfo *pQueryInfo = pExpr->_node.info;
+    int32_t     optr = pQueryInfo->optr;
+    if (pQueryInfo->indexed && optr >= TSDB_RELATION_LESS && optr <= TSDB_RELATION_GREATER_EQUAL) {
+      tQueryIndexColumn(pSkipList, pQueryInfo, result);
+      return true;
+    }
+
+    return param->indexQueryFn(param->pIndexInfo, pQueryInfo, result);
+  }
+
+  if (pLeft->nodeType != TSQL_NODE_EXPR || pRight->nodeType != TSQL_NODE_EXPR) {
+    return false;
+  }
+
+  if (pExpr->_node.optr == TSDB_RELATION_AND) {
+    if (tExprTreeIndexTraverse(pLeft, pSkipList, result, param)) {
+      exprTreeTraverseImpl(pRight, result, param);
+      return true;
+    }
+
+    if (tExprTreeIndexTraverse(pRight, pSkipList, result, param)) {
+      exprTreeTraverseImpl(pLeft, result, param);
+      return true;
+    }
+
+    return false;
+  }
+
+  if (pExpr->_node.optr != TSDB_RELATION_OR) {
+    return false;
+  }
+
+  SArray *rLeft  = taosArrayInit(10, sizeof(STableKeyInfo));
+  SArray *rRight = taosArrayInit(10, sizeof(STableKeyInfo));
+
+  bool ret = tExprTreeIndexTraverse(pLeft, pSkipList, rLeft, param) &&
+             tExprTreeIndexTraverse(pRight, pSkipList, rRight, param);
+  if (ret) {
+    merge(rLeft, rRight, result);
+  }
+
+  taosArrayDestroy(rLeft);
+  taosArrayDestroy(rRight);
+  return ret;
+}
+
 // post-root order traverse syntax tree
 void tExprTreeTraverse(tExprNode *pExpr, SSkipList *pSkipList, SArray *result, SExprTraverseSupp *param) {
   if (pExpr == NULL) {
     return;
   }
 
+  if (pSkipList != NULL && param->indexQueryFn != NULL && taosArrayGetSize(result) == 0 &&
+      tExprTreeIndexTraverse(pExpr, pSkipList, result, param)) {
+    return;
+  }
+
   tExprNode *pLeft  = pExpr->_node.pLeft;
   tExprNode *pRight = pExpr->_node.pRight;
 
@@ -773,8 +839,8 @@ void tExprTreeTraverse(tExprNode *pExpr, SSkipList *pSkipList, SArray *result, S
   }
   
   if (weight == 2 || (weight == 1 && pExpr->_node.optr == TSDB_RELATION_OR)) {
-    SArray* rLeft  = taosArrayInit(10, POINTER_BYTES);
-    SArray* rRight = taosArrayInit(10, POINTER_BYTES);
+    SArray* rLeft  = taosArrayInit(10, sizeof(STableKeyInfo));
+    SArray* rRight = taosArrayInit(10, sizeof(STableKeyInfo));
 
     tExprTreeTraverse(pLeft, pSkipList, rLeft, param);
     tExprTreeTraverse(pRight, pSkipList, rRight, param);
@@ -27,9 +27,15 @@
 #include "query.h"
 #include "queryLog.h"
 #include "tlosertree.h"
+#include "tsched.h"
 
 #define MAX_ROWS_PER_RESBUF_PAGE  ((1u<<12) - 1)
 
+#define GROUPRESULTID             1   // the pages of the groups of a group by on a normal column in pResultBuf
+#define GROUP_SPILL_PARTITIONS    32
+#define GROUP_SPILL_PAGE_RECORDS  16  // the minimum number of spilled records of a page
+#define GROUP_SPILL_ALIGN(_n)     (((_n) + 7) & ~7)
+
 /**
  * check if the primary column is load by default, otherwise, the program will
  * forced to load primary column explicitly.
@@ -183,8 +189,9 @@ static void setWindowResOutputBufInitCtx(SQueryRuntimeEnv *pRuntimeEnv, SWindowR
 static void resetMergeResultBuf(SQuery *pQuery, SQLFunctionCtx *pCtx, SResultInfo *pResultInfo);
 static bool functionNeedToExecute(SQueryRuntimeEnv *pRuntimeEnv, SQLFunctionCtx *pCtx, int32_t functionId);
 
-static void setExecParams(SQuery *pQuery, SQLFunctionCtx *pCtx, void* inputData, TSKEY *tsCol, SDataBlockInfo* pBlockInfo,
-                          SDataStatis *pStatis, void *param, int32_t colIndex);
+static int32_t getNumOfScanWorkers(SQInfo *pQInfo);
+static void setExecParams(SQueryRuntimeEnv *pRuntimeEnv, SQLFunctionCtx *pCtx, void* inputData, TSKEY *tsCol,
+                          SDataBlockInfo* pBlockInfo, SDataStatis *pStatis, void *param, int32_t colIndex);
 
 static void initCtxOutputBuf(SQueryRuntimeEnv *pRuntimeEnv);
 static void destroyTableQueryInfoImpl(STableQueryInfo *pTableQueryInfo);
@@ -194,18 +201,19 @@ static void buildTagQueryResult(SQInfo *pQInfo);
 
 static int32_t setAdditionalInfo(SQInfo *pQInfo, void *pTable, STableQueryInfo *pTableQueryInfo);
 static int32_t flushFromResultBuf(SQueryRuntimeEnv* pRuntimeEnv, SGroupResInfo* pGroupResInfo);
+static void cleanupQueryHandle(SQueryRuntimeEnv *pRuntimeEnv, TsdbQueryHandleT pQueryHandle);
 
 bool doFilterData(SQuery *pQuery, int32_t elemPos) {
   for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
     SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
 
     char *pElem = (char*)pFilterInfo->pData + pFilterInfo->info.bytes * elemPos;
+    bool  isnull = pFilterInfo->hasNull && isNull(pElem, pFilterInfo->info.type);
 
     bool qualified = false;
     for (int32_t j = 0; j < pFilterInfo->numOfFilters; ++j) {
       SColumnFilterElem *pFilterElem = &pFilterInfo->pFilters[j];
 
-      bool isnull = isNull(pElem, pFilterInfo->info.type);
       if (isnull) {
         if (pFilterElem->fp == isNull_filter) {
           qualified = true;
@@ -236,6 +244,24 @@ bool doFilterData(SQuery *pQuery, int32_t elemPos) {
   return true;
 }
 
+/*
+ * Evaluate the filters over the first numOfRows rows of the data block column by column, returns the selection
+ * vector in which the rows that satisfy all the filters are 1, or NULL if out of memory.
+ */
+static int8_t *doFilterDataBlock(SQuery *pQuery, int32_t numOfRows) {
+  int8_t *pSel = malloc((size_t)numOfRows * 2);
+  if (pSel == NULL) {
+    return NULL;
+  }
+
+  memset(pSel, 1, (size_t)numOfRows);
+  for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
+    doFilterColumnDataBlock(&pQuery->pFilterInfo[k], numOfRows, pSel, pSel + numOfRows);
+  }
+
+  return pSel;
+}
+
 int64_t getNumOfResult(SQueryRuntimeEnv *pRuntimeEnv) {
   SQuery *pQuery = pRuntimeEnv->pQuery;
   bool    hasMainFunction = hasMainOutput(pQuery);
@@ -308,11 +334,10 @@ bool isGroupbyNormalCol(SSqlGroupbyExpr *pGroupbyExpr) {
   return false;
 }
 
-int16_t getGroupbyColumnType(SQuery *pQuery, SSqlGroupbyExpr *pGroupbyExpr) {
+static SColumnInfo *getGroupbyColumnInfo(SQuery *pQuery, SSqlGroupbyExpr *pGroupbyExpr) {
   assert(pGroupbyExpr != NULL);
 
   int32_t colId = -2;
-  int16_t type = TSDB_DATA_TYPE_NULL;
 
   for (int32_t i = 0; i < pGroupbyExpr->numOfGroupCols; ++i) {
     SColIndex *pColIndex = taosArrayGet(pGroupbyExpr->columnInfo, i);
@@ -324,12 +349,16 @@ int16_t getGroupbyColumnType(SQuery *pQuery, SSqlGroupbyExpr *pGroupbyExpr) {
 
   for (int32_t i = 0; i < pQuery->numOfCols; ++i) {
     if (colId == pQuery->colList[i].colId) {
-      type = pQuery->colList[i].type;
-      break;
+      return &pQuery->colList[i];
     }
   }
 
-  return type;
+  return NULL;
+}
+
+int16_t getGroupbyColumnType(SQuery *pQuery, SSqlGroupbyExpr *pGroupbyExpr) {
+  SColumnInfo *pColInfo = getGroupbyColumnInfo(pQuery, pGroupbyExpr);
+  return (pColInfo != NULL) ? pColInfo->type : TSDB_DATA_TYPE_NULL;
 }
 
 bool isSelectivityWithTagsQuery(SQuery *pQuery) {
@@ -445,11 +474,96 @@ static bool hasNullValue(SColIndex* pColIndex, SDataStatis *pStatis, SDataStatis
   return true;
 }
 
-static SWindowResult *doSetTimeWindowFromKey(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, char *pData,
-                                             int16_t bytes, bool masterscan) {
+enum {
+  COL_NULL_UNKNOWN = -1,
+  COL_NULL_NONE    = 0,
+  COL_NULL_EXIST   = 1,
+};
+
+static void resetColumnNullFlag(SQueryRuntimeEnv *pRuntimeEnv, SArray *pDataBlock) {
+  if (pDataBlock != NULL) {
+    memset(pRuntimeEnv->colHasNull, COL_NULL_UNKNOWN, taosArrayGetSize(pDataBlock));
+  }
+}
+
+/**
+ * Blocks merged from the cache and the files, and blocks with sub-blocks, carry no statistics. Such a column is
+ * checked for NULL values at most once per data block, and the result is shared by all the filters and the functions
+ * on the column, so that all-valid blocks skip the per-element NULL checks just like the blocks whose statistics
+ * report no NULL value.
+ */
+static bool hasNullInColumnData(SQueryRuntimeEnv *pRuntimeEnv, int32_t slot, const char *pData, int16_t type,
+                                int16_t bytes, int32_t numOfRows) {
+  assert(slot >= 0 && slot < TSDB_MAX_COLUMNS);
+
+  int8_t *flag = &pRuntimeEnv->colHasNull[slot];
+  if (*flag != COL_NULL_UNKNOWN) {
+    return (*flag == COL_NULL_EXIST);
+  }
+
+  *flag = COL_NULL_NONE;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    if (isNull(pData + i * bytes, type)) {
+      *flag = COL_NULL_EXIST;
+      break;
+    }
+  }
+
+  return (*flag == COL_NULL_EXIST);
+}
+
+static void spillGroupStates(SQueryRuntimeEnv *pRuntimeEnv);
+
+/*
+ * The spilled groups are returned by the table query only, and without an offset. The partitions being merged are not
+ * spilled again.
+ */
+static bool isGroupStateSpillable(SQueryRuntimeEnv *pRuntimeEnv) {
   SQuery *pQuery = pRuntimeEnv->pQuery;
 
-  int32_t *p1 = (int32_t *) taosHashGet(pWindowResInfo->hashList, pData, bytes);
+  if (pRuntimeEnv->stableQuery || pQuery->limit.offset > 0 ||
+      (pRuntimeEnv->pGroupSpill != NULL && pRuntimeEnv->pGroupSpill->merging)) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    if (!isGroupStateMergeable(pQuery->pSelectExpr[i].base.functionId)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * The states of the groups of a group by on a normal column are spilled to disk as soon as they would take more memory
+ * than the budget if the states of all the functions can be merged later on, otherwise the query fails rather than
+ * growing without bound.
+ */
+static int32_t checkGroupStateSize(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int16_t keyBytes) {
+  SQueryMemAcct *pAcct = pRuntimeEnv->pMemAcct;
+  if (pAcct == NULL || pAcct->budget <= 0) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int64_t size = (pWindowResInfo->size + 1) * getGroupStateSize(pRuntimeEnv, pWindowResInfo, keyBytes);
+  if (size > pAcct->budget) {
+    if (isGroupStateSpillable(pRuntimeEnv)) {
+      spillGroupStates(pRuntimeEnv);
+      return TSDB_CODE_SUCCESS;
+    }
+
+    qError("QInfo:%p states of %d groups take %" PRId64 "B, more than the memory budget:%" PRId64 "B, abort",
+           GET_QINFO_ADDR(pRuntimeEnv), pWindowResInfo->size + 1, size, pAcct->budget);
+    return TSDB_CODE_QRY_TOO_MANY_GROUPS;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static SWindowResult *doSetTimeWindowFromKey(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, char *pData,
+                                             int16_t bytes, bool masterscan) {
+  int32_t *p1 = getWindowResSlot(pWindowResInfo, pData, bytes);
   if (p1 != NULL) {
     pWindowResInfo->curIndex = *p1;
   } else {
@@ -457,6 +571,11 @@ static SWindowResult *doSetTimeWindowFromKey(SQueryRuntimeEnv *pRuntimeEnv, SWin
       return NULL;
     }
 
+    // the caller aborts the query, after the resources of the current data block are released
+    if (pRuntimeEnv->groupbyNormalCol && checkGroupStateSize(pRuntimeEnv, pWindowResInfo, bytes) != TSDB_CODE_SUCCESS) {
+      return NULL;
+    }
+
     // more than the capacity, reallocate the resources
     if (pWindowResInfo->size >= pWindowResInfo->capacity) {
       int64_t newCap = 0;
@@ -476,24 +595,31 @@ static SWindowResult *doSetTimeWindowFromKey(SQueryRuntimeEnv *pRuntimeEnv, SWin
 
       pWindowResInfo->pResult = (SWindowResult *)t;
 
+      qAcquireMem(pWindowResInfo->pMemAcct, (int64_t)newCap * sizeof(SWindowResult) - pWindowResInfo->resultSize);
+      pWindowResInfo->resultSize = (int64_t)newCap * sizeof(SWindowResult);
+
       int32_t inc = (int32_t)newCap - pWindowResInfo->capacity;
       memset(&pWindowResInfo->pResult[pWindowResInfo->capacity], 0, sizeof(SWindowResult) * inc);
 
-      pRuntimeEnv->summary.internalSupSize += (pQuery->numOfOutput * sizeof(SResultInfo) + pRuntimeEnv->interBufSize) * inc;
+      pWindowResInfo->capacity = (int32_t)newCap;
+    }
 
-      for (int32_t i = pWindowResInfo->capacity; i < newCap; ++i) {
-        int32_t ret = createQueryResultInfo(pQuery, &pWindowResInfo->pResult[i], pRuntimeEnv->stableQuery, pRuntimeEnv->interBufSize);
-        if (ret != TSDB_CODE_SUCCESS) {
-          longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
-        }
-      }
+    // add a new result set for a new group, the result info is created when the slot is used for the first time
+    SWindowResult *pWindowRes = &pWindowResInfo->pResult[pWindowResInfo->size];
+    if (pWindowRes->resultInfo == NULL &&
+        createQueryResultInfo(pRuntimeEnv, pWindowResInfo, pWindowRes) != TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
 
-      pWindowResInfo->capacity = (int32_t)newCap;
+    // the key of a binary/nchar group is set by the caller
+    if (IS_VAR_DATA_TYPE(pWindowResInfo->type)) {
+      pWindowRes->key = NULL;
     }
 
-    // add a new result set for a new group
     pWindowResInfo->curIndex = pWindowResInfo->size++;
-    taosHashPut(pWindowResInfo->hashList, pData, bytes, (char *)&pWindowResInfo->curIndex, sizeof(int32_t));
+    if (putWindowResSlot(pWindowResInfo, pData, bytes, pWindowResInfo->curIndex) != TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
   }
 
   // too many time window in query
@@ -905,18 +1031,44 @@ static FORCE_INLINE TSKEY reviseWindowEkey(SQuery *pQuery, STimeWindow *pWindow)
   return ekey;
 }
 
-//todo binary search
-static void* getDataBlockImpl(SArray* pDataBlock, int32_t colId) {
+static int32_t getDataBlockSlot(SArray* pDataBlock, int32_t colId) {
   int32_t numOfCols = (int32_t)taosArrayGetSize(pDataBlock);
 
   for (int32_t i = 0; i < numOfCols; ++i) {
     SColumnInfoData *p = taosArrayGet(pDataBlock, i);
     if (colId == p->info.colId) {
-      return p->pData;
+      return i;
     }
   }
 
-  return NULL;
+  return -1;
+}
+
+// set the data of the filter columns of the data block, the NULL flags come from the statistics if the block has them
+static void setFilterColumnData(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pStatis, SArray *pDataBlock,
+                                int32_t numOfRows) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+
+  for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
+    SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
+
+    int32_t slot = getDataBlockSlot(pDataBlock, pFilterInfo->info.colId);
+    assert(slot >= 0);
+
+    pFilterInfo->pData = ((SColumnInfoData *)taosArrayGet(pDataBlock, slot))->pData;
+    pFilterInfo->hasNull = true;
+    for (int32_t i = 0; pStatis != NULL && i < pQuery->numOfCols; ++i) {
+      if (pStatis[i].colId == pFilterInfo->info.colId) {
+        pFilterInfo->hasNull = (pStatis[i].numOfNull != 0);
+        break;
+      }
+    }
+
+    if (pFilterInfo->hasNull) {
+      pFilterInfo->hasNull = hasNullInColumnData(pRuntimeEnv, slot, pFilterInfo->pData, pFilterInfo->info.type,
+                                                 pFilterInfo->info.bytes, numOfRows);
+    }
+  }
 }
 
 static char *getDataBlock(SQueryRuntimeEnv *pRuntimeEnv, SArithmeticSupport *sas, int32_t col, int32_t size,
@@ -1005,9 +1157,11 @@ static void blockwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *
     longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
   }
 
+  resetColumnNullFlag(pRuntimeEnv, pDataBlock);
+
   for (int32_t k = 0; k < pQuery->numOfOutput; ++k) {
     char *dataBlock = getDataBlock(pRuntimeEnv, &sasArray[k], k, pDataBlockInfo->rows, pDataBlock);
-    setExecParams(pQuery, &pCtx[k], dataBlock, tsCols, pDataBlockInfo, pStatis, &sasArray[k], k);
+    setExecParams(pRuntimeEnv, &pCtx[k], dataBlock, tsCols, pDataBlockInfo, pStatis, &sasArray[k], k);
   }
 
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
@@ -1094,13 +1248,35 @@ static void blockwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *
   taosTFree(sasArray);
 }
 
+static void freeArithmeticSupport(SQuery *pQuery, SArithmeticSupport *sasArray) {
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    if (pQuery->pSelectExpr[i].base.functionId != TSDB_FUNC_ARITHM) {
+      continue;
+    }
+
+    taosTFree(sasArray[i].data);
+  }
+
+  free(sasArray);
+}
+
+static FORCE_INLINE bool isSameGroupKey(const char *prev, const char *val, int16_t type, int16_t bytes) {
+  if (prev == NULL) {
+    return false;
+  }
+
+  if (IS_VAR_DATA_TYPE(type)) {
+    return varDataLen(prev) == varDataLen(val) && memcmp(varDataVal(prev), varDataVal(val), varDataLen(val)) == 0;
+  }
+
+  return memcmp(prev, val, bytes) == 0;
+}
+
 static int32_t setGroupResultOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, char *pData, int16_t type, int16_t bytes) {
   if (isNull(pData, type)) {  // ignore the null value
     return -1;
   }
 
-  int32_t GROUPRESULTID = 1;
-
   SDiskbasedResultBuf *pResultBuf = pRuntimeEnv->pResultBuf;
 
   // not assign result buffer yet, add new result buffer
@@ -1118,32 +1294,37 @@ static int32_t setGroupResultOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, char *pDat
 
   SWindowResult *pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, &pRuntimeEnv->windowResInfo, d, len, true);
   if (pWindowRes == NULL) {
-    return -1;
-  }
-
-  int64_t v = -1;
-  switch(type) {
-    case TSDB_DATA_TYPE_BOOL:
-    case TSDB_DATA_TYPE_TINYINT:  v = GET_INT8_VAL(pData);  break;
-    case TSDB_DATA_TYPE_SMALLINT: v = GET_INT16_VAL(pData); break;
-    case TSDB_DATA_TYPE_INT:      v = GET_INT32_VAL(pData); break;
-    case TSDB_DATA_TYPE_BIGINT:   v = GET_INT64_VAL(pData); break;
-  }
-
-  if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
-    pWindowRes->key = malloc(varDataTLen(pData));
-    varDataCopy(pWindowRes->key, pData);
-  } else {
-    pWindowRes->win.skey = v;
-    pWindowRes->win.ekey = v;
+    return TSDB_CODE_QRY_TOO_MANY_GROUPS;
   }
 
   assert(pRuntimeEnv->windowResInfo.interval == 0);
 
+  // a new group, the key is kept by the result until the result is cleared
   if (pWindowRes->pos.pageId == -1) {
     int32_t ret = addNewWindowResultBuf(pWindowRes, pResultBuf, GROUPRESULTID, pRuntimeEnv->numOfRowsPerPage);
     if (ret != 0) {
-      return -1;
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    int64_t v = -1;
+    switch(type) {
+      case TSDB_DATA_TYPE_BOOL:
+      case TSDB_DATA_TYPE_TINYINT:  v = GET_INT8_VAL(pData);  break;
+      case TSDB_DATA_TYPE_SMALLINT: v = GET_INT16_VAL(pData); break;
+      case TSDB_DATA_TYPE_INT:      v = GET_INT32_VAL(pData); break;
+      case TSDB_DATA_TYPE_BIGINT:   v = GET_INT64_VAL(pData); break;
+    }
+
+    if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
+      pWindowRes->key = malloc(varDataTLen(pData));
+      if (pWindowRes->key == NULL) {
+        longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+      }
+
+      varDataCopy(pWindowRes->key, pData);
+    } else {
+      pWindowRes->win.skey = v;
+      pWindowRes->win.ekey = v;
     }
   }
 
@@ -1152,6 +1333,274 @@ static int32_t setGroupResultOutputBuf(SQueryRuntimeEnv *pRuntimeEnv, char *pDat
   return TSDB_CODE_SUCCESS;
 }
 
+static int32_t initGroupSpillInfo(SQueryRuntimeEnv *pRuntimeEnv) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+
+  SGroupSpillInfo *pSpill = calloc(1, sizeof(SGroupSpillInfo));
+  if (pSpill == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  // an integer key is kept as int64_t, the same as in the window result
+  SColumnInfo *pColInfo = getGroupbyColumnInfo(pQuery, pQuery->pGroupbyExpr);
+  int32_t      keySize = IS_VAR_DATA_TYPE(pColInfo->type) ? pColInfo->bytes : sizeof(int64_t);
+
+  pSpill->keySize = GROUP_SPILL_ALIGN(keySize);
+  pSpill->recordSize = pSpill->keySize;
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    pSpill->recordSize += sizeof(SResultInfo) + GROUP_SPILL_ALIGN(pQuery->pSelectExpr[i].interBytes) +
+                          GROUP_SPILL_ALIGN(pQuery->pSelectExpr[i].bytes);
+  }
+
+  int32_t ps = DEFAULT_INTERN_BUF_PAGE_SIZE;
+  while (pSpill->recordSize * GROUP_SPILL_PAGE_RECORDS > ps - (int32_t)sizeof(tFilePage)) {
+    ps = (ps << 1u);
+  }
+
+  int32_t code = createDiskbasedResultBuffer(&pSpill->pBuf, pSpill->recordSize, ps, MAX(ps * 2, 1024 * 1024 * 2),
+                                             GET_QINFO_ADDR(pRuntimeEnv), pRuntimeEnv->pMemAcct);
+  if (code != TSDB_CODE_SUCCESS) {
+    free(pSpill);
+    return code;
+  }
+
+  pSpill->numOfPartitions = GROUP_SPILL_PARTITIONS;
+  pRuntimeEnv->pGroupSpill = pSpill;
+  return TSDB_CODE_SUCCESS;
+}
+
+// the key is the key area of a record, the binary/nchar key of a group or the int64_t one
+static int32_t getGroupSpillPartition(SGroupSpillInfo *pSpill, int16_t type, const char *key) {
+  uint32_t hashVal = IS_VAR_DATA_TYPE(type) ? MurmurHash3_32(varDataVal(key), varDataLen(key))
+                                            : MurmurHash3_32(key, sizeof(int64_t));
+  return (int32_t)(hashVal % pSpill->numOfPartitions);
+}
+
+// the last page of the partition if it has any room left, or a new one
+static tFilePage *getGroupSpillPage(SDiskbasedResultBuf *pBuf, int32_t partition) {
+  SIDList list = getDataBufPagesIdList(pBuf, partition);
+
+  if (taosArrayGetSize(list) > 0) {
+    SPageInfo *pi = getLastPageInfo(list);
+    tFilePage *page = getResBufPage(pBuf, pi->pageId);
+    if (page->num < getNumOfRowsPerPage(pBuf)) {
+      return page;
+    }
+
+    releaseResBufPage(pBuf, page);
+  }
+
+  int32_t pageId = -1;
+  return getNewDataBuf(pBuf, partition, &pageId);
+}
+
+static void doSpillGroupState(SQueryRuntimeEnv *pRuntimeEnv, SWindowResult *pResult, char *pRecord) {
+  SQuery *         pQuery = pRuntimeEnv->pQuery;
+  SGroupSpillInfo *pSpill = pRuntimeEnv->pGroupSpill;
+
+  if (IS_VAR_DATA_TYPE(pRuntimeEnv->windowResInfo.type)) {
+    varDataCopy(pRecord, pResult->key);
+  } else {
+    memcpy(pRecord, &pResult->win.skey, sizeof(int64_t));
+  }
+
+  char *     p = pRecord + pSpill->keySize;
+  tFilePage *page = getResBufPage(pRuntimeEnv->pResultBuf, pResult->pos.pageId);
+
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    SResultInfo *pResInfo = &pResult->resultInfo[i];
+    int32_t      interBytes = pQuery->pSelectExpr[i].interBytes;
+
+    memcpy(p, pResInfo, sizeof(SResultInfo));
+    p += sizeof(SResultInfo);
+
+    memcpy(p, pResInfo->interResultBuf, (size_t)interBytes);
+    p += GROUP_SPILL_ALIGN(interBytes);
+
+    memcpy(p, getPosInResultPage(pRuntimeEnv, i, pResult, page), (size_t)pQuery->pSelectExpr[i].bytes);
+    p += GROUP_SPILL_ALIGN(pQuery->pSelectExpr[i].bytes);
+  }
+}
+
+/*
+ * Spill the states of all the groups to the partitions, and clear the groups. The output rows of the groups in
+ * pResultBuf are not used any more, so that their pages can be flushed to disk.
+ */
+static void spillGroupStates(SQueryRuntimeEnv *pRuntimeEnv) {
+  SWindowResInfo *pWindowResInfo = &pRuntimeEnv->windowResInfo;
+  int16_t         type = pWindowResInfo->type;
+
+  if (pRuntimeEnv->pGroupSpill == NULL) {
+    int32_t code = initGroupSpillInfo(pRuntimeEnv);
+    if (code != TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, code);
+    }
+  }
+
+  SGroupSpillInfo *pSpill = pRuntimeEnv->pGroupSpill;
+
+  int32_t *partition = malloc(sizeof(int32_t) * MAX(pWindowResInfo->size, 1));
+  if (partition == NULL) {
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+  }
+
+  for (int32_t i = 0; i < pWindowResInfo->size; ++i) {
+    SWindowResult *pResult = &pWindowResInfo->pResult[i];
+    partition[i] = getGroupSpillPartition(pSpill, type, IS_VAR_DATA_TYPE(type) ? pResult->key : (char *)&pResult->win.skey);
+  }
+
+  // the groups are written one partition after another, so that one page of the spill buffer is used at a time
+  for (int32_t p = 0; p < pSpill->numOfPartitions; ++p) {
+    tFilePage *page = NULL;
+
+    for (int32_t i = 0; i < pWindowResInfo->size; ++i) {
+      if (partition[i] != p) {
+        continue;
+      }
+
+      if (page == NULL || page->num >= getNumOfRowsPerPage(pSpill->pBuf)) {
+        if (page != NULL) {
+          releaseResBufPage(pSpill->pBuf, page);
+        }
+
+        page = getGroupSpillPage(pSpill->pBuf, p);
+        if (page == NULL) {
+          free(partition);
+          longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+        }
+      }
+
+      doSpillGroupState(pRuntimeEnv, &pWindowResInfo->pResult[i], page->data + page->num * pSpill->recordSize);
+      page->num += 1;
+    }
+
+    if (page != NULL) {
+      releaseResBufPage(pSpill->pBuf, page);
+    }
+  }
+
+  free(partition);
+
+  pSpill->numOfSpilled += pWindowResInfo->size;
+  qDebug("QInfo:%p states of %d groups spilled, %" PRId64 " groups spilled in total", GET_QINFO_ADDR(pRuntimeEnv),
+         pWindowResInfo->size, pSpill->numOfSpilled);
+
+  resetTimeWindowInfo(pRuntimeEnv, pWindowResInfo);
+
+  SIDList list = getDataBufPagesIdList(pRuntimeEnv->pResultBuf, GROUPRESULTID);
+  size_t  num = taosArrayGetSize(list);
+  for (int32_t i = 0; i < num; ++i) {
+    SPageInfo *pi = taosArrayGetP(list, i);
+    if (pi->pData != NULL && pi->used) {
+      releaseResBufPageInfo(pRuntimeEnv->pResultBuf, pi);
+    }
+  }
+}
+
+// the state of the first record of a group is restored, the following ones are merged into it
+static void mergeGroupRecord(SQueryRuntimeEnv *pRuntimeEnv, char *pRecord) {
+  SQuery *         pQuery = pRuntimeEnv->pQuery;
+  SWindowResInfo * pWindowResInfo = &pRuntimeEnv->windowResInfo;
+  SGroupSpillInfo *pSpill = pRuntimeEnv->pGroupSpill;
+  bool             varKey = IS_VAR_DATA_TYPE(pWindowResInfo->type);
+
+  char *  key = varKey ? varDataVal(pRecord) : pRecord;
+  int16_t len = varKey ? varDataLen(pRecord) : sizeof(int64_t);
+
+  SWindowResult *pResult = doSetTimeWindowFromKey(pRuntimeEnv, pWindowResInfo, key, len, true);
+  if (pResult == NULL) {
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_TOO_MANY_GROUPS);
+  }
+
+  bool newGroup = (pResult->pos.pageId == -1);
+  if (newGroup) {
+    if (addNewWindowResultBuf(pResult, pRuntimeEnv->pResultBuf, GROUPRESULTID, pRuntimeEnv->numOfRowsPerPage) != 0) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    if (varKey) {
+      pResult->key = malloc(varDataTLen(pRecord));
+      if (pResult->key == NULL) {
+        longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+      }
+
+      varDataCopy(pResult->key, pRecord);
+    } else {
+      memcpy(&pResult->win.skey, pRecord, sizeof(int64_t));
+      pResult->win.ekey = pResult->win.skey;
+    }
+  } else {
+    setWindowResOutputBuf(pRuntimeEnv, pResult);
+  }
+
+  char *     p = pRecord + pSpill->keySize;
+  tFilePage *page = getResBufPage(pRuntimeEnv->pResultBuf, pResult->pos.pageId);
+
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    int32_t interBytes = pQuery->pSelectExpr[i].interBytes;
+    int16_t bytes = pQuery->pSelectExpr[i].bytes;
+
+    SResultInfo info;
+    memcpy(&info, p, sizeof(SResultInfo));
+    info.interResultBuf = p + sizeof(SResultInfo);
+
+    char *pOutput = p + sizeof(SResultInfo) + GROUP_SPILL_ALIGN(interBytes);
+
+    if (newGroup) {
+      SResultInfo *pResInfo = &pResult->resultInfo[i];
+      char *       buf = pResInfo->interResultBuf;
+
+      memcpy(pResInfo, &info, sizeof(SResultInfo));
+      pResInfo->interResultBuf = buf;
+
+      memcpy(buf, info.interResultBuf, (size_t)interBytes);
+      memcpy(getPosInResultPage(pRuntimeEnv, i, pResult, page), pOutput, (size_t)bytes);
+    } else {
+      mergeGroupState(&pRuntimeEnv->pCtx[i], &info, pOutput);
+    }
+
+    p += sizeof(SResultInfo) + GROUP_SPILL_ALIGN(interBytes) + GROUP_SPILL_ALIGN(bytes);
+  }
+}
+
+/*
+ * Once all the groups in windowResInfo are returned, the records of the next partition that has any are merged into
+ * the groups, which are finalized by the caller. It returns false if there are groups not returned yet, or if all the
+ * partitions are merged.
+ */
+static bool mergeNextSpilledGroups(SQueryRuntimeEnv *pRuntimeEnv) {
+  SGroupSpillInfo *pSpill = pRuntimeEnv->pGroupSpill;
+  SWindowResInfo * pWindowResInfo = &pRuntimeEnv->windowResInfo;
+
+  if (pSpill == NULL || pWindowResInfo->size > 0) {
+    return false;
+  }
+
+  pSpill->merging = true;
+
+  while (pWindowResInfo->size == 0 && pSpill->nextPartition < pSpill->numOfPartitions) {
+    SIDList list = getDataBufPagesIdList(pSpill->pBuf, pSpill->nextPartition);
+    size_t  num = taosArrayGetSize(list);
+
+    for (int32_t i = 0; i < num; ++i) {
+      SPageInfo *pi = taosArrayGetP(list, i);
+      tFilePage *page = getResBufPage(pSpill->pBuf, pi->pageId);
+
+      for (int32_t j = 0; j < page->num; ++j) {
+        mergeGroupRecord(pRuntimeEnv, page->data + j * pSpill->recordSize);
+      }
+
+      releaseResBufPage(pSpill->pBuf, page);
+    }
+
+    qDebug("QInfo:%p %d groups of the spilled partition %d merged", GET_QINFO_ADDR(pRuntimeEnv), pWindowResInfo->size,
+           pSpill->nextPartition);
+    pSpill->nextPartition += 1;
+  }
+
+  return pWindowResInfo->size > 0;
+}
+
 static char *getGroupbyColumnData(SQuery *pQuery, int16_t *type, int16_t *bytes, SArray* pDataBlock) {
   SSqlGroupbyExpr *pGroupbyExpr = pQuery->pGroupbyExpr;
 
@@ -1286,16 +1735,25 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
     groupbyColumnData = getGroupbyColumnData(pQuery, &type, &bytes, pDataBlock);
   }
 
+  // the filters are evaluated already if the filter columns of the block are loaded before the other columns, and so
+  // are the NULL flags of the filter columns
+  int8_t *pFilterRes = pRuntimeEnv->pFilterSel;
+  pRuntimeEnv->pFilterSel = NULL;
+
+  if (pFilterRes == NULL) {
+    resetColumnNullFlag(pRuntimeEnv, pDataBlock);
+  }
+
   for (int32_t k = 0; k < pQuery->numOfOutput; ++k) {
     char *dataBlock = getDataBlock(pRuntimeEnv, &sasArray[k], k, pDataBlockInfo->rows, pDataBlock);
-    setExecParams(pQuery, &pCtx[k], dataBlock, tsCols, pDataBlockInfo, pStatis, &sasArray[k], k);
+    setExecParams(pRuntimeEnv, &pCtx[k], dataBlock, tsCols, pDataBlockInfo, pStatis, &sasArray[k], k);
   }
 
-  // set the input column data
-  for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
-    SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
-    pFilterInfo->pData = getDataBlockImpl(pDataBlock, pFilterInfo->info.colId);
-    assert(pFilterInfo->pData != NULL);
+  // evaluate the filters over the whole block, falls back to doFilterData per row if out of memory
+  bool filterRows = (pQuery->numOfFilterCols > 0) && (!pRuntimeEnv->allRowsQualified);
+  if (filterRows && pFilterRes == NULL) {
+    setFilterColumnData(pRuntimeEnv, pStatis, pDataBlock, pDataBlockInfo->rows);
+    pFilterRes = doFilterDataBlock(pQuery, pDataBlockInfo->rows);
   }
 
   int32_t step = GET_FORWARD_DIRECTION_FACTOR(pQuery->order.order);
@@ -1310,6 +1768,7 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
 
   int32_t j = 0;
   int32_t offset = -1;
+  char *  prevGroupVal = NULL;
 
   for (j = 0; j < pDataBlockInfo->rows; ++j) {
     offset = GET_COL_DATA_POS(pQuery, j, step);
@@ -1325,7 +1784,7 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
       }
     }
 
-    if (pQuery->numOfFilterCols > 0 && (!doFilterData(pQuery, offset))) {
+    if (filterRows && !((pFilterRes != NULL) ? pFilterRes[offset] : doFilterData(pQuery, offset))) {
       continue;
     }
 
@@ -1379,9 +1838,20 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
       if (groupbyColumnValue) {
         char *val = groupbyColumnData + bytes * offset;
 
-        int32_t ret = setGroupResultOutputBuf(pRuntimeEnv, val, type, bytes);
-        if (ret != TSDB_CODE_SUCCESS) {  // null data, too many state code
-          continue;
+        // the output buffer of the previous row is still in use if the row belongs to the same group
+        if (!isSameGroupKey(prevGroupVal, val, type, bytes)) {
+          int32_t ret = setGroupResultOutputBuf(pRuntimeEnv, val, type, bytes);
+          if (ret == TSDB_CODE_QRY_TOO_MANY_GROUPS) {
+            freeArithmeticSupport(pQuery, sasArray);
+            taosTFree(pFilterRes);
+            longjmp(pRuntimeEnv->env, ret);
+          }
+
+          if (ret != TSDB_CODE_SUCCESS) {  // null data
+            continue;
+          }
+
+          prevGroupVal = val;
         }
       }
 
@@ -1402,6 +1872,8 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
     }
   }
 
+  taosTFree(pFilterRes);
+
   assert(offset >= 0);
   if (tsCols != NULL) {
     item->lastKey = tsCols[offset] + step;
@@ -1409,16 +1881,7 @@ static void rowwiseApplyFunctions(SQueryRuntimeEnv *pRuntimeEnv, SDataStatis *pS
     item->lastKey = (QUERY_IS_ASC_QUERY(pQuery)? pDataBlockInfo->window.ekey:pDataBlockInfo->window.skey) + step;
   }
 
-  // todo refactor: extract method
-  for(int32_t i = 0; i < pQuery->numOfOutput; ++i) {
-    if (pQuery->pSelectExpr[i].base.functionId != TSDB_FUNC_ARITHM) {
-      continue;
-    }
-
-    taosTFree(sasArray[i].data);
-  }
-
-  free(sasArray);
+  freeArithmeticSupport(pQuery, sasArray);
 }
 
 static int32_t tableApplyFunctionsOnBlock(SQueryRuntimeEnv *pRuntimeEnv, SDataBlockInfo *pDataBlockInfo,
@@ -1428,7 +1891,8 @@ static int32_t tableApplyFunctionsOnBlock(SQueryRuntimeEnv *pRuntimeEnv, SDataBl
   STableQueryInfo* pTableQInfo = pQuery->current;
   SWindowResInfo*  pWindowResInfo = &pRuntimeEnv->windowResInfo;
 
-  if (pQuery->numOfFilterCols > 0 || pRuntimeEnv->pTSBuf != NULL || pRuntimeEnv->groupbyNormalCol) {
+  if ((pQuery->numOfFilterCols > 0 && !pRuntimeEnv->allRowsQualified) || pRuntimeEnv->pTSBuf != NULL ||
+      pRuntimeEnv->groupbyNormalCol) {
     rowwiseApplyFunctions(pRuntimeEnv, pStatis, pDataBlockInfo, pWindowResInfo, pDataBlock);
   } else {
     blockwiseApplyFunctions(pRuntimeEnv, pStatis, pDataBlockInfo, pWindowResInfo, searchFn, pDataBlock);
@@ -1468,14 +1932,21 @@ static int32_t tableApplyFunctionsOnBlock(SQueryRuntimeEnv *pRuntimeEnv, SDataBl
   return numOfRes;
 }
 
-void setExecParams(SQuery *pQuery, SQLFunctionCtx *pCtx, void* inputData, TSKEY *tsCol, SDataBlockInfo* pBlockInfo,
-                   SDataStatis *pStatis, void *param, int32_t colIndex) {
+void setExecParams(SQueryRuntimeEnv *pRuntimeEnv, SQLFunctionCtx *pCtx, void* inputData, TSKEY *tsCol,
+                   SDataBlockInfo* pBlockInfo, SDataStatis *pStatis, void *param, int32_t colIndex) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
 
   int32_t functionId = pQuery->pSelectExpr[colIndex].base.functionId;
   int32_t colId = pQuery->pSelectExpr[colIndex].base.colInfo.colId;
 
   SDataStatis *tpField = NULL;
-  pCtx->hasNull = hasNullValue(&pQuery->pSelectExpr[colIndex].base.colInfo, pStatis, &tpField);
+  SColIndex   *pColIndex = &pQuery->pSelectExpr[colIndex].base.colInfo;
+  pCtx->hasNull = hasNullValue(pColIndex, pStatis, &tpField);
+  if (pCtx->hasNull && tpField == NULL && inputData != NULL && functionId != TSDB_FUNC_ARITHM) {
+    pCtx->hasNull = hasNullInColumnData(pRuntimeEnv, pColIndex->colIndex, inputData, pCtx->inputType,
+                                        pCtx->inputBytes, pBlockInfo->rows);
+  }
+
   pCtx->aInputElemBuf = inputData;
 
   if (tpField != NULL) {
@@ -1659,6 +2130,7 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int16_t order
 
     assert(isValidDataType(pCtx->inputType));
     pCtx->ptsOutputBuf = NULL;
+    pCtx->pMemAcct = pRuntimeEnv->pMemAcct;
 
     pCtx->outputBytes = pQuery->pSelectExpr[i].bytes;
     pCtx->outputType = pQuery->pSelectExpr[i].type;
@@ -1751,16 +2223,45 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
   pRuntimeEnv->pFillInfo = taosDestoryFillInfo(pRuntimeEnv->pFillInfo);
 
   destroyResultBuf(pRuntimeEnv->pResultBuf);
-  tsdbCleanupQueryHandle(pRuntimeEnv->pQueryHandle);
-  tsdbCleanupQueryHandle(pRuntimeEnv->pSecQueryHandle);
+  if (pRuntimeEnv->pGroupSpill != NULL) {
+    destroyResultBuf(pRuntimeEnv->pGroupSpill->pBuf);
+    taosTFree(pRuntimeEnv->pGroupSpill);
+  }
+
+  cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pQueryHandle);
+  cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pSecQueryHandle);
 
   pRuntimeEnv->pTSBuf = tsBufDestroy(pRuntimeEnv->pTSBuf);
+  taosTFree(pRuntimeEnv->pFilterSel);
 }
 
-#define IS_QUERY_KILLED(_q) ((_q)->code == TSDB_CODE_TSC_QUERY_CANCELLED)
+#define IS_QUERY_KILLED(_q)                        \
+  ((_q)->code == TSDB_CODE_TSC_QUERY_CANCELLED || \
+   ((_q)->pParent != NULL && (_q)->pParent->code == TSDB_CODE_TSC_QUERY_CANCELLED))
 
 static void setQueryKilled(SQInfo *pQInfo) { pQInfo->code = TSDB_CODE_TSC_QUERY_CANCELLED;}
 
+/*
+ * Account the buffers of the tsdb query handle, which grow as more tables are scanned, and abort the query if its
+ * memory usage exceeds the limit.
+ */
+static void checkQueryMemUsage(SQueryRuntimeEnv *pRuntimeEnv) {
+  int64_t size = tsdbGetQueryHandleMemSize(pRuntimeEnv->pQueryHandle);
+  if (size > pRuntimeEnv->tsdbMemSize) {
+    qAcquireMem(pRuntimeEnv->pMemAcct, size - pRuntimeEnv->tsdbMemSize);
+  } else if (size < pRuntimeEnv->tsdbMemSize) {
+    qReleaseMem(pRuntimeEnv->pMemAcct, pRuntimeEnv->tsdbMemSize - size);
+  }
+
+  pRuntimeEnv->tsdbMemSize = size;
+
+  if (qMemLimitExceeded(pRuntimeEnv->pMemAcct)) {
+    qError("QInfo:%p memory usage:%" PRId64 "B exceeds the limit:%" PRId64 "B, abort", GET_QINFO_ADDR(pRuntimeEnv),
+           qGetMemUsage(pRuntimeEnv->pMemAcct), pRuntimeEnv->pMemAcct->limit);
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_EXCEED_MEM_LIMIT);
+  }
+}
+
 static bool isFixedOutputQuery(SQueryRuntimeEnv* pRuntimeEnv) {
   SQuery* pQuery = pRuntimeEnv->pQuery;
   if (QUERY_IS_INTERVAL_QUERY(pQuery)) {
@@ -2176,6 +2677,83 @@ static bool needToLoadDataBlock(SQueryRuntimeEnv* pRuntimeEnv, SDataStatis *pDat
   return false;
 }
 
+/*
+ * All rows of a data block satisfy the filters if no value of the filter columns is NULL and, for each column, one of
+ * the filters accepts both the min and the max value. Only the filters that accept an interval of values, i.e. the
+ * comparison, range and equal filters, are checked this way.
+ */
+static bool isAllRowsQualified(SQuery* pQuery, SDataStatis *pDataStatis, int32_t numOfRows) {
+  if (pDataStatis == NULL) {
+    return false;
+  }
+
+  for (int32_t k = 0; k < pQuery->numOfFilterCols; ++k) {
+    SSingleColumnFilterInfo *pFilterInfo = &pQuery->pFilterInfo[k];
+
+    // the statistics of a timestamp column is the key range of the block
+    int16_t type = pFilterInfo->info.type;
+    if (!IS_PREFILTER_TYPE(type) || type == TSDB_DATA_TYPE_TIMESTAMP) {
+      return false;
+    }
+
+    SDataStatis* pDataBlockst = NULL;
+    for(int32_t i = 0; i < pQuery->numOfCols; ++i) {
+      if (pDataStatis[i].colId == pFilterInfo->info.colId) {
+        pDataBlockst = &pDataStatis[i];
+        break;
+      }
+    }
+
+    if (pDataBlockst == NULL) {
+      return false;
+    }
+
+    bool qualified = false;
+    for (int32_t j = 0; j < pFilterInfo->numOfFilters && !qualified; ++j) {
+      SColumnFilterElem *pFilterElem = &pFilterInfo->pFilters[j];
+
+      if (pFilterElem->fp == isNull_filter) {
+        qualified = (pDataBlockst->numOfNull == numOfRows);
+        continue;
+      }
+
+      // NULL value does not satisfy any other filters
+      if (pDataBlockst->numOfNull != 0) {
+        continue;
+      }
+
+      if (pFilterElem->fp == notNull_filter) {
+        qualified = true;
+        continue;
+      }
+
+      int16_t optr = pFilterElem->filterInfo.lowerRelOptr;
+      if (optr == TSDB_RELATION_NOT_EQUAL || optr == TSDB_RELATION_LIKE) {
+        continue;
+      }
+
+      if (type == TSDB_DATA_TYPE_FLOAT) {
+        float minval = (float)(*(double *)(&pDataBlockst->min));
+        float maxval = (float)(*(double *)(&pDataBlockst->max));
+
+        qualified = pFilterElem->fp(pFilterElem, (char *)&minval, (char *)&minval) &&
+                    pFilterElem->fp(pFilterElem, (char *)&maxval, (char *)&maxval);
+      } else {
+        char *minval = (char *)&pDataBlockst->min;
+        char *maxval = (char *)&pDataBlockst->max;
+
+        qualified = pFilterElem->fp(pFilterElem, minval, minval) && pFilterElem->fp(pFilterElem, maxval, maxval);
+      }
+    }
+
+    if (!qualified) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 static bool overlapWithTimeWindow(SQuery* pQuery, SDataBlockInfo* pBlockInfo) {
   STimeWindow w = {0};
 
@@ -2225,10 +2803,71 @@ static bool overlapWithTimeWindow(SQuery* pQuery, SDataBlockInfo* pBlockInfo) {
   return false;
 }
 
+/*
+ * Load the filter columns of the data block only and evaluate the filters over them, the selection vector is passed
+ * on to rowwiseApplyFunctions through pRuntimeEnv->pFilterSel. If no row of the block satisfies the filters,
+ * *qualified is set to false and the other columns of the block are never loaded. If tsdb loads the block as a whole,
+ * e.g. a block in memory or with sub-blocks, it is returned in *pDataBlock and filtered by rowwiseApplyFunctions.
+ */
+static int32_t doLoadFilterColumns(SQueryRuntimeEnv *pRuntimeEnv, void *pQueryHandle, SDataBlockInfo *pBlockInfo,
+                                   SDataStatis *pStatis, SArray **pDataBlock, bool *qualified) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
+  *qualified = true;
+
+  SArray *pIdList = taosArrayInit(pQuery->numOfFilterCols, sizeof(int16_t));
+  if (pIdList == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  for (int32_t i = 0; i < pQuery->numOfFilterCols; ++i) {
+    taosArrayPush(pIdList, &pQuery->pFilterInfo[i].info.colId);
+  }
+
+  SArray *pBlock = tsdbRetrieveDataBlock(pQueryHandle, pIdList);
+  taosArrayDestroy(pIdList);
+
+  if (pBlock == NULL) {
+    return terrno;
+  }
+
+  if (!tsdbIsDataBlockPartlyLoaded(pQueryHandle)) {
+    *pDataBlock = pBlock;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  pRuntimeEnv->summary.partialLoadBlocks += 1;
+
+  resetColumnNullFlag(pRuntimeEnv, pBlock);
+  setFilterColumnData(pRuntimeEnv, pStatis, pBlock, pBlockInfo->rows);
+
+  int8_t *pSel = doFilterDataBlock(pQuery, pBlockInfo->rows);
+  if (pSel == NULL) {  // let the rowwiseApplyFunctions filter the rows one by one
+    return TSDB_CODE_SUCCESS;
+  }
+
+  *qualified = false;
+  for (int32_t i = 0; i < pBlockInfo->rows; ++i) {
+    if (pSel[i]) {
+      *qualified = true;
+      break;
+    }
+  }
+
+  if (*qualified) {
+    pRuntimeEnv->pFilterSel = pSel;
+  } else {
+    free(pSel);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
 int32_t loadDataBlockOnDemand(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo * pWindowResInfo, void* pQueryHandle, SDataBlockInfo* pBlockInfo, SDataStatis **pStatis, SArray** pDataBlock, uint32_t* status) {
   SQuery *pQuery = pRuntimeEnv->pQuery;
 
   *status = BLK_DATA_NO_NEEDED;
+  pRuntimeEnv->allRowsQualified = false;
+  taosTFree(pRuntimeEnv->pFilterSel);
 
   if (pQuery->numOfFilterCols > 0 || pRuntimeEnv->pTSBuf > 0) {
     *status = BLK_DATA_ALL_NEEDED;
@@ -2292,18 +2931,44 @@ int32_t loadDataBlockOnDemand(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo * pW
     tsdbRetrieveDataBlockStatisInfo(pQueryHandle, pStatis);
 
     if (!needToLoadDataBlock(pRuntimeEnv, *pStatis, pRuntimeEnv->pCtx, pBlockInfo->rows)) {
-      // current block has been discard due to filter applied
+      // current block has been discard due to filter applied, no need to load its data
       pRuntimeEnv->summary.discardBlocks += 1;
       qDebug("QInfo:%p data block discard, brange:%"PRId64 "-%"PRId64", rows:%d", GET_QINFO_ADDR(pRuntimeEnv),
           pBlockInfo->window.skey, pBlockInfo->window.ekey, pBlockInfo->rows);
       (*status) = BLK_DATA_DISCARD;
+      return TSDB_CODE_SUCCESS;
+    }
+
+    if (pQuery->numOfFilterCols > 0 && isAllRowsQualified(pQuery, *pStatis, pBlockInfo->rows)) {
+      pRuntimeEnv->allRowsQualified = true;
+      pRuntimeEnv->summary.qualifiedBlocks += 1;
     }
 
     pRuntimeEnv->summary.totalCheckedRows += pBlockInfo->rows;
+
+    // load the filter columns first, the other columns are loaded only if any row of the block is qualified
+    if (pQuery->numOfFilterCols > 0 && !pRuntimeEnv->allRowsQualified) {
+      bool qualified = true;
+      int32_t code = doLoadFilterColumns(pRuntimeEnv, pQueryHandle, pBlockInfo, *pStatis, pDataBlock, &qualified);
+      if (code != TSDB_CODE_SUCCESS) {
+        return code;
+      }
+
+      if (!qualified) {
+        pRuntimeEnv->summary.discardBlocks += 1;
+        qDebug("QInfo:%p data block discard after filter, brange:%"PRId64 "-%"PRId64", rows:%d",
+               GET_QINFO_ADDR(pRuntimeEnv), pBlockInfo->window.skey, pBlockInfo->window.ekey, pBlockInfo->rows);
+        (*status) = BLK_DATA_DISCARD;
+        return TSDB_CODE_SUCCESS;
+      }
+    }
+
     pRuntimeEnv->summary.loadBlocks += 1;
-    *pDataBlock = tsdbRetrieveDataBlock(pQueryHandle, NULL);
     if (*pDataBlock == NULL) {
-      return terrno;
+      *pDataBlock = tsdbRetrieveDataBlock(pQueryHandle, NULL);
+      if (*pDataBlock == NULL) {
+        return terrno;
+      }
     }
   }
 
@@ -2391,6 +3056,8 @@ static void ensureOutputBufferSimple(SQueryRuntimeEnv* pRuntimeEnv, int32_t capa
       pQuery->sdata[i] = (tFilePage *)tmp;
     }
 
+    qAcquireMem(pRuntimeEnv->pMemAcct, (int64_t)(capacity - pQuery->rec.capacity) * bytes);
+
     // set the pCtx output buffer position
     pRuntimeEnv->pCtx[i].aOutputBuf = pQuery->sdata[i]->data;
   }
@@ -2423,6 +3090,8 @@ static void ensureOutputBuffer(SQueryRuntimeEnv* pRuntimeEnv, SDataBlockInfo* pB
           pQuery->sdata[i] = (tFilePage *)tmp;
         }
 
+        qAcquireMem(pRuntimeEnv->pMemAcct, (int64_t)(newSize - pRec->capacity) * bytes);
+
         // set the pCtx output buffer position
         pRuntimeEnv->pCtx[i].aOutputBuf = pQuery->sdata[i]->data + pRec->rows * bytes;
 
@@ -2481,6 +3150,8 @@ static int64_t doScanAllDataBlocks(SQueryRuntimeEnv *pRuntimeEnv) {
       longjmp(pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
     }
 
+    checkQueryMemUsage(pRuntimeEnv);
+
     tsdbRetrieveDataBlockInfo(pQueryHandle, &blockInfo);
     doSetInitialTimewindow(pRuntimeEnv, &blockInfo);
 
@@ -3301,21 +3972,20 @@ void switchCtxOrder(SQueryRuntimeEnv *pRuntimeEnv) {
   }
 }
 
-int32_t createQueryResultInfo(SQuery *pQuery, SWindowResult *pResultRow, bool isSTableQuery, size_t interBufSize) {
-  int32_t numOfCols = pQuery->numOfOutput;
+int32_t createQueryResultInfo(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, SWindowResult *pResultRow) {
+  SQuery *pQuery = pRuntimeEnv->pQuery;
 
-  size_t size = numOfCols * sizeof(SResultInfo) + interBufSize;
-  pResultRow->resultInfo = calloc(1, size);
+  pResultRow->resultInfo = (SResultInfo *)allocWindowResultInfo(pRuntimeEnv, pWindowResInfo);
   if (pResultRow->resultInfo == NULL) {
     return TSDB_CODE_QRY_OUT_OF_MEMORY;
   }
 
   pResultRow->pos = (SPosInfo) {-1, -1};
 
-  char* buf = (char*) pResultRow->resultInfo + numOfCols * sizeof(SResultInfo);
+  char* buf = (char*) pResultRow->resultInfo + pQuery->numOfOutput * sizeof(SResultInfo);
 
   // set the intermediate result output buffer
-  setWindowResultInfo(pResultRow->resultInfo, pQuery, isSTableQuery, buf);
+  setWindowResultInfo(pResultRow->resultInfo, pQuery, pRuntimeEnv->stableQuery, buf);
   return TSDB_CODE_SUCCESS;
 }
 
@@ -3546,7 +4216,7 @@ static void setEnvBeforeReverseScan(SQueryRuntimeEnv *pRuntimeEnv, SQueryStatusI
 
   // clean unused handle
   if (pRuntimeEnv->pSecQueryHandle != NULL) {
-    tsdbCleanupQueryHandle(pRuntimeEnv->pSecQueryHandle);
+    cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pSecQueryHandle);
   }
 
   pRuntimeEnv->pSecQueryHandle = tsdbQueryTables(pQInfo->tsdb, &cond, &pQInfo->tableGroupInfo, pQInfo);
@@ -3629,7 +4299,7 @@ void scanOneTableDataBlocks(SQueryRuntimeEnv *pRuntimeEnv, TSKEY start) {
     TIME_WINDOW_COPY(cond.twindow, qstatus.curWindow);
 
     if (pRuntimeEnv->pSecQueryHandle != NULL) {
-      tsdbCleanupQueryHandle(pRuntimeEnv->pSecQueryHandle);
+      cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pSecQueryHandle);
     }
 
     restoreTimeWindow(&pQInfo->tableGroupInfo, &cond);
@@ -3672,6 +4342,16 @@ void finalizeQueryResult(SQueryRuntimeEnv *pRuntimeEnv) {
     // for each group result, call the finalize function for each column
     SWindowResInfo *pWindowResInfo = &pRuntimeEnv->windowResInfo;
     if (pRuntimeEnv->groupbyNormalCol) {
+      // once any group is spilled, the groups left are spilled as well, and the first partition is merged
+      SGroupSpillInfo *pSpill = pRuntimeEnv->pGroupSpill;
+      if (pSpill != NULL && !pSpill->merging) {
+        if (pWindowResInfo->size > 0) {
+          spillGroupStates(pRuntimeEnv);
+        }
+
+        mergeNextSpilledGroups(pRuntimeEnv);
+      }
+
       closeAllTimeWindow(pWindowResInfo);
     }
 
@@ -4067,7 +4747,8 @@ static void stableApplyFunctionsOnBlock(SQueryRuntimeEnv *pRuntimeEnv, SDataBloc
   SWindowResInfo * pWindowResInfo = &pTableQueryInfo->windowResInfo;
   pQuery->pos = QUERY_IS_ASC_QUERY(pQuery)? 0 : pDataBlockInfo->rows - 1;
 
-  if (pQuery->numOfFilterCols > 0 || pRuntimeEnv->pTSBuf != NULL || pRuntimeEnv->groupbyNormalCol) {
+  if ((pQuery->numOfFilterCols > 0 && !pRuntimeEnv->allRowsQualified) || pRuntimeEnv->pTSBuf != NULL ||
+      pRuntimeEnv->groupbyNormalCol) {
     rowwiseApplyFunctions(pRuntimeEnv, pStatis, pDataBlockInfo, pWindowResInfo, pDataBlock);
   } else {
     blockwiseApplyFunctions(pRuntimeEnv, pStatis, pDataBlockInfo, pWindowResInfo, searchFn, pDataBlock);
@@ -4196,6 +4877,29 @@ int32_t doFillGapsInResults(SQueryRuntimeEnv* pRuntimeEnv, tFilePage **pDst, int
   }
 }
 
+static void addQueryHandleCost(SQueryRuntimeEnv *pRuntimeEnv, TsdbQueryHandleT pQueryHandle) {
+  STsdbQueryCost cost = {0};
+  tsdbRetrieveQueryCost(pQueryHandle, &cost);
+
+  SQueryCostInfo *pSummary = &pRuntimeEnv->summary;
+  pSummary->loadFileBlockTime += cost.blockLoadTime;
+  pSummary->loadStallTime += cost.readTime;
+  pSummary->prefetchBlocks += cost.prefetchBlocks;
+  pSummary->prefetchSize += cost.prefetchBytes;
+  pSummary->prefetchDepth = MAX(pSummary->prefetchDepth, (uint32_t)cost.prefetchDepth);
+}
+
+static void cleanupQueryHandle(SQueryRuntimeEnv *pRuntimeEnv, TsdbQueryHandleT pQueryHandle) {
+  addQueryHandleCost(pRuntimeEnv, pQueryHandle);
+
+  if (pQueryHandle != NULL && pQueryHandle == pRuntimeEnv->pQueryHandle) {
+    qReleaseMem(pRuntimeEnv->pMemAcct, pRuntimeEnv->tsdbMemSize);
+    pRuntimeEnv->tsdbMemSize = 0;
+  }
+
+  tsdbCleanupQueryHandle(pQueryHandle);
+}
+
 static void queryCostStatis(SQInfo *pQInfo) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
   SQueryCostInfo *pSummary = &pRuntimeEnv->summary;
@@ -4203,13 +4907,24 @@ static void queryCostStatis(SQInfo *pQInfo) {
   // add the merge time
   pSummary->elapsedTime += pSummary->firstStageMergeTime;
 
+  // the cost of the query handles that are still alive
+  addQueryHandleCost(pRuntimeEnv, pRuntimeEnv->pQueryHandle);
+  addQueryHandleCost(pRuntimeEnv, pRuntimeEnv->pSecQueryHandle);
+
   qDebug("QInfo:%p :cost summary: elapsed time:%"PRId64" us, first merge:%"PRId64" us, total blocks:%d, "
-         "load block statis:%d, load data block:%d, total rows:%"PRId64 ", check rows:%"PRId64,
-         pQInfo, pSummary->elapsedTime, pSummary->firstStageMergeTime, pSummary->totalBlocks, pSummary->loadBlockStatis,
-         pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows);
+         "load block statis:%d, load data block:%d, discard block:%d, all rows qualified block:%d, filter first "
+         "block:%d, total rows:%"PRId64", check rows:%"PRId64, pQInfo, pSummary->elapsedTime,
+         pSummary->firstStageMergeTime, pSummary->totalBlocks, pSummary->loadBlockStatis, pSummary->loadBlocks,
+         pSummary->discardBlocks, pSummary->qualifiedBlocks, pSummary->partialLoadBlocks, pSummary->totalRows,
+         pSummary->totalCheckedRows);
 
-  qDebug("QInfo:%p :cost summary: internal size:%"PRId64"B, numOfWin:%"PRId64, pQInfo, pSummary->internalSupSize,
-      pSummary->numOfTimeWindows);
+  qDebug("QInfo:%p :cost summary: load data block:%"PRId64" us, stalled in read:%"PRId64" us, prefetch blocks:%"PRId64
+         ", prefetch size:%"PRId64"B, prefetch depth:%d", pQInfo, pSummary->loadFileBlockTime, pSummary->loadStallTime,
+         pSummary->prefetchBlocks, pSummary->prefetchSize, pSummary->prefetchDepth);
+
+  qDebug("QInfo:%p :cost summary: internal size:%"PRId64"B, numOfWin:%"PRId64", scan workers:%d, peak memory:%"PRId64
+         "B", pQInfo, pSummary->internalSupSize, pSummary->numOfTimeWindows, pSummary->scanWorkers,
+         pQInfo->memAcct.peak);
 }
 
 static void updateOffsetVal(SQueryRuntimeEnv *pRuntimeEnv, SDataBlockInfo *pBlockInfo) {
@@ -4268,6 +4983,8 @@ void skipBlocks(SQueryRuntimeEnv *pRuntimeEnv) {
       longjmp(pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
     }
 
+    checkQueryMemUsage(pRuntimeEnv);
+
     tsdbRetrieveDataBlockInfo(pQueryHandle, &blockInfo);
 
     if (pQuery->limit.offset > blockInfo.rows) {
@@ -4428,6 +5145,11 @@ static int32_t setupQueryHandle(void* tsdb, SQInfo* pQInfo, bool isSTableQuery)
     return TSDB_CODE_SUCCESS;
   }
 
+  // the scan workers create their own query handles
+  if (isSTableQuery && getNumOfScanWorkers(pQInfo) > 1) {
+    return TSDB_CODE_SUCCESS;
+  }
+
   STsdbQueryCond cond = {
     .order   = pQuery->order.order,
     .colList = pQuery->colList,
@@ -4517,11 +5239,6 @@ int32_t doInitQInfo(SQInfo *pQInfo, STSBuf *pTsBuf, void *tsdb, int32_t vgId, bo
 
   setScanLimitationByResultBuffer(pQuery);
 
-  code = setupQueryHandle(tsdb, pQInfo, isSTableQuery);
-  if (code != TSDB_CODE_SUCCESS) {
-    return code;
-  }
-
   pQInfo->tsdb = tsdb;
   pQInfo->vgId = vgId;
 
@@ -4532,6 +5249,12 @@ int32_t doInitQInfo(SQInfo *pQInfo, STSBuf *pTsBuf, void *tsdb, int32_t vgId, bo
   pRuntimeEnv->prevGroupId = INT32_MIN;
   pRuntimeEnv->groupbyNormalCol = isGroupbyNormalCol(pQuery->pGroupbyExpr);
 
+  // the runtime environment is needed to know if the tables are scanned by the scan workers
+  code = setupQueryHandle(tsdb, pQInfo, isSTableQuery);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
   if (pTsBuf != NULL) {
     int16_t order = (pQuery->order.order == pRuntimeEnv->pTSBuf->tsOrder) ? TSDB_ORDER_ASC : TSDB_ORDER_DESC;
     tsBufSetTraverseOrder(pRuntimeEnv->pTSBuf, order);
@@ -4549,7 +5272,7 @@ int32_t doInitQInfo(SQInfo *pQInfo, STSBuf *pTsBuf, void *tsdb, int32_t vgId, bo
   int32_t TWOMB = 1024*1024*2;
 
   if (isSTableQuery && !onlyQueryTags(pRuntimeEnv->pQuery)) {
-    code = createDiskbasedResultBuffer(&pRuntimeEnv->pResultBuf, rowsize, ps, TWOMB, pQInfo);
+    code = createDiskbasedResultBuffer(&pRuntimeEnv->pResultBuf, rowsize, ps, TWOMB, pQInfo, pRuntimeEnv->pMemAcct);
     if (code != TSDB_CODE_SUCCESS) {
       return code;
     }
@@ -4577,7 +5300,7 @@ int32_t doInitQInfo(SQInfo *pQInfo, STSBuf *pTsBuf, void *tsdb, int32_t vgId, bo
   } else if (pRuntimeEnv->groupbyNormalCol || QUERY_IS_INTERVAL_QUERY(pQuery)) {
     int32_t numOfResultRows = getInitialPageNum(pQInfo);
     getIntermediateBufInfo(pRuntimeEnv, &ps, &rowsize);
-    code = createDiskbasedResultBuffer(&pRuntimeEnv->pResultBuf, rowsize, ps, TWOMB, pQInfo);
+    code = createDiskbasedResultBuffer(&pRuntimeEnv->pResultBuf, rowsize, ps, TWOMB, pQInfo, pRuntimeEnv->pMemAcct);
     if (code != TSDB_CODE_SUCCESS) {
       return code;
     }
@@ -4659,6 +5382,8 @@ static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
       longjmp(pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
     }
 
+    checkQueryMemUsage(pRuntimeEnv);
+
     tsdbRetrieveDataBlockInfo(pQueryHandle, &blockInfo);
     STableQueryInfo **pTableQueryInfo = (STableQueryInfo**) taosHashGet(pQInfo->tableqinfoGroupInfo.map, &blockInfo.tid, sizeof(blockInfo.tid));
     if(pTableQueryInfo == NULL) {
@@ -4715,6 +5440,482 @@ static int64_t scanMultiTableDataBlocks(SQInfo *pQInfo) {
   return et - st;
 }
 
+/*
+ * For a super table aggregation without time window, the tables of the query can be partitioned among several scan
+ * workers. Each worker scans its tables with its own tsdb query handle into its own group results, and the group
+ * results of all workers are merged into those of the query when the scan is completed. All the query handles of the
+ * workers read the memory tables of one snapshot.
+ */
+typedef struct SScanWorker {
+  SQInfo          qinfo;  // copy of the query object, with its own runtime environment
+  SQuery          query;
+  STableGroupInfo tableGroupInfo;
+  int32_t         code;   // set by the thread scanning the worker
+} SScanWorker;
+
+/*
+ * The workers of all the queries are scanned by one pool of tsNumOfScanThreads - 1 threads. The thread of the query
+ * scans the workers not taken by the pool yet, so the number of scan threads is bounded however many queries run,
+ * and a query still progresses when the pool is busy with other queries.
+ */
+#define SCAN_POOL_QUEUE_SIZE 1024
+
+typedef struct SScanJob {
+  int32_t      ref;           // held by the query and by each task queued in the pool
+  int32_t      numOfWorkers;
+  SScanWorker *pWorkers;
+  tsem_t       done;          // posted when the pool completes a worker
+  int8_t       claimed[];     // a worker is scanned by the first one claiming it, the pool or the query
+} SScanJob;
+
+static void *         scanPool = NULL;
+static pthread_once_t scanPoolInit = PTHREAD_ONCE_INIT;
+
+static void scanPoolInitFunc() {
+  if (tsNumOfScanThreads > 1) {
+    scanPool = taosInitScheduler(SCAN_POOL_QUEUE_SIZE, tsNumOfScanThreads - 1, "qscan");
+    if (scanPool == NULL) {
+      qError("failed to create the scan thread pool, super table queries are scanned by one thread");
+    }
+  }
+}
+
+static int32_t getNumOfScanWorkers(SQInfo *pQInfo) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+
+  if (tsNumOfScanThreads <= 1 || pQInfo->tableGroupInfo.numOfTables <= 1) {
+    return 1;
+  }
+
+  pthread_once(&scanPoolInit, scanPoolInitFunc);
+  if (scanPool == NULL) {
+    return 1;
+  }
+
+  if (QUERY_IS_INTERVAL_QUERY(pQuery) || pRuntimeEnv->groupbyNormalCol || pRuntimeEnv->pTSBuf != NULL ||
+      needReverseScan(pQuery) || isSumAvgRateQuery(pQuery)) {
+    return 1;
+  }
+
+  // the output of these functions depends on the timestamp of the block being scanned
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    int32_t functionId = pQuery->pSelectExpr[i].base.functionId;
+    if (functionId == TSDB_FUNC_TS || functionId == TSDB_FUNC_TWA) {
+      return 1;
+    }
+  }
+
+  return (int32_t)MIN(tsNumOfScanThreads, pQInfo->tableGroupInfo.numOfTables);
+}
+
+static void destroyScanWorkers(SQInfo *pQInfo, SScanWorker *pWorkers, int32_t numOfWorkers) {
+  SQueryCostInfo *pSummary = &pQInfo->runtimeEnv.summary;
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    SScanWorker *     pWorker = &pWorkers[i];
+    SQueryRuntimeEnv *pWorkerEnv = &pWorker->qinfo.runtimeEnv;
+    SQueryCostInfo *  pWorkerSummary = &pWorkerEnv->summary;
+
+    // the buffers of the query handle are accounted by the worker, its cost is a part of the cost of the query
+    if (pWorkerEnv->pQueryHandle != NULL) {
+      qReleaseMem(pWorkerEnv->pMemAcct, pWorkerEnv->tsdbMemSize);
+      pWorkerEnv->tsdbMemSize = 0;
+
+      cleanupQueryHandle(&pQInfo->runtimeEnv, pWorkerEnv->pQueryHandle);
+      pWorkerEnv->pQueryHandle = NULL;
+    }
+
+    pSummary->totalBlocks += pWorkerSummary->totalBlocks;
+    pSummary->loadBlocks += pWorkerSummary->loadBlocks;
+    pSummary->loadBlockStatis += pWorkerSummary->loadBlockStatis;
+    pSummary->discardBlocks += pWorkerSummary->discardBlocks;
+    pSummary->qualifiedBlocks += pWorkerSummary->qualifiedBlocks;
+    pSummary->partialLoadBlocks += pWorkerSummary->partialLoadBlocks;
+    pSummary->totalRows += pWorkerSummary->totalRows;
+    pSummary->totalCheckedRows += pWorkerSummary->totalCheckedRows;
+    pSummary->internalSupSize += pWorkerSummary->internalSupSize;
+
+    teardownQueryRuntimeEnv(pWorkerEnv);
+    taosHashCleanup(pWorker->qinfo.tableqinfoGroupInfo.map);
+    taosTFree(pWorker->query.pFilterInfo);
+
+    SArray *pGroupList = pWorker->tableGroupInfo.pGroupList;
+    if (pGroupList != NULL) {
+      if (taosArrayGetSize(pGroupList) > 0) {
+        taosArrayDestroy(taosArrayGetP(pGroupList, 0));
+      }
+
+      taosArrayDestroy(pGroupList);
+    }
+  }
+
+  free(pWorkers);
+}
+
+static int32_t setupScanWorker(SQInfo *pQInfo, SScanWorker *pWorker, STsdbQueryCond *pCond, TsdbMemSnapshotT snapshot) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+  SQueryRuntimeEnv *pWorkerEnv = &pWorker->qinfo.runtimeEnv;
+
+  // the data of the filter columns is set for each data block, so the filter info can not be shared
+  if (pQuery->numOfFilterCols > 0) {
+    pWorker->query.pFilterInfo = malloc(sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+    if (pWorker->query.pFilterInfo == NULL) {
+      return TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+
+    memcpy(pWorker->query.pFilterInfo, pQuery->pFilterInfo, sizeof(SSingleColumnFilterInfo) * pQuery->numOfFilterCols);
+  }
+
+  int32_t code = setupQueryRuntimeEnv(pWorkerEnv, pQuery->order.order);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  // the null flag is removed from the expression when the query sets up its runtime environment
+  for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+    pWorkerEnv->pCtx[i].requireNull = pRuntimeEnv->pCtx[i].requireNull;
+  }
+
+  int32_t ps = DEFAULT_PAGE_SIZE;
+  int32_t rowsize = 0;
+  getIntermediateBufInfo(pWorkerEnv, &ps, &rowsize);
+
+  code = createDiskbasedResultBuffer(&pWorkerEnv->pResultBuf, rowsize, ps, 1024 * 1024 * 2, pQInfo,
+                                     pWorkerEnv->pMemAcct);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  code = initWindowResInfo(&pWorkerEnv->windowResInfo, pWorkerEnv, 8, (int32_t)pRuntimeEnv->windowResInfo.threshold,
+                           TSDB_DATA_TYPE_INT);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  pWorkerEnv->pQueryHandle = tsdbQueryTablesInSnapshot(pQInfo->tsdb, pCond, &pWorker->tableGroupInfo, pQInfo, snapshot);
+  if (pWorkerEnv->pQueryHandle == NULL) {
+    return terrno;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static SScanWorker *createScanWorkers(SQInfo *pQInfo, int32_t numOfWorkers, TsdbMemSnapshotT snapshot) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+
+  SScanWorker *pWorkers = calloc(numOfWorkers, sizeof(SScanWorker));
+  if (pWorkers == NULL) {
+    terrno = TSDB_CODE_QRY_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  int32_t numOfTables = (int32_t)(pQInfo->tableGroupInfo.numOfTables / numOfWorkers + 1);
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    SScanWorker *pWorker = &pWorkers[i];
+
+    pWorker->query = *pQuery;
+    pWorker->query.current = NULL;
+    pWorker->query.pFilterInfo = NULL;
+
+    // the resources owned by the query are not inherited
+    SQInfo *pInfo = &pWorker->qinfo;
+    *pInfo = *pQInfo;
+    pInfo->pParent = pQInfo;
+    pInfo->code = TSDB_CODE_SUCCESS;
+    pInfo->arrTableIdInfo = NULL;
+    pInfo->tableqinfoGroupInfo.map =
+        taosHashInit(numOfTables, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true, false);
+
+    SQueryRuntimeEnv *pWorkerEnv = &pInfo->runtimeEnv;
+    pWorkerEnv->pQuery = &pWorker->query;
+    pWorkerEnv->resultInfo = NULL;
+    pWorkerEnv->pCtx = NULL;
+    pWorkerEnv->pFillInfo = NULL;
+    pWorkerEnv->pTSBuf = NULL;
+    pWorkerEnv->pQueryHandle = NULL;
+    pWorkerEnv->pSecQueryHandle = NULL;
+    pWorkerEnv->pResultBuf = NULL;
+    pWorkerEnv->tsdbMemSize = 0;
+    pWorkerEnv->prevGroupId = INT32_MIN;
+    memset(&pWorkerEnv->windowResInfo, 0, sizeof(pWorkerEnv->windowResInfo));
+    memset(&pWorkerEnv->summary, 0, sizeof(pWorkerEnv->summary));
+
+    SArray *pTableList = taosArrayInit(numOfTables, sizeof(STableKeyInfo));
+    pWorker->tableGroupInfo.pGroupList = taosArrayInit(1, POINTER_BYTES);
+    if (pTableList == NULL || pWorker->tableGroupInfo.pGroupList == NULL || pInfo->tableqinfoGroupInfo.map == NULL) {
+      taosArrayDestroy(pTableList);
+      terrno = TSDB_CODE_QRY_OUT_OF_MEMORY;
+      goto _error;
+    }
+
+    taosArrayPush(pWorker->tableGroupInfo.pGroupList, &pTableList);
+  }
+
+  // the tables of each group are spread among the workers
+  int32_t index = 0;
+  size_t  numOfGroups = GET_NUM_OF_TABLEGROUP(pQInfo);
+
+  for (int32_t i = 0; i < numOfGroups; ++i) {
+    SArray *pKeyInfoList = taosArrayGetP(pQInfo->tableGroupInfo.pGroupList, i);
+    SArray *group = GET_TABLEGROUP(pQInfo, i);
+
+    size_t num = taosArrayGetSize(group);
+    for (int32_t j = 0; j < num; ++j, ++index) {
+      SScanWorker *    pWorker = &pWorkers[index % numOfWorkers];
+      STableQueryInfo *item = taosArrayGetP(group, j);
+      STableKeyInfo *  pKeyInfo = taosArrayGet(pKeyInfoList, j);
+      assert(pKeyInfo->pTable == item->pTable);
+
+      SArray *  pTableList = taosArrayGetP(pWorker->tableGroupInfo.pGroupList, 0);
+      STableId *id = TSDB_TABLEID(item->pTable);
+
+      if (taosArrayPush(pTableList, pKeyInfo) == NULL ||
+          taosHashPut(pWorker->qinfo.tableqinfoGroupInfo.map, &id->tid, sizeof(id->tid), &item, POINTER_BYTES) != 0) {
+        terrno = TSDB_CODE_QRY_OUT_OF_MEMORY;
+        goto _error;
+      }
+
+      pWorker->tableGroupInfo.numOfTables += 1;
+    }
+  }
+
+  STsdbQueryCond cond = {
+    .order     = pQuery->order.order,
+    .colList   = pQuery->colList,
+    .numOfCols = pQuery->numOfCols,
+  };
+
+  TIME_WINDOW_COPY(cond.twindow, pQuery->window);
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    int32_t code = setupScanWorker(pQInfo, &pWorkers[i], &cond, snapshot);
+    if (code != TSDB_CODE_SUCCESS) {
+      terrno = code;
+      goto _error;
+    }
+  }
+
+  return pWorkers;
+
+_error:
+  destroyScanWorkers(pQInfo, pWorkers, numOfWorkers);
+  return NULL;
+}
+
+static void *scanTablesInWorker(void *param) {
+  SScanWorker *pWorker = (SScanWorker *)param;
+  SQInfo *     pQInfo = &pWorker->qinfo;
+
+  int32_t code = setjmp(pQInfo->runtimeEnv.env);
+  if (code != TSDB_CODE_SUCCESS) {
+    qError("QInfo:%p scan worker %p failed since %s", pQInfo->pParent, pQInfo, tstrerror(code));
+    atomic_store_32(&pWorker->code, code);
+    return NULL;
+  }
+
+  int64_t el = scanMultiTableDataBlocks(pQInfo);
+  qDebug("QInfo:%p scan worker %p completed, tables:%" PRIzu ", elapsed time:%" PRId64 "ms", pQInfo->pParent, pQInfo,
+         pWorker->tableGroupInfo.numOfTables, el);
+
+  return NULL;
+}
+
+static void releaseScanJob(SScanJob *pJob) {
+  if (atomic_sub_fetch_32(&pJob->ref, 1) == 0) {
+    tsem_destroy(&pJob->done);
+    free(pJob);
+  }
+}
+
+static void scanTablesInPool(SSchedMsg *pMsg) {
+  SScanJob *pJob = (SScanJob *)pMsg->ahandle;
+  int32_t   index = (int32_t)(intptr_t)pMsg->thandle;
+
+  // the workers of a job are not accessed any more once all of them are claimed, the job itself still is
+  if (atomic_val_compare_exchange_8(&pJob->claimed[index], 0, 1) == 0) {
+    scanTablesInWorker(&pJob->pWorkers[index]);
+    tsem_post(&pJob->done);
+  }
+
+  releaseScanJob(pJob);
+}
+
+// returns the number of workers scanned by the thread of the query
+static int32_t runScanWorkers(SQInfo *pQInfo, SScanWorker *pWorkers, int32_t numOfWorkers) {
+  SScanJob *pJob = calloc(1, sizeof(SScanJob) + numOfWorkers * sizeof(int8_t));
+  if (pJob == NULL || tsem_init(&pJob->done, 0, 0) != 0) {
+    qError("QInfo:%p failed to create scan job, the tables are scanned by one thread", pQInfo);
+    free(pJob);
+
+    for (int32_t i = 0; i < numOfWorkers; ++i) {
+      scanTablesInWorker(&pWorkers[i]);
+    }
+    return numOfWorkers;
+  }
+
+  pJob->ref = numOfWorkers;
+  pJob->numOfWorkers = numOfWorkers;
+  pJob->pWorkers = pWorkers;
+
+  for (int32_t i = 1; i < numOfWorkers; ++i) {
+    SSchedMsg msg = {.fp = scanTablesInPool, .ahandle = pJob, .thandle = (void *)(intptr_t)i};
+    taosScheduleTask(scanPool, &msg);
+  }
+
+  int32_t numOfScanned = 0;
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    if (atomic_val_compare_exchange_8(&pJob->claimed[i], 0, 1) == 0) {
+      scanTablesInWorker(&pWorkers[i]);
+      numOfScanned += 1;
+    }
+  }
+
+  // wait for the workers claimed by the pool
+  for (int32_t i = numOfScanned; i < numOfWorkers; ++i) {
+    tsem_wait(&pJob->done);
+  }
+
+  releaseScanJob(pJob);
+  return numOfScanned;
+}
+
+/*
+ * merge the group results of a worker into the group results of the query, in the same way as the results of
+ * different tables are merged in mergeIntoGroupResultImpl
+ */
+static void mergeScanWorkerResult(SQInfo *pQInfo, SScanWorker *pWorker) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQuery *          pQuery = pRuntimeEnv->pQuery;
+  SQLFunctionCtx *  pCtx = pRuntimeEnv->pCtx;
+
+  SQueryRuntimeEnv *pWorkerEnv = &pWorker->qinfo.runtimeEnv;
+  SWindowResInfo *  pWorkerResInfo = &pWorkerEnv->windowResInfo;
+
+  int32_t numOfGroups = (int32_t)GET_NUM_OF_TABLEGROUP(pQInfo);
+
+  for (int32_t groupIndex = 0; groupIndex < numOfGroups; ++groupIndex) {
+    int32_t *slot = getWindowResSlot(pWorkerResInfo, (char *)&groupIndex, sizeof(groupIndex));
+    if (slot == NULL) {
+      continue;
+    }
+
+    SWindowResult *pSrc = getWindowResult(pWorkerResInfo, *slot);
+    tFilePage *    page = getResBufPage(pWorkerEnv->pResultBuf, pSrc->pos.pageId);
+
+    SWindowResult *pWindowRes = doSetTimeWindowFromKey(pRuntimeEnv, &pRuntimeEnv->windowResInfo, (char *)&groupIndex,
+                                                       sizeof(groupIndex), true);
+    if (pWindowRes->pos.pageId == -1 &&
+        addNewWindowResultBuf(pWindowRes, pRuntimeEnv->pResultBuf, groupIndex, pRuntimeEnv->numOfRowsPerPage) !=
+            TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    setWindowResOutputBuf(pRuntimeEnv, pWindowRes);
+
+    for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+      int32_t functionId = pQuery->pSelectExpr[i].base.functionId;
+
+      pCtx[i].currentStage = FIRST_STAGE_MERGE;
+      if (!GET_RES_INFO(&pCtx[i])->initialized) {
+        aAggs[functionId].init(&pCtx[i]);
+      }
+
+      pCtx[i].size = 1;
+      pCtx[i].startOffset = 0;
+      pCtx[i].hasNull = true;
+      pCtx[i].nStartQueryTimestamp = pQuery->window.skey;
+      pCtx[i].aInputElemBuf = getPosInResultPage(pWorkerEnv, i, pSrc, page);
+
+      // in case of tag column, the tag information should be extracted from input buffer
+      if (functionId == TSDB_FUNC_TAG_DUMMY || functionId == TSDB_FUNC_TAG) {
+        tVariantDestroy(&pCtx[i].tag);
+
+        int32_t type = pCtx[i].outputType;
+        if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
+          tVariantCreateFromBinary(&pCtx[i].tag, varDataVal(pCtx[i].aInputElemBuf), varDataLen(pCtx[i].aInputElemBuf),
+                                   type);
+        } else {
+          tVariantCreateFromBinary(&pCtx[i].tag, pCtx[i].aInputElemBuf, pCtx[i].inputBytes, pCtx[i].inputType);
+        }
+      }
+    }
+
+    for (int32_t i = 0; i < pQuery->numOfOutput; ++i) {
+      int32_t functionId = pQuery->pSelectExpr[i].base.functionId;
+      if (functionId == TSDB_FUNC_TAG_DUMMY) {
+        continue;
+      }
+
+      aAggs[functionId].distMergeFunc(&pCtx[i]);
+    }
+  }
+
+  pRuntimeEnv->prevGroupId = INT32_MIN;
+}
+
+static int64_t scanMultiTableDataBlocksInParallel(SQInfo *pQInfo, int32_t numOfWorkers) {
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+
+  int64_t st = taosGetTimestampMs();
+
+  // the query handle of the query is not created if the query is scanned by the workers
+  assert(pRuntimeEnv->pQueryHandle == NULL);
+
+  TsdbMemSnapshotT snapshot = tsdbTakeQueryMemSnapshot(pQInfo->tsdb);
+  if (snapshot == NULL) {
+    longjmp(pRuntimeEnv->env, terrno);
+  }
+
+  SScanWorker *pWorkers = createScanWorkers(pQInfo, numOfWorkers, snapshot);
+  if (pWorkers == NULL) {
+    qError("QInfo:%p failed to create scan workers since %s", pQInfo, tstrerror(terrno));
+    tsdbReleaseQueryMemSnapshot(snapshot);
+    longjmp(pRuntimeEnv->env, terrno);
+  }
+
+  int32_t numOfLocal = runScanWorkers(pQInfo, pWorkers, numOfWorkers);
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  for (int32_t i = 0; i < numOfWorkers && code == TSDB_CODE_SUCCESS; ++i) {
+    code = atomic_load_32(&pWorkers[i].code);
+  }
+
+  if (code == TSDB_CODE_SUCCESS && !IS_QUERY_KILLED(pQInfo)) {
+    // resources of the workers must be released if the merge fails
+    jmp_buf env;
+    memcpy(env, pRuntimeEnv->env, sizeof(jmp_buf));
+
+    code = setjmp(pRuntimeEnv->env);
+    if (code == TSDB_CODE_SUCCESS) {
+      for (int32_t i = 0; i < numOfWorkers; ++i) {
+        mergeScanWorkerResult(pQInfo, &pWorkers[i]);
+      }
+    }
+
+    memcpy(pRuntimeEnv->env, env, sizeof(jmp_buf));
+  }
+
+  destroyScanWorkers(pQInfo, pWorkers, numOfWorkers);
+  tsdbReleaseQueryMemSnapshot(snapshot);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    longjmp(pRuntimeEnv->env, code);
+  }
+
+  updateWindowResNumOfRes(pRuntimeEnv);
+  pRuntimeEnv->summary.scanWorkers = numOfWorkers;
+
+  int64_t et = taosGetTimestampMs();
+  qDebug("QInfo:%p %" PRIzu " tables are scanned by %d workers, %d of them by the query thread", pQInfo,
+         pQInfo->tableGroupInfo.numOfTables, numOfWorkers, numOfLocal);
+
+  return et - st;
+}
+
 static bool multiTableMultioutputHelper(SQInfo *pQInfo, int32_t index) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
   SQuery *          pQuery = pRuntimeEnv->pQuery;
@@ -4750,7 +5951,7 @@ static bool multiTableMultioutputHelper(SQInfo *pQInfo, int32_t index) {
 
   // include only current table
   if (pRuntimeEnv->pQueryHandle != NULL) {
-    tsdbCleanupQueryHandle(pRuntimeEnv->pQueryHandle);
+    cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pQueryHandle);
     pRuntimeEnv->pQueryHandle = NULL;
   }
 
@@ -4818,7 +6019,7 @@ static void sequentialTableProcess(SQInfo *pQInfo) {
 
       // include only current table
       if (pRuntimeEnv->pQueryHandle != NULL) {
-        tsdbCleanupQueryHandle(pRuntimeEnv->pQueryHandle);
+        cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pQueryHandle);
         pRuntimeEnv->pQueryHandle = NULL;
       }
 
@@ -4891,7 +6092,7 @@ static void sequentialTableProcess(SQInfo *pQInfo) {
 
       // include only current table
       if (pRuntimeEnv->pQueryHandle != NULL) {
-        tsdbCleanupQueryHandle(pRuntimeEnv->pQueryHandle);
+        cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pQueryHandle);
         pRuntimeEnv->pQueryHandle = NULL;
       }
 
@@ -5091,7 +6292,7 @@ static void doSaveContext(SQInfo *pQInfo) {
 
   // clean unused handle
   if (pRuntimeEnv->pSecQueryHandle != NULL) {
-    tsdbCleanupQueryHandle(pRuntimeEnv->pSecQueryHandle);
+    cleanupQueryHandle(pRuntimeEnv, pRuntimeEnv->pSecQueryHandle);
   }
 
   setQueryStatus(pQuery, QUERY_NOT_COMPLETED);
@@ -5165,7 +6366,9 @@ static void multiTableQueryProcess(SQInfo *pQInfo) {
          pQuery->window.skey, pQuery->window.ekey, pQuery->order.order);
 
   // do check all qualified data blocks
-  int64_t el = scanMultiTableDataBlocks(pQInfo);
+  int32_t numOfWorkers = getNumOfScanWorkers(pQInfo);
+  int64_t el = (numOfWorkers > 1) ? scanMultiTableDataBlocksInParallel(pQInfo, numOfWorkers)
+                                  : scanMultiTableDataBlocks(pQInfo);
   qDebug("QInfo:%p master scan completed, elapsed time: %" PRId64 "ms, reverse scan start", pQInfo, el);
 
   // query error occurred or query is killed, abort current execution
@@ -5385,6 +6588,10 @@ static void tableIntervalProcess(SQInfo *pQInfo, STableQueryInfo* pTableInfo) {
     pQuery->rec.rows = 0;
     copyFromWindowResToSData(pQInfo, &pRuntimeEnv->windowResInfo);
     clearFirstNTimeWindow(pRuntimeEnv, pQInfo->groupIndex);
+
+    if (mergeNextSpilledGroups(pRuntimeEnv)) {
+      finalizeQueryResult(pRuntimeEnv);
+    }
   }
 }
 
@@ -5416,6 +6623,11 @@ static void tableQueryImpl(SQInfo *pQInfo) {
         copyFromWindowResToSData(pQInfo, &pRuntimeEnv->windowResInfo);
         clearFirstNTimeWindow(pRuntimeEnv, pQInfo->groupIndex);
 
+        // the next partition of the spilled groups is merged once all the groups of the previous one are returned
+        if (mergeNextSpilledGroups(pRuntimeEnv)) {
+          finalizeQueryResult(pRuntimeEnv);
+        }
+
         if (pQuery->rec.rows > 0) {
           qDebug("QInfo:%p %"PRId64" rows returned from group results, total:%"PRId64"", pQInfo, pQuery->rec.rows, pQuery->rec.total);
 
@@ -6133,6 +7345,9 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SSqlGroupbyExpr *pGrou
   pQInfo->signature = pQInfo;
   pQInfo->tableGroupInfo = *pTableGroupInfo;
 
+  qInitMemAcct(&pQInfo->memAcct, (int64_t)tsQueryMemBudget * 1024 * 1024, (int64_t)tsQueryMemLimit * 1024 * 1024);
+  pQInfo->runtimeEnv.pMemAcct = &pQInfo->memAcct;
+
   SQuery *pQuery = calloc(1, sizeof(SQuery));
   if (pQuery == NULL) {
     goto _cleanup_query;
@@ -6193,6 +7408,8 @@ static SQInfo *createQInfoImpl(SQueryTableMsg *pQueryMsg, SSqlGroupbyExpr *pGrou
     if (pQuery->sdata[col] == NULL) {
       goto _cleanup;
     }
+
+    qAcquireMem(&pQInfo->memAcct, size);
   }
 
   if (pQuery->fillType != TSDB_FILL_NONE) {
@@ -6819,6 +8036,7 @@ int32_t qDumpRetrieveResult(qinfo_t qinfo, SRetrieveTableRsp **pRsp, int32_t *co
   }
 
   (*pRsp)->precision = htons(pQuery->precision);
+  (*pRsp)->memUsage  = htobe64(qGetMemUsage(&pQInfo->memAcct));
   if (pQuery->rec.rows > 0 && pQInfo->code == TSDB_CODE_SUCCESS) {
     doDumpQueryResult(pQInfo, (*pRsp)->data);
   } else {
@@ -6850,6 +8068,17 @@ int32_t qQueryCompleted(qinfo_t qinfo) {
   return IS_QUERY_KILLED(pQInfo) || Q_STATUS_EQUAL(pQuery->status, QUERY_OVER);
 }
 
+bool qIsShortQuery(qinfo_t qinfo) {
+  SQInfo *pQInfo = (SQInfo *)qinfo;
+
+  if (pQInfo == NULL || !isValidQInfo(pQInfo)) {
+    return false;
+  }
+
+  SQuery* pQuery = pQInfo->runtimeEnv.pQuery;
+  return onlyQueryTags(pQuery) || isFirstLastRowQuery(pQuery) || pQInfo->tableqinfoGroupInfo.numOfTables == 0;
+}
+
 int32_t qKillQuery(qinfo_t qinfo) {
   SQInfo *pQInfo = (SQInfo *)qinfo;
 
@@ -17,6 +17,7 @@
 #include "os.h"
 
 #include "qExecutor.h"
+#include "qUtil.h"
 #include "taosmsg.h"
 #include "tcompare.h"
 #include "tsqlfunction.h"
@@ -177,7 +178,7 @@ bool equal_dd(SColumnFilterElem *pFilter, char *minval, char *maxval) {
   } else { /* range filter */
     assert(*(double *)minval < *(double *)maxval);
 
-    return *(double *)minval <= pFilter->filterInfo.lowerBndi && *(double *)maxval >= pFilter->filterInfo.lowerBndi;
+    return *(double *)minval <= pFilter->filterInfo.lowerBndd && *(double *)maxval >= pFilter->filterInfo.lowerBndd;
   }
 }
 
@@ -578,3 +579,209 @@ __filter_func_t* getValueFilterFuncArray(int32_t type) {
     default: return NULL;
   }
 }
+
+/*
+ * Block filters: a filter is evaluated over all the values of a column in a data block with a loop specialized for the
+ * data type and the relation, which the compiler is able to vectorize, instead of a filter function call per value.
+ * pRes is overwritten if init is true, otherwise the result is or-ed into it.
+ */
+#define BLOCK_FILTER_LOOP(_type, _expr)                                          \
+  do {                                                                           \
+    const _type *val = (const _type *)pData;                                     \
+    if (init) {                                                                  \
+      for (int32_t i = 0; i < numOfRows; ++i) pRes[i] = (int8_t)(_expr);         \
+    } else {                                                                     \
+      for (int32_t i = 0; i < numOfRows; ++i) pRes[i] |= (int8_t)(_expr);        \
+    }                                                                            \
+  } while (0)
+
+// the values of the integer type are compared with the bounds clamped into the range of the type
+#define BLOCK_FILTER_INTEGER(_type, _min, _max)                                  \
+  do {                                                                           \
+    int64_t lo = MAX(range.lower, (int64_t)(_min));                              \
+    int64_t hi = MIN(range.upper, (int64_t)(_max));                              \
+    if (lo > hi) {                                                               \
+      fillBlockFilterResult(pRes, numOfRows, range.negate, init);                \
+    } else if (range.negate) {                                                   \
+      _type x = (_type)lo;                                                       \
+      BLOCK_FILTER_LOOP(_type, val[i] != x);                                     \
+    } else {                                                                     \
+      _type l = (_type)lo, h = (_type)hi;                                        \
+      BLOCK_FILTER_LOOP(_type, (val[i] >= l) & (val[i] <= h));                   \
+    }                                                                            \
+  } while (0)
+
+#define BLOCK_FILTER_REAL(_type)                                                                   \
+  do {                                                                                             \
+    double l = pFilter->filterInfo.lowerBndd, h = pFilter->filterInfo.upperBndd;                   \
+    if (lower == TSDB_RELATION_EQUAL && type == TSDB_DATA_TYPE_FLOAT) {                            \
+      BLOCK_FILTER_LOOP(_type, fabs(val[i] - l) <= FLT_EPSILON);                                   \
+    } else if (lower == TSDB_RELATION_EQUAL) {                                                     \
+      BLOCK_FILTER_LOOP(_type, val[i] == l);                                                       \
+    } else if (lower == TSDB_RELATION_NOT_EQUAL) {                                                 \
+      BLOCK_FILTER_LOOP(_type, val[i] != l);                                                       \
+    } else {                                                                                       \
+      if (lower == TSDB_RELATION_INVALID) l = -INFINITY;                                           \
+      if (upper == TSDB_RELATION_INVALID) h = INFINITY;                                            \
+      if (lower == TSDB_RELATION_GREATER && upper == TSDB_RELATION_LESS) {                         \
+        BLOCK_FILTER_LOOP(_type, (val[i] > l) & (val[i] < h));                                     \
+      } else if (lower == TSDB_RELATION_GREATER) {                                                 \
+        BLOCK_FILTER_LOOP(_type, (val[i] > l) & (val[i] <= h));                                    \
+      } else if (upper == TSDB_RELATION_LESS) {                                                    \
+        BLOCK_FILTER_LOOP(_type, (val[i] >= l) & (val[i] < h));                                    \
+      } else {                                                                                     \
+        BLOCK_FILTER_LOOP(_type, (val[i] >= l) & (val[i] <= h));                                   \
+      }                                                                                            \
+    }                                                                                              \
+  } while (0)
+
+typedef struct SIntegerFilterRange {
+  int64_t lower;   // inclusive
+  int64_t upper;   // inclusive
+  bool    negate;  // not equal filter, the value is out of [lower, upper]
+} SIntegerFilterRange;
+
+static void fillBlockFilterResult(int8_t *pRes, int32_t numOfRows, bool qualified, bool init) {
+  if (qualified) {
+    memset(pRes, 1, numOfRows);
+  } else if (init) {
+    memset(pRes, 0, numOfRows);
+  }
+}
+
+static bool isRangeRelation(int16_t lower, int16_t upper) {
+  return (lower == TSDB_RELATION_INVALID || lower == TSDB_RELATION_GREATER || lower == TSDB_RELATION_GREATER_EQUAL ||
+          lower == TSDB_RELATION_EQUAL || lower == TSDB_RELATION_NOT_EQUAL) &&
+         (upper == TSDB_RELATION_INVALID || upper == TSDB_RELATION_LESS || upper == TSDB_RELATION_LESS_EQUAL);
+}
+
+// convert the relations of an integer filter into an inclusive range
+static SIntegerFilterRange getIntegerFilterRange(SColumnFilterElem *pFilter) {
+  SColumnFilterInfo * pInfo = &pFilter->filterInfo;
+  SIntegerFilterRange range = {.lower = INT64_MIN, .upper = INT64_MAX, .negate = false};
+
+  switch (pInfo->lowerRelOptr) {
+    case TSDB_RELATION_GREATER:
+      if (pInfo->lowerBndi == INT64_MAX) {
+        range.upper = INT64_MIN;  // empty range
+      } else {
+        range.lower = pInfo->lowerBndi + 1;
+      }
+      break;
+    case TSDB_RELATION_GREATER_EQUAL:
+      range.lower = pInfo->lowerBndi;
+      break;
+    case TSDB_RELATION_NOT_EQUAL:
+      range.negate = true;
+      // fall through
+    case TSDB_RELATION_EQUAL:
+      range.lower = pInfo->lowerBndi;
+      range.upper = pInfo->lowerBndi;
+      break;
+    default:
+      break;
+  }
+
+  switch (pInfo->upperRelOptr) {
+    case TSDB_RELATION_LESS:
+      if (pInfo->upperBndi == INT64_MIN) {
+        range.lower = INT64_MAX;  // empty range
+      } else {
+        range.upper = MIN(range.upper, pInfo->upperBndi - 1);
+      }
+      break;
+    case TSDB_RELATION_LESS_EQUAL:
+      range.upper = MIN(range.upper, pInfo->upperBndi);
+      break;
+    default:
+      break;
+  }
+
+  return range;
+}
+
+// return false if there is no block filter for the type and relation of the filter
+static bool doBlockFilter(SColumnFilterElem *pFilter, int16_t type, const char *pData, int32_t numOfRows,
+                          int8_t *pRes, bool init) {
+  int16_t lower = pFilter->filterInfo.lowerRelOptr;
+  int16_t upper = pFilter->filterInfo.upperRelOptr;
+  if (!isRangeRelation(lower, upper)) {
+    return false;
+  }
+
+  if (type == TSDB_DATA_TYPE_FLOAT) {
+    BLOCK_FILTER_REAL(float);
+    return true;
+  } else if (type == TSDB_DATA_TYPE_DOUBLE) {
+    BLOCK_FILTER_REAL(double);
+    return true;
+  }
+
+  SIntegerFilterRange range = getIntegerFilterRange(pFilter);
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:   BLOCK_FILTER_INTEGER(int8_t, INT8_MIN, INT8_MAX); break;
+    case TSDB_DATA_TYPE_SMALLINT:  BLOCK_FILTER_INTEGER(int16_t, INT16_MIN, INT16_MAX); break;
+    case TSDB_DATA_TYPE_INT:       BLOCK_FILTER_INTEGER(int32_t, INT32_MIN, INT32_MAX); break;
+    case TSDB_DATA_TYPE_TIMESTAMP:
+    case TSDB_DATA_TYPE_BIGINT:    BLOCK_FILTER_INTEGER(int64_t, INT64_MIN, INT64_MAX); break;
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+/*
+ * Evaluate the filters of a column over the data block and clear the rows that do not satisfy any of them in pSel,
+ * with the same NULL value semantics as doFilterData. pBuf holds numOfRows bytes at least.
+ */
+void doFilterColumnDataBlock(SSingleColumnFilterInfo *pFilterInfo, int32_t numOfRows, int8_t *pSel, int8_t *pBuf) {
+  int16_t type = pFilterInfo->info.type;
+  int16_t bytes = pFilterInfo->info.bytes;
+  char *  pData = (char *)pFilterInfo->pData;
+
+  bool init = true;
+  bool isNullFilter = false;
+  bool notNullFilter = false;
+
+  for (int32_t j = 0; j < pFilterInfo->numOfFilters; ++j) {
+    SColumnFilterElem *pFilterElem = &pFilterInfo->pFilters[j];
+
+    if (pFilterElem->fp == isNull_filter) {
+      isNullFilter = true;
+      continue;
+    } else if (pFilterElem->fp == notNull_filter) {
+      notNullFilter = true;
+      continue;
+    }
+
+    if (!doBlockFilter(pFilterElem, type, pData, numOfRows, pBuf, init)) {
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        char *pElem = pData + bytes * i;
+        bool  qualified = pFilterElem->fp(pFilterElem, pElem, pElem);
+        pBuf[i] = init ? qualified : (pBuf[i] | qualified);
+      }
+    }
+
+    init = false;
+  }
+
+  if (init) {
+    memset(pBuf, 0, numOfRows);
+  }
+
+  if (pFilterInfo->hasNull || notNullFilter) {
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      if (pFilterInfo->hasNull && isNull(pData + bytes * i, type)) {
+        pBuf[i] = isNullFilter;
+      } else if (notNullFilter) {
+        pBuf[i] = 1;
+      }
+    }
+  }
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    pSel[i] &= pBuf[i];
+  }
+}
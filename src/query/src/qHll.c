@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+
+#include "qHll.h"
+
+/**
+ * HyperLogLog with the estimator of the paper:
+ * Otmar Ertl. New cardinality estimation algorithms for HyperLogLog sketches, 2017.
+ * https://arxiv.org/abs/1702.01284
+ *
+ * It needs neither the linear counting for small cardinalities nor empirical bias correction tables, and the 64-bit
+ * hash leaves no correction for large cardinalities either.
+ */
+
+#define HLL_RANK_BITS (64 - HLL_BUCKET_BITS)
+#define HLL_HASH_SEED 0xadc83b19ULL
+
+// MurmurHash64A by Austin Appleby, public domain
+static uint64_t hllHash(const void *key, int32_t len) {
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int      r = 47;
+
+  uint64_t       h = HLL_HASH_SEED ^ (len * m);
+  const uint8_t *data = (const uint8_t *)key;
+  const uint8_t *end = data + (len - (len & 7));
+
+  while (data != end) {
+    uint64_t k;
+    memcpy(&k, data, sizeof(k));
+
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+
+    h ^= k;
+    h *= m;
+    data += 8;
+  }
+
+  switch (len & 7) {
+    case 7: h ^= (uint64_t)data[6] << 48;  // fall through
+    case 6: h ^= (uint64_t)data[5] << 40;  // fall through
+    case 5: h ^= (uint64_t)data[4] << 32;  // fall through
+    case 4: h ^= (uint64_t)data[3] << 24;  // fall through
+    case 3: h ^= (uint64_t)data[2] << 16;  // fall through
+    case 2: h ^= (uint64_t)data[1] << 8;   // fall through
+    case 1:
+      h ^= (uint64_t)data[0];
+      h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  return h;
+}
+
+void tHllAdd(SHllInfo *pHll, const void *data, int32_t len) {
+  uint64_t hash = hllHash(data, len);
+  uint32_t index = (uint32_t)(hash & (HLL_BUCKETS - 1));
+
+  // the rank is the position of the first 1 bit in the rest of the hash, the sentinel bit bounds it
+  hash >>= HLL_BUCKET_BITS;
+  hash |= ((uint64_t)1 << HLL_RANK_BITS);
+
+  uint8_t rank = 1;
+  while ((hash & 1) == 0) {
+    rank++;
+    hash >>= 1;
+  }
+
+  if (pHll->buckets[index] < rank) {
+    pHll->buckets[index] = rank;
+  }
+}
+
+void tHllMerge(SHllInfo *pDst, const SHllInfo *pSrc) {
+  for (int32_t i = 0; i < HLL_BUCKETS; ++i) {
+    if (pDst->buckets[i] < pSrc->buckets[i]) {
+      pDst->buckets[i] = pSrc->buckets[i];
+    }
+  }
+}
+
+static double hllSigma(double x) {
+  if (x == 1.0) {
+    return INFINITY;
+  }
+
+  double y = 1.0;
+  double z = x;
+  double zPrev = 0;
+  do {
+    x *= x;
+    zPrev = z;
+    z += x * y;
+    y += y;
+  } while (zPrev != z);
+
+  return z;
+}
+
+static double hllTau(double x) {
+  if (x == 0.0 || x == 1.0) {
+    return 0.0;
+  }
+
+  double y = 1.0;
+  double z = 1 - x;
+  double zPrev = 0;
+  do {
+    x = sqrt(x);
+    zPrev = z;
+    y *= 0.5;
+    z -= pow(1 - x, 2) * y;
+  } while (zPrev != z);
+
+  return z / 3;
+}
+
+int64_t tHllCount(const SHllInfo *pHll) {
+  int32_t histogram[HLL_RANK_BITS + 2] = {0};
+  for (int32_t i = 0; i < HLL_BUCKETS; ++i) {
+    histogram[pHll->buckets[i]]++;
+  }
+
+  if (histogram[0] == HLL_BUCKETS) {
+    return 0;
+  }
+
+  double m = HLL_BUCKETS;
+  double z = m * hllTau((m - histogram[HLL_RANK_BITS + 1]) / m);
+  for (int32_t k = HLL_RANK_BITS; k >= 1; --k) {
+    z = 0.5 * (z + histogram[k]);
+  }
+  z += m * hllSigma(histogram[0] / m);
+
+  return (int64_t)llroundl(0.5 / log(2) * m * m / z);
+}
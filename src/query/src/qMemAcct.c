@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qMemAcct.h"
+#include "os.h"
+
+// the size of the memory block is kept in front of it, the header keeps the alignment of malloc
+#define MEM_ACCT_HEADER_SIZE 16
+
+void qInitMemAcct(SQueryMemAcct *pAcct, int64_t budget, int64_t limit) {
+  memset(pAcct, 0, sizeof(SQueryMemAcct));
+  pAcct->budget = budget;
+  pAcct->limit = limit;
+}
+
+bool qAcquireMem(SQueryMemAcct *pAcct, int64_t size) {
+  if (pAcct == NULL) {
+    return true;
+  }
+
+  int64_t used = atomic_add_fetch_64(&pAcct->used, size);
+
+  int64_t peak = atomic_load_64(&pAcct->peak);
+  while (used > peak) {
+    int64_t prev = atomic_val_compare_exchange_64(&pAcct->peak, peak, used);
+    if (prev == peak) {
+      break;
+    }
+
+    peak = prev;
+  }
+
+  if (pAcct->limit > 0 && used > pAcct->limit) {
+    atomic_store_8(&pAcct->exceeded, 1);
+    return false;
+  }
+
+  return true;
+}
+
+void qReleaseMem(SQueryMemAcct *pAcct, int64_t size) {
+  if (pAcct == NULL) {
+    return;
+  }
+
+  atomic_sub_fetch_64(&pAcct->used, size);
+}
+
+bool qMemOverBudget(SQueryMemAcct *pAcct, int64_t size) {
+  return (pAcct != NULL) && (pAcct->budget > 0) && (atomic_load_64(&pAcct->used) + size > pAcct->budget);
+}
+
+bool qMemLimitExceeded(SQueryMemAcct *pAcct) { return (pAcct != NULL) && (atomic_load_8(&pAcct->exceeded) != 0); }
+
+int64_t qGetMemUsage(SQueryMemAcct *pAcct) { return (pAcct == NULL) ? 0 : atomic_load_64(&pAcct->used); }
+
+void *qMemCalloc(SQueryMemAcct *pAcct, size_t size) {
+  char *p = calloc(1, size + MEM_ACCT_HEADER_SIZE);
+  if (p == NULL) {
+    return NULL;
+  }
+
+  *(int64_t *)p = (int64_t)size;
+  qAcquireMem(pAcct, (int64_t)size);
+
+  return p + MEM_ACCT_HEADER_SIZE;
+}
+
+void qMemFree(SQueryMemAcct *pAcct, void *p) {
+  if (p == NULL) {
+    return;
+  }
+
+  char *h = (char *)p - MEM_ACCT_HEADER_SIZE;
+  qReleaseMem(pAcct, *(int64_t *)h);
+  free(h);
+}
@@ -158,6 +158,14 @@ tSQLExpr *tSQLExprIdValueCreate(SStrToken *pToken, int32_t optrType) {
 tSQLExpr *tSQLExprCreateFunction(tSQLExprList *pList, SStrToken *pFuncToken, SStrToken *endToken, int32_t optType) {
   if (pFuncToken == NULL) return NULL;
 
+  /*
+   * the functions added after the grammar was generated are not keywords, so that they do not break the table and
+   * column names of the same name, and they are recognized by the name here
+   */
+  if (optType == TK_ID && pFuncToken->n == 3 && strncasecmp(pFuncToken->z, "hll", 3) == 0) {
+    optType = TK_HLL;
+  }
+
   tSQLExpr *pExpr = calloc(1, sizeof(tSQLExpr));
   pExpr->nSQLOptr = optType;
   pExpr->pParam = pList;
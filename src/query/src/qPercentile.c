@@ -234,7 +234,7 @@ int32_t tBucketIntHash(tMemBucket *pBucket, const void *value) {
 }
 
 int32_t tBucketDoubleHash(tMemBucket *pBucket, const void *value) {
-  double v = GET_DOUBLE_VAL(value);
+  double v = (pBucket->type == TSDB_DATA_TYPE_FLOAT) ? GET_FLOAT_VAL(value) : GET_DOUBLE_VAL(value);
   int32_t index = -1;
 
   if (pBucket->range.dMinVal == DBL_MAX) {
@@ -305,7 +305,7 @@ static void resetSlotInfo(tMemBucket* pBucket) {
   }
 }
 
-tMemBucket *tMemBucketCreate(int16_t nElemSize, int16_t dataType, double minval, double maxval) {
+tMemBucket *tMemBucketCreate(int16_t nElemSize, int16_t dataType, double minval, double maxval, SQueryMemAcct *pMemAcct) {
   tMemBucket *pBucket = (tMemBucket *)calloc(1, sizeof(tMemBucket));
   if (pBucket == NULL) {
     return NULL;
@@ -345,7 +345,8 @@ tMemBucket *tMemBucketCreate(int16_t nElemSize, int16_t dataType, double minval,
 
   resetSlotInfo(pBucket);
 
-  int32_t ret = createDiskbasedResultBuffer(&pBucket->pBuffer, pBucket->bytes, pBucket->bufPageSize, pBucket->bufPageSize * 512, NULL);
+  int32_t ret = createDiskbasedResultBuffer(&pBucket->pBuffer, pBucket->bytes, pBucket->bufPageSize, pBucket->bufPageSize * 512, NULL,
+                                            pMemAcct);
   if (ret != TSDB_CODE_SUCCESS) {
     tMemBucketDestroy(pBucket);
     return NULL;
@@ -802,3 +803,113 @@ char *getFirstElemOfMemBuffer(tMemBucketSlot *pSeg, int32_t slotIdx, tFilePage *
 //  }
   return thisVal;
 }
+
+/*
+ * Floyd-Rivest selection: for a large range, the range is first narrowed by recursively selecting in a sample around
+ * the expected position of the k-th element, so that the partition around it almost always splits at k. The number
+ * of partitions is bounded as in introselect, and the rest of the range is sorted once the bound is exceeded.
+ */
+#define PERCENTILE_SELECT_SAMPLE_THRESHOLD 600
+
+#define DEFINE_PERCENTILE_SELECT(_name, _type)                                                            \
+  static int32_t _name##Compar(const void *p1, const void *p2) {                                          \
+    _type v1 = *(const _type *)p1;                                                                        \
+    _type v2 = *(const _type *)p2;                                                                        \
+    return (v1 == v2) ? 0 : ((v1 < v2) ? -1 : 1);                                                         \
+  }                                                                                                       \
+                                                                                                          \
+  static void _name##Select(_type *a, int64_t left, int64_t right, int64_t k, int32_t depth) {            \
+    while (right > left) {                                                                                \
+      if (depth-- <= 0) {                                                                                 \
+        qsort(a + left, (size_t)(right - left + 1), sizeof(_type), _name##Compar);                        \
+        return;                                                                                           \
+      }                                                                                                   \
+                                                                                                          \
+      if (right - left > PERCENTILE_SELECT_SAMPLE_THRESHOLD) {                                            \
+        double  n = (double)(right - left + 1);                                                           \
+        double  i = (double)(k - left + 1);                                                               \
+        double  z = log(n);                                                                               \
+        double  s = 0.5 * exp(2 * z / 3);                                                                 \
+        double  sd = 0.5 * sqrt(z * s * (n - s) / n) * ((i < n / 2) ? -1 : 1);                            \
+        int64_t newLeft = MAX(left, (int64_t)(k - i * s / n + sd));                                       \
+        int64_t newRight = MIN(right, (int64_t)(k + (n - i) * s / n + sd));                               \
+        _name##Select(a, newLeft, newRight, k, depth);                                                    \
+      }                                                                                                   \
+                                                                                                          \
+      _type   t = a[k], tmp;                                                                              \
+      int64_t i = left, j = right;                                                                        \
+                                                                                                          \
+      tmp = a[left], a[left] = a[k], a[k] = tmp;                                                          \
+      if (a[right] > t) {                                                                                 \
+        tmp = a[right], a[right] = a[left], a[left] = tmp;                                                \
+      }                                                                                                   \
+                                                                                                          \
+      while (i < j) {                                                                                     \
+        tmp = a[i], a[i] = a[j], a[j] = tmp;                                                              \
+        i++, j--;                                                                                         \
+        while (a[i] < t) i++;                                                                             \
+        while (a[j] > t) j--;                                                                             \
+      }                                                                                                   \
+                                                                                                          \
+      if (a[left] == t) {                                                                                 \
+        tmp = a[left], a[left] = a[j], a[j] = tmp;                                                        \
+      } else {                                                                                            \
+        j++;                                                                                              \
+        tmp = a[j], a[j] = a[right], a[right] = tmp;                                                      \
+      }                                                                                                   \
+                                                                                                          \
+      if (j <= k) left = j + 1;                                                                           \
+      if (k <= j) right = j - 1;                                                                          \
+    }                                                                                                     \
+  }                                                                                                       \
+                                                                                                          \
+  static double _name##Percentile(_type *a, int64_t num, int64_t k, double fraction) {                    \
+    int32_t depth = 2 * (int32_t)(log2((double)num) + 1) + 8;                                             \
+    _name##Select(a, 0, num - 1, k, depth);                                                               \
+                                                                                                          \
+    if (fraction <= 0 || k + 1 >= num) {                                                                  \
+      return (double)a[k];                                                                                \
+    }                                                                                                     \
+                                                                                                          \
+    /* the elements after k are not less than a[k], the next one in order is the minimum of them */       \
+    _type next = a[k + 1];                                                                                \
+    for (int64_t m = k + 2; m < num; ++m) {                                                               \
+      if (a[m] < next) next = a[m];                                                                       \
+    }                                                                                                     \
+                                                                                                          \
+    /* interpolate as getPercentileImpl does, so that both give the same result to the last bit */        \
+    return (1 - fraction) * (double)a[k] + fraction * (double)next;                                       \
+  }
+
+DEFINE_PERCENTILE_SELECT(int8, int8_t)
+DEFINE_PERCENTILE_SELECT(int16, int16_t)
+DEFINE_PERCENTILE_SELECT(int32, int32_t)
+DEFINE_PERCENTILE_SELECT(int64, int64_t)
+DEFINE_PERCENTILE_SELECT(float, float)
+DEFINE_PERCENTILE_SELECT(double, double)
+
+double tPercentileSelect(void *pData, int64_t num, int16_t type, double percent) {
+  if (num <= 0) {
+    return 0.0;
+  }
+
+  // the same position and interpolation as getPercentile
+  double  percentVal = (fabs(percent) * (num - 1)) / ((double)100.0);
+  int64_t k = MIN((int64_t)percentVal, num - 1);
+  double  fraction = percentVal - k;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return int8Percentile(pData, num, k, fraction);
+    case TSDB_DATA_TYPE_SMALLINT:
+      return int16Percentile(pData, num, k, fraction);
+    case TSDB_DATA_TYPE_BIGINT:
+      return int64Percentile(pData, num, k, fraction);
+    case TSDB_DATA_TYPE_FLOAT:
+      return floatPercentile(pData, num, k, fraction);
+    case TSDB_DATA_TYPE_DOUBLE:
+      return doublePercentile(pData, num, k, fraction);
+    default:
+      return int32Percentile(pData, num, k, fraction);
+  }
+}
@@ -9,8 +9,11 @@
 #define GET_DATA_PAYLOAD(_p) ((char *)(_p)->pData + POINTER_BYTES)
 #define NO_IN_MEM_AVAILABLE_PAGES(_b) (listNEles((_b)->lruList) >= (_b)->inMemPages)
 
+// flush a page to disk instead of taking more memory if the memory budget of the query is exceeded
+#define OVER_MEM_BUDGET(_b) (listNEles((_b)->lruList) >= 2 && qMemOverBudget((_b)->pMemAcct, (_b)->pageSize))
+
 int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t rowSize, int32_t pagesize,
-                                    int32_t inMemBufSize, const void* handle) {
+                                    int32_t inMemBufSize, const void* handle, SQueryMemAcct* pMemAcct) {
   *pResultBuf = calloc(1, sizeof(SDiskbasedResultBuf));
 
   SDiskbasedResultBuf* pResBuf = *pResultBuf;
@@ -27,6 +30,7 @@ int32_t createDiskbasedResultBuffer(SDiskbasedResultBuf** pResultBuf, int32_t ro
   pResBuf->file         = NULL;
   pResBuf->handle       = handle;
   pResBuf->fileSize     = 0;
+  pResBuf->pMemAcct     = pMemAcct;
 
   // at least more than 2 pages must be in memory
   assert(inMemBufSize >= pagesize * 2);
@@ -67,22 +71,19 @@ static char* doCompressData(void* data, int32_t srcSize, int32_t *dst, SDiskbase
     return data;
   }
 
+  // the incompressible data is one byte longer than the page with the indicator, so it is kept in the assist buffer
   *dst = tsCompressString(data, srcSize, 1, pResultBuf->assistBuf, srcSize, ONE_STAGE_COMP, NULL, 0);
-
-  memcpy(data, pResultBuf->assistBuf, *dst);
-  return data;
+  return pResultBuf->assistBuf;
 }
 
-static char* doDecompressData(void* data, int32_t srcSize, int32_t *dst, SDiskbasedResultBuf* pResultBuf) { // do nothing
+static char* doDecompressData(void* data, int32_t srcSize, int32_t *dst, char* out, SDiskbasedResultBuf* pResultBuf) { // do nothing
   if (!pResultBuf->comp) {
     *dst = srcSize;
     return data;
   }
 
-  *dst = tsDecompressString(data, srcSize, 1, pResultBuf->assistBuf, pResultBuf->pageSize, ONE_STAGE_COMP, NULL, 0);
-
-  memcpy(data, pResultBuf->assistBuf, *dst);
-  return data;
+  *dst = tsDecompressString(data, srcSize, 1, out, pResultBuf->pageSize, ONE_STAGE_COMP, NULL, 0);
+  return out;
 }
 
 static int32_t allocatePositionInFile(SDiskbasedResultBuf* pResultBuf, size_t size) {
@@ -165,7 +166,8 @@ static char* doFlushPageToDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
 
 static char* flushPageToDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
   int32_t ret = TSDB_CODE_SUCCESS;
-  assert(pResultBuf->numOfPages * pResultBuf->pageSize == pResultBuf->totalBufSize && pResultBuf->numOfPages >= pResultBuf->inMemPages);
+  assert(pResultBuf->numOfPages * pResultBuf->pageSize == pResultBuf->totalBufSize &&
+         (pResultBuf->numOfPages >= pResultBuf->inMemPages || pResultBuf->pMemAcct != NULL));
 
   if (pResultBuf->file == NULL) {
     if ((ret = createDiskFile(pResultBuf)) != TSDB_CODE_SUCCESS) {
@@ -179,8 +181,11 @@ static char* flushPageToDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
 
 // load file block data in disk
 static char* loadPageFromDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
+  // the compressed data is read into the assist buffer, see doCompressData
+  char* t = pResultBuf->comp ? pResultBuf->assistBuf : GET_DATA_PAYLOAD(pg);
+
   int32_t ret = fseek(pResultBuf->file, pg->info.offset, SEEK_SET);
-  ret = (int32_t)fread(GET_DATA_PAYLOAD(pg), 1, pg->info.length, pResultBuf->file);
+  ret = (int32_t)fread(t, 1, pg->info.length, pResultBuf->file);
   if (ret != pg->info.length) {
     terrno = errno;
     return NULL;
@@ -189,7 +194,7 @@ static char* loadPageFromDisk(SDiskbasedResultBuf* pResultBuf, SPageInfo* pg) {
   pResultBuf->statis.loadBytes += pg->info.length;
 
   int32_t fullSize = 0;
-  doDecompressData(GET_DATA_PAYLOAD(pg), pg->info.length, &fullSize, pResultBuf);
+  doDecompressData(t, pg->info.length, &fullSize, GET_DATA_PAYLOAD(pg), pResultBuf);
 
   return (char*)GET_DATA_PAYLOAD(pg);
 }
@@ -252,6 +257,10 @@ static char* evicOneDataPage(SDiskbasedResultBuf* pResultBuf) {
 
   // all pages are referenced by user, try to allocate new space
   if (pn == NULL) {
+    if (!NO_IN_MEM_AVAILABLE_PAGES(pResultBuf)) {  // evicted due to the memory budget
+      return NULL;
+    }
+
     int32_t prev = pResultBuf->inMemPages;
 
     // increase by 50% of previous mem pages
@@ -290,7 +299,7 @@ tFilePage* getNewDataBuf(SDiskbasedResultBuf* pResultBuf, int32_t groupId, int32
   pResultBuf->statis.getPages += 1;
 
   char* availablePage = NULL;
-  if (NO_IN_MEM_AVAILABLE_PAGES(pResultBuf)) {
+  if (NO_IN_MEM_AVAILABLE_PAGES(pResultBuf) || OVER_MEM_BUDGET(pResultBuf)) {
     availablePage = evicOneDataPage(pResultBuf);
   }
 
@@ -310,7 +319,7 @@ tFilePage* getNewDataBuf(SDiskbasedResultBuf* pResultBuf, int32_t groupId, int32
 
   // allocate buf
   if (availablePage == NULL) {
-    pi->pData = calloc(1, pResultBuf->pageSize + POINTER_BYTES);
+    pi->pData = qMemCalloc(pResultBuf->pMemAcct, pResultBuf->pageSize + POINTER_BYTES);
   } else {
     pi->pData = availablePage;
   }
@@ -349,12 +358,12 @@ tFilePage* getResBufPage(SDiskbasedResultBuf* pResultBuf, int32_t id) {
     assert((*pi)->pData == NULL && (*pi)->pn == NULL && (*pi)->info.length >= 0 && (*pi)->info.offset >= 0);
 
     char* availablePage = NULL;
-    if (NO_IN_MEM_AVAILABLE_PAGES(pResultBuf)) {
+    if (NO_IN_MEM_AVAILABLE_PAGES(pResultBuf) || OVER_MEM_BUDGET(pResultBuf)) {
       availablePage = evicOneDataPage(pResultBuf);
     }
 
     if (availablePage == NULL) {
-      (*pi)->pData = calloc(1, pResultBuf->pageSize + POINTER_BYTES);
+      (*pi)->pData = qMemCalloc(pResultBuf->pMemAcct, pResultBuf->pageSize + POINTER_BYTES);
     } else {
       (*pi)->pData = availablePage;
     }
@@ -426,7 +435,7 @@ void destroyResultBuf(SDiskbasedResultBuf* pResultBuf) {
     size_t n = taosArrayGetSize(*p);
     for(int32_t i = 0; i < n; ++i) {
       SPageInfo* pi = taosArrayGetP(*p, i);
-      taosTFree(pi->pData);
+      qMemFree(pResultBuf->pMemAcct, pi->pData);
       taosTFree(pi);
     }
 
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+
+#include "qTDigest.h"
+
+/**
+ * The merging t-digest of the paper:
+ * Ted Dunning, Otmar Ertl. Computing extremely accurate quantiles using t-digests, 2019.
+ * https://arxiv.org/abs/1902.04023
+ *
+ * The scale function k(q) = compression / (2 * PI) * asin(2q - 1) limits the size of a centroid by its quantile, so
+ * the centroids near the tails are small and the p99/p999 are far more accurate than the ones in the middle. Since
+ * two adjacent centroids always span more than 1 in k, there are no more than compression + 1 centroids.
+ */
+
+static double tdigestQuantileLimit(double q) {
+  double k = TDIGEST_COMPRESSION / (2 * M_PI) * asin(2 * q - 1) + 1;
+  if (k >= TDIGEST_COMPRESSION / 4.0) {
+    return 1.0;
+  }
+
+  return (sin(k * 2 * M_PI / TDIGEST_COMPRESSION) + 1) / 2;
+}
+
+static int32_t tdigestCompareDouble(const void *pLeft, const void *pRight) {
+  double v1 = *(const double *)pLeft;
+  double v2 = *(const double *)pRight;
+
+  if (v1 == v2) {
+    return 0;
+  }
+
+  return (v1 < v2) ? -1 : 1;
+}
+
+/*
+ * merge the sorted centroids into the digest in one pass, the centroids of both are visited in the order of their
+ * means and absorbed by the current one as long as the size limit of its quantile is not exceeded
+ */
+static void tdigestCompress(STDigest *pDigest, const SCentroid *pInput, int32_t num, int64_t weight) {
+  SCentroid out[TDIGEST_MAX_CENTROIDS];
+  int32_t   numOfOut = 0;
+
+  const SCentroid *pExist = pDigest->centroids;
+  int32_t          numOfExist = pDigest->numOfCentroids;
+
+  int64_t total = pDigest->total + weight;
+  int32_t i = 0, j = 0;
+
+  SCentroid cur;
+  if (j >= num || (i < numOfExist && pExist[i].mean <= pInput[j].mean)) {
+    cur = pExist[i++];
+  } else {
+    cur = pInput[j++];
+  }
+
+  int64_t weightSoFar = 0;
+  double  limit = total * tdigestQuantileLimit(0);
+
+  while (i < numOfExist || j < num) {
+    SCentroid next;
+    if (j >= num || (i < numOfExist && pExist[i].mean <= pInput[j].mean)) {
+      next = pExist[i++];
+    } else {
+      next = pInput[j++];
+    }
+
+    // the last slot is reserved for the current centroid
+    if (weightSoFar + cur.weight + next.weight <= limit || numOfOut >= TDIGEST_MAX_CENTROIDS - 1) {
+      cur.weight += next.weight;
+      cur.mean += (next.mean - cur.mean) * next.weight / cur.weight;
+    } else {
+      weightSoFar += cur.weight;
+      out[numOfOut++] = cur;
+
+      limit = total * tdigestQuantileLimit((double)weightSoFar / total);
+      cur = next;
+    }
+  }
+
+  out[numOfOut++] = cur;
+
+  memcpy(pDigest->centroids, out, numOfOut * sizeof(SCentroid));
+  pDigest->numOfCentroids = numOfOut;
+  pDigest->total = total;
+}
+
+void tTDigestInit(STDigest *pDigest) {
+  pDigest->total = 0;
+  pDigest->numOfCentroids = 0;
+  pDigest->min = DBL_MAX;
+  pDigest->max = -DBL_MAX;
+}
+
+void tTDigestAddBatch(STDigest *pDigest, double *vals, int32_t num) {
+  if (num <= 0) {
+    return;
+  }
+
+  qsort(vals, num, sizeof(double), tdigestCompareDouble);
+
+  if (vals[0] < pDigest->min) {
+    pDigest->min = vals[0];
+  }
+
+  if (vals[num - 1] > pDigest->max) {
+    pDigest->max = vals[num - 1];
+  }
+
+  SCentroid input[TDIGEST_BATCH_SIZE];
+  for (int32_t i = 0; i < num; i += TDIGEST_BATCH_SIZE) {
+    int32_t n = MIN(num - i, TDIGEST_BATCH_SIZE);
+    for (int32_t j = 0; j < n; ++j) {
+      input[j].mean = vals[i + j];
+      input[j].weight = 1;
+    }
+
+    tdigestCompress(pDigest, input, n, n);
+  }
+}
+
+void tTDigestMerge(STDigest *pDst, const STDigest *pSrc) {
+  if (pSrc->total <= 0) {
+    return;
+  }
+
+  if (pSrc->min < pDst->min) {
+    pDst->min = pSrc->min;
+  }
+
+  if (pSrc->max > pDst->max) {
+    pDst->max = pSrc->max;
+  }
+
+  tdigestCompress(pDst, pSrc->centroids, pSrc->numOfCentroids, pSrc->total);
+}
+
+/*
+ * the values of a centroid are assumed to spread evenly around its mean, so the quantile is interpolated between the
+ * means of the two adjacent centroids, or between the min/max and the mean of the first/last centroid
+ */
+double tTDigestQuantile(const STDigest *pDigest, double q) {
+  if (pDigest->total <= 0) {
+    return NAN;
+  }
+
+  const SCentroid *c = pDigest->centroids;
+  int32_t          n = pDigest->numOfCentroids;
+
+  if (q <= 0) {
+    return pDigest->min;
+  } else if (q >= 1) {
+    return pDigest->max;
+  }
+
+  double index = q * pDigest->total;
+
+  double weightSoFar = c[0].weight / 2.0;
+  if (index < weightSoFar) {
+    return pDigest->min + (c[0].mean - pDigest->min) * index / weightSoFar;
+  }
+
+  for (int32_t i = 0; i < n - 1; ++i) {
+    double dw = (c[i].weight + c[i + 1].weight) / 2.0;
+    if (weightSoFar + dw > index) {
+      double z1 = index - weightSoFar;
+      double z2 = weightSoFar + dw - index;
+      return (c[i].mean * z2 + c[i + 1].mean * z1) / dw;
+    }
+
+    weightSoFar += dw;
+  }
+
+  double halfWeight = c[n - 1].weight / 2.0;
+  double ratio = MIN((index - weightSoFar) / halfWeight, 1.0);
+  return c[n - 1].mean + (pDigest->max - c[n - 1].mean) * ratio;
+}
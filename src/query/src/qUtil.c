@@ -30,21 +30,204 @@ int32_t getOutputInterResultBufSize(SQuery* pQuery) {
   return size;
 }
 
+#define GROUP_KEY_HASH_FACTOR   0x9E3779B97F4A7C15ULL
+#define GROUP_KEY_HASH_ENTRY    (sizeof(int64_t) + sizeof(int32_t))
+#define RESULT_INFO_CHUNK_SIZE  (256 * 1024)
+
+static FORCE_INLINE int64_t getGroupKeyValue(const char *pData, int16_t bytes) {
+  switch (bytes) {
+    case sizeof(int8_t):  return GET_INT8_VAL(pData);
+    case sizeof(int16_t): return GET_INT16_VAL(pData);
+    case sizeof(int32_t): return GET_INT32_VAL(pData);
+    default:              return GET_INT64_VAL(pData);
+  }
+}
+
+static int32_t initGroupKeyHash(SGroupKeyHash *pHash, int32_t size) {
+  int32_t bits = 4;
+  while ((1 << bits) < size * 2 && bits < 30) {
+    bits += 1;
+  }
+
+  int32_t capacity = 1 << bits;
+  int64_t *keys = malloc(sizeof(int64_t) * capacity);
+  int32_t *slots = malloc(sizeof(int32_t) * capacity);
+  if (keys == NULL || slots == NULL) {
+    taosTFree(keys);
+    taosTFree(slots);
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  memset(slots, 0xff, sizeof(int32_t) * capacity);
+
+  pHash->keys = keys;
+  pHash->slots = slots;
+  pHash->capacity = capacity;
+  pHash->shift = 64 - bits;
+  pHash->size = 0;
+  return TSDB_CODE_SUCCESS;
+}
+
+static void clearGroupKeyHash(SGroupKeyHash *pHash) {
+  memset(pHash->slots, 0xff, sizeof(int32_t) * pHash->capacity);
+  pHash->size = 0;
+}
+
+static void cleanupGroupKeyHash(SGroupKeyHash *pHash) {
+  taosTFree(pHash->keys);
+  taosTFree(pHash->slots);
+  pHash->capacity = 0;
+  pHash->size = 0;
+}
+
+// linear probing, the table is kept at most half full
+static FORCE_INLINE int32_t *groupKeyHashGet(SGroupKeyHash *pHash, int64_t key) {
+  int32_t mask = pHash->capacity - 1;
+  int32_t i = (int32_t)(((uint64_t)key * GROUP_KEY_HASH_FACTOR) >> pHash->shift);
+
+  while (pHash->slots[i] != -1) {
+    if (pHash->keys[i] == key) {
+      return &pHash->slots[i];
+    }
+
+    i = (i + 1) & mask;
+  }
+
+  return NULL;
+}
+
+static int32_t groupKeyHashPut(SGroupKeyHash *pHash, int64_t key, int32_t slot) {
+  if ((pHash->size + 1) * 2 > pHash->capacity) {
+    SGroupKeyHash h = {0};
+    if (initGroupKeyHash(&h, pHash->capacity) != TSDB_CODE_SUCCESS) {
+      return TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+
+    for (int32_t i = 0; i < pHash->capacity; ++i) {
+      if (pHash->slots[i] != -1) {
+        groupKeyHashPut(&h, pHash->keys[i], pHash->slots[i]);
+      }
+    }
+
+    cleanupGroupKeyHash(pHash);
+    *pHash = h;
+  }
+
+  int32_t mask = pHash->capacity - 1;
+  int32_t i = (int32_t)(((uint64_t)key * GROUP_KEY_HASH_FACTOR) >> pHash->shift);
+
+  while (pHash->slots[i] != -1 && pHash->keys[i] != key) {
+    i = (i + 1) & mask;
+  }
+
+  if (pHash->slots[i] == -1) {
+    pHash->size += 1;
+  }
+
+  pHash->keys[i] = key;
+  pHash->slots[i] = slot;
+  return TSDB_CODE_SUCCESS;
+}
+
+int32_t *getWindowResSlot(SWindowResInfo *pWindowResInfo, const char *pData, int16_t bytes) {
+  if (pWindowResInfo->hashList != NULL) {
+    return (int32_t *)taosHashGet(pWindowResInfo->hashList, pData, bytes);
+  }
+
+  return groupKeyHashGet(&pWindowResInfo->keyHash, getGroupKeyValue(pData, bytes));
+}
+
+int32_t putWindowResSlot(SWindowResInfo *pWindowResInfo, const char *pData, int16_t bytes, int32_t slot) {
+  if (pWindowResInfo->hashList != NULL) {
+    return taosHashPut(pWindowResInfo->hashList, pData, bytes, (char *)&slot, sizeof(int32_t));
+  }
+
+  SGroupKeyHash *pHash = &pWindowResInfo->keyHash;
+  int32_t        capacity = pHash->capacity;
+
+  int32_t code = groupKeyHashPut(pHash, getGroupKeyValue(pData, bytes), slot);
+  if (pHash->capacity != capacity) {
+    qAcquireMem(pWindowResInfo->pMemAcct, (int64_t)(pHash->capacity - capacity) * GROUP_KEY_HASH_ENTRY);
+  }
+
+  return code;
+}
+
+static size_t getResultInfoSize(SQueryRuntimeEnv *pRuntimeEnv) {
+  size_t size = pRuntimeEnv->pQuery->numOfOutput * sizeof(SResultInfo) + pRuntimeEnv->interBufSize;
+  return (size + 7) & ~((size_t)7);
+}
+
+/*
+ * Unlike the output rows, which are paged in the disk based result buffer, the result, the SResultInfo and the
+ * intermediate buffers of a group and the hash entry of its key stay in memory until the query completes.
+ */
+int64_t getGroupStateSize(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo, int16_t keyBytes) {
+  int64_t size = sizeof(SWindowResult) + getResultInfoSize(pRuntimeEnv);
+
+  if (pWindowResInfo->hashList != NULL) {
+    size += keyBytes * 2;  // the key is kept by the result and by the hash node
+  } else {
+    size += GROUP_KEY_HASH_ENTRY * 2;  // the key hash is kept at most half full
+  }
+
+  return size;
+}
+
+/*
+ * The SResultInfo and the intermediate buffer of a result are carved out of large chunks when the result slot is
+ * used for the first time, instead of one allocation for each slot of the whole capacity.
+ */
+char *allocWindowResultInfo(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo) {
+  size_t size = getResultInfoSize(pRuntimeEnv);
+
+  if (pWindowResInfo->numOfFreeInfo == 0) {
+    int32_t num = (int32_t)MAX(1, RESULT_INFO_CHUNK_SIZE / size);
+    char *  p = qMemCalloc(pWindowResInfo->pMemAcct, num * size);
+    if (p == NULL) {
+      return NULL;
+    }
+
+    if (pWindowResInfo->pInfoBuf == NULL) {
+      pWindowResInfo->pInfoBuf = taosArrayInit(4, POINTER_BYTES);
+    }
+
+    if (pWindowResInfo->pInfoBuf == NULL || taosArrayPush(pWindowResInfo->pInfoBuf, &p) == NULL) {
+      qMemFree(pWindowResInfo->pMemAcct, p);
+      return NULL;
+    }
+
+    pWindowResInfo->pFreeInfo = p;
+    pWindowResInfo->numOfFreeInfo = num;
+    pRuntimeEnv->summary.internalSupSize += num * size;
+  }
+
+  char *p = pWindowResInfo->pFreeInfo;
+  pWindowResInfo->pFreeInfo += size;
+  pWindowResInfo->numOfFreeInfo -= 1;
+  return p;
+}
+
 int32_t initWindowResInfo(SWindowResInfo *pWindowResInfo, SQueryRuntimeEnv *pRuntimeEnv, int32_t size,
                           int32_t threshold, int16_t type) {
   pWindowResInfo->capacity = size;
   pWindowResInfo->threshold = threshold;
   
   pWindowResInfo->type = type;
-  _hash_fn_t fn = taosGetDefaultHashFunction(type);
-  pWindowResInfo->hashList = taosHashInit(threshold, fn, true, false);
-  if (pWindowResInfo->hashList == NULL) {
+  if (IS_VAR_DATA_TYPE(type)) {
+    _hash_fn_t fn = taosGetDefaultHashFunction(type);
+    pWindowResInfo->hashList = taosHashInit(threshold, fn, true, false);
+    if (pWindowResInfo->hashList == NULL) {
+      return TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+  } else if (initGroupKeyHash(&pWindowResInfo->keyHash, threshold) != TSDB_CODE_SUCCESS) {
     return TSDB_CODE_QRY_OUT_OF_MEMORY;
   }
   
   pWindowResInfo->curIndex = -1;
   pWindowResInfo->size     = 0;
   pWindowResInfo->prevSKey = TSKEY_INITIAL_VAL;
+  pWindowResInfo->pMemAcct = pRuntimeEnv->pMemAcct;
 
   SQueryCostInfo* pSummary = &pRuntimeEnv->summary;
 
@@ -56,26 +239,22 @@ int32_t initWindowResInfo(SWindowResInfo *pWindowResInfo, SQueryRuntimeEnv *pRun
 
   pWindowResInfo->interval = pRuntimeEnv->pQuery->interval.interval;
 
+  pWindowResInfo->resultSize = sizeof(SWindowResult) * threshold;
+  qAcquireMem(pWindowResInfo->pMemAcct, pWindowResInfo->resultSize);
+  qAcquireMem(pWindowResInfo->pMemAcct, (int64_t)pWindowResInfo->keyHash.capacity * GROUP_KEY_HASH_ENTRY);
+
   pSummary->internalSupSize += sizeof(SWindowResult) * threshold;
-  pSummary->internalSupSize += (pRuntimeEnv->pQuery->numOfOutput * sizeof(SResultInfo) + pRuntimeEnv->interBufSize) * pWindowResInfo->capacity;
+  pSummary->internalSupSize += sizeof(int32_t) * pWindowResInfo->keyHash.capacity * 3;
   pSummary->numOfTimeWindows = threshold;
 
-  for (int32_t i = 0; i < pWindowResInfo->capacity; ++i) {
-    int32_t code = createQueryResultInfo(pRuntimeEnv->pQuery, &pWindowResInfo->pResult[i], pRuntimeEnv->stableQuery, pRuntimeEnv->interBufSize);
-    if (code != TSDB_CODE_SUCCESS) {
-      return code;
-    }
-  }
-  
   return TSDB_CODE_SUCCESS;
 }
 
-void destroyTimeWindowRes(SWindowResult *pWindowRes) {
-  if (pWindowRes == NULL) {
-    return;
+// the key of a binary/nchar group is kept by its result until the result is cleared, it is NULL until it is set
+static void destroyWindowResKey(SWindowResInfo *pWindowResInfo, SWindowResult *pWindowRes) {
+  if (IS_VAR_DATA_TYPE(pWindowResInfo->type)) {
+    taosTFree(pWindowRes->key);
   }
-
-  free(pWindowRes->resultInfo);
 }
 
 void cleanupTimeWindowInfo(SWindowResInfo *pWindowResInfo) {
@@ -88,13 +267,28 @@ void cleanupTimeWindowInfo(SWindowResInfo *pWindowResInfo) {
   }
   
   if (pWindowResInfo->pResult != NULL) {
-    for (int32_t i = 0; i < pWindowResInfo->capacity; ++i) {
-      destroyTimeWindowRes(&pWindowResInfo->pResult[i]);
+    for (int32_t i = 0; i < pWindowResInfo->size; ++i) {
+      destroyWindowResKey(pWindowResInfo, &pWindowResInfo->pResult[i]);
+    }
+  }
+
+  if (pWindowResInfo->pInfoBuf != NULL) {
+    size_t num = taosArrayGetSize(pWindowResInfo->pInfoBuf);
+    for (int32_t i = 0; i < num; ++i) {
+      qMemFree(pWindowResInfo->pMemAcct, *(char **)taosArrayGet(pWindowResInfo->pInfoBuf, i));
     }
+
+    taosArrayDestroy(pWindowResInfo->pInfoBuf);
+    pWindowResInfo->pInfoBuf = NULL;
   }
   
   taosHashCleanup(pWindowResInfo->hashList);
+  qReleaseMem(pWindowResInfo->pMemAcct, (int64_t)pWindowResInfo->keyHash.capacity * GROUP_KEY_HASH_ENTRY);
+  cleanupGroupKeyHash(&pWindowResInfo->keyHash);
   taosTFree(pWindowResInfo->pResult);
+
+  qReleaseMem(pWindowResInfo->pMemAcct, pWindowResInfo->resultSize);
+  pWindowResInfo->resultSize = 0;
 }
 
 void resetTimeWindowInfo(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowResInfo) {
@@ -104,15 +298,21 @@ void resetTimeWindowInfo(SQueryRuntimeEnv *pRuntimeEnv, SWindowResInfo *pWindowR
   
   for (int32_t i = 0; i < pWindowResInfo->size; ++i) {
     SWindowResult *pWindowRes = &pWindowResInfo->pResult[i];
+    destroyWindowResKey(pWindowResInfo, pWindowRes);
     clearTimeWindowResBuf(pRuntimeEnv, pWindowRes);
   }
   
   pWindowResInfo->curIndex = -1;
-  taosHashCleanup(pWindowResInfo->hashList);
   pWindowResInfo->size = 0;
-  
-  _hash_fn_t fn = taosGetDefaultHashFunction(pWindowResInfo->type);
-  pWindowResInfo->hashList = taosHashInit(pWindowResInfo->capacity, fn, true, false);
+
+  if (pWindowResInfo->hashList != NULL) {
+    taosHashCleanup(pWindowResInfo->hashList);
+
+    _hash_fn_t fn = taosGetDefaultHashFunction(pWindowResInfo->type);
+    pWindowResInfo->hashList = taosHashInit(pWindowResInfo->capacity, fn, true, false);
+  } else {
+    clearGroupKeyHash(&pWindowResInfo->keyHash);
+  }
   
   pWindowResInfo->startTime = TSKEY_INITIAL_VAL;
   pWindowResInfo->prevSKey = TSKEY_INITIAL_VAL;
@@ -128,6 +328,7 @@ void clearFirstNTimeWindow(SQueryRuntimeEnv *pRuntimeEnv, int32_t num) {
   assert(num >= 0 && num <= numOfClosed);
 
   int16_t type = pWindowResInfo->type;
+  bool    varKey = IS_VAR_DATA_TYPE(type);
 
   char *key = NULL;
   int16_t bytes = -1;
@@ -135,17 +336,10 @@ void clearFirstNTimeWindow(SQueryRuntimeEnv *pRuntimeEnv, int32_t num) {
   for (int32_t i = 0; i < num; ++i) {
     SWindowResult *pResult = &pWindowResInfo->pResult[i];
     if (pResult->closed) {  // remove the window slot from hash table
-
-      // todo refactor
-      if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
-        key = varDataVal(pResult->key);
-        bytes = varDataLen(pResult->key);
-      } else {
-        key = (char*) &pResult->win.skey;
-        bytes = tDataTypeDesc[pWindowResInfo->type].nSize;
+      if (varKey) {
+        taosHashRemove(pWindowResInfo->hashList, varDataVal(pResult->key), varDataLen(pResult->key));
+        destroyWindowResKey(pWindowResInfo, pResult);
       }
-
-      taosHashRemove(pWindowResInfo->hashList, (const char *)key, bytes);
     } else {
       break;
     }
@@ -166,17 +360,23 @@ void clearFirstNTimeWindow(SQueryRuntimeEnv *pRuntimeEnv, int32_t num) {
   
   pWindowResInfo->size = remain;
 
+  // the open addressing hash table is rebuilt with the remain windows
+  if (!varKey) {
+    clearGroupKeyHash(&pWindowResInfo->keyHash);
+  }
+
   for (int32_t k = 0; k < pWindowResInfo->size; ++k) {
     SWindowResult *pResult = &pWindowResInfo->pResult[k];
 
-    if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
-      key = varDataVal(pResult->key);
-      bytes = varDataLen(pResult->key);
-    } else {
-      key = (char*) &pResult->win.skey;
+    if (!varKey) {
       bytes = tDataTypeDesc[pWindowResInfo->type].nSize;
+      putWindowResSlot(pWindowResInfo, (const char *)&pResult->win.skey, bytes, k);
+      continue;
     }
 
+    key = varDataVal(pResult->key);
+    bytes = varDataLen(pResult->key);
+
     int32_t *p = (int32_t *)taosHashGet(pWindowResInfo->hashList, (const char *)key, bytes);
     assert(p != NULL); 
 
@@ -2,6 +2,7 @@
 #include <sys/time.h>
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 #include "qAst.h"
 #include "taosmsg.h"
@@ -631,4 +632,63 @@ void exprSerializeTest2() {
 TEST(testCase, astTest) {
 //  exprSerializeTest2();
 }
-#endif
\ No newline at end of file
+#endif
+
+extern "C" {
+int32_t merge(SArray *pLeft, SArray *pRight, SArray *pFinalRes);
+int32_t intersect(SArray *pLeft, SArray *pRight, SArray *pFinalRes);
+}
+
+namespace {
+// the tables are told apart by their addresses only, table i is at tables + i
+char tables[64];
+
+SArray *createTableKeyInfoList(const std::vector<int> &ids) {
+  SArray *pList = (SArray *)taosArrayInit(4, sizeof(STableKeyInfo));
+  for (int id : ids) {
+    STableKeyInfo info = {.pTable = tables + id, .lastKey = id};
+    taosArrayPush(pList, &info);
+  }
+  return pList;
+}
+
+std::vector<int> getTableIds(SArray *pList) {
+  std::vector<int> ids;
+  for (size_t i = 0; i < taosArrayGetSize(pList); ++i) {
+    ids.push_back((int)((char *)((STableKeyInfo *)taosArrayGet(pList, i))->pTable - tables));
+  }
+  return ids;
+}
+
+std::vector<int> mergeTables(const std::vector<int> &left, const std::vector<int> &right, bool isIntersect) {
+  SArray *pLeft = createTableKeyInfoList(left);
+  SArray *pRight = createTableKeyInfoList(right);
+  SArray *pRes = (SArray *)taosArrayInit(4, sizeof(STableKeyInfo));
+
+  int32_t num = isIntersect ? intersect(pLeft, pRight, pRes) : merge(pLeft, pRight, pRes);
+  EXPECT_EQ(num, (int32_t)taosArrayGetSize(pRes));
+
+  std::vector<int> ids = getTableIds(pRes);
+  taosArrayDestroy(pLeft);
+  taosArrayDestroy(pRight);
+  taosArrayDestroy(pRes);
+  return ids;
+}
+}  // namespace
+
+TEST(testCase, astMergeTest) {
+  // unsorted, overlapping and with duplicates in one side
+  EXPECT_EQ(mergeTables({5, 1, 3, 3, 9}, {11, 3, 7, 1}, false), std::vector<int>({1, 3, 5, 7, 9, 11}));
+  EXPECT_EQ(mergeTables({2, 4}, {1, 3, 5}, false), std::vector<int>({1, 2, 3, 4, 5}));
+  EXPECT_EQ(mergeTables({8, 6}, {}, false), std::vector<int>({6, 8}));
+  EXPECT_EQ(mergeTables({}, {6, 6}, false), std::vector<int>({6}));
+  EXPECT_EQ(mergeTables({}, {}, false), std::vector<int>());
+}
+
+TEST(testCase, astIntersectTest) {
+  EXPECT_EQ(mergeTables({5, 1, 3, 9}, {11, 3, 7, 1}, true), std::vector<int>({1, 3}));
+  EXPECT_EQ(mergeTables({2, 4}, {1, 3, 5}, true), std::vector<int>());
+  EXPECT_EQ(mergeTables({4, 2, 6}, {6, 4, 2}, true), std::vector<int>({2, 4, 6}));
+  EXPECT_EQ(mergeTables({8, 6}, {}, true), std::vector<int>());
+  EXPECT_EQ(mergeTables({}, {6}, true), std::vector<int>());
+}
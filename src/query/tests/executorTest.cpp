@@ -0,0 +1,495 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "taos.h"
+#include "tglobal.h"
+#include "trpc.h"
+#include "tsdb.h"
+
+extern "C" {
+#include "qExecutor.h"
+}
+
+namespace {
+
+const int      TEST_VNODE = 3;
+const uint64_t TEST_SUPER_UID = 8001;
+const int      TEST_TABLES = 9;
+const TSKEY    TEST_INTERVAL = 1000;
+
+void setScanCfg(STsdbCfg *pCfg) {
+  memset((void *)pCfg, 0, sizeof(*pCfg));
+  pCfg->tsdbId = TEST_VNODE;
+  pCfg->cacheBlockSize = 16;
+  pCfg->totalBlocks = 4;
+  pCfg->daysPerFile = 10;
+  pCfg->keep = 3650;
+  pCfg->minRowsPerFileBlock = 100;
+  pCfg->maxRowsPerFileBlock = 4096;
+  pCfg->precision = TSDB_TIME_PRECISION_MILLI;
+  pCfg->compression = 2;
+}
+
+uint64_t tableUid(int tid) { return TEST_SUPER_UID + tid; }
+
+// table tid has tid * 40 rows, the row i of it has the value tid * 1000 + i in both c1 and c2
+int numOfRows(int tid) { return tid * 40; }
+int32_t rowValue(int tid, int i) { return tid * 1000 + i; }
+
+// the value of every nullEvery-th row is NULL if nullEvery is not 0
+int insertRows(TSDB_REPO_T *repo, STSchema *pSchema, int tid, TSKEY startKey, int from, int nRows,
+               int nullEvery = 0) {
+  SSubmitMsg *pMsg =
+      (SSubmitMsg *)calloc(1, sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * nRows);
+  if (pMsg == NULL) return -1;
+
+  SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+  for (int i = from; i < from + nRows; i++) {
+    SDataRow row = (SDataRow)(pBlock->data + pBlock->dataLen);
+    tdInitDataRow(row, pSchema);
+
+    TSKEY   key = startKey + i * TEST_INTERVAL;
+    int32_t val = (nullEvery > 0 && i % nullEvery == 0) ? TSDB_DATA_INT_NULL : rowValue(tid, i);
+    tdAppendColVal(row, (void *)(&key), TSDB_DATA_TYPE_TIMESTAMP, 8, schemaColAt(pSchema, 0)->offset);
+    tdAppendColVal(row, (void *)(&val), TSDB_DATA_TYPE_INT, 4, schemaColAt(pSchema, 1)->offset);
+    tdAppendColVal(row, (void *)(&val), TSDB_DATA_TYPE_INT, 4, schemaColAt(pSchema, 2)->offset);
+    pBlock->dataLen += dataRowLen(row);
+    pBlock->numOfRows++;
+  }
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->dataLen);
+  pMsg->numOfBlocks = htonl(1);
+  pBlock->dataLen = htonl(pBlock->dataLen);
+  pBlock->numOfRows = htons(pBlock->numOfRows);
+  pBlock->uid = htobe64(tableUid(tid));
+  pBlock->tid = htonl(tid);
+  pBlock->sversion = htonl(0);
+
+  int code = tsdbInsertData(repo, pMsg, NULL);
+  free(pMsg);
+  return code;
+}
+
+// select <functions>(c1) from <tables> where ts between skey and ekey and <filters on c2, or'ed>
+struct STestQuery {
+  TSKEY                          skey;
+  TSKEY                          ekey;
+  std::vector<int16_t>           functions;
+  std::vector<int>               tids;
+  bool                           groupby;  // group by c1, the functions end with the projection of c1 added by the client
+  std::vector<SColumnFilterInfo> filters;
+};
+
+SColumnFilterInfo rangeFilter(int16_t lowerRelOptr, int64_t lower, int16_t upperRelOptr, int64_t upper) {
+  SColumnFilterInfo info;
+  memset(&info, 0, sizeof(info));
+  info.lowerRelOptr = lowerRelOptr;
+  info.upperRelOptr = upperRelOptr;
+  info.lowerBndi = lower;
+  info.upperBndi = upper;
+  return info;
+}
+
+// count, sum and hll of the int column c1 are bigint, avg and spread are double, the other functions are int
+int16_t outputBytes(int16_t functionId) {
+  switch (functionId) {
+    case TSDB_FUNC_COUNT:
+    case TSDB_FUNC_SUM:
+    case TSDB_FUNC_HLL:
+    case TSDB_FUNC_AVG:
+    case TSDB_FUNC_SPREAD:
+      return sizeof(int64_t);
+    default:
+      return sizeof(int32_t);
+  }
+}
+
+SQueryTableMsg *buildQueryMsg(const STestQuery &desc) {
+  const int numOfOutput = (int)desc.functions.size();
+  const int numOfTables = (int)desc.tids.size();
+  const int numOfFilters = (int)desc.filters.size();
+
+  size_t size = sizeof(SQueryTableMsg) + 3 * sizeof(SColumnInfo) + numOfFilters * sizeof(SColumnFilterInfo) +
+                numOfOutput * sizeof(SSqlFuncMsg) + numOfTables * sizeof(STableIdInfo) + sizeof(SColIndex) + 1;
+  SQueryTableMsg *pMsg = (SQueryTableMsg *)calloc(1, size);
+
+  pMsg->window.skey = htobe64(desc.skey);
+  pMsg->window.ekey = htobe64(desc.ekey);
+  pMsg->numOfTables = htonl(numOfTables);
+  pMsg->order = htons(TSDB_ORDER_ASC);
+  pMsg->numOfCols = htons(3);
+  pMsg->queryType = htonl((numOfTables > 1) ? TSDB_QUERY_TYPE_MULTITABLE_QUERY : TSDB_QUERY_TYPE_TABLE_QUERY);
+  pMsg->numOfOutput = htons(numOfOutput);
+  pMsg->numOfGroupCols = htons(desc.groupby ? 1 : 0);
+  pMsg->fillType = htons(TSDB_FILL_NONE);
+
+  for (int16_t i = 0; i < 3; i++) {
+    pMsg->colList[i].colId = htons(i);
+    pMsg->colList[i].type = htons(i == 0 ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT);
+    pMsg->colList[i].bytes = htons(i == 0 ? 8 : 4);
+  }
+  pMsg->colList[2].numOfFilters = htons(numOfFilters);
+
+  char *p = (char *)(pMsg->colList + 3);
+  for (const SColumnFilterInfo &filter : desc.filters) {
+    SColumnFilterInfo *pFilter = (SColumnFilterInfo *)p;
+    pFilter->lowerRelOptr = htons(filter.lowerRelOptr);
+    pFilter->upperRelOptr = htons(filter.upperRelOptr);
+    pFilter->lowerBndi = htobe64(filter.lowerBndi);
+    pFilter->upperBndi = htobe64(filter.upperBndi);
+    p += sizeof(SColumnFilterInfo);
+  }
+
+  for (int i = 0; i < numOfOutput; i++, p += sizeof(SSqlFuncMsg)) {
+    SSqlFuncMsg *pFunc = (SSqlFuncMsg *)p;
+    pFunc->functionId = htons(desc.functions[i]);
+    pFunc->colInfo.colId = htons(1);
+    pFunc->colInfo.colIndex = htons(1);
+    pFunc->colInfo.flag = htons(TSDB_COL_NORMAL);
+  }
+
+  for (int tid : desc.tids) {
+    STableIdInfo *pId = (STableIdInfo *)p;
+    pId->uid = htobe64(tableUid(tid));
+    pId->tid = htonl(tid);
+    pId->key = htobe64(desc.skey);
+    p += sizeof(STableIdInfo);
+  }
+
+  // the group by columns are not in network order
+  if (desc.groupby) {
+    SColIndex *pIndex = (SColIndex *)p;
+    pIndex->colId = 1;
+    pIndex->colIndex = 1;
+    pIndex->flag = TSDB_COL_NORMAL;
+    p += sizeof(SColIndex);
+  }
+
+  return pMsg;
+}
+
+struct SQueryResult {
+  int32_t                        code;
+  int32_t                        numOfRows;
+  std::vector<std::vector<char>> columns;
+  uint32_t                       partialLoadBlocks;
+  uint32_t                       discardBlocks;
+  int64_t                        spilledGroups;
+
+  int64_t bigintAt(int col, int row) const { return ((const int64_t *)columns[col].data())[row]; }
+  double  doubleAt(int col, int row) const { return ((const double *)columns[col].data())[row]; }
+  int32_t intAt(int col, int row) const { return ((const int32_t *)columns[col].data())[row]; }
+};
+
+class ExecutorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rootDir = strdup("./executor_vnode");
+    taosRemoveDir(rootDir);
+    startKey = taosGetTimestamp(TSDB_TIME_PRECISION_MILLI) - 30 * tsMsPerDay[TSDB_TIME_PRECISION_MILLI];
+
+    STsdbCfg tsdbCfg;
+    setScanCfg(&tsdbCfg);
+    ASSERT_EQ(tsdbCreateRepo(rootDir, &tsdbCfg), 0);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    STSchemaBuilder schemaBuilder = {0};
+    tdInitTSchemaBuilder(&schemaBuilder, 0);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, 8);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, 1, 4);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, 2, 4);
+    schema = tdGetSchemaFromBuilder(&schemaBuilder);
+    tdResetTSchemaBuilder(&schemaBuilder, 0);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, 3, 4);
+    tagSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+    tdDestroyTSchemaBuilder(&schemaBuilder);
+
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      SKVRowBuilder kvBuilder;
+      ASSERT_EQ(tdInitKVRowBuilder(&kvBuilder), 0);
+      tdAddColToKVRow(&kvBuilder, 3, TSDB_DATA_TYPE_INT, &tid);
+
+      char name[TSDB_TABLE_NAME_LEN] = "\0";
+      snprintf(name, sizeof(name), "exec_t%d", tid);
+
+      STableCfg cfg;
+      memset((void *)&cfg, 0, sizeof(cfg));
+      cfg.type = TSDB_CHILD_TABLE;
+      cfg.name = name;
+      cfg.sname = (char *)"exec_st";
+      cfg.tableId.tid = tid;
+      cfg.tableId.uid = tableUid(tid);
+      cfg.superUid = TEST_SUPER_UID;
+      cfg.schema = schema;
+      cfg.tagSchema = tagSchema;
+      cfg.tagValues = tdGetKVRowFromBuilder(&kvBuilder);
+      tdDestroyKVRowBuilder(&kvBuilder);
+
+      ASSERT_EQ(tsdbCreateTable(repo, &cfg), 0);
+      kvRowFree(cfg.tagValues);
+    }
+  }
+
+  void TearDown() override {
+    if (repo) tsdbCloseRepo(repo, 0);
+    tdFreeSchema(schema);
+    tdFreeSchema(tagSchema);
+    taosRemoveDir(rootDir);
+    free(rootDir);
+  }
+
+  // the first half of the rows of each table is committed to the data files, the other half stays in memory
+  void writeRows() {
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      ASSERT_EQ(insertRows(repo, schema, tid, startKey, 0, numOfRows(tid) / 2), 0);
+    }
+
+    tsdbCloseRepo(repo, 1);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      ASSERT_EQ(insertRows(repo, schema, tid, startKey, numOfRows(tid) / 2, numOfRows(tid) - numOfRows(tid) / 2), 0);
+    }
+  }
+
+  // count and sum of the rows of table tid whose value passes the filter c2 >= lower and c2 <= upper
+  void expectedFilterResult(int tid, int32_t lower, int32_t upper, int nullEvery, int64_t *count, int64_t *sum) {
+    *count = 0;
+    *sum = 0;
+    for (int i = 0; i < numOfRows(tid); i++) {
+      if ((nullEvery > 0 && i % nullEvery == 0) || rowValue(tid, i) < lower || rowValue(tid, i) > upper) continue;
+
+      *count += 1;
+      *sum += rowValue(tid, i);
+    }
+  }
+
+  // select count(c1), sum(c1) from table tid where c2 >= lower and c2 <= upper
+  void runFilterQuery(int tid, int32_t lower, int32_t upper, int64_t *count, int64_t *sum, SQueryResult *pRes) {
+    STestQuery desc = {startKey, startKey + numOfRows(tid) * TEST_INTERVAL, {TSDB_FUNC_COUNT, TSDB_FUNC_SUM}, {tid},
+                       false, {rangeFilter(TSDB_RELATION_GREATER_EQUAL, lower, TSDB_RELATION_LESS_EQUAL, upper)}};
+    runQuery(desc, pRes);
+    ASSERT_EQ(pRes->code, TSDB_CODE_SUCCESS);
+
+    // no result row if no row passes the filter
+    *count = (pRes->numOfRows > 0) ? pRes->bigintAt(0, 0) : 0;
+    *sum = (pRes->numOfRows > 0) ? pRes->bigintAt(1, 0) : 0;
+  }
+
+  // memBudget is the budget of the query in bytes, -1 for the configured one
+  void runQuery(const STestQuery &desc, SQueryResult *pRes, int64_t memBudget = -1) {
+    SQueryTableMsg *pMsg = buildQueryMsg(desc);
+    qinfo_t         qinfo = NULL;
+    ASSERT_EQ(qCreateQueryInfo(repo, TEST_VNODE, pMsg, &qinfo), TSDB_CODE_SUCCESS);
+
+    SQInfo *pQInfo = (SQInfo *)qinfo;
+    if (memBudget >= 0) {
+      pQInfo->memAcct.budget = memBudget;
+    }
+
+    pRes->numOfRows = 0;
+    pRes->columns.assign(desc.functions.size(), std::vector<char>());
+
+    // the results are returned column-wise, in as many responses as needed
+    bool continueExec = true;
+    while (continueExec) {
+      qTableQuery(qinfo);
+
+      SRetrieveTableRsp *pRsp = NULL;
+      int32_t            contLen = 0;
+      pRes->code = qDumpRetrieveResult(qinfo, &pRsp, &contLen, &continueExec);
+
+      int32_t rows = htonl(pRsp->numOfRows);
+      char *  data = pRsp->data;
+      for (size_t i = 0; i < desc.functions.size(); i++) {
+        int32_t len = rows * outputBytes(desc.functions[i]);
+        pRes->columns[i].insert(pRes->columns[i].end(), data, data + len);
+        data += len;
+      }
+
+      pRes->numOfRows += rows;
+      rpcFreeCont(pRsp);
+    }
+
+    pRes->partialLoadBlocks = pQInfo->runtimeEnv.summary.partialLoadBlocks;
+    pRes->discardBlocks = pQInfo->runtimeEnv.summary.discardBlocks;
+    pRes->spilledGroups = pQInfo->runtimeEnv.pGroupSpill ? pQInfo->runtimeEnv.pGroupSpill->numOfSpilled : 0;
+
+    qDestroyQueryInfo(qinfo);
+    free(pMsg);
+  }
+
+  char *       rootDir = NULL;
+  TSKEY        startKey = 0;
+  STSchema *   schema = NULL;
+  STSchema *   tagSchema = NULL;
+  TSDB_REPO_T *repo = NULL;
+};
+
+}  // namespace
+
+TEST_F(ExecutorTest, groupbyNormalColumn) {
+  writeRows();
+
+  // every row of the table is a group of its own
+  STestQuery   desc = {startKey, startKey + numOfRows(TEST_TABLES) * TEST_INTERVAL,
+                       {TSDB_FUNC_COUNT, TSDB_FUNC_PRJ}, {TEST_TABLES}, true};
+  SQueryResult res;
+  runQuery(desc, &res);
+  ASSERT_EQ(res.code, TSDB_CODE_SUCCESS);
+  ASSERT_EQ(res.numOfRows, numOfRows(TEST_TABLES));
+
+  std::vector<bool> found(numOfRows(TEST_TABLES), false);
+  for (int i = 0; i < res.numOfRows; i++) {
+    EXPECT_EQ(res.bigintAt(0, i), 1);
+
+    int row = res.intAt(1, i) - rowValue(TEST_TABLES, 0);
+    ASSERT_TRUE(row >= 0 && row < numOfRows(TEST_TABLES));
+    EXPECT_FALSE(found[row]);
+    found[row] = true;
+  }
+}
+
+TEST_F(ExecutorTest, groupbyStatesOverMemBudget) {
+  writeRows();
+
+  // the states of the groups are spilled once they outgrow the budget, the same as without a budget
+  STestQuery   desc = {startKey, startKey + numOfRows(TEST_TABLES) * TEST_INTERVAL,
+                       {TSDB_FUNC_COUNT, TSDB_FUNC_PRJ}, {TEST_TABLES}, true};
+  SQueryResult res;
+  runQuery(desc, &res, 16 * 1024);
+  ASSERT_EQ(res.code, TSDB_CODE_SUCCESS);
+  ASSERT_EQ(res.numOfRows, numOfRows(TEST_TABLES));
+  EXPECT_GT(res.spilledGroups, 0);
+
+  std::vector<bool> found(numOfRows(TEST_TABLES), false);
+  for (int i = 0; i < res.numOfRows; i++) {
+    EXPECT_EQ(res.bigintAt(0, i), 1);
+
+    int row = res.intAt(1, i) - rowValue(TEST_TABLES, 0);
+    ASSERT_TRUE(row >= 0 && row < numOfRows(TEST_TABLES));
+    EXPECT_FALSE(found[row]);
+    found[row] = true;
+  }
+
+  // the budget is not exceeded by fewer groups
+  desc.ekey = startKey + 20 * TEST_INTERVAL;
+  runQuery(desc, &res, 16 * 1024);
+  EXPECT_EQ(res.code, TSDB_CODE_SUCCESS);
+  EXPECT_EQ(res.numOfRows, 21);
+  EXPECT_EQ(res.spilledGroups, 0);
+
+  // the sketches of hll can not be merged, the states are not spilled
+  desc = {startKey, startKey + numOfRows(TEST_TABLES) * TEST_INTERVAL, {TSDB_FUNC_HLL, TSDB_FUNC_PRJ},
+          {TEST_TABLES}, true};
+  runQuery(desc, &res, 16 * 1024);
+  EXPECT_EQ(res.code, TSDB_CODE_QRY_TOO_MANY_GROUPS);
+  EXPECT_EQ(res.numOfRows, 0);
+}
+
+TEST_F(ExecutorTest, groupbyMergeSpilledStates) {
+  writeRows();
+
+  // the rows of the table are written twice, the states of a group spilled before are merged with the later ones
+  int rows = numOfRows(TEST_TABLES);
+  ASSERT_EQ(insertRows(repo, schema, TEST_TABLES, startKey + rows * TEST_INTERVAL, 0, rows), 0);
+
+  STestQuery desc = {startKey,
+                     startKey + 2 * rows * TEST_INTERVAL,
+                     {TSDB_FUNC_COUNT, TSDB_FUNC_SUM, TSDB_FUNC_AVG, TSDB_FUNC_MIN, TSDB_FUNC_MAX, TSDB_FUNC_SPREAD,
+                      TSDB_FUNC_PRJ},
+                     {TEST_TABLES},
+                     true};
+  SQueryResult res;
+  runQuery(desc, &res, 16 * 1024);
+  ASSERT_EQ(res.code, TSDB_CODE_SUCCESS);
+  ASSERT_EQ(res.numOfRows, rows);
+  EXPECT_GT(res.spilledGroups, rows);
+
+  std::vector<bool> found(rows, false);
+  for (int i = 0; i < res.numOfRows; i++) {
+    int32_t val = res.intAt(6, i);
+    int     row = val - rowValue(TEST_TABLES, 0);
+    ASSERT_TRUE(row >= 0 && row < rows);
+    EXPECT_FALSE(found[row]);
+    found[row] = true;
+
+    EXPECT_EQ(res.bigintAt(0, i), 2);
+    EXPECT_EQ(res.bigintAt(1, i), 2 * (int64_t)val);
+    EXPECT_DOUBLE_EQ(res.doubleAt(2, i), val);
+    EXPECT_EQ(res.intAt(3, i), val);
+    EXPECT_EQ(res.intAt(4, i), val);
+    EXPECT_DOUBLE_EQ(res.doubleAt(5, i), 0);
+  }
+}
+
+TEST_F(ExecutorTest, filterColumnsLoadedFirst) {
+  writeRows();
+
+  // cuts the file block and the rows in memory, neither can be settled by the block statistics
+  const int32_t lower = rowValue(TEST_TABLES, 10), upper = rowValue(TEST_TABLES, 300);
+
+  int64_t count = 0, sum = 0, expectedCount = 0, expectedSum = 0;
+  expectedFilterResult(TEST_TABLES, lower, upper, 0, &expectedCount, &expectedSum);
+
+  SQueryResult res;
+  runFilterQuery(TEST_TABLES, lower, upper, &count, &sum, &res);
+  EXPECT_EQ(count, expectedCount);
+  EXPECT_EQ(sum, expectedSum);
+  EXPECT_GT(res.partialLoadBlocks, 0u);
+}
+
+TEST_F(ExecutorTest, filterColumnsDiscardBlock) {
+  writeRows();
+
+  // overlaps the range of the file block, but no value of it passes the filter
+  const int32_t value = rowValue(TEST_TABLES, 10);
+
+  STestQuery desc = {startKey, startKey + numOfRows(TEST_TABLES) * TEST_INTERVAL, {TSDB_FUNC_COUNT}, {TEST_TABLES},
+                     false, {rangeFilter(TSDB_RELATION_GREATER, value, TSDB_RELATION_LESS, value + 1)}};
+  SQueryResult res;
+  runQuery(desc, &res);
+  ASSERT_EQ(res.code, TSDB_CODE_SUCCESS);
+  EXPECT_TRUE(res.numOfRows == 0 || res.bigintAt(0, 0) == 0);
+  EXPECT_GT(res.partialLoadBlocks, 0u);
+  EXPECT_GE(res.discardBlocks, res.partialLoadBlocks);
+}
+
+TEST_F(ExecutorTest, filterColumnsInMemoryBlock) {
+  // all the rows stay in memory, so the blocks are loaded as a whole and filtered once
+  ASSERT_EQ(insertRows(repo, schema, TEST_TABLES, startKey, 0, numOfRows(TEST_TABLES)), 0);
+
+  const int32_t lower = rowValue(TEST_TABLES, 10), upper = rowValue(TEST_TABLES, 300);
+
+  int64_t count = 0, sum = 0, expectedCount = 0, expectedSum = 0;
+  expectedFilterResult(TEST_TABLES, lower, upper, 0, &expectedCount, &expectedSum);
+
+  SQueryResult res;
+  runFilterQuery(TEST_TABLES, lower, upper, &count, &sum, &res);
+  EXPECT_EQ(count, expectedCount);
+  EXPECT_EQ(sum, expectedSum);
+  EXPECT_EQ(res.partialLoadBlocks, 0u);
+}
+
+TEST_F(ExecutorTest, filterColumnsWithNull) {
+  const int nullEvery = 7;
+  ASSERT_EQ(insertRows(repo, schema, TEST_TABLES, startKey, 0, numOfRows(TEST_TABLES), nullEvery), 0);
+
+  tsdbCloseRepo(repo, 1);
+  repo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(repo, nullptr);
+
+  const int32_t lower = rowValue(TEST_TABLES, 10), upper = rowValue(TEST_TABLES, 300);
+
+  int64_t count = 0, sum = 0, expectedCount = 0, expectedSum = 0;
+  expectedFilterResult(TEST_TABLES, lower, upper, nullEvery, &expectedCount, &expectedSum);
+
+  SQueryResult res;
+  runFilterQuery(TEST_TABLES, lower, upper, &count, &sum, &res);
+  EXPECT_EQ(count, expectedCount);
+  EXPECT_EQ(sum, expectedSum);
+  EXPECT_GT(res.partialLoadBlocks, 0u);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <cassert>
+#include <iostream>
+
+#include "taos.h"
+#include "tsdb.h"
+
+extern "C" {
+#include "qExecutor.h"
+#include "qUtil.h"
+
+bool doFilterData(SQuery *pQuery, int32_t elemPos);
+}
+
+namespace {
+const int32_t numOfRows = 1000;
+
+// set up the filter function in the same way as createFilterInfo
+void setFilterFunc(SColumnFilterElem* pElem, int16_t type) {
+  int32_t lower = pElem->filterInfo.lowerRelOptr;
+  int32_t upper = pElem->filterInfo.upperRelOptr;
+
+  if (lower != TSDB_RELATION_INVALID && upper != TSDB_RELATION_INVALID) {
+    __filter_func_t* rangeFilterArray = getRangeFilterFuncArray(type);
+    int32_t          index = (lower == TSDB_RELATION_GREATER_EQUAL) ? (upper == TSDB_RELATION_LESS_EQUAL ? 4 : 2)
+                                                                    : (upper == TSDB_RELATION_LESS_EQUAL ? 3 : 1);
+    pElem->fp = rangeFilterArray[index];
+  } else {
+    pElem->fp = getValueFilterFuncArray(type)[(lower != TSDB_RELATION_INVALID) ? lower : upper];
+  }
+}
+
+SSingleColumnFilterInfo columnFilterInfo(int16_t type, int16_t bytes, void* pData, SColumnFilterElem* pFilters,
+                                         int32_t numOfFilters) {
+  SSingleColumnFilterInfo info = {0};
+  info.pData = pData;
+  info.hasNull = true;
+  info.info.type = type;
+  info.info.bytes = bytes;
+  info.numOfFilters = numOfFilters;
+  info.pFilters = pFilters;
+
+  for (int32_t j = 0; j < numOfFilters; ++j) {
+    setFilterFunc(&pFilters[j], type);
+  }
+
+  return info;
+}
+
+// the rows selected over the whole block must be the ones doFilterData qualifies row by row
+void checkColumnFilters(SSingleColumnFilterInfo* pInfo, int32_t numOfFilterCols) {
+  SQuery query = {0};
+  query.numOfFilterCols = numOfFilterCols;
+  query.pFilterInfo = pInfo;
+
+  int8_t sel[numOfRows];
+  int8_t buf[numOfRows];
+  memset(sel, 1, sizeof(sel));
+
+  for (int32_t k = 0; k < numOfFilterCols; ++k) {
+    doFilterColumnDataBlock(&pInfo[k], numOfRows, sel, buf);
+  }
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    ASSERT_EQ(sel[i] != 0, doFilterData(&query, i)) << "type:" << pInfo[0].info.type << " row:" << i;
+  }
+}
+
+void checkFilters(int16_t type, int16_t bytes, void* pData, SColumnFilterElem* pFilters, int32_t numOfFilters) {
+  SSingleColumnFilterInfo info = columnFilterInfo(type, bytes, pData, pFilters, numOfFilters);
+  checkColumnFilters(&info, 1);
+}
+
+SColumnFilterElem intFilter(int16_t lower, int64_t lowerBnd, int16_t upper, int64_t upperBnd) {
+  SColumnFilterElem elem = {0};
+  elem.filterInfo.lowerRelOptr = lower;
+  elem.filterInfo.upperRelOptr = upper;
+  elem.filterInfo.lowerBndi = lowerBnd;
+  elem.filterInfo.upperBndi = upperBnd;
+  return elem;
+}
+
+SColumnFilterElem realFilter(int16_t lower, double lowerBnd, int16_t upper, double upperBnd) {
+  SColumnFilterElem elem = {0};
+  elem.filterInfo.lowerRelOptr = lower;
+  elem.filterInfo.upperRelOptr = upper;
+  elem.filterInfo.lowerBndd = lowerBnd;
+  elem.filterInfo.upperBndd = upperBnd;
+  return elem;
+}
+
+template <typename T>
+void checkIntegerFilters(int16_t type, uint64_t nullVal) {
+  T data[numOfRows];
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    data[i] = (T)(rand() % 200 - 100);
+    if (i % 37 == 0) memcpy(&data[i], &nullVal, sizeof(T));
+  }
+
+  int16_t ops[][2] = {
+      {TSDB_RELATION_GREATER, TSDB_RELATION_INVALID},     {TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_INVALID},
+      {TSDB_RELATION_INVALID, TSDB_RELATION_LESS},        {TSDB_RELATION_INVALID, TSDB_RELATION_LESS_EQUAL},
+      {TSDB_RELATION_EQUAL, TSDB_RELATION_INVALID},       {TSDB_RELATION_NOT_EQUAL, TSDB_RELATION_INVALID},
+      {TSDB_RELATION_GREATER, TSDB_RELATION_LESS},        {TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_LESS_EQUAL},
+      {TSDB_RELATION_GREATER, TSDB_RELATION_LESS_EQUAL},  {TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_LESS},
+      {TSDB_RELATION_ISNULL, TSDB_RELATION_INVALID},      {TSDB_RELATION_NOTNULL, TSDB_RELATION_INVALID},
+  };
+
+  // bounds inside and out of the range of the type
+  int64_t bounds[] = {-1000, -100, -3, 0, 5, 99, 1000, INT64_MIN, INT64_MAX};
+
+  for (auto& op : ops) {
+    for (auto lb : bounds) {
+      for (auto ub : bounds) {
+        SColumnFilterElem elem = intFilter(op[0], lb, op[1], ub);
+        checkFilters(type, sizeof(T), data, &elem, 1);
+      }
+    }
+  }
+
+  // filters on the same column are or-ed
+  SColumnFilterElem elems[] = {intFilter(TSDB_RELATION_INVALID, 0, TSDB_RELATION_LESS, -50),
+                               intFilter(TSDB_RELATION_EQUAL, 7, TSDB_RELATION_INVALID, 0),
+                               intFilter(TSDB_RELATION_ISNULL, 0, TSDB_RELATION_INVALID, 0)};
+  checkFilters(type, sizeof(T), data, elems, 3);
+}
+
+template <typename T>
+void checkRealFilters(int16_t type, uint64_t nullVal) {
+  T data[numOfRows];
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    data[i] = (T)((rand() % 400 - 200) / 4.0);
+    if (i % 37 == 0) memcpy(&data[i], &nullVal, sizeof(T));
+  }
+
+  int16_t ops[][2] = {
+      {TSDB_RELATION_GREATER, TSDB_RELATION_INVALID},     {TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_INVALID},
+      {TSDB_RELATION_INVALID, TSDB_RELATION_LESS},        {TSDB_RELATION_INVALID, TSDB_RELATION_LESS_EQUAL},
+      {TSDB_RELATION_EQUAL, TSDB_RELATION_INVALID},       {TSDB_RELATION_NOT_EQUAL, TSDB_RELATION_INVALID},
+      {TSDB_RELATION_GREATER, TSDB_RELATION_LESS},        {TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_LESS_EQUAL},
+      {TSDB_RELATION_GREATER, TSDB_RELATION_LESS_EQUAL},  {TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_LESS},
+  };
+
+  double bounds[] = {-100.0, -10.25, 0.0, 3.5, 12.75, 100.0};
+
+  for (auto& op : ops) {
+    for (auto lb : bounds) {
+      for (auto ub : bounds) {
+        SColumnFilterElem elem = realFilter(op[0], lb, op[1], ub);
+        checkFilters(type, sizeof(T), data, &elem, 1);
+      }
+    }
+  }
+}
+}  // namespace
+
+TEST(testCase, blockFilterIntegerTest) {
+  checkIntegerFilters<int8_t>(TSDB_DATA_TYPE_TINYINT, TSDB_DATA_TINYINT_NULL);
+  checkIntegerFilters<int16_t>(TSDB_DATA_TYPE_SMALLINT, TSDB_DATA_SMALLINT_NULL);
+  checkIntegerFilters<int32_t>(TSDB_DATA_TYPE_INT, TSDB_DATA_INT_NULL);
+  checkIntegerFilters<int64_t>(TSDB_DATA_TYPE_BIGINT, TSDB_DATA_BIGINT_NULL);
+}
+
+TEST(testCase, blockFilterRealTest) {
+  checkRealFilters<float>(TSDB_DATA_TYPE_FLOAT, TSDB_DATA_FLOAT_NULL);
+  checkRealFilters<double>(TSDB_DATA_TYPE_DOUBLE, TSDB_DATA_DOUBLE_NULL);
+}
+
+TEST(testCase, blockFilterColumnsTest) {
+  int32_t iData[numOfRows];
+  double  dData[numOfRows];
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    iData[i] = (i % 41 == 0) ? TSDB_DATA_INT_NULL : rand() % 200 - 100;
+    dData[i] = (rand() % 400 - 200) / 4.0;
+    if (i % 43 == 0) {
+      uint64_t nullVal = TSDB_DATA_DOUBLE_NULL;
+      memcpy(&dData[i], &nullVal, sizeof(double));
+    }
+  }
+
+  // the filters of a column are or-ed, the columns are and-ed
+  SColumnFilterElem iElems[] = {intFilter(TSDB_RELATION_GREATER_EQUAL, -20, TSDB_RELATION_LESS, 60),
+                                intFilter(TSDB_RELATION_ISNULL, 0, TSDB_RELATION_INVALID, 0)};
+  SColumnFilterElem dElems[] = {realFilter(TSDB_RELATION_INVALID, 0, TSDB_RELATION_LESS_EQUAL, 12.75),
+                                realFilter(TSDB_RELATION_NOT_EQUAL, 0, TSDB_RELATION_INVALID, 0)};
+
+  SSingleColumnFilterInfo info[] = {
+      columnFilterInfo(TSDB_DATA_TYPE_INT, sizeof(int32_t), iData, iElems, 2),
+      columnFilterInfo(TSDB_DATA_TYPE_DOUBLE, sizeof(double), dData, dElems, 2),
+  };
+  checkColumnFilters(info, 2);
+
+  info[1].numOfFilters = 1;
+  checkColumnFilters(info, 2);
+}
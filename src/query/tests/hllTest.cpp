@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "taos.h"
+
+extern "C" {
+#include "qHll.h"
+}
+
+namespace {
+// the estimate is expected within 5 times of the standard error of 1.6%
+void checkEstimate(int64_t numOfDistinct) {
+  SHllInfo info = {0};
+  for (int64_t i = 0; i < numOfDistinct; ++i) {
+    int64_t v = i * 7919 + 13;
+    tHllAdd(&info, &v, sizeof(v));
+
+    // duplicated values do not change the estimate
+    tHllAdd(&info, &v, sizeof(v));
+  }
+
+  int64_t est = tHllCount(&info);
+  double  err = fabs((double)(est - numOfDistinct)) / numOfDistinct;
+  ASSERT_LT(err, 0.08) << "distinct:" << numOfDistinct << " estimate:" << est;
+}
+}  // namespace
+
+TEST(testCase, hllEmptyTest) {
+  SHllInfo info = {0};
+  ASSERT_EQ(tHllCount(&info), 0);
+
+  const char* s = "abc";
+  tHllAdd(&info, s, 3);
+  ASSERT_EQ(tHllCount(&info), 1);
+}
+
+TEST(testCase, hllEstimateTest) {
+  int64_t sizes[] = {10, 100, 1000, 10000, 100000, 1000000};
+  for (auto n : sizes) {
+    checkEstimate(n);
+  }
+}
+
+TEST(testCase, hllMergeTest) {
+  SHllInfo all = {0};
+  SHllInfo part[4] = {{0}};
+
+  for (int32_t i = 0; i < 200000; ++i) {
+    char buf[32] = {0};
+    int32_t len = snprintf(buf, sizeof(buf), "device_%d", i % 50000);
+
+    tHllAdd(&all, buf, len);
+    tHllAdd(&part[i % 4], buf, len);
+  }
+
+  SHllInfo merged = {0};
+  for (int32_t i = 0; i < 4; ++i) {
+    tHllMerge(&merged, &part[i]);
+  }
+
+  // the union of the sketches is the sketch of the union
+  ASSERT_EQ(memcmp(&merged, &all, sizeof(SHllInfo)), 0);
+  ASSERT_EQ(tHllCount(&merged), tHllCount(&all));
+  ASSERT_LT(fabs((double)(tHllCount(&merged) - 50000)) / 50000, 0.08);
+}
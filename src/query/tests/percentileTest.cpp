@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "taos.h"
+#include "tsdb.h"
+
+extern "C" {
+#include "qPercentile.h"
+}
+
+namespace {
+double percents[] = {0, 0.1, 1, 10, 25, 50, 75, 90, 99, 99.9, 100};
+
+template <typename T>
+double bucketPercentile(const std::vector<T>& vals, int16_t type, double percent) {
+  T minVal = vals[0], maxVal = vals[0];
+  for (auto v : vals) {
+    minVal = std::min(minVal, v);
+    maxVal = std::max(maxVal, v);
+  }
+
+  tMemBucket* pBucket = tMemBucketCreate(sizeof(T), type, (double)minVal, (double)maxVal, NULL);
+  tMemBucketPut(pBucket, vals.data(), vals.size());
+
+  double res = getPercentile(pBucket, percent);
+  tMemBucketDestroy(pBucket);
+  return res;
+}
+
+template <typename T>
+void checkSelect(int16_t type, int32_t num, int32_t range) {
+  std::vector<T> vals(num);
+  for (int32_t i = 0; i < num; ++i) {
+    vals[i] = (T)(rand() % range - range / 4);
+  }
+
+  for (auto p : percents) {
+    std::vector<T> buf(vals);
+    double         res = tPercentileSelect(buf.data(), num, type, p);
+    ASSERT_DOUBLE_EQ(res, bucketPercentile(vals, type, p)) << "type:" << type << " num:" << num << " percent:" << p;
+  }
+}
+
+template <typename T>
+void benchmark(int16_t type, int64_t num) {
+  std::vector<T> vals(num);
+  for (int64_t i = 0; i < num; ++i) {
+    vals[i] = (T)(rand() % 10000000);
+  }
+
+  auto   st = std::chrono::steady_clock::now();
+  double bucket = bucketPercentile(vals, type, 99);
+  auto   mid = std::chrono::steady_clock::now();
+  double select = tPercentileSelect(vals.data(), num, type, 99);
+  auto   et = std::chrono::steady_clock::now();
+
+  ASSERT_DOUBLE_EQ(bucket, select);
+  std::cout << "type:" << type << " num:" << num
+            << " bucket:" << std::chrono::duration_cast<std::chrono::milliseconds>(mid - st).count() << "ms"
+            << " select:" << std::chrono::duration_cast<std::chrono::milliseconds>(et - mid).count() << "ms"
+            << std::endl;
+}
+}  // namespace
+
+TEST(testCase, percentileSelectTest) {
+  int32_t sizes[] = {1, 2, 3, 10, 1000, 100000};
+  for (auto n : sizes) {
+    checkSelect<int8_t>(TSDB_DATA_TYPE_TINYINT, n, 200);
+    checkSelect<int16_t>(TSDB_DATA_TYPE_SMALLINT, n, 20000);
+    checkSelect<int32_t>(TSDB_DATA_TYPE_INT, n, 1000000);
+    checkSelect<int64_t>(TSDB_DATA_TYPE_BIGINT, n, 1000000);
+    checkSelect<float>(TSDB_DATA_TYPE_FLOAT, n, 1000000);
+    checkSelect<double>(TSDB_DATA_TYPE_DOUBLE, n, 1000000);
+  }
+}
+
+TEST(testCase, percentileSelectDuplicateTest) {
+  // all the same, and sorted in both orders
+  std::vector<int32_t> vals(100000, 7);
+  ASSERT_EQ(tPercentileSelect(vals.data(), vals.size(), TSDB_DATA_TYPE_INT, 50), 7);
+
+  for (int32_t i = 0; i < (int32_t)vals.size(); ++i) {
+    vals[i] = i;
+  }
+  ASSERT_DOUBLE_EQ(tPercentileSelect(vals.data(), vals.size(), TSDB_DATA_TYPE_INT, 99), 98999.01);
+
+  for (int32_t i = 0; i < (int32_t)vals.size(); ++i) {
+    vals[i] = (int32_t)vals.size() - i;
+  }
+  ASSERT_DOUBLE_EQ(tPercentileSelect(vals.data(), vals.size(), TSDB_DATA_TYPE_INT, 1), 1000.99);
+}
+
+// run with --gtest_also_run_disabled_tests, the 100M cases take about 1.2GB memory
+TEST(testCase, DISABLED_percentileBenchmark) {
+  benchmark<int32_t>(TSDB_DATA_TYPE_INT, 10000000);
+  benchmark<double>(TSDB_DATA_TYPE_DOUBLE, 10000000);
+  benchmark<int32_t>(TSDB_DATA_TYPE_INT, 100000000);
+  benchmark<double>(TSDB_DATA_TYPE_DOUBLE, 100000000);
+}
@@ -10,7 +10,7 @@ namespace {
 // simple test
 void simpleTest() {
   SDiskbasedResultBuf* pResultBuf = NULL;
-  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 4096, NULL);
+  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 4096, NULL, NULL);
   
   int32_t pageId = 0;
   int32_t groupId = 0;
@@ -52,7 +52,7 @@ void simpleTest() {
 
 void writeDownTest() {
   SDiskbasedResultBuf* pResultBuf = NULL;
-  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 4*1024, NULL);
+  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 4*1024, NULL, NULL);
 
   int32_t pageId = 0;
   int32_t writePageId = 0;
@@ -99,7 +99,7 @@ void writeDownTest() {
 
 void recyclePageTest() {
   SDiskbasedResultBuf* pResultBuf = NULL;
-  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 4*1024, NULL);
+  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 4*1024, NULL, NULL);
 
   int32_t pageId = 0;
   int32_t writePageId = 0;
@@ -149,6 +149,49 @@ void recyclePageTest() {
 
   destroyResultBuf(pResultBuf);
 }
+
+// pages are flushed to disk once the query memory budget is used up, even if the buffer has room for them
+void memBudgetTest() {
+  SQueryMemAcct acct;
+  qInitMemAcct(&acct, 3 * 1024, 1024 * 1024);
+
+  SDiskbasedResultBuf* pResultBuf = NULL;
+  int32_t ret = createDiskbasedResultBuffer(&pResultBuf, 64, 1024, 16*1024, NULL, &acct);
+  ASSERT_EQ(ret, TSDB_CODE_SUCCESS);
+
+  int32_t pageId = 0;
+  int32_t groupId = 0;
+
+  for (int32_t i = 0; i < 8; ++i) {
+    tFilePage* pBufPage = getNewDataBuf(pResultBuf, groupId, &pageId);
+    ASSERT_TRUE(pBufPage != NULL);
+    *(int32_t*)(pBufPage->data) = i;
+    releaseResBufPage(pResultBuf, pBufPage);
+  }
+
+  ASSERT_GT(pResultBuf->statis.flushPages, 0);
+  ASSERT_LE(qGetMemUsage(&acct), 4 * (1024 + 8));
+  ASSERT_FALSE(qMemLimitExceeded(&acct));
+
+  // the flushed pages are loaded from disk again
+  for (int32_t i = 0; i < 8; ++i) {
+    tFilePage* pBufPage = getResBufPage(pResultBuf, i);
+    ASSERT_EQ(*(int32_t*)(pBufPage->data), i);
+    releaseResBufPage(pResultBuf, pBufPage);
+  }
+
+  destroyResultBuf(pResultBuf);
+  ASSERT_EQ(qGetMemUsage(&acct), 0);
+  ASSERT_GT(acct.peak, 0);
+
+  // the allocations beyond the limit still succeed, but the limit is marked as exceeded
+  qInitMemAcct(&acct, 0, 1024);
+  void* p = qMemCalloc(&acct, 2048);
+  ASSERT_TRUE(p != NULL);
+  ASSERT_TRUE(qMemLimitExceeded(&acct));
+  qMemFree(&acct, p);
+  ASSERT_EQ(qGetMemUsage(&acct), 0);
+}
 } // namespace
 
 
@@ -157,4 +200,5 @@ TEST(testCase, resultBufferTest) {
   simpleTest();
   writeDownTest();
   recyclePageTest();
+  memBudgetTest();
 }
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "taos.h"
+#include "tglobal.h"
+#include "trpc.h"
+#include "tsdb.h"
+
+extern "C" {
+#include "qExecutor.h"
+}
+
+namespace {
+
+const int      TEST_VNODE = 3;
+const uint64_t TEST_SUPER_UID = 8001;
+const int      TEST_TABLES = 9;
+const TSKEY    TEST_INTERVAL = 1000;
+
+void setScanCfg(STsdbCfg *pCfg) {
+  memset((void *)pCfg, 0, sizeof(*pCfg));
+  pCfg->tsdbId = TEST_VNODE;
+  pCfg->cacheBlockSize = 16;
+  pCfg->totalBlocks = 4;
+  pCfg->daysPerFile = 10;
+  pCfg->keep = 3650;
+  pCfg->minRowsPerFileBlock = 100;
+  pCfg->maxRowsPerFileBlock = 4096;
+  pCfg->precision = TSDB_TIME_PRECISION_MILLI;
+  pCfg->compression = 2;
+}
+
+uint64_t tableUid(int tid) { return TEST_SUPER_UID + tid; }
+
+// table tid has tid * 40 rows, the row i of it has the value tid * 1000 + i
+int numOfRows(int tid) { return tid * 40; }
+int32_t rowValue(int tid, int i) { return tid * 1000 + i; }
+
+int insertRows(TSDB_REPO_T *repo, STSchema *pSchema, int tid, TSKEY startKey, int from, int nRows) {
+  SSubmitMsg *pMsg =
+      (SSubmitMsg *)calloc(1, sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * nRows);
+  if (pMsg == NULL) return -1;
+
+  SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+  for (int i = from; i < from + nRows; i++) {
+    SDataRow row = (SDataRow)(pBlock->data + pBlock->dataLen);
+    tdInitDataRow(row, pSchema);
+
+    TSKEY   key = startKey + i * TEST_INTERVAL;
+    int32_t val = rowValue(tid, i);
+    tdAppendColVal(row, (void *)(&key), TSDB_DATA_TYPE_TIMESTAMP, 8, schemaColAt(pSchema, 0)->offset);
+    tdAppendColVal(row, (void *)(&val), TSDB_DATA_TYPE_INT, 4, schemaColAt(pSchema, 1)->offset);
+    pBlock->dataLen += dataRowLen(row);
+    pBlock->numOfRows++;
+  }
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->dataLen);
+  pMsg->numOfBlocks = htonl(1);
+  pBlock->dataLen = htonl(pBlock->dataLen);
+  pBlock->numOfRows = htons(pBlock->numOfRows);
+  pBlock->uid = htobe64(tableUid(tid));
+  pBlock->tid = htonl(tid);
+  pBlock->sversion = htonl(0);
+
+  int code = tsdbInsertData(repo, pMsg, NULL);
+  free(pMsg);
+  return code;
+}
+
+// select count(c1), sum(c1), max(c1), min(c1) from the child tables
+SQueryTableMsg *buildQueryMsg(TSKEY skey, TSKEY ekey) {
+  const int16_t functions[] = {TSDB_FUNC_COUNT, TSDB_FUNC_SUM, TSDB_FUNC_MAX, TSDB_FUNC_MIN};
+  const int     numOfOutput = tListLen(functions);
+
+  size_t size = sizeof(SQueryTableMsg) + 2 * sizeof(SColumnInfo) + numOfOutput * sizeof(SSqlFuncMsg) +
+                TEST_TABLES * sizeof(STableIdInfo) + 1;
+  SQueryTableMsg *pMsg = (SQueryTableMsg *)calloc(1, size);
+
+  pMsg->window.skey = htobe64(skey);
+  pMsg->window.ekey = htobe64(ekey);
+  pMsg->numOfTables = htonl(TEST_TABLES);
+  pMsg->order = htons(TSDB_ORDER_ASC);
+  pMsg->numOfCols = htons(2);
+  pMsg->queryType = htonl(TSDB_QUERY_TYPE_MULTITABLE_QUERY);
+  pMsg->numOfOutput = htons(numOfOutput);
+  pMsg->fillType = htons(TSDB_FILL_NONE);
+
+  for (int16_t i = 0; i < 2; i++) {
+    pMsg->colList[i].colId = htons(i);
+    pMsg->colList[i].type = htons(i == 0 ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT);
+    pMsg->colList[i].bytes = htons(i == 0 ? 8 : 4);
+  }
+
+  char *p = (char *)(pMsg->colList + 2);
+  for (int i = 0; i < numOfOutput; i++, p += sizeof(SSqlFuncMsg)) {
+    SSqlFuncMsg *pFunc = (SSqlFuncMsg *)p;
+    pFunc->functionId = htons(functions[i]);
+    pFunc->colInfo.colId = htons(1);
+    pFunc->colInfo.colIndex = htons(1);
+    pFunc->colInfo.flag = htons(TSDB_COL_NORMAL);
+  }
+
+  for (int tid = 1; tid <= TEST_TABLES; tid++, p += sizeof(STableIdInfo)) {
+    STableIdInfo *pId = (STableIdInfo *)p;
+    pId->uid = htobe64(tableUid(tid));
+    pId->tid = htonl(tid);
+    pId->key = htobe64(skey);
+  }
+
+  return pMsg;
+}
+
+struct SAggResult {
+  int64_t count;
+  int64_t sum;
+  int32_t max;
+  int32_t min;
+  int64_t memUsage;  // bytes accounted to the query after the scan, except the buffers of its own query handle
+};
+
+class ScanWorkerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rootDir = strdup("./scan_vnode");
+    taosRemoveDir(rootDir);
+    startKey = taosGetTimestamp(TSDB_TIME_PRECISION_MILLI) - 30 * tsMsPerDay[TSDB_TIME_PRECISION_MILLI];
+
+    STsdbCfg tsdbCfg;
+    setScanCfg(&tsdbCfg);
+    ASSERT_EQ(tsdbCreateRepo(rootDir, &tsdbCfg), 0);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    STSchemaBuilder schemaBuilder = {0};
+    tdInitTSchemaBuilder(&schemaBuilder, 0);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, 8);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, 1, 4);
+    schema = tdGetSchemaFromBuilder(&schemaBuilder);
+    tdResetTSchemaBuilder(&schemaBuilder, 0);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, 2, 4);
+    tagSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+    tdDestroyTSchemaBuilder(&schemaBuilder);
+
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      SKVRowBuilder kvBuilder;
+      ASSERT_EQ(tdInitKVRowBuilder(&kvBuilder), 0);
+      tdAddColToKVRow(&kvBuilder, 2, TSDB_DATA_TYPE_INT, &tid);
+
+      char name[TSDB_TABLE_NAME_LEN] = "\0";
+      snprintf(name, sizeof(name), "scan_t%d", tid);
+
+      STableCfg cfg;
+      memset((void *)&cfg, 0, sizeof(cfg));
+      cfg.type = TSDB_CHILD_TABLE;
+      cfg.name = name;
+      cfg.sname = (char *)"scan_st";
+      cfg.tableId.tid = tid;
+      cfg.tableId.uid = tableUid(tid);
+      cfg.superUid = TEST_SUPER_UID;
+      cfg.schema = schema;
+      cfg.tagSchema = tagSchema;
+      cfg.tagValues = tdGetKVRowFromBuilder(&kvBuilder);
+      tdDestroyKVRowBuilder(&kvBuilder);
+
+      ASSERT_EQ(tsdbCreateTable(repo, &cfg), 0);
+      kvRowFree(cfg.tagValues);
+    }
+  }
+
+  void TearDown() override {
+    if (repo) tsdbCloseRepo(repo, 0);
+    tdFreeSchema(schema);
+    tdFreeSchema(tagSchema);
+    taosRemoveDir(rootDir);
+    free(rootDir);
+    tsNumOfScanThreads = 1;
+  }
+
+  // the first half of the rows of each table is committed to the data files, the other half stays in memory
+  void writeRows() {
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      ASSERT_EQ(insertRows(repo, schema, tid, startKey, 0, numOfRows(tid) / 2), 0);
+    }
+
+    tsdbCloseRepo(repo, 1);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      ASSERT_EQ(insertRows(repo, schema, tid, startKey, numOfRows(tid) / 2, numOfRows(tid) - numOfRows(tid) / 2), 0);
+    }
+  }
+
+  SAggResult expectedResult(TSKEY skey, TSKEY ekey) {
+    SAggResult res = {0, 0, INT32_MIN, INT32_MAX};
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      for (int i = 0; i < numOfRows(tid); i++) {
+        TSKEY key = startKey + i * TEST_INTERVAL;
+        if (key < skey || key > ekey) continue;
+
+        res.count += 1;
+        res.sum += rowValue(tid, i);
+        res.max = MAX(res.max, rowValue(tid, i));
+        res.min = MIN(res.min, rowValue(tid, i));
+      }
+    }
+    return res;
+  }
+
+  void runQuery(int32_t numOfScanThreads, TSKEY skey, TSKEY ekey, SAggResult *pRes, uint32_t *scanWorkers) {
+    tsNumOfScanThreads = numOfScanThreads;
+
+    SQueryTableMsg *pMsg = buildQueryMsg(skey, ekey);
+    qinfo_t         qinfo = NULL;
+    ASSERT_EQ(qCreateQueryInfo(repo, TEST_VNODE, pMsg, &qinfo), TSDB_CODE_SUCCESS);
+
+    qTableQuery(qinfo);
+
+    SRetrieveTableRsp *pRsp = NULL;
+    int32_t            contLen = 0;
+    bool               continueExec = false;
+    ASSERT_EQ(qDumpRetrieveResult(qinfo, &pRsp, &contLen, &continueExec), TSDB_CODE_SUCCESS);
+    ASSERT_EQ(htonl(pRsp->numOfRows), 1);
+
+    // the result is column-wise: count and sum are bigint, max and min are int
+    char *data = pRsp->data;
+    pRes->count = *(int64_t *)data;
+    pRes->sum = *(int64_t *)(data + 8);
+    pRes->max = *(int32_t *)(data + 16);
+    pRes->min = *(int32_t *)(data + 20);
+
+    SQInfo *pQInfo = (SQInfo *)qinfo;
+    pRes->memUsage = qGetMemUsage(&pQInfo->memAcct) - pQInfo->runtimeEnv.tsdbMemSize;
+    *scanWorkers = pQInfo->runtimeEnv.summary.scanWorkers;
+
+    rpcFreeCont(pRsp);
+    qDestroyQueryInfo(qinfo);
+    free(pMsg);
+  }
+
+  void checkQuery(TSKEY skey, TSKEY ekey) {
+    SAggResult expected = expectedResult(skey, ekey);
+    ASSERT_GT(expected.count, 0);
+
+    SAggResult serial;
+    uint32_t   scanWorkers = 0;
+    runQuery(1, skey, ekey, &serial, &scanWorkers);
+    EXPECT_EQ(scanWorkers, 0u);
+    EXPECT_EQ(serial.count, expected.count);
+    EXPECT_EQ(serial.sum, expected.sum);
+    EXPECT_EQ(serial.max, expected.max);
+    EXPECT_EQ(serial.min, expected.min);
+
+    // more workers than the threads of the pool, the query thread scans the workers not taken by the pool
+    const int32_t threads[] = {2, 4, TEST_TABLES, 64};
+    for (int32_t numOfThreads : threads) {
+      SAggResult parallel;
+      runQuery(numOfThreads, skey, ekey, &parallel, &scanWorkers);
+      EXPECT_EQ(scanWorkers, (uint32_t)MIN(numOfThreads, TEST_TABLES));
+      EXPECT_EQ(parallel.count, serial.count);
+      EXPECT_EQ(parallel.sum, serial.sum);
+      EXPECT_EQ(parallel.max, serial.max);
+      EXPECT_EQ(parallel.min, serial.min);
+
+      // the memory of the workers is released once they are merged
+      EXPECT_EQ(parallel.memUsage, serial.memUsage);
+    }
+  }
+
+  char *       rootDir = NULL;
+  TSKEY        startKey = 0;
+  STSchema *   schema = NULL;
+  STSchema *   tagSchema = NULL;
+  TSDB_REPO_T *repo = NULL;
+};
+
+}  // namespace
+
+TEST_F(ScanWorkerTest, parallelScanMatchesSerialScan) {
+  writeRows();
+  checkQuery(startKey, startKey + numOfRows(TEST_TABLES) * TEST_INTERVAL);
+}
+
+TEST_F(ScanWorkerTest, parallelScanOfTimeRange) {
+  writeRows();
+
+  // a range cutting the rows in the data files and the rows in memory of the larger tables
+  checkQuery(startKey + 30 * TEST_INTERVAL, startKey + 150 * TEST_INTERVAL);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "taos.h"
+
+extern "C" {
+#include "qTDigest.h"
+}
+
+namespace {
+const int32_t numOfVals = 1000000;
+
+double exactQuantile(std::vector<double>& sorted, double q) {
+  double  index = q * (sorted.size() - 1);
+  int32_t i = (int32_t)index;
+  if (i + 1 >= (int32_t)sorted.size()) {
+    return sorted.back();
+  }
+
+  return sorted[i] + (sorted[i + 1] - sorted[i]) * (index - i);
+}
+
+void addAll(STDigest* pDigest, const std::vector<double>& vals) {
+  double buf[TDIGEST_BATCH_SIZE];
+  for (size_t i = 0; i < vals.size(); i += TDIGEST_BATCH_SIZE) {
+    int32_t n = (int32_t)std::min(vals.size() - i, (size_t)TDIGEST_BATCH_SIZE);
+    std::copy(vals.begin() + i, vals.begin() + i + n, buf);
+    tTDigestAddBatch(pDigest, buf, n);
+  }
+}
+
+// the rank error of the estimate, which is what the t-digest bounds
+double rankError(std::vector<double>& sorted, double q, double est) {
+  double rank = std::lower_bound(sorted.begin(), sorted.end(), est) - sorted.begin();
+  return fabs(rank / sorted.size() - q);
+}
+
+void checkQuantiles(std::vector<double>& vals) {
+  STDigest* pDigest = (STDigest*)malloc(sizeof(STDigest));
+  tTDigestInit(pDigest);
+  addAll(pDigest, vals);
+
+  ASSERT_EQ(pDigest->total, (int64_t)vals.size());
+  ASSERT_LE(pDigest->numOfCentroids, TDIGEST_COMPRESSION + 1);
+
+  std::vector<double> sorted(vals);
+  std::sort(sorted.begin(), sorted.end());
+
+  ASSERT_EQ(tTDigestQuantile(pDigest, 0), sorted.front());
+  ASSERT_EQ(tTDigestQuantile(pDigest, 1), sorted.back());
+
+  double qs[] = {0.5, 0.9, 0.99, 0.999, 0.001, 0.01};
+  for (auto q : qs) {
+    double est = tTDigestQuantile(pDigest, q);
+
+    // the error shrinks with q * (1 - q)
+    double bound = (q == 0.5 || q == 0.9) ? 0.005 : 0.0005;
+    ASSERT_LT(rankError(sorted, q, est), bound) << "q:" << q << " est:" << est << " exact:" << exactQuantile(sorted, q);
+  }
+
+  free(pDigest);
+}
+}  // namespace
+
+TEST(testCase, tdigestEmptyTest) {
+  STDigest* pDigest = (STDigest*)malloc(sizeof(STDigest));
+  tTDigestInit(pDigest);
+  ASSERT_TRUE(std::isnan(tTDigestQuantile(pDigest, 0.5)));
+
+  double v = 42;
+  tTDigestAddBatch(pDigest, &v, 1);
+  ASSERT_EQ(tTDigestQuantile(pDigest, 0.5), 42);
+  ASSERT_EQ(tTDigestQuantile(pDigest, 0.99), 42);
+  free(pDigest);
+}
+
+TEST(testCase, tdigestQuantileTest) {
+  std::vector<double> vals(numOfVals);
+
+  // uniform
+  for (int32_t i = 0; i < numOfVals; ++i) {
+    vals[i] = rand() % 100000;
+  }
+  checkQuantiles(vals);
+
+  // long tail, the latency-like distribution
+  for (int32_t i = 0; i < numOfVals; ++i) {
+    vals[i] = -log((rand() + 1.0) / ((double)RAND_MAX + 2)) * 1000;
+  }
+  checkQuantiles(vals);
+
+  // sorted input
+  std::sort(vals.begin(), vals.end());
+  checkQuantiles(vals);
+}
+
+TEST(testCase, tdigestMergeTest) {
+  std::vector<double> vals(numOfVals);
+  for (int32_t i = 0; i < numOfVals; ++i) {
+    vals[i] = -log((rand() + 1.0) / ((double)RAND_MAX + 2)) * 1000;
+  }
+
+  // each part has a different range, in the same way as the tables of a super table
+  const int32_t numOfParts = 8;
+  STDigest*     parts = (STDigest*)malloc(sizeof(STDigest) * numOfParts);
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    tTDigestInit(&parts[i]);
+    std::vector<double> part(vals.begin() + i * (numOfVals / numOfParts), vals.begin() + (i + 1) * (numOfVals / numOfParts));
+    for (auto& v : part) {
+      v += i * 100;
+    }
+
+    addAll(&parts[i], part);
+    std::copy(part.begin(), part.end(), vals.begin() + i * (numOfVals / numOfParts));
+  }
+
+  STDigest* pMerged = (STDigest*)malloc(sizeof(STDigest));
+  tTDigestInit(pMerged);
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    tTDigestMerge(pMerged, &parts[i]);
+  }
+
+  std::sort(vals.begin(), vals.end());
+  ASSERT_EQ(pMerged->total, numOfVals);
+  ASSERT_LE(pMerged->numOfCentroids, TDIGEST_COMPRESSION + 1);
+  ASSERT_EQ(tTDigestQuantile(pMerged, 0), vals.front());
+  ASSERT_EQ(tTDigestQuantile(pMerged, 1), vals.back());
+
+  double qs[] = {0.5, 0.99, 0.999};
+  for (auto q : qs) {
+    double bound = (q == 0.5) ? 0.005 : 0.001;
+    ASSERT_LT(rankError(vals, q, tTDigestQuantile(pMerged, q)), bound) << "q:" << q;
+  }
+
+  free(parts);
+  free(pMerged);
+}
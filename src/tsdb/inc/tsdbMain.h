@@ -53,6 +53,8 @@ extern int tsdbDebugFlag;
 
 // Definitions
 // ------------------ tsdbMeta.c
+#define TSDB_SUPER_TABLE_SL_LEVEL 5
+
 typedef struct STable {
   STableId       tableId;
   ETableType     type;
@@ -64,6 +66,7 @@ typedef struct STable {
   STSchema*      tagSchema;
   SKVRow         tagVal;
   SSkipList*     pIndex;         // For TSDB_SUPER_TABLE, it is the skiplist index
+  struct STagIndex* pTagIndex;   // For TSDB_SUPER_TABLE, the indexes of the other tags built on demand
   void*          eventHandler;   // TODO
   void*          streamHandler;  // TODO
   TSKEY          lastKey;        // lastkey inserted in this table, initialized as 0, TODO: make a structure
@@ -160,7 +163,11 @@ typedef enum {
   TSDB_FILE_TYPE_NHEAD,
   TSDB_FILE_TYPE_NDATA,
   TSDB_FILE_TYPE_NLAST,
-  TSDB_FILE_TYPE_NSTAT
+  TSDB_FILE_TYPE_NSTAT,
+  TSDB_FILE_TYPE_CHEAD,  // files written by a compaction
+  TSDB_FILE_TYPE_CDATA,
+  TSDB_FILE_TYPE_CLAST,
+  TSDB_FILE_TYPE_CMARK   // exists when the compacted files are complete and being switched in
 } TSDB_FILE_TYPE;
 
 #ifndef TDINTERNAL
@@ -192,12 +199,25 @@ typedef struct {
   SFile files[TSDB_FILE_TYPE_MAX];
 } SFileGroup;
 
+// A read only fd shared by the read helpers, which only read the file with positional reads
+typedef struct {
+  int      fid;
+  int      type;
+  uint32_t magic;
+  int      fd;
+  int      refCount;
+  bool     stale;  // the file group is changed, close the fd when it is not referenced
+} SSharedFile;
+
 typedef struct {
   pthread_rwlock_t fhlock;
 
   int         maxFGroups;
   int         nFGroups;
   SFileGroup* pFGroup;
+
+  pthread_mutex_t sflock;
+  SArray*         sharedFiles;  // SSharedFile
 } STsdbFileH;
 
 typedef struct {
@@ -224,6 +244,12 @@ typedef struct {
   pthread_t       commitThread;
   pthread_mutex_t mutex;
   bool            repoLocked;
+  int             compact;
+  pthread_t       compactThread;
+  int8_t          compactOver;  // the compaction thread is finished and can be joined
+  int8_t          compactStop;  // the repository is closing, the compaction is abandoned
+  // commits to file groups hold it shared, a compaction holds it exclusively when it switches the files in
+  pthread_rwlock_t compactLock;
 } STsdbRepo;
 
 // ------------------ tsdbRWHelper.c
@@ -318,6 +344,7 @@ typedef struct {
   SDataCols* pDataCols[2];
   void*      pBuffer;     // Buffer to hold the whole data block
   void*      compBuffer;  // Buffer for temperary compress/decompress purpose
+  int64_t    readTime;    // Time in us blocked in reading block data from files
 } SRWHelper;
 
 // ------------------ tsdbScan.c
@@ -422,6 +449,8 @@ void          tsdbCloseBufPool(STsdbRepo* pRepo);
 SListNode*    tsdbAllocBufBlockFromPool(STsdbRepo* pRepo);
 
 // ------------------ tsdbMemTable.c
+#define TSDB_CACHE_ROWS_BATCH 256  // number of cache rows transposed to columns in one batch
+
 int   tsdbInsertRowToMem(STsdbRepo* pRepo, SDataRow row, STable* pTable);
 int   tsdbRefMemTable(STsdbRepo* pRepo, SMemTable* pMemTable);
 int   tsdbUnRefMemTable(STsdbRepo* pRepo, SMemTable* pMemTable);
@@ -469,6 +498,8 @@ static FORCE_INLINE STsdbBufBlock* tsdbGetCurrBufBlock(STsdbRepo* pRepo) {
 #define TSDB_IS_FILE_OPENED(f) ((f)->fd > 0)
 #define TSDB_FGROUP_ITER_FORWARD TSDB_ORDER_ASC
 #define TSDB_FGROUP_ITER_BACKWARD TSDB_ORDER_DESC
+#define TSDB_MAX_IDLE_SHARED_FILES 48
+#define TSDB_ALL_SHARED_FILES INT32_MIN
 
 STsdbFileH* tsdbNewFileH(STsdbCfg* pCfg);
 void        tsdbFreeFileH(STsdbFileH* pFileH);
@@ -480,6 +511,9 @@ void        tsdbSeekFileGroupIter(SFileGroupIter* pIter, int fid);
 SFileGroup* tsdbGetFileGroupNext(SFileGroupIter* pIter);
 int         tsdbOpenFile(SFile* pFile, int oflag);
 void        tsdbCloseFile(SFile* pFile);
+int         tsdbOpenSharedFile(STsdbRepo* pRepo, int fid, int type, SFile* pFile);
+void        tsdbCloseSharedFile(STsdbRepo* pRepo, SFile* pFile);
+void        tsdbCloseIdleSharedFiles(STsdbRepo* pRepo, int fid);
 int         tsdbCreateFile(SFile* pFile, STsdbRepo* pRepo, int fid, int type);
 SFileGroup* tsdbSearchFGroup(STsdbFileH* pFileH, int fid, int flags);
 void        tsdbFitRetention(STsdbRepo* pRepo);
@@ -535,7 +569,12 @@ int  tsdbLoadCompData(SRWHelper* phelper, SCompBlock* pcompblock, void* target);
 void tsdbGetDataStatis(SRWHelper* pHelper, SDataStatis* pStatis, int numOfCols);
 int  tsdbLoadBlockDataCols(SRWHelper* pHelper, SCompBlock* pCompBlock, SCompInfo* pCompInfo, int16_t* colIds,
                            int numOfColIds);
+int  tsdbLoadMoreBlockDataCols(SRWHelper* pHelper, SCompBlock* pCompBlock, int16_t* colIds, int numOfColIds);
 int  tsdbLoadBlockData(SRWHelper* pHelper, SCompBlock* pCompBlock, SCompInfo* pCompInfo);
+int64_t tsdbReadAheadBlockData(SRWHelper* pHelper, SCompBlock* pCompBlock, SCompInfo* pCompInfo);
+int  tsdbWriteBlockToFile(SRWHelper* pHelper, SFile* pFile, SDataCols* pDataCols, SCompBlock* pCompBlock, bool isLast,
+                          bool isSuperBlock);
+int  tsdbEncodeSCompIdx(void** buf, SCompIdx* pIdx);
 
 static FORCE_INLINE int compTSKEY(const void* key1, const void* key2) {
   if (*(TSKEY*)key1 > *(TSKEY*)key2) {
@@ -562,6 +601,46 @@ STsdbMeta*  tsdbGetMeta(TSDB_REPO_T* pRepo);
 STsdbFileH* tsdbGetFile(TSDB_REPO_T* pRepo);
 int         tsdbCheckCommit(STsdbRepo* pRepo);
 
+// ------------------ tsdbCompact.c
+#define TSDB_COMPACT_SUBBLOCK_RATIO 10  // compact if more than 1/10 of blocks have sub-blocks
+#define TSDB_COMPACT_TOMB_RATIO 4       // compact if more than 1/4 of data file is tomb
+
+int  tsdbCompact(STsdbRepo* pRepo);
+int  tsdbAsyncCompact(STsdbRepo* pRepo);
+void tsdbStopCompact(STsdbRepo* pRepo);
+int  tsdbRecoverCompact(STsdbRepo* pRepo, char* dataDir);
+
+// ------------------ tsdbBlockCache.c
+#define TSDB_BLOCK_CACHE_ALL_FILES INT32_MIN
+
+typedef struct {
+  int32_t  vgId;
+  int32_t  fid;
+  uint32_t magic;  // magic of the file, it changes whenever the file is written
+  int16_t  colId;
+  int8_t   last;
+  int8_t   reserved;
+  int64_t  offset;  // offset of the column data in the file
+} SBlockCacheKey;
+
+bool  tsdbBlockCacheEnabled();
+void  tsdbInitBlockCacheKey(SBlockCacheKey* pKey, int32_t vgId, int32_t fid, SFile* pFile, int8_t last, int64_t offset,
+                            int16_t colId);
+void* tsdbAcquireCachedColData(SBlockCacheKey* pKey, void** ppData, int32_t* len);
+void  tsdbReleaseCachedColData(void* pHandle);
+void  tsdbCacheColData(SBlockCacheKey* pKey, const void* pData, int32_t len);
+void  tsdbInvalidateBlockCache(int32_t vgId, int32_t fid);
+
+// ------------------ tsdbTagIndex.c
+#define TSDB_TAG_INDEX_ALL_COLS INT16_MIN
+
+struct tQueryInfo;
+
+int  tsdbAddTableIntoTagIndex(STable* pSTable, STable* pTable, int16_t colId);
+void tsdbRemoveTableFromTagIndex(STable* pSTable, STable* pTable, int16_t colId);
+void tsdbFreeTagIndex(STable* pSTable);
+bool tsdbQueryTagIndex(STable* pSTable, struct tQueryInfo* pInfo, SArray* pTables);
+
 // ------------------ tsdbScan.c
 int              tsdbScanFGroup(STsdbScanHandle* pScanHandle, char* rootDir, int fid);
 STsdbScanHandle* tsdbNewScanHandle();
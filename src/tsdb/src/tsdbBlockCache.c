@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "hash.h"
+#include "taoserror.h"
+#include "tsdbMain.h"
+
+/*
+ * LRU cache of decompressed column data of file blocks, shared by the queries of all the repositories of a dnode.
+ * An entry handed out to a reader is pinned by a reference, evicting or invalidating it only unlinks it from the
+ * cache and the last reader frees it.
+ */
+typedef struct SBlockCacheEntry {
+  SBlockCacheKey           key;
+  struct SBlockCacheEntry *prev;
+  struct SBlockCacheEntry *next;
+  int32_t                  refCount;
+  bool                     removed;
+  int32_t                  len;
+  char                     data[];
+} SBlockCacheEntry;
+
+typedef struct {
+  pthread_mutex_t   mutex;
+  SHashObj *        map;   // SBlockCacheKey -> SBlockCacheEntry *
+  SBlockCacheEntry *head;  // most recently used
+  SBlockCacheEntry *tail;  // least recently used
+  int64_t           capacity;
+  int64_t           size;
+  int64_t           hits;
+  int64_t           misses;
+  int64_t           evictions;
+} SBlockCache;
+
+#define TSDB_BLOCK_CACHE_ENTRY_SIZE(len) ((int64_t)sizeof(SBlockCacheEntry) + (len))
+
+static SBlockCache tsBlockCache = {0};
+
+static void tsdbUnlinkCacheEntry(SBlockCacheEntry *pEntry);
+static void tsdbRemoveCacheEntry(SBlockCacheEntry *pEntry);
+
+int32_t tsdbInitBlockCache(int64_t capacity) {
+  if (tsBlockCache.map != NULL || capacity <= 0) return 0;
+
+  tsBlockCache.map = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  if (tsBlockCache.map == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pthread_mutex_init(&tsBlockCache.mutex, NULL);
+  tsBlockCache.capacity = capacity;
+  tsdbInfo("block cache is initialized, capacity:%" PRId64 " bytes", capacity);
+
+  return 0;
+}
+
+void tsdbCleanupBlockCache() {
+  if (tsBlockCache.map == NULL) return;
+
+  pthread_mutex_lock(&tsBlockCache.mutex);
+  while (tsBlockCache.head != NULL) {
+    tsdbRemoveCacheEntry(tsBlockCache.head);
+  }
+  taosHashCleanup(tsBlockCache.map);
+  tsBlockCache.map = NULL;
+  pthread_mutex_unlock(&tsBlockCache.mutex);
+
+  pthread_mutex_destroy(&tsBlockCache.mutex);
+  tsdbInfo("block cache is cleaned up, hits:%" PRId64 " misses:%" PRId64 " evictions:%" PRId64, tsBlockCache.hits,
+           tsBlockCache.misses, tsBlockCache.evictions);
+}
+
+void tsdbGetBlockCacheStat(STsdbBlockCacheStat *pStat) {
+  memset(pStat, 0, sizeof(*pStat));
+  if (tsBlockCache.map == NULL) return;
+
+  pthread_mutex_lock(&tsBlockCache.mutex);
+  pStat->hits = tsBlockCache.hits;
+  pStat->misses = tsBlockCache.misses;
+  pStat->evictions = tsBlockCache.evictions;
+  pStat->size = tsBlockCache.size;
+  pStat->capacity = tsBlockCache.capacity;
+  pStat->entries = (int32_t)taosHashGetSize(tsBlockCache.map);
+  pthread_mutex_unlock(&tsBlockCache.mutex);
+}
+
+bool tsdbBlockCacheEnabled() { return tsBlockCache.map != NULL; }
+
+void tsdbInitBlockCacheKey(SBlockCacheKey *pKey, int32_t vgId, int32_t fid, SFile *pFile, int8_t last, int64_t offset,
+                           int16_t colId) {
+  memset(pKey, 0, sizeof(*pKey));  // the key is hashed as bytes, so the padding must be zero
+  pKey->vgId = vgId;
+  pKey->fid = fid;
+  pKey->magic = pFile->info.magic;
+  pKey->colId = colId;
+  pKey->last = last;
+  pKey->offset = offset;
+}
+
+void *tsdbAcquireCachedColData(SBlockCacheKey *pKey, void **ppData, int32_t *len) {
+  if (tsBlockCache.map == NULL) return NULL;
+
+  pthread_mutex_lock(&tsBlockCache.mutex);
+
+  SBlockCacheEntry **ppEntry = (SBlockCacheEntry **)taosHashGet(tsBlockCache.map, (const char *)pKey, sizeof(*pKey));
+  if (ppEntry == NULL) {
+    tsBlockCache.misses++;
+    pthread_mutex_unlock(&tsBlockCache.mutex);
+    return NULL;
+  }
+
+  SBlockCacheEntry *pEntry = *ppEntry;
+  pEntry->refCount++;
+  tsBlockCache.hits++;
+
+  // move to the head of the LRU list
+  tsdbUnlinkCacheEntry(pEntry);
+  pEntry->next = tsBlockCache.head;
+  if (tsBlockCache.head != NULL) tsBlockCache.head->prev = pEntry;
+  tsBlockCache.head = pEntry;
+  if (tsBlockCache.tail == NULL) tsBlockCache.tail = pEntry;
+
+  pthread_mutex_unlock(&tsBlockCache.mutex);
+
+  *ppData = pEntry->data;
+  *len = pEntry->len;
+  return pEntry;
+}
+
+void tsdbReleaseCachedColData(void *pHandle) {
+  SBlockCacheEntry *pEntry = (SBlockCacheEntry *)pHandle;
+  if (pEntry == NULL) return;
+
+  pthread_mutex_lock(&tsBlockCache.mutex);
+  ASSERT(pEntry->refCount > 0);
+  bool toFree = (--pEntry->refCount == 0) && pEntry->removed;
+  pthread_mutex_unlock(&tsBlockCache.mutex);
+
+  if (toFree) free(pEntry);
+}
+
+void tsdbCacheColData(SBlockCacheKey *pKey, const void *pData, int32_t len) {
+  if (tsBlockCache.map == NULL) return;
+
+  int64_t esize = TSDB_BLOCK_CACHE_ENTRY_SIZE(len);
+  if (esize > tsBlockCache.capacity / 8) return;  // do not let one large block flush the cache
+
+  SBlockCacheEntry *pEntry = (SBlockCacheEntry *)malloc((size_t)esize);
+  if (pEntry == NULL) return;
+
+  pEntry->key = *pKey;
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+  pEntry->refCount = 0;
+  pEntry->removed = false;
+  pEntry->len = len;
+  memcpy(pEntry->data, pData, len);
+
+  pthread_mutex_lock(&tsBlockCache.mutex);
+
+  // another query may have loaded the same column concurrently
+  if (taosHashGet(tsBlockCache.map, (const char *)pKey, sizeof(*pKey)) != NULL) {
+    pthread_mutex_unlock(&tsBlockCache.mutex);
+    free(pEntry);
+    return;
+  }
+
+  while (tsBlockCache.tail != NULL && tsBlockCache.size + esize > tsBlockCache.capacity) {
+    tsdbRemoveCacheEntry(tsBlockCache.tail);
+    tsBlockCache.evictions++;
+  }
+
+  if (taosHashPut(tsBlockCache.map, (const char *)pKey, sizeof(*pKey), (void *)&pEntry, sizeof(pEntry)) < 0) {
+    pthread_mutex_unlock(&tsBlockCache.mutex);
+    free(pEntry);
+    return;
+  }
+
+  pEntry->next = tsBlockCache.head;
+  if (tsBlockCache.head != NULL) tsBlockCache.head->prev = pEntry;
+  tsBlockCache.head = pEntry;
+  if (tsBlockCache.tail == NULL) tsBlockCache.tail = pEntry;
+  tsBlockCache.size += esize;
+
+  pthread_mutex_unlock(&tsBlockCache.mutex);
+}
+
+void tsdbInvalidateBlockCache(int32_t vgId, int32_t fid) {
+  if (tsBlockCache.map == NULL) return;
+
+  int32_t nremoved = 0;
+
+  pthread_mutex_lock(&tsBlockCache.mutex);
+  SBlockCacheEntry *pEntry = tsBlockCache.head;
+  while (pEntry != NULL) {
+    SBlockCacheEntry *pNext = pEntry->next;
+    if (pEntry->key.vgId == vgId && (fid == TSDB_BLOCK_CACHE_ALL_FILES || pEntry->key.fid == fid)) {
+      tsdbRemoveCacheEntry(pEntry);
+      nremoved++;
+    }
+    pEntry = pNext;
+  }
+  pthread_mutex_unlock(&tsBlockCache.mutex);
+
+  if (nremoved > 0) {
+    tsdbDebug("vgId:%d %d entries of file %d are removed from block cache", vgId, nremoved, fid);
+  }
+}
+
+// Called with the cache mutex held
+static void tsdbUnlinkCacheEntry(SBlockCacheEntry *pEntry) {
+  if (pEntry->prev != NULL) {
+    pEntry->prev->next = pEntry->next;
+  } else {
+    tsBlockCache.head = pEntry->next;
+  }
+
+  if (pEntry->next != NULL) {
+    pEntry->next->prev = pEntry->prev;
+  } else {
+    tsBlockCache.tail = pEntry->prev;
+  }
+
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+}
+
+// Called with the cache mutex held
+static void tsdbRemoveCacheEntry(SBlockCacheEntry *pEntry) {
+  tsdbUnlinkCacheEntry(pEntry);
+  taosHashRemove(tsBlockCache.map, (const char *)&pEntry->key, sizeof(pEntry->key));
+  tsBlockCache.size -= TSDB_BLOCK_CACHE_ENTRY_SIZE(pEntry->len);
+
+  if (pEntry->refCount > 0) {
+    pEntry->removed = true;
+  } else {
+    free(pEntry);
+  }
+}
@@ -11,4 +11,619 @@
  *
  * You should have received a copy of the GNU Affero General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
- */
\ No newline at end of file
+ */
+#define _DEFAULT_SOURCE
+
+#include "os.h"
+#include "tchecksum.h"
+#include "tsdbMain.h"
+
+typedef struct {
+  STsdbRepo* pRepo;
+  SRWHelper  rhelper;  // helper to read the file group to compact
+  SFile      nFiles[TSDB_FILE_TYPE_LAST + 1];  // compacted .head/.data/.last files
+  SCompInfo* pCompInfo;
+  int        nBlocks;
+  void*      pWIdx;
+  SDataCols* pDataCols;  // rows pending to be written as one super block
+} SCompactH;
+
+#define TSDB_COMPACT_FILE(ch, t) (&((ch)->nFiles[(t)]))
+#define TSDB_COMPACT_HEAD_FILE(ch) TSDB_COMPACT_FILE(ch, TSDB_FILE_TYPE_HEAD)
+#define TSDB_COMPACT_DATA_FILE(ch) TSDB_COMPACT_FILE(ch, TSDB_FILE_TYPE_DATA)
+#define TSDB_COMPACT_LAST_FILE(ch) TSDB_COMPACT_FILE(ch, TSDB_FILE_TYPE_LAST)
+
+static SFileGroup* tsdbSelectFGroupToCompact(STsdbRepo* pRepo, SFileGroup* pGroup);
+static bool        tsdbShouldCompactFGroup(SFileGroup* pGroup);
+static int         tsdbCompactFGroup(STsdbRepo* pRepo, SFileGroup* pGroup);
+static int         tsdbInitCompactH(SCompactH* pComph, STsdbRepo* pRepo, SFileGroup* pGroup);
+static void        tsdbDestroyCompactH(SCompactH* pComph, bool hasError);
+static int         tsdbCreateCompactFile(SFile* pFile, STsdbRepo* pRepo, int fid, int type);
+static void        tsdbCloseCompactFile(SFile* pFile, bool hasError);
+static int         tsdbCompactTableData(SCompactH* pComph, STable* pTable);
+static int         tsdbCompactFlushBlock(SCompactH* pComph);
+static int         tsdbCompactWriteCompInfo(SCompactH* pComph);
+static int         tsdbCompactWriteCompIdx(SCompactH* pComph);
+static int         tsdbApplyCompactFiles(SCompactH* pComph, SFileGroup* pOGroup);
+static bool        tsdbIsFGroupChanged(SFileGroup* pGroup, SFileGroup* pOGroup);
+static int         tsdbWriteCompactMark(char* fname);
+static void        tsdbRemoveCompactFiles(STsdbRepo* pRepo, int fid, bool withMark);
+static int         tsdbFsyncDir(char* dirName);
+static void*       tsdbCompactThreadFunc(void* arg);
+
+// ---------------- INTERNAL FUNCTIONS ----------------
+int tsdbCompact(STsdbRepo* pRepo) {
+  SFileGroup fGroup = {0};
+
+  if (tsdbSelectFGroupToCompact(pRepo, &fGroup) == NULL) return 0;
+
+  tsdbInfo("vgId:%d start to compact file group %d, totalBlocks %u totalSubBlocks %u data tombSize %" PRIu64
+           " last tombSize %" PRIu64,
+           REPO_ID(pRepo), fGroup.fileId, fGroup.files[TSDB_FILE_TYPE_HEAD].info.totalBlocks,
+           fGroup.files[TSDB_FILE_TYPE_HEAD].info.totalSubBlocks, fGroup.files[TSDB_FILE_TYPE_DATA].info.tombSize,
+           fGroup.files[TSDB_FILE_TYPE_LAST].info.tombSize);
+
+  if (tsdbCompactFGroup(pRepo, &fGroup) < 0) {
+    tsdbError("vgId:%d failed to compact file group %d since %s", REPO_ID(pRepo), fGroup.fileId, tstrerror(terrno));
+    return -1;
+  }
+
+  return 0;
+}
+
+// Compaction runs on its own thread so the commit thread and the imem are not held by it. A new compaction is
+// only started when the previous one is over, it is called by the commit thread only.
+int tsdbAsyncCompact(STsdbRepo* pRepo) {
+  if (pRepo->compact) {
+    if (!atomic_load_8(&(pRepo->compactOver))) return 0;
+    pthread_join(pRepo->compactThread, NULL);
+    pRepo->compact = 0;
+  }
+
+  atomic_store_8(&(pRepo->compactOver), 0);
+  int code = pthread_create(&(pRepo->compactThread), NULL, tsdbCompactThreadFunc, (void*)pRepo);
+  if (code != 0) {
+    tsdbError("vgId:%d failed to create compact thread since %s", REPO_ID(pRepo), strerror(code));
+    terrno = TAOS_SYSTEM_ERROR(code);
+    return -1;
+  }
+  pRepo->compact = 1;
+
+  return 0;
+}
+
+void tsdbStopCompact(STsdbRepo* pRepo) {
+  if (!pRepo->compact) return;
+
+  atomic_store_8(&(pRepo->compactStop), 1);
+  pthread_join(pRepo->compactThread, NULL);
+  pRepo->compact = 0;
+  atomic_store_8(&(pRepo->compactStop), 0);
+}
+
+// The compacted files are switched in by renames after a mark file is written. If the mark file exists, the
+// compacted files are complete and those not renamed yet are renamed now, otherwise the compaction did not finish
+// and its files are removed.
+int tsdbRecoverCompact(STsdbRepo* pRepo, char* dataDir) {
+  struct dirent* dp = NULL;
+  int            vid = 0, fid = 0, n = 0;
+  bool           changed = false;
+
+  DIR* dir = opendir(dataDir);
+  if (dir == NULL) {
+    tsdbError("vgId:%d failed to open directory %s since %s", REPO_ID(pRepo), dataDir, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  // Pass 0 rolls the compactions with a mark file forward, pass 1 removes the files of unfinished ones
+  for (int pass = 0; pass < 2; pass++) {
+    rewinddir(dir);
+    while ((dp = readdir(dir)) != NULL) {
+      if (sscanf(dp->d_name, "v%df%d%n", &vid, &fid, &n) != 2 || vid != REPO_ID(pRepo)) continue;
+
+      char* suffix = dp->d_name + n;
+      if (pass == 0 && strcmp(suffix, tsdbFileSuffix[TSDB_FILE_TYPE_CMARK]) == 0) {
+        char ofname[TSDB_FILENAME_LEN] = "\0";
+        char nfname[TSDB_FILENAME_LEN] = "\0";
+        for (int type = TSDB_FILE_TYPE_HEAD; type <= TSDB_FILE_TYPE_LAST; type++) {
+          tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, TSDB_FILE_TYPE_CHEAD + type, nfname);
+          tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, type, ofname);
+          if (rename(nfname, ofname) < 0 && errno != ENOENT) {
+            tsdbError("vgId:%d failed to rename file %s to %s since %s", REPO_ID(pRepo), nfname, ofname,
+                      strerror(errno));
+            terrno = TAOS_SYSTEM_ERROR(errno);
+            closedir(dir);
+            return -1;
+          }
+        }
+        tsdbInfo("vgId:%d the compaction of file group %d is finished while recovering", REPO_ID(pRepo), fid);
+        tsdbRemoveCompactFiles(pRepo, fid, true);
+        changed = true;
+      } else if (pass == 1 && (strcmp(suffix, tsdbFileSuffix[TSDB_FILE_TYPE_CHEAD]) == 0 ||
+                               strcmp(suffix, tsdbFileSuffix[TSDB_FILE_TYPE_CDATA]) == 0 ||
+                               strcmp(suffix, tsdbFileSuffix[TSDB_FILE_TYPE_CLAST]) == 0)) {
+        tsdbInfo("vgId:%d the unfinished compaction of file group %d is abandoned", REPO_ID(pRepo), fid);
+        tsdbRemoveCompactFiles(pRepo, fid, false);
+        changed = true;
+      }
+    }
+  }
+
+  closedir(dir);
+
+  if (changed && tsdbFsyncDir(dataDir) < 0) return -1;
+
+  return 0;
+}
+
+// ---------------- LOCAL FUNCTIONS ----------------
+static void* tsdbCompactThreadFunc(void* arg) {
+  STsdbRepo* pRepo = (STsdbRepo*)arg;
+
+  tsdbCompact(pRepo);
+  atomic_store_8(&(pRepo->compactOver), 1);
+
+  return NULL;
+}
+
+static SFileGroup* tsdbSelectFGroupToCompact(STsdbRepo* pRepo, SFileGroup* pGroup) {
+  STsdbCfg*   pCfg = &(pRepo->config);
+  STsdbFileH* pFileH = pRepo->tsdbFileH;
+  SFileGroup* pRet = NULL;
+
+  // The file group still receiving in-order data is not compacted, it would be fragmented again soon
+  int cfid = (int)(TSDB_KEY_FILEID(taosGetTimestamp(pCfg->precision), pCfg->daysPerFile, pCfg->precision));
+
+  pthread_rwlock_rdlock(&(pFileH->fhlock));
+  for (int i = 0; i < pFileH->nFGroups; i++) {
+    SFileGroup* pFGroup = pFileH->pFGroup + i;
+    if (pFGroup->fileId >= cfid) break;
+    if (tsdbShouldCompactFGroup(pFGroup)) {
+      *pGroup = *pFGroup;
+      pRet = pGroup;
+      break;
+    }
+  }
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+
+  return pRet;
+}
+
+static bool tsdbShouldCompactFGroup(SFileGroup* pGroup) {
+  STsdbFileInfo* pHeadInfo = &(pGroup->files[TSDB_FILE_TYPE_HEAD].info);
+  STsdbFileInfo* pDataInfo = &(pGroup->files[TSDB_FILE_TYPE_DATA].info);
+  STsdbFileInfo* pLastInfo = &(pGroup->files[TSDB_FILE_TYPE_LAST].info);
+
+  if (pGroup->state) return false;
+
+  if (pHeadInfo->totalSubBlocks > 0 &&
+      (uint64_t)pHeadInfo->totalSubBlocks * TSDB_COMPACT_SUBBLOCK_RATIO >= pHeadInfo->totalBlocks) {
+    return true;
+  }
+
+  if (pDataInfo->tombSize > 0 && pDataInfo->tombSize * TSDB_COMPACT_TOMB_RATIO >= pDataInfo->size) return true;
+  if (pLastInfo->tombSize > 0 && pLastInfo->tombSize * TSDB_COMPACT_TOMB_RATIO >= pLastInfo->size) return true;
+
+  return false;
+}
+
+static int tsdbCompactFGroup(STsdbRepo* pRepo, SFileGroup* pGroup) {
+  STsdbMeta* pMeta = pRepo->tsdbMeta;
+  SCompactH  compactH;
+
+  if (tsdbInitCompactH(&compactH, pRepo, pGroup) < 0) goto _err;
+
+  for (int tid = 1; tid < pMeta->maxTables; tid++) {
+    STable* pTable = NULL;
+
+    if (atomic_load_8(&(pRepo->compactStop))) {
+      tsdbInfo("vgId:%d the compaction of file group %d is stopped", REPO_ID(pRepo), pGroup->fileId);
+      tsdbDestroyCompactH(&compactH, true);
+      return 0;
+    }
+
+    if (tsdbRLockRepoMeta(pRepo) < 0) goto _err;
+    if (tid < pMeta->maxTables && (pTable = pMeta->tables[tid]) != NULL) tsdbRefTable(pTable);
+    if (tsdbUnlockRepoMeta(pRepo) < 0) {
+      if (pTable) tsdbUnRefTable(pTable);
+      goto _err;
+    }
+
+    if (pTable == NULL) continue;
+
+    taosRLockLatch(&(pTable->latch));
+    int code = tsdbCompactTableData(&compactH, pTable);
+    taosRUnLockLatch(&(pTable->latch));
+
+    if (code < 0) {
+      tsdbError("vgId:%d failed to compact data of table %s tid %d uid %" PRIu64 " since %s", REPO_ID(pRepo),
+                TABLE_CHAR_NAME(pTable), TABLE_TID(pTable), TABLE_UID(pTable), tstrerror(terrno));
+      tsdbUnRefTable(pTable);
+      goto _err;
+    }
+
+    tsdbUnRefTable(pTable);
+  }
+
+  if (tsdbCompactWriteCompIdx(&compactH) < 0) goto _err;
+
+  tsdbDestroyCompactH(&compactH, false);
+  if (tsdbApplyCompactFiles(&compactH, pGroup) < 0) return -1;
+
+  return 0;
+
+_err:
+  tsdbDestroyCompactH(&compactH, true);
+  return -1;
+}
+
+static int tsdbInitCompactH(SCompactH* pComph, STsdbRepo* pRepo, SFileGroup* pGroup) {
+  STsdbCfg*  pCfg = &(pRepo->config);
+  STsdbMeta* pMeta = pRepo->tsdbMeta;
+
+  memset((void*)pComph, 0, sizeof(*pComph));
+  pComph->pRepo = pRepo;
+  for (int type = TSDB_FILE_TYPE_HEAD; type <= TSDB_FILE_TYPE_LAST; type++) TSDB_COMPACT_FILE(pComph, type)->fd = -1;
+
+  if (tsdbInitReadHelper(&(pComph->rhelper), pRepo) < 0) return -1;
+
+  if (tsdbSetAndOpenHelperFile(&(pComph->rhelper), pGroup) < 0) return -1;
+  if (tsdbLoadCompIdx(&(pComph->rhelper), NULL) < 0) return -1;
+
+  if (tsdbCreateCompactFile(TSDB_COMPACT_HEAD_FILE(pComph), pRepo, pGroup->fileId, TSDB_FILE_TYPE_CHEAD) < 0) return -1;
+  if (tsdbCreateCompactFile(TSDB_COMPACT_DATA_FILE(pComph), pRepo, pGroup->fileId, TSDB_FILE_TYPE_CDATA) < 0) return -1;
+  if (tsdbCreateCompactFile(TSDB_COMPACT_LAST_FILE(pComph), pRepo, pGroup->fileId, TSDB_FILE_TYPE_CLAST) < 0) return -1;
+
+  pComph->pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock);
+  if (pComph->pDataCols == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  return 0;
+}
+
+static void tsdbDestroyCompactH(SCompactH* pComph, bool hasError) {
+  tsdbCloseCompactFile(TSDB_COMPACT_HEAD_FILE(pComph), hasError);
+  tsdbCloseCompactFile(TSDB_COMPACT_DATA_FILE(pComph), hasError);
+  tsdbCloseCompactFile(TSDB_COMPACT_LAST_FILE(pComph), hasError);
+  tsdbDestroyHelper(&(pComph->rhelper));
+  tdFreeDataCols(pComph->pDataCols);
+  pComph->pDataCols = NULL;
+  taosTZfree(pComph->pCompInfo);
+  pComph->pCompInfo = NULL;
+  taosTZfree(pComph->pWIdx);
+  pComph->pWIdx = NULL;
+}
+
+static int tsdbCreateCompactFile(SFile* pFile, STsdbRepo* pRepo, int fid, int type) {
+  memset((void*)pFile, 0, sizeof(SFile));
+  pFile->fd = -1;
+
+  tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, type, pFile->fname);
+  (void)remove(pFile->fname);  // file left by a failed compaction
+
+  if (tsdbOpenFile(pFile, O_WRONLY | O_CREAT) < 0) return -1;
+
+  pFile->info.size = TSDB_FILE_HEAD_SIZE;
+  pFile->info.magic = TSDB_FILE_INIT_MAGIC;
+  if (tsdbUpdateFileHeader(pFile) < 0) return -1;
+
+  return 0;
+}
+
+static void tsdbCloseCompactFile(SFile* pFile, bool hasError) {
+  if (pFile->fd > 0) {
+    if (!hasError) {
+      tsdbUpdateFileHeader(pFile);
+      fsync(pFile->fd);
+    }
+    tsdbCloseFile(pFile);
+    if (hasError) (void)remove(pFile->fname);
+  }
+}
+
+static int tsdbCompactTableData(SCompactH* pComph, STable* pTable) {
+  STsdbRepo* pRepo = pComph->pRepo;
+  STsdbCfg*  pCfg = &(pRepo->config);
+  SRWHelper* pHelper = &(pComph->rhelper);
+  SCompIdx*  pIdx = &(pHelper->curCompIdx);
+  int        defaultRowsInBlock = pCfg->maxRowsPerFileBlock * 4 / 5;
+
+  if (tsdbSetHelperTable(pHelper, pTable, pRepo) < 0) return -1;
+  if (pIdx->offset <= 0) return 0;  // no data of this table in the file group
+
+  if (tsdbLoadCompInfo(pHelper, NULL) < 0) return -1;
+
+  if (tdInitDataCols(pComph->pDataCols, tsdbGetTableSchemaImpl(pTable, false, false, -1)) < 0) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pComph->nBlocks = 0;
+
+  for (int i = 0; i < (int)pIdx->numOfBlocks; i++) {
+    SCompBlock* pCompBlock = blockAtIdx(pHelper, i);
+
+    // Load the super block with all its sub-blocks merged
+    if (tsdbLoadBlockData(pHelper, pCompBlock, NULL) < 0) return -1;
+    SDataCols* pDataCols0 = pHelper->pDataCols[0];
+    ASSERT(pDataCols0->numOfRows == pCompBlock->numOfRows);
+
+    if (pComph->pDataCols->numOfRows + pDataCols0->numOfRows > pCfg->maxRowsPerFileBlock) {
+      if (tsdbCompactFlushBlock(pComph) < 0) return -1;
+    }
+
+    if (tdMergeDataCols(pComph->pDataCols, pDataCols0, pDataCols0->numOfRows) < 0) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    if (pComph->pDataCols->numOfRows >= defaultRowsInBlock) {
+      if (tsdbCompactFlushBlock(pComph) < 0) return -1;
+    }
+  }
+
+  if (tsdbCompactFlushBlock(pComph) < 0) return -1;
+
+  return tsdbCompactWriteCompInfo(pComph);
+}
+
+// All blocks are written to the new .data file as super blocks, so the new .last file is left empty
+static int tsdbCompactFlushBlock(SCompactH* pComph) {
+  SCompBlock compBlock = {0};
+
+  if (pComph->pDataCols->numOfRows == 0) return 0;
+
+  if (tsdbWriteBlockToFile(&(pComph->rhelper), TSDB_COMPACT_DATA_FILE(pComph), pComph->pDataCols, &compBlock, false,
+                           true) < 0) {
+    return -1;
+  }
+
+  size_t tsize = sizeof(SCompInfo) + sizeof(SCompBlock) * (pComph->nBlocks + 1) + sizeof(TSCKSUM);
+  if (taosTSizeof(pComph->pCompInfo) < tsize) {
+    pComph->pCompInfo = (SCompInfo*)taosTRealloc(pComph->pCompInfo, tsize + sizeof(SCompBlock) * 16);
+    if (pComph->pCompInfo == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  pComph->pCompInfo->blocks[pComph->nBlocks++] = compBlock;
+  tdResetDataCols(pComph->pDataCols);
+
+  return 0;
+}
+
+static int tsdbCompactWriteCompInfo(SCompactH* pComph) {
+  SRWHelper* pHelper = &(pComph->rhelper);
+  SFile*     pFile = TSDB_COMPACT_HEAD_FILE(pComph);
+  SCompIdx   compIdx = {0};
+
+  if (pComph->nBlocks == 0) return 0;
+
+  compIdx.tid = pHelper->tableInfo.tid;
+  compIdx.uid = pHelper->tableInfo.uid;
+  compIdx.len = (uint32_t)(sizeof(SCompInfo) + sizeof(SCompBlock) * pComph->nBlocks + sizeof(TSCKSUM));
+  compIdx.numOfBlocks = pComph->nBlocks;
+  compIdx.hasLast = 0;
+  compIdx.maxKey = pComph->pCompInfo->blocks[pComph->nBlocks - 1].keyLast;
+
+  pComph->pCompInfo->delimiter = TSDB_FILE_DELIMITER;
+  pComph->pCompInfo->uid = compIdx.uid;
+  pComph->pCompInfo->tid = compIdx.tid;
+  taosCalcChecksumAppend(0, (uint8_t*)pComph->pCompInfo, compIdx.len);
+  pFile->info.magic = taosCalcChecksum(
+      pFile->info.magic, (uint8_t*)POINTER_SHIFT(pComph->pCompInfo, compIdx.len - sizeof(TSCKSUM)), sizeof(TSCKSUM));
+
+  off_t offset = lseek(pFile->fd, 0, SEEK_END);
+  if (offset < 0) {
+    tsdbError("vgId:%d failed to lseek file %s since %s", REPO_ID(pComph->pRepo), pFile->fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+  compIdx.offset = (uint32_t)offset;
+
+  if (taosTWrite(pFile->fd, (void*)(pComph->pCompInfo), compIdx.len) < (int)compIdx.len) {
+    tsdbError("vgId:%d failed to write %d bytes to file %s since %s", REPO_ID(pComph->pRepo), compIdx.len,
+              pFile->fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  if (taosTSizeof(pComph->pWIdx) < pFile->info.len + sizeof(SCompIdx) + 12) {
+    pComph->pWIdx =
+        taosTRealloc(pComph->pWIdx, taosTSizeof(pComph->pWIdx) == 0 ? 1024 : taosTSizeof(pComph->pWIdx) * 2);
+    if (pComph->pWIdx == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  void* pBuf = POINTER_SHIFT(pComph->pWIdx, pFile->info.len);
+  pFile->info.len += tsdbEncodeSCompIdx(&pBuf, &compIdx);
+  pFile->info.size += compIdx.len;
+  pFile->info.totalBlocks += compIdx.numOfBlocks;
+
+  return 0;
+}
+
+static int tsdbCompactWriteCompIdx(SCompactH* pComph) {
+  SFile* pFile = TSDB_COMPACT_HEAD_FILE(pComph);
+
+  if (pFile->info.len == 0) return 0;  // all tables in the file group are dropped
+
+  pFile->info.len += sizeof(TSCKSUM);
+  if (taosTSizeof(pComph->pWIdx) < pFile->info.len) {
+    pComph->pWIdx = taosTRealloc(pComph->pWIdx, pFile->info.len);
+    if (pComph->pWIdx == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+  taosCalcChecksumAppend(0, (uint8_t*)pComph->pWIdx, pFile->info.len);
+  pFile->info.magic = taosCalcChecksum(
+      pFile->info.magic, (uint8_t*)POINTER_SHIFT(pComph->pWIdx, pFile->info.len - sizeof(TSCKSUM)), sizeof(TSCKSUM));
+
+  off_t offset = lseek(pFile->fd, 0, SEEK_END);
+  if (offset < 0) {
+    tsdbError("vgId:%d failed to lseek file %s since %s", REPO_ID(pComph->pRepo), pFile->fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  ASSERT(offset == pFile->info.size);
+
+  if (taosTWrite(pFile->fd, (void*)pComph->pWIdx, pFile->info.len) < (int)pFile->info.len) {
+    tsdbError("vgId:%d failed to write %d bytes to file %s since %s", REPO_ID(pComph->pRepo), pFile->info.len,
+              pFile->fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  pFile->info.offset = (uint32_t)offset;
+  pFile->info.size += pFile->info.len;
+
+  return 0;
+}
+
+// The files are switched in while commits to the file groups are blocked by compactLock. The result is dropped if
+// the file group is changed by a commit during the compaction.
+static int tsdbApplyCompactFiles(SCompactH* pComph, SFileGroup* pOGroup) {
+  STsdbRepo*  pRepo = pComph->pRepo;
+  STsdbFileH* pFileH = pRepo->tsdbFileH;
+  int         fid = pOGroup->fileId;
+  char        mname[TSDB_FILENAME_LEN] = "\0";
+
+  char* dataDir = tsdbGetDataDirName(pRepo->rootDir);
+  if (dataDir == NULL) return -1;
+
+  pthread_rwlock_wrlock(&(pRepo->compactLock));
+  pthread_rwlock_wrlock(&(pFileH->fhlock));
+
+  SFileGroup* pGroup = tsdbSearchFGroup(pFileH, fid, TD_EQ);
+  if (pGroup == NULL || tsdbIsFGroupChanged(pGroup, pOGroup)) {
+    // the file group is removed by retention or committed to during compaction
+    pthread_rwlock_unlock(&(pFileH->fhlock));
+    pthread_rwlock_unlock(&(pRepo->compactLock));
+    tsdbInfo("vgId:%d file group %d is changed during compaction, the compacted files are dropped", REPO_ID(pRepo),
+             fid);
+    tsdbRemoveCompactFiles(pRepo, fid, false);
+    taosTFree(dataDir);
+    return 0;
+  }
+
+  uint64_t osize = pGroup->files[TSDB_FILE_TYPE_DATA].info.size + pGroup->files[TSDB_FILE_TYPE_LAST].info.size;
+
+  // Once the mark file is durable the switch is completed by tsdbRecoverCompact after a crash
+  tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, TSDB_FILE_TYPE_CMARK, mname);
+  if (tsdbWriteCompactMark(mname) < 0 || tsdbFsyncDir(dataDir) < 0) {
+    tsdbRemoveCompactFiles(pRepo, fid, true);
+    goto _err;
+  }
+
+  for (int type = TSDB_FILE_TYPE_HEAD; type <= TSDB_FILE_TYPE_LAST; type++) {
+    SFile* pNFile = TSDB_COMPACT_FILE(pComph, type);
+    if (rename(pNFile->fname, pGroup->files[type].fname) < 0) {
+      tsdbError("vgId:%d failed to rename file %s to %s since %s", REPO_ID(pRepo), pNFile->fname,
+                pGroup->files[type].fname, strerror(errno));
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      // the mark file is kept, the switch is completed by tsdbRecoverCompact when the repository is opened again
+      pGroup->state = 1;
+      goto _err;
+    }
+  }
+
+  // the group takes the info of the compacted files only when all of them are switched in, so it never describes a
+  // mix of compacted and old files
+  for (int type = TSDB_FILE_TYPE_HEAD; type <= TSDB_FILE_TYPE_LAST; type++) {
+    pGroup->files[type].info = TSDB_COMPACT_FILE(pComph, type)->info;
+  }
+
+  if (tsdbFsyncDir(dataDir) < 0) goto _err;
+  (void)remove(mname);
+
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+  pthread_rwlock_unlock(&(pRepo->compactLock));
+
+  (void)tsdbFsyncDir(dataDir);
+  taosTFree(dataDir);
+
+  tsdbInvalidateBlockCache(REPO_ID(pRepo), fid);
+  tsdbCloseIdleSharedFiles(pRepo, fid);
+
+  tsdbInfo("vgId:%d file group %d is compacted, totalBlocks %u, data and last size %" PRIu64 " -> %" PRIu64,
+           REPO_ID(pRepo), fid, TSDB_COMPACT_HEAD_FILE(pComph)->info.totalBlocks, osize,
+           TSDB_COMPACT_DATA_FILE(pComph)->info.size + TSDB_COMPACT_LAST_FILE(pComph)->info.size);
+
+  return 0;
+
+_err:
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+  pthread_rwlock_unlock(&(pRepo->compactLock));
+  taosTFree(dataDir);
+  return -1;
+}
+
+static bool tsdbIsFGroupChanged(SFileGroup* pGroup, SFileGroup* pOGroup) {
+  for (int type = TSDB_FILE_TYPE_HEAD; type <= TSDB_FILE_TYPE_LAST; type++) {
+    if (pGroup->files[type].info.magic != pOGroup->files[type].info.magic ||
+        pGroup->files[type].info.size != pOGroup->files[type].info.size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int tsdbWriteCompactMark(char* fname) {
+  int fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+  if (fd < 0) {
+    tsdbError("failed to create file %s since %s", fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  if (fsync(fd) < 0) {
+    tsdbError("failed to fsync file %s since %s", fname, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    close(fd);
+    return -1;
+  }
+
+  close(fd);
+  return 0;
+}
+
+static void tsdbRemoveCompactFiles(STsdbRepo* pRepo, int fid, bool withMark) {
+  char fname[TSDB_FILENAME_LEN] = "\0";
+
+  for (int type = TSDB_FILE_TYPE_CHEAD; type <= TSDB_FILE_TYPE_CLAST; type++) {
+    tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, type, fname);
+    (void)remove(fname);
+  }
+
+  if (withMark) {
+    tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, TSDB_FILE_TYPE_CMARK, fname);
+    (void)remove(fname);
+  }
+}
+
+static int tsdbFsyncDir(char* dirName) {
+  int fd = open(dirName, O_RDONLY);
+  if (fd < 0) {
+    tsdbError("failed to open directory %s since %s", dirName, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  if (fsync(fd) < 0) {
+    tsdbError("failed to fsync directory %s since %s", dirName, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    close(fd);
+    return -1;
+  }
+
+  close(fd);
+  return 0;
+}
@@ -24,7 +24,7 @@
 #include "tutil.h"
 
 
-const char *tsdbFileSuffix[] = {".head", ".data", ".last", ".stat", ".h", ".d", ".l", ".s"};
+const char *tsdbFileSuffix[] = {".head", ".data", ".last", ".stat", ".h", ".d", ".l", ".s", ".ch", ".cd", ".cl", ".cm"};
 
 static int   tsdbInitFile(SFile *pFile, STsdbRepo *pRepo, int fid, int type);
 static void  tsdbDestroyFile(SFile *pFile);
@@ -33,6 +33,7 @@ static int   keyFGroupCompFunc(const void *key, const void *fgroup);
 static void  tsdbInitFileGroup(SFileGroup *pFGroup, STsdbRepo *pRepo);
 static TSKEY tsdbGetCurrMinKey(int8_t precision, int32_t keep);
 static int   tsdbGetCurrMinFid(int8_t precision, int32_t keep, int32_t days);
+static int   tsdbCountIdleSharedFiles(STsdbFileH *pFileH);
 
 // ---------------- INTERNAL FUNCTIONS ----------------
 STsdbFileH *tsdbNewFileH(STsdbCfg *pCfg) {
@@ -49,6 +50,19 @@ STsdbFileH *tsdbNewFileH(STsdbCfg *pCfg) {
     goto _err;
   }
 
+  code = pthread_mutex_init(&(pFileH->sflock), NULL);
+  if (code != 0) {
+    tsdbError("vgId:%d failed to init shared file lock since %s", pCfg->tsdbId, strerror(code));
+    terrno = TAOS_SYSTEM_ERROR(code);
+    goto _err;
+  }
+
+  pFileH->sharedFiles = taosArrayInit(TSDB_MAX_IDLE_SHARED_FILES, sizeof(SSharedFile));
+  if (pFileH->sharedFiles == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
   pFileH->maxFGroups = TSDB_MAX_FILE(pCfg->keep, pCfg->daysPerFile);
 
   pFileH->pFGroup = (SFileGroup *)calloc(pFileH->maxFGroups, sizeof(SFileGroup));
@@ -67,6 +81,8 @@ _err:
 void tsdbFreeFileH(STsdbFileH *pFileH) {
   if (pFileH) {
     pthread_rwlock_destroy(&pFileH->fhlock);
+    pthread_mutex_destroy(&pFileH->sflock);
+    taosArrayDestroy(pFileH->sharedFiles);
     taosTFree(pFileH->pFGroup);
     free(pFileH);
   }
@@ -93,6 +109,8 @@ int tsdbOpenFileH(STsdbRepo *pRepo) {
     goto _err;
   }
 
+  if (tsdbRecoverCompact(pRepo, tDataDir) < 0) goto _err;
+
   dir = opendir(tDataDir);
   if (dir == NULL) {
     tsdbError("vgId:%d failed to open directory %s since %s", REPO_ID(pRepo), tDataDir, strerror(errno));
@@ -202,6 +220,8 @@ _err:
 void tsdbCloseFileH(STsdbRepo *pRepo) {
   STsdbFileH *pFileH = pRepo->tsdbFileH;
 
+  tsdbCloseIdleSharedFiles(pRepo, TSDB_ALL_SHARED_FILES);
+
   for (int i = 0; i < pFileH->nFGroups; i++) {
     SFileGroup *pFGroup = pFileH->pFGroup + i;
     for (int type = 0; type < TSDB_FILE_TYPE_MAX; type++) {
@@ -341,6 +361,106 @@ void tsdbCloseFile(SFile *pFile) {
   }
 }
 
+/*
+ * Read helpers of different queries on the same file group share one fd, the fd is keyed by the file magic which
+ * changes whenever the file is written, so a helper never gets an fd of a renamed-over file of another version.
+ *
+ * Where the positional read is emulated by a seek and a read, as on windows, an fd can not be shared by threads and
+ * each helper opens its own.
+ */
+int tsdbOpenSharedFile(STsdbRepo *pRepo, int fid, int type, SFile *pFile) {
+  STsdbFileH *pFileH = pRepo->tsdbFileH;
+  ASSERT(!TSDB_IS_FILE_OPENED(pFile));
+
+#ifdef TAOS_OS_FUNC_FILE_PREAD
+  return tsdbOpenFile(pFile, O_RDONLY);
+#endif
+
+  pthread_mutex_lock(&(pFileH->sflock));
+
+  size_t size = taosArrayGetSize(pFileH->sharedFiles);
+  for (size_t i = 0; i < size; i++) {
+    SSharedFile *pShared = (SSharedFile *)taosArrayGet(pFileH->sharedFiles, i);
+    if (pShared->fid == fid && pShared->type == type && pShared->magic == pFile->info.magic && !pShared->stale) {
+      pShared->refCount++;
+      pFile->fd = pShared->fd;
+      pthread_mutex_unlock(&(pFileH->sflock));
+      return 0;
+    }
+  }
+
+  if (tsdbOpenFile(pFile, O_RDONLY) < 0) {
+    pthread_mutex_unlock(&(pFileH->sflock));
+    return -1;
+  }
+
+  SSharedFile shared = {.fid = fid, .type = type, .magic = pFile->info.magic, .fd = pFile->fd, .refCount = 1};
+  if (taosArrayPush(pFileH->sharedFiles, &shared) == NULL) {
+    tsdbCloseFile(pFile);
+    pthread_mutex_unlock(&(pFileH->sflock));
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pthread_mutex_unlock(&(pFileH->sflock));
+  return 0;
+}
+
+void tsdbCloseSharedFile(STsdbRepo *pRepo, SFile *pFile) {
+  STsdbFileH *pFileH = pRepo->tsdbFileH;
+  if (!TSDB_IS_FILE_OPENED(pFile)) return;
+
+#ifdef TAOS_OS_FUNC_FILE_PREAD
+  tsdbCloseFile(pFile);
+  return;
+#endif
+
+  pthread_mutex_lock(&(pFileH->sflock));
+
+  size_t size = taosArrayGetSize(pFileH->sharedFiles);
+  for (size_t i = 0; i < size; i++) {
+    SSharedFile *pShared = (SSharedFile *)taosArrayGet(pFileH->sharedFiles, i);
+    if (pShared->fd != pFile->fd) continue;
+
+    ASSERT(pShared->refCount > 0);
+    pShared->refCount--;
+    if (pShared->refCount == 0 && (pShared->stale || tsdbCountIdleSharedFiles(pFileH) > TSDB_MAX_IDLE_SHARED_FILES)) {
+      tsdbCloseFile(pFile);
+      taosArrayRemove(pFileH->sharedFiles, i);
+    }
+    break;
+  }
+
+  pthread_mutex_unlock(&(pFileH->sflock));
+  pFile->fd = -1;
+}
+
+// Called when the files of a file group are changed or removed
+void tsdbCloseIdleSharedFiles(STsdbRepo *pRepo, int fid) {
+  STsdbFileH *pFileH = pRepo->tsdbFileH;
+
+  pthread_mutex_lock(&(pFileH->sflock));
+
+  for (size_t i = 0; i < taosArrayGetSize(pFileH->sharedFiles);) {
+    SSharedFile *pShared = (SSharedFile *)taosArrayGet(pFileH->sharedFiles, i);
+    if (fid != TSDB_ALL_SHARED_FILES && pShared->fid != fid) {
+      i++;
+      continue;
+    }
+
+    if (pShared->refCount > 0) {
+      pShared->stale = true;
+      i++;
+    } else {
+      tsdbTrace("vgId:%d close shared fd %d of file group %d", REPO_ID(pRepo), pShared->fd, pShared->fid);
+      close(pShared->fd);
+      taosArrayRemove(pFileH->sharedFiles, i);
+    }
+  }
+
+  pthread_mutex_unlock(&(pFileH->sflock));
+}
+
 int tsdbCreateFile(SFile *pFile, STsdbRepo *pRepo, int fid, int type) {
   memset((void *)pFile, 0, sizeof(SFile));
   pFile->fd = -1;
@@ -458,6 +578,9 @@ void tsdbRemoveFileGroup(STsdbRepo *pRepo, SFileGroup *pFGroup) {
   pFileH->nFGroups--;
   ASSERT(pFileH->nFGroups >= 0);
 
+  tsdbInvalidateBlockCache(REPO_ID(pRepo), fileGroup.fileId);
+  tsdbCloseIdleSharedFiles(pRepo, fileGroup.fileId);
+
   for (int type = 0; type < TSDB_FILE_TYPE_MAX; type++) {
     if (remove(fileGroup.files[type].fname) < 0) {
       tsdbError("vgId:%d failed to remove file %s", REPO_ID(pRepo), fileGroup.files[type].fname);
@@ -596,4 +719,14 @@ static TSKEY tsdbGetCurrMinKey(int8_t precision, int32_t keep) {
 
 static int tsdbGetCurrMinFid(int8_t precision, int32_t keep, int32_t days) {
   return (int)(TSDB_KEY_FILEID(tsdbGetCurrMinKey(precision, keep), days, precision));
-}
\ No newline at end of file
+}
+
+static int tsdbCountIdleSharedFiles(STsdbFileH *pFileH) {
+  int nIdle = 0;
+  for (size_t i = 0; i < taosArrayGetSize(pFileH->sharedFiles); i++) {
+    SSharedFile *pShared = (SSharedFile *)taosArrayGet(pFileH->sharedFiles, i);
+    if (pShared->refCount == 0) nIdle++;
+  }
+
+  return nIdle;
+}
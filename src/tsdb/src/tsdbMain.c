@@ -165,12 +165,14 @@ void tsdbCloseRepo(TSDB_REPO_T *repo, int toCommit) {
     tsdbAsyncCommit(pRepo);
     if (pRepo->commit) pthread_join(pRepo->commitThread, NULL);
   }
+  tsdbStopCompact(pRepo);
   tsdbUnRefMemTable(pRepo, pRepo->mem);
   tsdbUnRefMemTable(pRepo, pRepo->imem);
   pRepo->mem = NULL;
   pRepo->imem = NULL;
 
   tsdbCloseFileH(pRepo);
+  tsdbInvalidateBlockCache(vgId, TSDB_BLOCK_CACHE_ALL_FILES);
   tsdbCloseBufPool(pRepo);
   tsdbCloseMeta(pRepo);
   tsdbFreeRepo(pRepo);
@@ -332,12 +334,15 @@ int32_t tsdbConfigRepo(TSDB_REPO_T *repo, STsdbCfg *pCfg) {
   return 0;
 }
 
-void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage) {
+void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage,
+                    int64_t *rowsAppended, int64_t *rowsInserted) {
   ASSERT(repo != NULL);
   STsdbRepo *pRepo = repo;
   *totalPoints = pRepo->stat.pointsWritten;
   *totalStorage = pRepo->stat.totalStorage;
   *compStorage = pRepo->stat.compStorage;
+  *rowsAppended = pRepo->stat.rowsAppended;
+  *rowsInserted = pRepo->stat.rowsInserted;
 }
 
 int tsdbGetState(TSDB_REPO_T *repo) {
@@ -674,6 +679,12 @@ static STsdbRepo *tsdbNewRepo(char *rootDir, STsdbAppH *pAppH, STsdbCfg *pCfg) {
 
   pRepo->repoLocked = false;
 
+  code = pthread_rwlock_init(&pRepo->compactLock, NULL);
+  if (code != 0) {
+    terrno = TAOS_SYSTEM_ERROR(code);
+    goto _err;
+  }
+
   pRepo->rootDir = strdup(rootDir);
   if (pRepo->rootDir == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
@@ -717,6 +728,7 @@ static void tsdbFreeRepo(STsdbRepo *pRepo) {
     // tsdbFreeMemTable(pRepo->imem);
     taosTFree(pRepo->rootDir);
     pthread_mutex_destroy(&pRepo->mutex);
+    pthread_rwlock_destroy(&pRepo->compactLock);
     free(pRepo);
   }
 }
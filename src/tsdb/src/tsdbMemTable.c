@@ -18,6 +18,14 @@
 
 #define TSDB_DATA_SKIPLIST_LEVEL 5
 
+typedef struct {
+  STsdbRepo *pRepo;
+  int *      fids;     // file groups to commit to, created before workers start
+  int        nFids;
+  int32_t    nextIdx;  // index of the next file group to pick by a worker
+  int32_t    code;     // first error met by any worker
+} SCommitQueue;
+
 static void        tsdbFreeBytes(STsdbRepo *pRepo, void *ptr, int bytes);
 static SMemTable * tsdbNewMemTable(STsdbRepo *pRepo);
 static void        tsdbFreeMemTable(SMemTable *pMemTable);
@@ -29,8 +37,13 @@ static int         tsdbCommitMeta(STsdbRepo *pRepo);
 static void        tsdbEndCommit(STsdbRepo *pRepo);
 static int         tsdbHasDataToCommit(SCommitIter *iters, int nIters, TSKEY minKey, TSKEY maxKey);
 static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHelper *pHelper, SDataCols *pDataCols);
-static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo);
+static int tsdbCommitToFileImpl(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHelper *pHelper, SDataCols *pDataCols);
+static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo, TSKEY startKey);
 static void         tsdbDestroyCommitIters(SCommitIter *iters, int maxTables);
+static int          tsdbSeekCommitIters(SCommitIter *iters, int nIters, TSKEY key);
+static int          tsdbCommitToFilesInParallel(STsdbRepo *pRepo, SCommitIter *iters);
+static int *        tsdbGetCommitFids(STsdbRepo *pRepo, SCommitIter *iters, int *nFids);
+static void *       tsdbCommitWorker(void *arg);
 static int          tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables);
 
 // ---------------- INTERNAL FUNCTIONS ----------------
@@ -39,6 +52,7 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
   STsdbMeta * pMeta = pRepo->tsdbMeta;
   int32_t     level = 0;
   int32_t     headSize = 0;
+  int32_t     bytes = 0;
   TSKEY       key = dataRowKey(row);
   SMemTable * pMemTable = pRepo->mem;
   STableData *pTableData = NULL;
@@ -52,20 +66,18 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
 
   tSkipListNewNodeInfo(pSList, &level, &headSize);
 
-  SSkipListNode *pNode = (SSkipListNode *)malloc(headSize + sizeof(SDataRow *));
+  // The skiplist node and the row are allocated together from the buffer pool, and are released wholesale with the
+  // memtable, so no heap allocation is made for each row
+  bytes = headSize + sizeof(SDataRow *) + dataRowLen(row);
+  SSkipListNode *pNode = (SSkipListNode *)tsdbAllocBytes(pRepo, bytes);
   if (pNode == NULL) {
-    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-    return -1;
-  }
-
-  void *pRow = tsdbAllocBytes(pRepo, dataRowLen(row));
-  if (pRow == NULL) {
     tsdbError("vgId:%d failed to insert row with key %" PRId64 " to table %s while allocate %d bytes since %s",
-              REPO_ID(pRepo), key, TABLE_CHAR_NAME(pTable), dataRowLen(row), tstrerror(terrno));
-    free(pNode);
+              REPO_ID(pRepo), key, TABLE_CHAR_NAME(pTable), bytes, tstrerror(terrno));
     return -1;
   }
 
+  void *pRow = POINTER_SHIFT(pNode, headSize + sizeof(SDataRow *));
+
   pNode->level = level;
   dataRowCpy(pRow, row);
   *(SDataRow *)SL_GET_NODE_DATA(pNode) = pRow;
@@ -76,8 +88,7 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
 
   if (TABLE_TID(pTable) >= pMemTable->maxTables) {
     if (tsdbAdjustMemMaxTables(pMemTable, pMeta->maxTables) < 0) {
-      tsdbFreeBytes(pRepo, pRow, dataRowLen(row));
-      free(pNode);
+      tsdbFreeBytes(pRepo, (void *)pNode, bytes);
       return -1;
     }
   }
@@ -96,8 +107,7 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
       tsdbError("vgId:%d failed to insert row with key %" PRId64
                 " to table %s while create new table data object since %s",
                 REPO_ID(pRepo), key, TABLE_CHAR_NAME(pTable), tstrerror(terrno));
-      tsdbFreeBytes(pRepo, (void *)pRow, dataRowLen(row));
-      free(pNode);
+      tsdbFreeBytes(pRepo, (void *)pNode, bytes);
       return -1;
     }
 
@@ -106,9 +116,10 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
 
   ASSERT((pTableData != NULL) && pTableData->uid == TABLE_UID(pTable));
 
+  // tSkipListPut pushes rows with increasing keys back in O(1), only out-of-order rows search the skiplist
+  bool inOrder = (pTableData->numOfRows == 0 || key > pTableData->keyLast);
   if (tSkipListPut(pTableData->pData, pNode) == NULL) {
-    tsdbFreeBytes(pRepo, (void *)pRow, dataRowLen(row));
-    free(pNode);
+    tsdbFreeBytes(pRepo, (void *)pNode, bytes);
   } else {
     if (TABLE_LASTKEY(pTable) < key) TABLE_LASTKEY(pTable) = key;
     if (pMemTable->keyFirst > key) pMemTable->keyFirst = key;
@@ -119,6 +130,12 @@ int tsdbInsertRowToMem(STsdbRepo *pRepo, SDataRow row, STable *pTable) {
     if (pTableData->keyLast < key) pTableData->keyLast = key;
     pTableData->numOfRows++;
 
+    if (inOrder) {
+      pRepo->stat.rowsAppended++;
+    } else {
+      pRepo->stat.rowsInserted++;
+    }
+
     ASSERT(pTableData->numOfRows == tSkipListGetSize(pTableData->pData));
   }
 
@@ -203,6 +220,10 @@ void *tsdbAllocBytes(STsdbRepo *pRepo, int bytes) {
   STsdbBufBlock *pBufBlock = NULL;
   void *         ptr = NULL;
 
+  // Round up the size so the next allocation is pointer aligned, as the skiplist nodes carved from the buffer hold
+  // pointers
+  bytes = (int)ALIGN_NUM(bytes, sizeof(void *));
+
   // Either allocate from buffer blocks or from SYSTEM memory pool
   if (pRepo->mem == NULL) {
     SMemTable *pMemTable = tsdbNewMemTable(pRepo);
@@ -303,6 +324,8 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
   int       numOfRows = 0;
   TSKEY     keyNext = 0;
   int       filterIter = 0;
+  SDataRow  rows[TSDB_CACHE_ROWS_BATCH];
+  int       nRows = 0;  // rows pending to be appended to pCols
 
   if (nFilterKeys != 0) { // for filter purpose
     ASSERT(filterKeys != NULL);
@@ -339,24 +362,35 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
       if (numOfRows >= maxRowsToRead) break;
       if (pCols) {
         if (pSchema == NULL || schemaVersion(pSchema) != dataRowVersion(row)) {
+          if (nRows > 0) {
+            tdAppendDataRowsToDataCol(rows, nRows, pSchema, pCols);
+            nRows = 0;
+          }
           pSchema = tsdbGetTableSchemaImpl(pTable, false, false, dataRowVersion(row));
           if (pSchema == NULL) {
             ASSERT(0);
           }
         }
 
-        tdAppendDataRowToDataCol(row, pSchema, pCols);
+        rows[nRows++] = row;
+        if (nRows >= TSDB_CACHE_ROWS_BATCH) {
+          tdAppendDataRowsToDataCol(rows, nRows, pSchema, pCols);
+          nRows = 0;
+        }
       }
       numOfRows++;
     }
   } while (tSkipListIterNext(pIter));
 
+  if (nRows > 0) tdAppendDataRowsToDataCol(rows, nRows, pSchema, pCols);
+
   return numOfRows;
 }
 
 // ---------------- LOCAL FUNCTIONS ----------------
 static void tsdbFreeBytes(STsdbRepo *pRepo, void *ptr, int bytes) {
   ASSERT(pRepo->mem != NULL);
+  bytes = (int)ALIGN_NUM(bytes, sizeof(void *));
   if (pRepo->mem->extraBuffList == NULL) {
     STsdbBufBlock *pBufBlock = tsdbGetCurrBufBlock(pRepo);
     ASSERT(pBufBlock != NULL);
@@ -441,7 +475,7 @@ static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
   pTableData->numOfRows = 0;
 
   pTableData->pData = tSkipListCreate(TSDB_DATA_SKIPLIST_LEVEL, TSDB_DATA_TYPE_TIMESTAMP,
-                                      TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 1, tsdbGetTsTupleKey);
+                                      TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP], 0, 0, 0, tsdbGetTsTupleKey);
   if (pTableData->pData == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     goto _err;
@@ -479,12 +513,19 @@ static void *tsdbCommitData(void *arg) {
 
   // Create the iterator to read from cache
   if (pMem->numOfRows > 0) {
-    iters = tsdbCreateCommitIters(pRepo);
+    iters = tsdbCreateCommitIters(pRepo, pMem->keyFirst);
     if (iters == NULL) {
       tsdbError("vgId:%d failed to create commit iterator since %s", REPO_ID(pRepo), tstrerror(terrno));
       goto _exit;
     }
+  }
 
+  if (pMem->numOfRows > 0 && tsNumOfCommitThreads > 1) {
+    if (tsdbCommitToFilesInParallel(pRepo, iters) < 0) {
+      tsdbError("vgId:%d failed to commit to files in parallel since %s", REPO_ID(pRepo), tstrerror(terrno));
+      goto _exit;
+    }
+  } else if (pMem->numOfRows > 0) {
     if (tsdbInitWriteHelper(&whelper, pRepo) < 0) {
       tsdbError("vgId:%d failed to init write helper since %s", REPO_ID(pRepo), tstrerror(terrno));
       goto _exit;
@@ -517,6 +558,9 @@ static void *tsdbCommitData(void *arg) {
 
   tsdbFitRetention(pRepo);
 
+  // Compact at most one fragmented file group in the background, a failure there does not affect the committed data
+  tsdbAsyncCompact(pRepo);
+
 _exit:
   tdFreeDataCols(pDataCols);
   tsdbDestroyCommitIters(iters, pMem->maxTables);
@@ -593,11 +637,20 @@ void tsdbGetFidKeyRange(int daysPerFile, int8_t precision, int fileId, TSKEY *mi
   *maxKey = *minKey + daysPerFile * tsMsPerDay[precision] - 1;
 }
 
+// A compaction can not switch its files in while the file group is being committed to
 static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHelper *pHelper, SDataCols *pDataCols) {
+  pthread_rwlock_rdlock(&(pRepo->compactLock));
+  int code = tsdbCommitToFileImpl(pRepo, fid, iters, pHelper, pDataCols);
+  pthread_rwlock_unlock(&(pRepo->compactLock));
+  return code;
+}
+
+static int tsdbCommitToFileImpl(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHelper *pHelper, SDataCols *pDataCols) {
   char *      dataDir = NULL;
   STsdbCfg *  pCfg = &pRepo->config;
   STsdbFileH *pFileH = pRepo->tsdbFileH;
   SFileGroup *pGroup = NULL;
+  SFileGroup  fGroup = {0};
   SMemTable * pMem = pRepo->imem;
   bool        newLast = false;
 
@@ -618,13 +671,22 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHe
     return -1;
   }
 
-  if ((pGroup = tsdbCreateFGroupIfNeed(pRepo, dataDir, fid)) == NULL) {
-    tsdbError("vgId:%d failed to create file group %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
-    goto _err;
+  // Work on a copy of the file group, the file group array may be resorted by other commit workers
+  pthread_rwlock_rdlock(&(pFileH->fhlock));
+  pGroup = tsdbSearchFGroup(pFileH, fid, TD_EQ);
+  if (pGroup != NULL) fGroup = *pGroup;
+  pthread_rwlock_unlock(&(pFileH->fhlock));
+
+  if (pGroup == NULL) {
+    if ((pGroup = tsdbCreateFGroupIfNeed(pRepo, dataDir, fid)) == NULL) {
+      tsdbError("vgId:%d failed to create file group %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
+      goto _err;
+    }
+    fGroup = *pGroup;
   }
 
   // Open files for write/read
-  if (tsdbSetAndOpenHelperFile(pHelper, pGroup) < 0) {
+  if (tsdbSetAndOpenHelperFile(pHelper, &fGroup) < 0) {
     tsdbError("vgId:%d failed to set helper file since %s", REPO_ID(pRepo), tstrerror(terrno));
     goto _err;
   }
@@ -681,10 +743,13 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHe
   }
 
   taosTFree(dataDir);
-  tsdbCloseHelperFile(pHelper, 0, pGroup);
+  tsdbCloseHelperFile(pHelper, 0, &fGroup);
 
   pthread_rwlock_wrlock(&(pFileH->fhlock));
 
+  pGroup = tsdbSearchFGroup(pFileH, fid, TD_EQ);
+  ASSERT(pGroup != NULL);
+
   (void)rename(helperNewHeadF(pHelper)->fname, helperHeadF(pHelper)->fname);
   pGroup->files[TSDB_FILE_TYPE_HEAD].info = helperNewHeadF(pHelper)->info;
 
@@ -699,6 +764,9 @@ static int tsdbCommitToFile(STsdbRepo *pRepo, int fid, SCommitIter *iters, SRWHe
 
   pthread_rwlock_unlock(&(pFileH->fhlock));
 
+  tsdbInvalidateBlockCache(REPO_ID(pRepo), fid);
+  tsdbCloseIdleSharedFiles(pRepo, fid);
+
   return 0;
 
 _err:
@@ -707,7 +775,7 @@ _err:
   return -1;
 }
 
-static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo) {
+static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo, TSKEY startKey) {
   SMemTable *pMem = pRepo->imem;
   STsdbMeta *pMeta = pRepo->tsdbMeta;
 
@@ -731,7 +799,8 @@ static SCommitIter *tsdbCreateCommitIters(STsdbRepo *pRepo) {
 
   for (int i = 0; i < pMem->maxTables; i++) {
     if ((iters[i].pTable != NULL) && (pMem->tData[i] != NULL) && (TABLE_UID(iters[i].pTable) == pMem->tData[i]->uid)) {
-      if ((iters[i].pIter = tSkipListCreateIter(pMem->tData[i]->pData)) == NULL) {
+      if ((iters[i].pIter = tSkipListCreateIterFromVal(pMem->tData[i]->pData, (const char *)(&startKey),
+                                                       TSDB_DATA_TYPE_TIMESTAMP, TSDB_ORDER_ASC)) == NULL) {
         terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
         goto _err;
       }
@@ -760,6 +829,176 @@ static void tsdbDestroyCommitIters(SCommitIter *iters, int maxTables) {
   free(iters);
 }
 
+// Move each iterator to the first row with key not less than the given key
+static int tsdbSeekCommitIters(SCommitIter *iters, int nIters, TSKEY key) {
+  for (int i = 0; i < nIters; i++) {
+    SCommitIter *pIter = iters + i;
+    if (pIter->pIter == NULL) continue;
+
+    TSKEY nextKey = tsdbNextIterKey(pIter->pIter);
+    if (nextKey < 0 || nextKey >= key) continue;
+
+    SSkipList *pSList = pIter->pIter->pSkipList;
+    tSkipListDestroyIter(pIter->pIter);
+    pIter->pIter = tSkipListCreateIterFromVal(pSList, (const char *)(&key), TSDB_DATA_TYPE_TIMESTAMP, TSDB_ORDER_ASC);
+    if (pIter->pIter == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+    tSkipListIterNext(pIter->pIter);
+  }
+
+  return 0;
+}
+
+// Find out all file groups having data to commit and create them ahead, so commit workers never add file groups
+static int *tsdbGetCommitFids(STsdbRepo *pRepo, SCommitIter *iters, int *nFids) {
+  STsdbCfg * pCfg = &(pRepo->config);
+  SMemTable *pMem = pRepo->imem;
+  char *     dataDir = NULL;
+  int *      fids = NULL;
+
+  int sfid = (int)(TSDB_KEY_FILEID(pMem->keyFirst, pCfg->daysPerFile, pCfg->precision));
+  int efid = (int)(TSDB_KEY_FILEID(pMem->keyLast, pCfg->daysPerFile, pCfg->precision));
+
+  *nFids = 0;
+  fids = (int *)malloc(sizeof(int) * (efid - sfid + 1));
+  dataDir = tsdbGetDataDirName(pRepo->rootDir);
+  if (fids == NULL || dataDir == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  while (true) {
+    TSKEY nextKey = -1;
+    for (int i = 0; i < pMem->maxTables; i++) {
+      TSKEY key = tsdbNextIterKey(iters[i].pIter);
+      if (key >= 0 && (nextKey < 0 || key < nextKey)) nextKey = key;
+    }
+    if (nextKey < 0) break;
+
+    int   fid = (int)(TSDB_KEY_FILEID(nextKey, pCfg->daysPerFile, pCfg->precision));
+    TSKEY minKey = 0, maxKey = 0;
+    tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
+
+    ASSERT(*nFids < efid - sfid + 1);
+    if (tsdbCreateFGroupIfNeed(pRepo, dataDir, fid) == NULL) {
+      tsdbError("vgId:%d failed to create file group %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
+      goto _err;
+    }
+    fids[(*nFids)++] = fid;
+
+    if (tsdbSeekCommitIters(iters, pMem->maxTables, maxKey + 1) < 0) goto _err;
+  }
+
+  taosTFree(dataDir);
+  return fids;
+
+_err:
+  taosTFree(dataDir);
+  taosTFree(fids);
+  return NULL;
+}
+
+static int tsdbCommitToFilesInParallel(STsdbRepo *pRepo, SCommitIter *iters) {
+  SCommitQueue queue = {0};
+  pthread_t *  threads = NULL;
+  int          nThreads = 0;
+
+  queue.pRepo = pRepo;
+  queue.fids = tsdbGetCommitFids(pRepo, iters, &queue.nFids);
+  if (queue.fids == NULL) return -1;
+
+  threads = (pthread_t *)calloc(MIN(tsNumOfCommitThreads, queue.nFids), sizeof(pthread_t));
+  if (threads == NULL && queue.nFids > 0) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    taosTFree(queue.fids);
+    return -1;
+  }
+
+  for (; nThreads < MIN(tsNumOfCommitThreads, queue.nFids); nThreads++) {
+    int ret = pthread_create(threads + nThreads, NULL, tsdbCommitWorker, (void *)(&queue));
+    if (ret != 0) {
+      tsdbError("vgId:%d failed to create commit worker since %s", REPO_ID(pRepo), strerror(ret));
+      atomic_store_32(&queue.code, TAOS_SYSTEM_ERROR(ret));
+      break;
+    }
+  }
+
+  tsdbDebug("vgId:%d %d file groups are committed by %d workers", REPO_ID(pRepo), queue.nFids, nThreads);
+
+  for (int i = 0; i < nThreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  taosTFree(threads);
+  taosTFree(queue.fids);
+
+  if (queue.code != TSDB_CODE_SUCCESS) {
+    terrno = queue.code;
+    return -1;
+  }
+
+  return 0;
+}
+
+static void *tsdbCommitWorker(void *arg) {
+  SCommitQueue *pQueue = (SCommitQueue *)arg;
+  STsdbRepo *   pRepo = pQueue->pRepo;
+  STsdbCfg *    pCfg = &(pRepo->config);
+  STsdbMeta *   pMeta = pRepo->tsdbMeta;
+  SMemTable *   pMem = pRepo->imem;
+  SCommitIter * iters = NULL;
+  SDataCols *   pDataCols = NULL;
+  SRWHelper     whelper = {0};
+
+  if (tsdbInitWriteHelper(&whelper, pRepo) < 0) {
+    tsdbError("vgId:%d failed to init write helper since %s", REPO_ID(pRepo), tstrerror(terrno));
+    goto _err;
+  }
+
+  if ((pDataCols = tdNewDataCols(pMeta->maxRowBytes, pMeta->maxCols, pCfg->maxRowsPerFileBlock)) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbError("vgId:%d failed to init data cols with maxRowBytes %d maxCols %d maxRowsPerFileBlock %d since %s",
+              REPO_ID(pRepo), pMeta->maxCols, pMeta->maxRowBytes, pCfg->maxRowsPerFileBlock, tstrerror(terrno));
+    goto _err;
+  }
+
+  while (atomic_load_32(&pQueue->code) == TSDB_CODE_SUCCESS) {
+    int idx = atomic_fetch_add_32(&pQueue->nextIdx, 1);
+    if (idx >= pQueue->nFids) break;
+
+    int   fid = pQueue->fids[idx];
+    TSKEY minKey = 0, maxKey = 0;
+    tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
+
+    // Each worker reads the cache with its own iterators starting from the file group
+    if ((iters = tsdbCreateCommitIters(pRepo, minKey)) == NULL) {
+      tsdbError("vgId:%d failed to create commit iterator since %s", REPO_ID(pRepo), tstrerror(terrno));
+      goto _err;
+    }
+
+    if (tsdbCommitToFile(pRepo, fid, iters, &whelper, pDataCols) < 0) {
+      tsdbError("vgId:%d failed to commit to file %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
+      goto _err;
+    }
+
+    tsdbDestroyCommitIters(iters, pMem->maxTables);
+    iters = NULL;
+  }
+
+  tdFreeDataCols(pDataCols);
+  tsdbDestroyHelper(&whelper);
+  return NULL;
+
+_err:
+  atomic_store_32(&pQueue->code, terrno);
+  tsdbDestroyCommitIters(iters, pMem->maxTables);
+  tdFreeDataCols(pDataCols);
+  tsdbDestroyHelper(&whelper);
+  return NULL;
+}
+
 static int tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables) {
   ASSERT(pMemTable->maxTables < maxTables);
 
@@ -20,7 +20,6 @@
 #include "tsdbMain.h"
 #include "tskiplist.h"
 
-#define TSDB_SUPER_TABLE_SL_LEVEL 5
 #define DEFAULT_TAG_INDEX_COLUMN 0
 
 static int     tsdbCompareSchemaVersion(const void *key1, const void *key2);
@@ -387,17 +386,24 @@ int tsdbUpdateTableTagValue(TSDB_REPO_T *repo, SUpdateTableTagValMsg *pMsg) {
   // STColumn *pCol = bsearch(&(pMsg->colId), pMsg->data, pMsg->numOfTags, sizeof(STColumn), colIdCompar);
   // ASSERT(pCol != NULL);
 
+  tsdbWLockRepoMeta(pRepo);
+  if (pNewSchema != NULL) {
+    tsdbFreeTagIndex(pTable->pSuper);  // built again on the new tag schema when queried
+  }
   if (isChangeIndexCol) {
-    tsdbWLockRepoMeta(pRepo);
     tsdbRemoveTableFromIndex(pMeta, pTable);
+  } else {
+    tsdbRemoveTableFromTagIndex(pTable->pSuper, pTable, pMsg->colId);
   }
   taosWLockLatch(&(pTable->latch));
   tdSetKVRowDataOfCol(&(pTable->tagVal), pMsg->colId, pMsg->type, POINTER_SHIFT(pMsg->data, pMsg->schemaLen));
   taosWUnLockLatch(&(pTable->latch));
   if (isChangeIndexCol) {
     tsdbAddTableIntoIndex(pMeta, pTable, false);
-    tsdbUnlockRepoMeta(pRepo);
+  } else {
+    tsdbAddTableIntoTagIndex(pTable->pSuper, pTable, pMsg->colId);
   }
+  tsdbUnlockRepoMeta(pRepo);
 
   // Update on file
   int tlen1 = (pNewSchema) ? tsdbGetTableEncodeSize(TSDB_UPDATE_META, pTable->pSuper) : 0;
@@ -774,6 +780,7 @@ static void tsdbFreeTable(STable *pTable) {
     kvRowFree(pTable->tagVal);
 
     tSkipListDestroy(pTable->pIndex);
+    if (TABLE_TYPE(pTable) == TSDB_SUPER_TABLE) tsdbFreeTagIndex(pTable);
     taosTFree(pTable->sql);
     free(pTable);
   }
@@ -917,6 +924,7 @@ static int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper
   memcpy(SL_GET_NODE_DATA(pNode), &pTable, sizeof(STable *));
 
   tSkipListPut(pSTable->pIndex, pNode);
+  tsdbAddTableIntoTagIndex(pSTable, pTable, TSDB_TAG_INDEX_ALL_COLS);
   if (refSuper) T_REF_INC(pSTable);
   return 0;
 }
@@ -946,6 +954,7 @@ static int tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable) {
   }
 
   taosArrayDestroy(res);
+  tsdbRemoveTableFromTagIndex(pSTable, pTable, TSDB_TAG_INDEX_ALL_COLS);
   return 0;
 }
 
@@ -28,14 +28,19 @@
 #define TSDB_KEY_COL_OFFSET 0
 #define TSDB_GET_COMPBLOCK_IDX(h, b) (POINTER_DISTANCE(b, (h)->pCompInfo->blocks)/sizeof(SCompBlock))
 
+// A column to read in tsdbLoadBlockDataColsImpl
+typedef struct {
+  SDataCol *pDataCol;
+  SCompCol  compCol;
+} SColLoad;
+
 static bool tsdbShouldCreateNewLast(SRWHelper *pHelper);
-static int  tsdbWriteBlockToFile(SRWHelper *pHelper, SFile *pFile, SDataCols *pDataCols, SCompBlock *pCompBlock,
-                                 bool isLast, bool isSuperBlock);
 static int  compareKeyBlock(const void *arg1, const void *arg2);
 static int  tsdbAdjustInfoSizeIfNeeded(SRWHelper *pHelper, size_t esize);
 static int  tsdbInsertSuperBlock(SRWHelper *pHelper, SCompBlock *pCompBlock, int blkIdx);
 static int  tsdbAddSubBlock(SRWHelper *pHelper, SCompBlock *pCompBlock, int blkIdx, int rowsAdded);
 static int  tsdbUpdateSuperBlock(SRWHelper *pHelper, SCompBlock *pCompBlock, int blkIdx);
+static void tsdbAddBlockToTomb(SRWHelper *pHelper, SCompBlock *pCompBlock);
 static void tsdbResetHelperFileImpl(SRWHelper *pHelper);
 static int  tsdbInitHelperFile(SRWHelper *pHelper);
 static void tsdbDestroyHelperFile(SRWHelper *pHelper);
@@ -50,14 +55,11 @@ static int  tsdbInitHelper(SRWHelper *pHelper, STsdbRepo *pRepo, tsdb_rw_helper_
 static int  tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, char *content, int32_t len, int8_t comp, int numOfRows,
                                          int maxPoints, char *buffer, int bufferSize);
 static int  tsdbLoadBlockDataColsImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDataCols *pDataCols, int16_t *colIds,
-                                      int numOfColIds);
+                                      int numOfColIds, bool loadKey);
 static int  tsdbLoadBlockDataImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDataCols *pDataCols);
-static int  tsdbEncodeSCompIdx(void **buf, SCompIdx *pIdx);
 static void *tsdbDecodeSCompIdx(void *buf, SCompIdx *pIdx);
 static int   tsdbProcessAppendCommit(SRWHelper *pHelper, SCommitIter *pCommitIter, SDataCols *pDataCols, TSKEY maxKey);
 static void  tsdbDestroyHelperBlock(SRWHelper *pHelper);
-static int   tsdbLoadColData(SRWHelper *pHelper, SFile *pFile, SCompBlock *pCompBlock, SCompCol *pCompCol,
-                             SDataCol *pDataCol);
 static int   tsdbWriteBlockToProperFile(SRWHelper *pHelper, SDataCols *pDataCols, SCompBlock *pCompBlock);
 static int   tsdbProcessMergeCommit(SRWHelper *pHelper, SCommitIter *pCommitIter, SDataCols *pDataCols, TSKEY maxKey,
                                     int *blkIdx);
@@ -120,8 +122,8 @@ int tsdbSetAndOpenHelperFile(SRWHelper *pHelper, SFileGroup *pGroup) {
   }
 
   // Open the files
-  if (tsdbOpenFile(helperHeadF(pHelper), O_RDONLY) < 0) return -1;
   if (helperType(pHelper) == TSDB_WRITE_HELPER) {
+    if (tsdbOpenFile(helperHeadF(pHelper), O_RDONLY) < 0) return -1;
     if (tsdbOpenFile(helperDataF(pHelper), O_RDWR) < 0) return -1;
     if (tsdbOpenFile(helperLastF(pHelper), O_RDWR) < 0) return -1;
 
@@ -142,8 +144,10 @@ int tsdbSetAndOpenHelperFile(SRWHelper *pHelper, SFileGroup *pGroup) {
       if (tsdbUpdateFileHeader(pFile) < 0) return -1;
     }
   } else {
-    if (tsdbOpenFile(helperDataF(pHelper), O_RDONLY) < 0) return -1;
-    if (tsdbOpenFile(helperLastF(pHelper), O_RDONLY) < 0) return -1;
+    int fid = pGroup->fileId;
+    if (tsdbOpenSharedFile(pRepo, fid, TSDB_FILE_TYPE_HEAD, helperHeadF(pHelper)) < 0) return -1;
+    if (tsdbOpenSharedFile(pRepo, fid, TSDB_FILE_TYPE_DATA, helperDataF(pHelper)) < 0) return -1;
+    if (tsdbOpenSharedFile(pRepo, fid, TSDB_FILE_TYPE_LAST, helperLastF(pHelper)) < 0) return -1;
   }
 
   helperSetState(pHelper, TSDB_HELPER_FILE_SET_AND_OPEN);
@@ -154,6 +158,13 @@ int tsdbSetAndOpenHelperFile(SRWHelper *pHelper, SFileGroup *pGroup) {
 int tsdbCloseHelperFile(SRWHelper *pHelper, bool hasError, SFileGroup *pGroup) {
   SFile *pFile = NULL;
 
+  if (helperType(pHelper) == TSDB_READ_HELPER) {
+    tsdbCloseSharedFile(pHelper->pRepo, helperHeadF(pHelper));
+    tsdbCloseSharedFile(pHelper->pRepo, helperDataF(pHelper));
+    tsdbCloseSharedFile(pHelper->pRepo, helperLastF(pHelper));
+    return 0;
+  }
+
   pFile = helperHeadF(pHelper);
   tsdbCloseFile(pFile);
 
@@ -399,6 +410,9 @@ int tsdbWriteCompInfo(SRWHelper *pHelper) {
     pFile->info.len += tsdbEncodeSCompIdx(&pBuf, &(pHelper->curCompIdx));
 
     pFile->info.size += pIdx->len;
+    pFile->info.totalBlocks += pIdx->numOfBlocks;
+    pFile->info.totalSubBlocks +=
+        (uint32_t)((pIdx->len - sizeof(SCompInfo) - sizeof(TSCKSUM)) / sizeof(SCompBlock) - pIdx->numOfBlocks);
     // ASSERT(pFile->info.size == lseek(pFile->fd, 0, SEEK_CUR));
   }
 
@@ -448,13 +462,7 @@ int tsdbWriteCompIdx(SRWHelper *pHelper) {
 
 int tsdbLoadCompIdxImpl(SFile *pFile, uint32_t offset, uint32_t len, void *buffer) {
   const char *prefixMsg = "failed to load SCompIdx part";
-  if (lseek(pFile->fd, offset, SEEK_SET) < 0) {
-    tsdbError("%s: seek to file %s offset %u failed since %s", prefixMsg, pFile->fname, offset, strerror(errno));
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    return -1;
-  }
-
-  if (taosTRead(pFile->fd, buffer, len) < len) {
+  if (taosTPRead(pFile->fd, buffer, len, offset) < len) {
     tsdbError("%s: read file %s offset %u len %u failed since %s", prefixMsg, pFile->fname, offset, len,
               strerror(errno));
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
@@ -539,19 +547,13 @@ int tsdbLoadCompIdx(SRWHelper *pHelper, void *target) {
 int tsdbLoadCompInfoImpl(SFile *pFile, SCompIdx *pIdx, SCompInfo **ppCompInfo) {
   const char *prefixMsg = "failed to load SCompInfo/SCompBlock part";
 
-  if (lseek(pFile->fd, pIdx->offset, SEEK_SET) < 0) {
-    tsdbError("%s: seek to file %s offset %u failed since %s", prefixMsg, pFile->fname, pIdx->offset, strerror(errno));
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    return -1;
-  }
-
   *ppCompInfo = taosTRealloc((void *)(*ppCompInfo), pIdx->len);
   if (*ppCompInfo == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     return -1;
   }
 
-  if (taosTRead(pFile->fd, (void *)(*ppCompInfo), pIdx->len) < (int)pIdx->len) {
+  if (taosTPRead(pFile->fd, (void *)(*ppCompInfo), pIdx->len, pIdx->offset) < (int)pIdx->len) {
     tsdbError("%s: read file %s offset %u len %u failed since %s", prefixMsg, pFile->fname, pIdx->offset, pIdx->len,
               strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -595,12 +597,6 @@ int tsdbLoadCompData(SRWHelper *pHelper, SCompBlock *pCompBlock, void *target) {
   ASSERT(pCompBlock->numOfSubBlocks <= 1);
   SFile *pFile = (pCompBlock->last) ? helperLastF(pHelper) : helperDataF(pHelper);
 
-  if (lseek(pFile->fd, (off_t)pCompBlock->offset, SEEK_SET) < 0) {
-    tsdbError("vgId:%d failed to lseek file %s since %s", REPO_ID(pHelper->pRepo), pFile->fname, strerror(errno));
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    return -1;
-  }
-
   size_t tsize = TSDB_GET_COMPCOL_LEN(pCompBlock->numOfCols);
   pHelper->pCompData = taosTRealloc((void *)pHelper->pCompData, tsize);
   if (pHelper->pCompData == NULL) {
@@ -608,7 +604,7 @@ int tsdbLoadCompData(SRWHelper *pHelper, SCompBlock *pCompBlock, void *target) {
     return -1;
   }
 
-  if (taosTRead(pFile->fd, (void *)pHelper->pCompData, tsize) < tsize) {
+  if (taosTPRead(pFile->fd, (void *)pHelper->pCompData, tsize, pCompBlock->offset) < tsize) {
     tsdbError("vgId:%d failed to read %" PRIzu " bytes from file %s since %s", REPO_ID(pHelper->pRepo), tsize, pFile->fname,
               strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -666,11 +662,11 @@ int tsdbLoadBlockDataCols(SRWHelper *pHelper, SCompBlock *pCompBlock, SCompInfo
     pTCompBlock = (SCompBlock *)POINTER_SHIFT((pCompInfo == NULL) ? pHelper->pCompInfo : pCompInfo, pCompBlock->offset);
 
   tdResetDataCols(pHelper->pDataCols[0]);
-  if (tsdbLoadBlockDataColsImpl(pHelper, pTCompBlock, pHelper->pDataCols[0], colIds, numOfColIds) < 0) goto _err;
+  if (tsdbLoadBlockDataColsImpl(pHelper, pTCompBlock, pHelper->pDataCols[0], colIds, numOfColIds, true) < 0) goto _err;
   for (int i = 1; i < numOfSubBlocks; i++) {
     tdResetDataCols(pHelper->pDataCols[1]);
     pTCompBlock++;
-    if (tsdbLoadBlockDataColsImpl(pHelper, pTCompBlock, pHelper->pDataCols[1], colIds, numOfColIds) < 0) goto _err;
+    if (tsdbLoadBlockDataColsImpl(pHelper, pTCompBlock, pHelper->pDataCols[1], colIds, numOfColIds, true) < 0) goto _err;
     if (tdMergeDataCols(pHelper->pDataCols[0], pHelper->pDataCols[1], pHelper->pDataCols[1]->numOfRows) < 0) goto _err;
   }
 
@@ -684,6 +680,15 @@ _err:
   return -1;
 }
 
+// Load more columns of a block without sub-blocks into pDataCols[0], which keeps the columns loaded by
+// tsdbLoadBlockDataCols. The timestamp column is not loaded again.
+int tsdbLoadMoreBlockDataCols(SRWHelper *pHelper, SCompBlock *pCompBlock, int16_t *colIds, int numOfColIds) {
+  ASSERT(pCompBlock->numOfSubBlocks == 1);
+  ASSERT(pHelper->pDataCols[0]->numOfRows == pCompBlock->numOfRows);
+
+  return tsdbLoadBlockDataColsImpl(pHelper, pCompBlock, pHelper->pDataCols[0], colIds, numOfColIds, false);
+}
+
 int tsdbLoadBlockData(SRWHelper *pHelper, SCompBlock *pCompBlock, SCompInfo *pCompInfo) {
   SCompBlock *pTCompBlock = pCompBlock;
 
@@ -710,6 +715,25 @@ _err:
   return -1;
 }
 
+// Ask the kernel to read the data of a block and its sub-blocks into the page cache in the background, return the
+// number of bytes requested
+int64_t tsdbReadAheadBlockData(SRWHelper *pHelper, SCompBlock *pCompBlock, SCompInfo *pCompInfo) {
+  SCompBlock *pTCompBlock = pCompBlock;
+  int64_t     bytes = 0;
+
+  int numOfSubBlocks = pCompBlock->numOfSubBlocks;
+  if (numOfSubBlocks > 1)
+    pTCompBlock = (SCompBlock *)POINTER_SHIFT((pCompInfo == NULL) ? pHelper->pCompInfo : pCompInfo, pCompBlock->offset);
+
+  for (int i = 0; i < numOfSubBlocks; i++, pTCompBlock++) {
+    SFile *pFile = (pTCompBlock->last) ? helperLastF(pHelper) : helperDataF(pHelper);
+    if (pFile->fd < 0) continue;
+    if (taosReadAhead(pFile->fd, pTCompBlock->offset, pTCompBlock->len) == 0) bytes += pTCompBlock->len;
+  }
+
+  return bytes;
+}
+
 // ---------------------- INTERNAL FUNCTIONS ----------------------
 static bool tsdbShouldCreateNewLast(SRWHelper *pHelper) {
   ASSERT(helperLastF(pHelper)->fd > 0);
@@ -719,8 +743,8 @@ static bool tsdbShouldCreateNewLast(SRWHelper *pHelper) {
   return false;
 }
 
-static int tsdbWriteBlockToFile(SRWHelper *pHelper, SFile *pFile, SDataCols *pDataCols, SCompBlock *pCompBlock,
-                                bool isLast, bool isSuperBlock) {
+int tsdbWriteBlockToFile(SRWHelper *pHelper, SFile *pFile, SDataCols *pDataCols, SCompBlock *pCompBlock, bool isLast,
+                         bool isSuperBlock) {
   STsdbCfg * pCfg = &(pHelper->pRepo->config);
   SCompData *pCompData = (SCompData *)(pHelper->pBuffer);
   int64_t    offset = 0;
@@ -1020,6 +1044,8 @@ static int tsdbUpdateSuperBlock(SRWHelper *pHelper, SCompBlock *pCompBlock, int
 
   ASSERT(pSCompBlock->numOfSubBlocks >= 1);
 
+  tsdbAddBlockToTomb(pHelper, pSCompBlock);
+
   // Delete the sub blocks it has
   if (pSCompBlock->numOfSubBlocks > 1) {
     size_t tsize = (size_t)(pIdx->len - (pSCompBlock->offset + pSCompBlock->len));
@@ -1047,6 +1073,26 @@ static int tsdbUpdateSuperBlock(SRWHelper *pHelper, SCompBlock *pCompBlock, int
   return 0;
 }
 
+static void tsdbAddBlockToTomb(SRWHelper *pHelper, SCompBlock *pCompBlock) {
+  SCompBlock *pTCompBlock = pCompBlock;
+  int         nBlocks = 1;
+
+  if (pCompBlock->numOfSubBlocks > 1) {
+    pTCompBlock = (SCompBlock *)POINTER_SHIFT(pHelper->pCompInfo, pCompBlock->offset);
+    nBlocks = pCompBlock->numOfSubBlocks;
+  }
+
+  // The space occupied by the replaced block and its sub-blocks can only be reclaimed by compaction. Blocks in an old
+  // .last file which is being replaced by a new one are dropped as a whole, so no need to count them.
+  for (int i = 0; i < nBlocks; i++, pTCompBlock++) {
+    if (pTCompBlock->last) {
+      if (!TSDB_NLAST_FILE_OPENED(pHelper)) helperLastF(pHelper)->info.tombSize += pTCompBlock->len;
+    } else {
+      helperDataF(pHelper)->info.tombSize += pTCompBlock->len;
+    }
+  }
+}
+
 static void tsdbResetHelperFileImpl(SRWHelper *pHelper) {
   pHelper->idxH.numOfIdx = 0;
   pHelper->idxH.curIdx = 0;
@@ -1187,62 +1233,194 @@ static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, char *content, int32
   return 0;
 }
 
-static int tsdbLoadColData(SRWHelper *pHelper, SFile *pFile, SCompBlock *pCompBlock, SCompCol *pCompCol,
-                           SDataCol *pDataCol) {
+static int64_t tsdbGetColDataOffset(SCompBlock *pCompBlock, SCompCol *pCompCol) {
+  return pCompBlock->offset + TSDB_GET_COMPCOL_LEN(pCompBlock->numOfCols) + pCompCol->offset;
+}
+
+// Only the queries go through the block cache, the blocks loaded by commit are not read again
+static bool tsdbShouldUseBlockCache(SRWHelper *pHelper) {
+  return (helperType(pHelper) == TSDB_READ_HELPER) && tsdbBlockCacheEnabled();
+}
+
+static bool tsdbLoadCachedColData(SRWHelper *pHelper, SFile *pFile, SCompBlock *pCompBlock, SCompCol *pCompCol,
+                                  SDataCol *pDataCol) {
+  if (!tsdbShouldUseBlockCache(pHelper)) return false;
+
+  SBlockCacheKey key;
+  tsdbInitBlockCacheKey(&key, REPO_ID(pHelper->pRepo), helperFileId(pHelper), pFile, (int8_t)pCompBlock->last,
+                        tsdbGetColDataOffset(pCompBlock, pCompCol), pCompCol->colId);
+
+  void *  pData = NULL;
+  int32_t len = 0;
+  void *  pEntry = tsdbAcquireCachedColData(&key, &pData, &len);
+  if (pEntry == NULL) return false;
+
+  if (len > pDataCol->spaceSize) {
+    tsdbReleaseCachedColData(pEntry);
+    return false;
+  }
+
+  memcpy(pDataCol->pData, pData, len);
+  tsdbReleaseCachedColData(pEntry);
+
+  pDataCol->len = len;
+  if (pDataCol->type == TSDB_DATA_TYPE_BINARY || pDataCol->type == TSDB_DATA_TYPE_NCHAR) {
+    dataColSetOffset(pDataCol, pCompBlock->numOfRows);
+  }
+  return true;
+}
+
+// Verify and decode the raw column data in content, then put it to the block cache
+static int tsdbDecodeColData(SRWHelper *pHelper, SFile *pFile, SCompBlock *pCompBlock, SCompCol *pCompCol,
+                             SDataCol *pDataCol, char *content) {
   ASSERT(pDataCol->colId == pCompCol->colId);
   int tsize = pDataCol->bytes * pCompBlock->numOfRows + COMP_OVERFLOW_BYTES;
-  pHelper->pBuffer = taosTRealloc(pHelper->pBuffer, pCompCol->len);
-  if (pHelper->pBuffer == NULL) {
+  pHelper->compBuffer = taosTRealloc(pHelper->compBuffer, tsize);
+  if (pHelper->compBuffer == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     return -1;
   }
 
-  pHelper->compBuffer = taosTRealloc(pHelper->compBuffer, tsize);
-  if (pHelper->compBuffer == NULL) {
+  if (tsdbCheckAndDecodeColumnData(pDataCol, content, pCompCol->len, pCompBlock->algorithm, pCompBlock->numOfRows,
+                                   pHelper->pRepo->config.maxRowsPerFileBlock, pHelper->compBuffer,
+                                   (int32_t)taosTSizeof(pHelper->compBuffer)) < 0) {
+    tsdbError("vgId:%d file %s is broken at column %d offset %" PRId64, REPO_ID(pHelper->pRepo), pFile->fname,
+              pCompCol->colId, tsdbGetColDataOffset(pCompBlock, pCompCol));
+    return -1;
+  }
+
+  if (tsdbShouldUseBlockCache(pHelper)) {
+    SBlockCacheKey key;
+    tsdbInitBlockCacheKey(&key, REPO_ID(pHelper->pRepo), helperFileId(pHelper), pFile, (int8_t)pCompBlock->last,
+                          tsdbGetColDataOffset(pCompBlock, pCompCol), pCompCol->colId);
+    tsdbCacheColData(&key, pDataCol->pData, pDataCol->len);
+  }
+
+  return 0;
+}
+
+// Load the SCompData part and the raw key column data with one vectored read, the key column follows SCompData
+static int tsdbLoadCompDataAndKey(SRWHelper *pHelper, SFile *pFile, SCompBlock *pCompBlock) {
+  size_t tsize = TSDB_GET_COMPCOL_LEN(pCompBlock->numOfCols);
+  pHelper->pCompData = taosTRealloc((void *)pHelper->pCompData, tsize);
+  if (pHelper->pCompData == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     return -1;
   }
 
-  int64_t offset = pCompBlock->offset + TSDB_GET_COMPCOL_LEN(pCompBlock->numOfCols) + pCompCol->offset;
-  if (lseek(pFile->fd, (off_t)offset, SEEK_SET) < 0) {
-    tsdbError("vgId:%d failed to lseek file %s since %s", REPO_ID(pHelper->pRepo), pFile->fname, strerror(errno));
+  pHelper->pBuffer = taosTRealloc(pHelper->pBuffer, pCompBlock->keyLen);
+  if (pHelper->pBuffer == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  struct iovec iov[2];
+  iov[0].iov_base = (void *)pHelper->pCompData;
+  iov[0].iov_len = tsize;
+  iov[1].iov_base = pHelper->pBuffer;
+  iov[1].iov_len = pCompBlock->keyLen;
+
+  ssize_t len = (ssize_t)tsize + pCompBlock->keyLen;
+  int64_t st = taosGetTimestampUs();
+  ssize_t nread = taosTPReadv(pFile->fd, iov, 2, pCompBlock->offset);
+  pHelper->readTime += (taosGetTimestampUs() - st);
+  if (nread < len) {
+    tsdbError("vgId:%d failed to read %" PRIzu " bytes from file %s since %s", REPO_ID(pHelper->pRepo), (size_t)len,
+              pFile->fname, strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
     return -1;
   }
 
-  if (taosTRead(pFile->fd, pHelper->pBuffer, pCompCol->len) < pCompCol->len) {
-    tsdbError("vgId:%d failed to read %d bytes from file %s since %s", REPO_ID(pHelper->pRepo), pCompCol->len, pFile->fname,
+  if (!taosCheckChecksumWhole((uint8_t *)pHelper->pCompData, (uint32_t)tsize)) {
+    tsdbError("vgId:%d file %s is broken, offset %" PRId64 " size %" PRIzu "", REPO_ID(pHelper->pRepo), pFile->fname,
+              (int64_t)pCompBlock->offset, tsize);
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    return -1;
+  }
+
+  ASSERT(pCompBlock->numOfCols == pHelper->pCompData->numOfCols);
+
+  return 0;
+}
+
+// Read the raw data of columns adjacent in the file with one positional read and decode them
+static int tsdbLoadColDataRun(SRWHelper *pHelper, SFile *pFile, SCompBlock *pCompBlock, SColLoad *pLoads,
+                              int nLoads) {
+  SCompCol *pFirst = &pLoads[0].compCol;
+  SCompCol *pLast = &pLoads[nLoads - 1].compCol;
+  int64_t   offset = tsdbGetColDataOffset(pCompBlock, pFirst);
+  int32_t   len = pLast->offset + pLast->len - pFirst->offset;
+
+  pHelper->pBuffer = taosTRealloc(pHelper->pBuffer, len);
+  if (pHelper->pBuffer == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  int64_t st = taosGetTimestampUs();
+  ssize_t nread = taosTPRead(pFile->fd, pHelper->pBuffer, len, offset);
+  pHelper->readTime += (taosGetTimestampUs() - st);
+  if (nread < len) {
+    tsdbError("vgId:%d failed to read %d bytes from file %s since %s", REPO_ID(pHelper->pRepo), len, pFile->fname,
               strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
     return -1;
   }
 
-  if (tsdbCheckAndDecodeColumnData(pDataCol, pHelper->pBuffer, pCompCol->len, pCompBlock->algorithm,
-                                   pCompBlock->numOfRows, pHelper->pRepo->config.maxRowsPerFileBlock,
-                                   pHelper->compBuffer, (int32_t)taosTSizeof(pHelper->compBuffer)) < 0) {
-    tsdbError("vgId:%d file %s is broken at column %d offset %" PRId64, REPO_ID(pHelper->pRepo), pFile->fname,
-              pCompCol->colId, offset);
-    return -1;
+  for (int i = 0; i < nLoads; i++) {
+    char *content = (char *)POINTER_SHIFT(pHelper->pBuffer, pLoads[i].compCol.offset - pFirst->offset);
+    if (tsdbDecodeColData(pHelper, pFile, pCompBlock, &pLoads[i].compCol, pLoads[i].pDataCol, content) < 0) return -1;
   }
 
   return 0;
 }
 
-static int tsdbLoadBlockDataColsImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDataCols *pDataCols, int16_t *colIds, int numOfColIds) {
+static int tsdbLoadBlockDataColsImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDataCols *pDataCols, int16_t *colIds,
+                                     int numOfColIds, bool loadKey) {
   ASSERT(pCompBlock->numOfSubBlocks <= 1);
   ASSERT(colIds[0] == 0);
+  ASSERT(pDataCols->cols[0].colId == 0);
 
-  SFile *  pFile = (pCompBlock->last) ? helperLastF(pHelper) : helperDataF(pHelper);
-  SCompCol compCol = {0};
+  SFile *   pFile = (pCompBlock->last) ? helperLastF(pHelper) : helperDataF(pHelper);
+  SDataCol *pKeyCol = &pDataCols->cols[0];
+  SColLoad *pLoads = NULL;
+  int       nLoads = 0;
+  SCompCol  compCol = {0};
 
-  // If only load timestamp column, no need to load SCompData part
-  if (numOfColIds > 1 && tsdbLoadCompData(pHelper, pCompBlock, NULL) < 0) goto _err;
+  compCol.colId = 0;
+  compCol.len = pCompBlock->keyLen;
+  compCol.type = pKeyCol->type;
+  compCol.offset = TSDB_KEY_COL_OFFSET;
 
   pDataCols->numOfRows = pCompBlock->numOfRows;
 
-  int dcol = 0;
+  pLoads = (SColLoad *)malloc(sizeof(SColLoad) * numOfColIds);
+  if (pLoads == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  // If only load timestamp column, no need to load SCompData part
+  bool keyLoaded = (!loadKey) || tsdbLoadCachedColData(pHelper, pFile, pCompBlock, &compCol, pKeyCol);
+  if (numOfColIds > 1) {
+    if (keyLoaded) {
+      if (tsdbLoadCompData(pHelper, pCompBlock, NULL) < 0) goto _err;
+    } else {
+      if (tsdbLoadCompDataAndKey(pHelper, pFile, pCompBlock) < 0) goto _err;
+      if (tsdbDecodeColData(pHelper, pFile, pCompBlock, &compCol, pKeyCol, pHelper->pBuffer) < 0) goto _err;
+      keyLoaded = true;
+    }
+  }
+
+  if (!keyLoaded) {
+    pLoads[nLoads].pDataCol = pKeyCol;
+    pLoads[nLoads].compCol = compCol;
+    nLoads++;
+  }
+
+  int dcol = 1;
   int ccol = 0;
-  for (int i = 0; i < numOfColIds; i++) {
+  for (int i = 1; i < numOfColIds; i++) {
     int16_t   colId = colIds[i];
     SDataCol *pDataCol = NULL;
     SCompCol *pCompCol = NULL;
@@ -1265,43 +1443,53 @@ static int tsdbLoadBlockDataColsImpl(SRWHelper *pHelper, SCompBlock *pCompBlock,
     if (pDataCol == NULL) continue;
     ASSERT(pDataCol->colId == colId);
 
-    if (colId == 0) {  // load the key row
-      compCol.colId = colId;
-      compCol.len = pCompBlock->keyLen;
-      compCol.type = pDataCol->type;
-      compCol.offset = TSDB_KEY_COL_OFFSET;
-      pCompCol = &compCol;
-    } else {  // load non-key rows
-      while (true) {
-        if (ccol >= pCompBlock->numOfCols) {
-          pCompCol = NULL;
-          break;
-        }
-
-        pCompCol = &(pHelper->pCompData->cols[ccol]);
-        if (pCompCol->colId > colId) {
-          pCompCol = NULL;
-          break;
-        } else {
-          ccol++;
-          if (pCompCol->colId == colId) break;
-        }
+    while (true) {
+      if (ccol >= pCompBlock->numOfCols) {
+        pCompCol = NULL;
+        break;
       }
 
-      if (pCompCol == NULL) {
-        dataColSetNEleNull(pDataCol, pCompBlock->numOfRows, pDataCols->maxPoints);
-        continue;
+      pCompCol = &(pHelper->pCompData->cols[ccol]);
+      if (pCompCol->colId > colId) {
+        pCompCol = NULL;
+        break;
+      } else {
+        ccol++;
+        if (pCompCol->colId == colId) break;
       }
+    }
+
+    if (pCompCol == NULL) {
+      dataColSetNEleNull(pDataCol, pCompBlock->numOfRows, pDataCols->maxPoints);
+      continue;
+    }
 
-      ASSERT(pCompCol->colId == pDataCol->colId);
+    ASSERT(pCompCol->colId == pDataCol->colId);
+
+    if (tsdbLoadCachedColData(pHelper, pFile, pCompBlock, pCompCol, pDataCol)) continue;
+
+    pLoads[nLoads].pDataCol = pDataCol;
+    pLoads[nLoads].compCol = *pCompCol;
+    nLoads++;
+  }
+
+  // Columns adjacent in the file are read together
+  for (int start = 0; start < nLoads;) {
+    int end = start + 1;
+    while (end < nLoads &&
+           pLoads[end].compCol.offset == pLoads[end - 1].compCol.offset + pLoads[end - 1].compCol.len) {
+      end++;
     }
 
-    if (tsdbLoadColData(pHelper, pFile, pCompBlock, pCompCol, pDataCol) < 0) goto _err;
+    if (tsdbLoadColDataRun(pHelper, pFile, pCompBlock, pLoads + start, end - start) < 0) goto _err;
+    start = end;
   }
 
+  free(pLoads);
   return 0;
 
 _err:
+  taosTFree(pLoads);
   return -1;
 }
 
@@ -1318,14 +1506,10 @@ static int tsdbLoadBlockDataImpl(SRWHelper *pHelper, SCompBlock *pCompBlock, SDa
 
   SCompData *pCompData = (SCompData *)pHelper->pBuffer;
 
-  int fd = pFile->fd;
-  if (lseek(fd, (off_t)pCompBlock->offset, SEEK_SET) < 0) {
-    tsdbError("vgId:%d tid:%d failed to lseek file %s since %s", REPO_ID(pHelper->pRepo), pHelper->tableInfo.tid,
-              pFile->fname, strerror(errno));
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    goto _err;
-  }
-  if (taosTRead(fd, (void *)pCompData, pCompBlock->len) < pCompBlock->len) {
+  int64_t st = taosGetTimestampUs();
+  ssize_t nread = taosTPRead(pFile->fd, (void *)pCompData, pCompBlock->len, pCompBlock->offset);
+  pHelper->readTime += (taosGetTimestampUs() - st);
+  if (nread < pCompBlock->len) {
     tsdbError("vgId:%d failed to read %d bytes from file %s since %s", REPO_ID(pHelper->pRepo), pCompBlock->len,
               pFile->fname, strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -1404,7 +1588,7 @@ _err:
   return -1;
 }
 
-static int tsdbEncodeSCompIdx(void **buf, SCompIdx *pIdx) {
+int tsdbEncodeSCompIdx(void **buf, SCompIdx *pIdx) {
   int tlen = 0;
 
   tlen += taosEncodeVariantI32(buf, pIdx->tid);
@@ -57,7 +57,7 @@ typedef struct SDataBlockLoadInfo {
   SFileGroup* fileGroup;
   int32_t     slot;
   int32_t     tid;
-  SArray*     pLoadedCols;
+  SArray*     pLoadedCols;  // ids of the loaded columns if only part of the columns of the block are loaded
 } SDataBlockLoadInfo;
 
 typedef struct SLoadCompBlockInfo {
@@ -95,6 +95,9 @@ typedef struct SIOCostSummary {
   int64_t blockLoadTime;
   int64_t statisInfoLoadTime;
   int64_t checkForNextTime;
+  int64_t prefetchBlocks;
+  int64_t prefetchBytes;
+  int32_t prefetchDepth;    // max number of blocks read ahead of the block being loaded
 } SIOCostSummary;
 
 typedef struct STsdbQueryHandle {
@@ -118,15 +121,25 @@ typedef struct STsdbQueryHandle {
   SRWHelper      rhelper;
   STableBlockInfo* pDataBlockInfo;
   int32_t        allocSize;        // allocated data block size
+  int64_t        memSize;          // bytes of the buffers allocated for the query
+  int32_t        prefetchSlot;     // the last slot in pDataBlockInfo that has been read ahead
   SMemTable*     mem;              // mem-table
   SMemTable*     imem;             // imem-table, acquired from snapshot
+  bool           sharedMem;        // mem and imem belong to a snapshot shared with other query handles
   SArray*        defaultLoadColumn;// default load column
   SDataBlockLoadInfo dataBlockLoadInfo; /* record current block load information */
   SLoadCompBlockInfo compBlockLoadInfo; /* record current compblock information in SQuery */
 
   SIOCostSummary cost;
+  STsdbQueryCost retrievedCost;    // the part of cost moved out by tsdbRetrieveQueryCost
 } STsdbQueryHandle;
 
+typedef struct STsdbMemSnapshot {
+  STsdbRepo* pTsdb;
+  SMemTable* mem;
+  SMemTable* imem;
+} STsdbMemSnapshot;
+
 typedef struct STableGroupSupporter {
   int32_t    numOfCols;
   SColIndex* pCols;
@@ -146,6 +159,47 @@ static void tsdbInitDataBlockLoadInfo(SDataBlockLoadInfo* pBlockLoadInfo) {
   pBlockLoadInfo->slot = -1;
   pBlockLoadInfo->tid = -1;
   pBlockLoadInfo->fileGroup = NULL;
+
+  if (pBlockLoadInfo->pLoadedCols != NULL) {
+    taosArrayClear(pBlockLoadInfo->pLoadedCols);
+  }
+}
+
+static bool isColumnLoaded(SDataBlockLoadInfo* pBlockLoadInfo, int16_t colId) {
+  size_t num = (pBlockLoadInfo->pLoadedCols == NULL) ? 0 : taosArrayGetSize(pBlockLoadInfo->pLoadedCols);
+  if (num == 0) {
+    return true;
+  }
+
+  for (int32_t i = 0; i < num; ++i) {
+    if (*(int16_t*)taosArrayGet(pBlockLoadInfo->pLoadedCols, i) == colId) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool isColumnInList(SArray* pIdList, int16_t colId) {
+  size_t num = taosArrayGetSize(pIdList);
+  for (int32_t i = 0; i < num; ++i) {
+    if (*(int16_t*)taosArrayGet(pIdList, i) == colId) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool isAllColumnsLoaded(SDataBlockLoadInfo* pBlockLoadInfo, SArray* pIdList) {
+  size_t num = taosArrayGetSize(pIdList);
+  for (int32_t i = 0; i < num; ++i) {
+    if (!isColumnLoaded(pBlockLoadInfo, *(int16_t*)taosArrayGet(pIdList, i))) {
+      return false;
+    }
+  }
+
+  return true;
 }
 
 static void tsdbInitCompBlockLoadInfo(SLoadCompBlockInfo* pCompBlockLoadInfo) {
@@ -181,7 +235,31 @@ static SArray* getDefaultLoadColumns(STsdbQueryHandle* pQueryHandle, bool loadTS
   return pLocalIdList;
 }
 
-TsdbQueryHandleT* tsdbQueryTables(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STableGroupInfo* groupList, void* qinfo) {
+TsdbMemSnapshotT tsdbTakeQueryMemSnapshot(TSDB_REPO_T* tsdb) {
+  STsdbMemSnapshot* pSnapshot = calloc(1, sizeof(STsdbMemSnapshot));
+  if (pSnapshot == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pSnapshot->pTsdb = tsdb;
+  tsdbTakeMemSnapshot(pSnapshot->pTsdb, &pSnapshot->mem, &pSnapshot->imem);
+
+  return pSnapshot;
+}
+
+void tsdbReleaseQueryMemSnapshot(TsdbMemSnapshotT snapshot) {
+  STsdbMemSnapshot* pSnapshot = (STsdbMemSnapshot*)snapshot;
+  if (pSnapshot == NULL) {
+    return;
+  }
+
+  tsdbUnTakeMemSnapShot(pSnapshot->pTsdb, pSnapshot->mem, pSnapshot->imem);
+  free(pSnapshot);
+}
+
+static TsdbQueryHandleT* tsdbQueryTablesImpl(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STableGroupInfo* groupList,
+                                             void* qinfo, STsdbMemSnapshot* pSnapshot) {
   STsdbQueryHandle* pQueryHandle = calloc(1, sizeof(STsdbQueryHandle));
   if (pQueryHandle == NULL) {
     goto out_of_memory;
@@ -204,7 +282,18 @@ TsdbQueryHandleT* tsdbQueryTables(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STab
     goto out_of_memory;
   }
 
-  tsdbTakeMemSnapshot(pQueryHandle->pTsdb, &pQueryHandle->mem, &pQueryHandle->imem);
+  pQueryHandle->memSize = pQueryHandle->rhelper.pDataCols[0]->bufSize + pQueryHandle->rhelper.pDataCols[1]->bufSize;
+
+  if (pSnapshot == NULL) {
+    tsdbTakeMemSnapshot(pQueryHandle->pTsdb, &pQueryHandle->mem, &pQueryHandle->imem);
+  } else {
+    // the snapshot keeps the mem-table latched, it must not be latched again since a waiting writer blocks new readers
+    pQueryHandle->mem = pSnapshot->mem;
+    pQueryHandle->imem = pSnapshot->imem;
+    pQueryHandle->sharedMem = true;
+    tsdbRefMemTable(pQueryHandle->pTsdb, pQueryHandle->mem);
+    tsdbRefMemTable(pQueryHandle->pTsdb, pQueryHandle->imem);
+  }
 
   size_t sizeOfGroup = taosArrayGetSize(groupList->pGroupList);
   assert(sizeOfGroup >= 1 && pCond != NULL && pCond->numOfCols > 0);
@@ -238,6 +327,7 @@ TsdbQueryHandleT* tsdbQueryTables(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STab
     }
     taosArrayPush(pQueryHandle->pColumns, &colInfo);
     pQueryHandle->statis[i].colId = colInfo.info.colId;
+    pQueryHandle->memSize += EXTRA_BYTES + pQueryHandle->outputCapacity * pCond->colList[i].bytes;
   }
 
   pQueryHandle->pTableCheckInfo = taosArrayInit(groupList->numOfTables, sizeof(STableCheckInfo));
@@ -295,6 +385,16 @@ out_of_memory:
   return NULL;
 }
 
+TsdbQueryHandleT* tsdbQueryTables(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STableGroupInfo* groupList, void* qinfo) {
+  return tsdbQueryTablesImpl(tsdb, pCond, groupList, qinfo, NULL);
+}
+
+TsdbQueryHandleT* tsdbQueryTablesInSnapshot(TSDB_REPO_T* tsdb, STsdbQueryCond* pCond, STableGroupInfo* groupList,
+                                            void* qinfo, TsdbMemSnapshotT snapshot) {
+  assert(snapshot != NULL && ((STsdbMemSnapshot*)snapshot)->pTsdb == tsdb);
+  return tsdbQueryTablesImpl(tsdb, pCond, groupList, qinfo, (STsdbMemSnapshot*)snapshot);
+}
+
 TsdbQueryHandleT tsdbQueryLastRow(TSDB_REPO_T *tsdb, STsdbQueryCond *pCond, STableGroupInfo *groupList, void* qinfo) {
   pCond->twindow = changeTableGroupByLastrow(groupList);
 
@@ -688,7 +788,73 @@ static int32_t getFileCompInfo(STsdbQueryHandle* pQueryHandle, int32_t* numOfBlo
   return code;
 }
 
-static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* pBlock, STableCheckInfo* pCheckInfo, int32_t slotIndex) {
+static int64_t getFileBlockDataLen(STableCheckInfo* pCheckInfo, SCompBlock* pBlock) {
+  if (pBlock->numOfSubBlocks <= 1) {
+    return pBlock->len;
+  }
+
+  int64_t     len = 0;
+  SCompBlock* pSubBlock = (SCompBlock*)POINTER_SHIFT(pCheckInfo->pCompInfo, pBlock->offset);
+  for (int32_t i = 0; i < pBlock->numOfSubBlocks; ++i) {
+    len += pSubBlock[i].len;
+  }
+
+  return len;
+}
+
+/*
+ * Once the data of a file block is loaded, the following blocks in the traverse order are likely to be loaded as well.
+ * Ask the kernel to read them ahead in the background, so the reading overlaps with the processing of the current
+ * block. At most tsPrefetchBlocks blocks and tsPrefetchSize MB are read ahead of the current block.
+ */
+static void prefetchFileDataBlocks(STsdbQueryHandle* pQueryHandle) {
+  if (tsPrefetchBlocks <= 0) {
+    return;
+  }
+
+  SQueryFilePos*  cur = &pQueryHandle->cur;
+  SIOCostSummary* pCost = &pQueryHandle->cost;
+
+  int32_t step = ASCENDING_TRAVERSE(pQueryHandle->order) ? 1 : -1;
+  int64_t budget = (int64_t)tsPrefetchSize * 1024 * 1024;
+  int64_t bytes = 0;
+
+  for (int32_t i = 1; i <= tsPrefetchBlocks; ++i) {
+    int32_t slot = cur->slot + i * step;
+    if (slot < 0 || slot >= pQueryHandle->numOfBlocks) {
+      break;
+    }
+
+    STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[slot];
+
+    bytes += getFileBlockDataLen(pBlockInfo->pTableCheckInfo, pBlockInfo->compBlock);
+    if (bytes > budget) {
+      break;
+    }
+
+    // it has been read ahead already
+    if ((slot - pQueryHandle->prefetchSlot) * step <= 0) {
+      continue;
+    }
+
+    pCost->prefetchBytes +=
+        tsdbReadAheadBlockData(&pQueryHandle->rhelper, pBlockInfo->compBlock, pBlockInfo->pTableCheckInfo->pCompInfo);
+    pCost->prefetchBlocks += 1;
+    pQueryHandle->prefetchSlot = slot;
+  }
+
+  int32_t depth = (pQueryHandle->prefetchSlot - cur->slot) * step;
+  if (depth > pCost->prefetchDepth) {
+    pCost->prefetchDepth = depth;
+  }
+}
+
+/*
+ * Load the columns of a file block into rhelper.pDataCols[0]. If pIdList is not NULL, only the timestamp and the columns
+ * in pIdList are loaded when the block has no sub-blocks, and the other columns are left to doLoadRemainColumns.
+ */
+static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* pBlock, STableCheckInfo* pCheckInfo,
+                                   int32_t slotIndex, SArray* pIdList) {
   STsdbRepo *pRepo = pQueryHandle->pTsdb;
   int64_t    st = taosGetTimestampUs();
 
@@ -701,6 +867,8 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* p
       terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
       goto _error;
     }
+
+    pQueryHandle->memSize += pCheckInfo->pDataCols->bufSize;
   }
 
   STSchema* pSchema = tsdbGetTableSchema(pCheckInfo->pTableObj);
@@ -725,17 +893,44 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* p
     goto _error;
   }
 
+  SDataBlockLoadInfo* pBlockLoadInfo = &pQueryHandle->dataBlockLoadInfo;
+
   int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
+  int32_t  numOfCols = (int32_t)(QH_GET_NUM_OF_COLS(pQueryHandle));
+
+  if (pBlockLoadInfo->pLoadedCols != NULL) {
+    taosArrayClear(pBlockLoadInfo->pLoadedCols);
+  }
+
+  if (pIdList != NULL && pBlock->numOfSubBlocks == 1) {
+    if (pBlockLoadInfo->pLoadedCols == NULL) {
+      pBlockLoadInfo->pLoadedCols = taosArrayInit(numOfCols, sizeof(int16_t));
+    }
 
-  int32_t ret = tsdbLoadBlockDataCols(&(pQueryHandle->rhelper), pBlock, pCheckInfo->pCompInfo, colIds, (int)(QH_GET_NUM_OF_COLS(pQueryHandle)));
+    if (pBlockLoadInfo->pLoadedCols != NULL) {
+      taosArrayPush(pBlockLoadInfo->pLoadedCols, &colIds[0]);
+      for (int32_t i = 1; i < numOfCols; ++i) {
+        if (isColumnInList(pIdList, colIds[i])) {
+          taosArrayPush(pBlockLoadInfo->pLoadedCols, &colIds[i]);
+        }
+      }
+
+      if (taosArrayGetSize(pBlockLoadInfo->pLoadedCols) < numOfCols) {
+        colIds = pBlockLoadInfo->pLoadedCols->pData;
+        numOfCols = (int32_t)taosArrayGetSize(pBlockLoadInfo->pLoadedCols);
+      } else {  // all columns are required
+        taosArrayClear(pBlockLoadInfo->pLoadedCols);
+      }
+    }
+  }
+
+  int32_t ret = tsdbLoadBlockDataCols(&(pQueryHandle->rhelper), pBlock, pCheckInfo->pCompInfo, colIds, numOfCols);
   if (ret != TSDB_CODE_SUCCESS) {
     int32_t c = terrno;
     assert(c != TSDB_CODE_SUCCESS);
     goto _error;
   }
 
-  SDataBlockLoadInfo* pBlockLoadInfo = &pQueryHandle->dataBlockLoadInfo;
-
   pBlockLoadInfo->fileGroup = pQueryHandle->pFileGroup;
   pBlockLoadInfo->slot = pQueryHandle->cur.slot;
   pBlockLoadInfo->tid = pCheckInfo->pTableObj->tableId.tid;
@@ -748,12 +943,16 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* p
   int64_t elapsedTime = (taosGetTimestampUs() - st);
   pQueryHandle->cost.blockLoadTime += elapsedTime;
 
-  tsdbDebug("%p load file block into buffer, index:%d, brange:%"PRId64"-%"PRId64", rows:%d, elapsed time:%"PRId64 " us, %p",
-      pQueryHandle, slotIndex, pBlock->keyFirst, pBlock->keyLast, pBlock->numOfRows, elapsedTime, pQueryHandle->qinfo);
+  prefetchFileDataBlocks(pQueryHandle);
+
+  tsdbDebug("%p load file block into buffer, index:%d, brange:%"PRId64"-%"PRId64", rows:%d, cols:%d, elapsed time:%"PRId64
+      " us, %p", pQueryHandle, slotIndex, pBlock->keyFirst, pBlock->keyLast, pBlock->numOfRows, numOfCols, elapsedTime,
+      pQueryHandle->qinfo);
   return TSDB_CODE_SUCCESS;
 
 _error:
   pBlock->numOfRows = 0;
+  tsdbInitDataBlockLoadInfo(pBlockLoadInfo);
 
   tsdbError("%p error occurs in loading file block, index:%d, brange:%"PRId64"-%"PRId64", rows:%d, %p",
             pQueryHandle, slotIndex, pBlock->keyFirst, pBlock->keyLast, pBlock->numOfRows, pQueryHandle->qinfo);
@@ -804,7 +1003,7 @@ static int32_t handleDataMergeIfNeeded(STsdbQueryHandle* pQueryHandle, SCompBloc
     }
 
     // return error, add test cases
-    if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
+    if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot, NULL)) != TSDB_CODE_SUCCESS) {
       return code;
     }
 
@@ -855,7 +1054,7 @@ static int32_t loadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* pBl
   if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
     // query ended in/started from current block
     if (pQueryHandle->window.ekey < pBlock->keyLast || pCheckInfo->lastKey > pBlock->keyFirst) {
-      if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
+      if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot, NULL)) != TSDB_CODE_SUCCESS) {
         *exists = false;
         return code;
       }
@@ -878,7 +1077,7 @@ static int32_t loadFileDataBlock(STsdbQueryHandle* pQueryHandle, SCompBlock* pBl
     }
   } else {  //desc order, query ended in current block
     if (pQueryHandle->window.ekey > pBlock->keyFirst || pCheckInfo->lastKey < pBlock->keyLast) {
-      if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
+      if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot, NULL)) != TSDB_CODE_SUCCESS) {
         *exists = false;
         return code;
       }
@@ -1001,7 +1200,9 @@ int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t capacity
 
     if (pColInfo->info.colId == src->colId) {
 
-      if (pColInfo->info.type != TSDB_DATA_TYPE_BINARY && pColInfo->info.type != TSDB_DATA_TYPE_NCHAR) {
+      if (!isColumnLoaded(&pQueryHandle->dataBlockLoadInfo, src->colId)) {
+        // not loaded yet, copied after the remain columns are loaded
+      } else if (pColInfo->info.type != TSDB_DATA_TYPE_BINARY && pColInfo->info.type != TSDB_DATA_TYPE_NCHAR) {
         memmove(pData, (char*)src->pData + bytes * start, bytes * num);
       } else {  // handle the var-string
         char* dst = pData;
@@ -1059,64 +1260,57 @@ int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t capacity
   return numOfRows + num;
 }
 
-static void copyOneRowFromMem(STsdbQueryHandle* pQueryHandle, int32_t capacity, int32_t numOfRows, SDataRow row,
-                              int32_t numOfCols, STable* pTable) {
-  char* pData = NULL;
-
-  // the schema version info is embeded in SDataRow
-  STSchema* pSchema = tsdbGetTableSchemaByVersion(pTable, dataRowVersion(row));
+// Copy rows with the same schema version from cache to the output columns. The schema columns are matched once for all
+// rows, and then each output column is filled in a tight loop.
+static void copyRowsFromMem(STsdbQueryHandle* pQueryHandle, int32_t capacity, int32_t numOfRows, SDataRow* rows,
+                            int32_t nRows, int32_t numOfCols, STSchema* pSchema) {
   int32_t numOfRowCols = schemaNCols(pSchema);
+  bool    asc = ASCENDING_TRAVERSE(pQueryHandle->order);
 
-  int32_t i = 0, j = 0;
-  while(i < numOfCols && j < numOfRowCols) {
+  int32_t j = 0;
+  for (int32_t i = 0; i < numOfCols; ++i) {
     SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
-    if (pSchema->columns[j].colId < pColInfo->info.colId) {
+    int16_t          type = pColInfo->info.type;
+    int32_t          bytes = pColInfo->info.bytes;
+
+    while (j < numOfRowCols && pSchema->columns[j].colId < pColInfo->info.colId) {
       j++;
-      continue;
     }
 
-    if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
-      pData = (char*)pColInfo->pData + numOfRows * pColInfo->info.bytes;
-    } else {
-      pData = (char*)pColInfo->pData + (capacity - numOfRows - 1) * pColInfo->info.bytes;
+    // the first row is put at the end of the buffer in case of descending order query
+    char*   pData = (char*)pColInfo->pData + (asc ? numOfRows : (capacity - numOfRows - 1)) * bytes;
+    int32_t step = asc ? bytes : -bytes;
+
+    if (j >= numOfRowCols || pSchema->columns[j].colId != pColInfo->info.colId) {  // it is a NULL data
+      for (int32_t k = 0; k < nRows; ++k, pData += step) {
+        if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
+          setVardataNull(pData, type);
+        } else {
+          setNull(pData, type, bytes);
+        }
+      }
+      continue;
     }
 
-    if (pSchema->columns[j].colId == pColInfo->info.colId) {
-      void* value = tdGetRowDataOfCol(row, (int8_t)pColInfo->info.type, TD_DATA_ROW_HEAD_SIZE + pSchema->columns[j].offset);
-      if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
+    int32_t offset = TD_DATA_ROW_HEAD_SIZE + pSchema->columns[j].offset;
+    if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
+      for (int32_t k = 0; k < nRows; ++k, pData += step) {
+        void* value = tdGetRowDataOfCol(rows[k], (int8_t)type, offset);
         memcpy(pData, value, varDataTLen(value));
-      } else {
-        memcpy(pData, value, pColInfo->info.bytes);
       }
-
-      j++;
-      i++;
-    } else { // pColInfo->info.colId < pSchema->columns[j].colId, it is a NULL data
-      if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
-        setVardataNull(pData, pColInfo->info.type);
-      } else {
-        setNull(pData, pColInfo->info.type, pColInfo->info.bytes);
+    } else {
+      for (int32_t k = 0; k < nRows; ++k, pData += step) {
+        memcpy(pData, POINTER_SHIFT(rows[k], offset), bytes);
       }
-      i++;
     }
   }
+}
 
-  while (i < numOfCols) { // the remain columns are all null data
-    SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
-    if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
-      pData = (char*)pColInfo->pData + numOfRows * pColInfo->info.bytes;
-    } else {
-      pData = (char*)pColInfo->pData + (capacity - numOfRows - 1) * pColInfo->info.bytes;
-    }
-
-    if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
-      setVardataNull(pData, pColInfo->info.type);
-    } else {
-      setNull(pData, pColInfo->info.type, pColInfo->info.bytes);
-    }
-
-    i++;
-  }
+static void copyOneRowFromMem(STsdbQueryHandle* pQueryHandle, int32_t capacity, int32_t numOfRows, SDataRow row,
+                              int32_t numOfCols, STable* pTable) {
+  // the schema version info is embeded in SDataRow
+  STSchema* pSchema = tsdbGetTableSchemaByVersion(pTable, dataRowVersion(row));
+  copyRowsFromMem(pQueryHandle, capacity, numOfRows, &row, 1, numOfCols, pSchema);
 }
 
 static void moveDataToFront(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, int32_t numOfCols) {
@@ -1500,6 +1694,7 @@ static int32_t createDataBlocksInfo(STsdbQueryHandle* pQueryHandle, int32_t numO
   size_t size = sizeof(STableBlockInfo) * numOfBlocks;
 
   if (pQueryHandle->allocSize < size) {
+    pQueryHandle->memSize += (int64_t)size - pQueryHandle->allocSize;
     pQueryHandle->allocSize = (int32_t)size;
     char* tmp = realloc(pQueryHandle->pDataBlockInfo, pQueryHandle->allocSize);
     if (tmp == NULL) {
@@ -1695,6 +1890,7 @@ static int32_t getDataBlocksInFilesImpl(STsdbQueryHandle* pQueryHandle, bool* ex
   assert(pQueryHandle->pFileGroup != NULL && pQueryHandle->numOfBlocks > 0);
   cur->slot = ASCENDING_TRAVERSE(pQueryHandle->order)? 0:pQueryHandle->numOfBlocks-1;
   cur->fid = pQueryHandle->pFileGroup->fileId;
+  pQueryHandle->prefetchSlot = cur->slot;
 
   STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[cur->slot];
   return loadFileDataBlock(pQueryHandle, pBlockInfo->compBlock, pBlockInfo->pTableCheckInfo, exists);
@@ -1809,6 +2005,11 @@ static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int
   int64_t st = taosGetTimestampUs();
   STable* pTable = pCheckInfo->pTableObj;
 
+  // rows are copied to the output columns in batches of the same schema version
+  STSchema* pSchema = NULL;
+  SDataRow  rows[TSDB_CACHE_ROWS_BATCH];
+  int32_t   nRows = 0;
+
   do {
     SDataRow row = getSDataRowInTableMem(pCheckInfo, pQueryHandle->order);
     if (row == NULL) {
@@ -1828,7 +2029,20 @@ static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int
     }
 
     win->ekey = key;
-    copyOneRowFromMem(pQueryHandle, maxRowsToRead, numOfRows, row, numOfCols, pTable);
+
+    if (pSchema == NULL || schemaVersion(pSchema) != dataRowVersion(row)) {
+      if (nRows > 0) {
+        copyRowsFromMem(pQueryHandle, maxRowsToRead, numOfRows - nRows, rows, nRows, numOfCols, pSchema);
+        nRows = 0;
+      }
+      pSchema = tsdbGetTableSchemaByVersion(pTable, dataRowVersion(row));
+    }
+
+    rows[nRows++] = row;
+    if (nRows >= TSDB_CACHE_ROWS_BATCH) {
+      copyRowsFromMem(pQueryHandle, maxRowsToRead, numOfRows + 1 - nRows, rows, nRows, numOfCols, pSchema);
+      nRows = 0;
+    }
 
     if (++numOfRows >= maxRowsToRead) {
       moveToNextRowInMem(pCheckInfo);
@@ -1837,6 +2051,10 @@ static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int
 
   } while(moveToNextRowInMem(pCheckInfo));
 
+  if (nRows > 0) {
+    copyRowsFromMem(pQueryHandle, maxRowsToRead, numOfRows - nRows, rows, nRows, numOfCols, pSchema);
+  }
+
   assert(numOfRows <= maxRowsToRead);
 
   // if the buffer is not full in case of descending order query, move the data in the front of the buffer
@@ -2212,6 +2430,80 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
   return TSDB_CODE_SUCCESS;
 }
 
+static void doCopyFileBlockToColumns(STsdbQueryHandle* pHandle, SCompBlock* pBlock) {
+  int32_t numOfRows = doCopyRowsFromFileBlock(pHandle, pHandle->outputCapacity, 0, 0, pBlock->numOfRows - 1);
+
+  // if the buffer is not full in case of descending order query, move the data in the front of the buffer
+  if (!ASCENDING_TRAVERSE(pHandle->order) && numOfRows < pHandle->outputCapacity) {
+    int32_t emptySize = pHandle->outputCapacity - numOfRows;
+    int32_t reqNumOfCols = (int32_t)taosArrayGetSize(pHandle->pColumns);
+
+    for(int32_t i = 0; i < reqNumOfCols; ++i) {
+      SColumnInfoData* pColInfo = taosArrayGet(pHandle->pColumns, i);
+      memmove((char*)pColInfo->pData, (char*)pColInfo->pData + emptySize * pColInfo->info.bytes, numOfRows * pColInfo->info.bytes);
+    }
+  }
+}
+
+// load the columns of current block that are not loaded by a previous tsdbRetrieveDataBlock with a column list
+static int32_t doLoadRemainColumns(STsdbQueryHandle* pHandle, SCompBlock* pBlock) {
+  SDataBlockLoadInfo* pBlockLoadInfo = &pHandle->dataBlockLoadInfo;
+
+  int16_t* colIds = pHandle->defaultLoadColumn->pData;
+  int32_t  numOfCols = (int32_t)(QH_GET_NUM_OF_COLS(pHandle));
+
+  SArray* pRemain = taosArrayInit(numOfCols, sizeof(int16_t));
+  if (pRemain == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return terrno;
+  }
+
+  taosArrayPush(pRemain, &colIds[0]);
+  for (int32_t i = 1; i < numOfCols; ++i) {
+    if (!isColumnLoaded(pBlockLoadInfo, colIds[i])) {
+      taosArrayPush(pRemain, &colIds[i]);
+    }
+  }
+
+  int64_t st = taosGetTimestampUs();
+  int32_t ret = tsdbLoadMoreBlockDataCols(&pHandle->rhelper, pBlock, pRemain->pData, (int)taosArrayGetSize(pRemain));
+  pHandle->cost.blockLoadTime += (taosGetTimestampUs() - st);
+
+  tsdbDebug("%p load remain %d columns of file block, brange:%"PRId64"-%"PRId64", %p", pHandle,
+            (int32_t)taosArrayGetSize(pRemain) - 1, pBlock->keyFirst, pBlock->keyLast, pHandle->qinfo);
+
+  taosArrayDestroy(pRemain);
+  taosArrayClear(pBlockLoadInfo->pLoadedCols);
+
+  if (ret != TSDB_CODE_SUCCESS) {
+    tsdbInitDataBlockLoadInfo(pBlockLoadInfo);
+    return terrno;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static bool isCurrentFileBlockLoaded(STsdbQueryHandle* pHandle, STableCheckInfo* pCheckInfo) {
+  SDataBlockLoadInfo* pBlockLoadInfo = &pHandle->dataBlockLoadInfo;
+  return pBlockLoadInfo->slot == pHandle->cur.slot && pBlockLoadInfo->fileGroup->fileId == pHandle->cur.fid &&
+         pBlockLoadInfo->tid == pCheckInfo->pTableObj->tableId.tid;
+}
+
+bool tsdbIsDataBlockPartlyLoaded(TsdbQueryHandleT* pQueryHandle) {
+  STsdbQueryHandle* pHandle = (STsdbQueryHandle*)pQueryHandle;
+  if (pHandle->cur.fid < 0 || pHandle->cur.mixBlock) {
+    return false;
+  }
+
+  STableBlockInfo*    pBlockInfo = &pHandle->pDataBlockInfo[pHandle->cur.slot];
+  SDataBlockLoadInfo* pBlockLoadInfo = &pHandle->dataBlockLoadInfo;
+  if (!isCurrentFileBlockLoaded(pHandle, pBlockInfo->pTableCheckInfo)) {
+    return false;
+  }
+
+  return (pBlockLoadInfo->pLoadedCols != NULL) && (taosArrayGetSize(pBlockLoadInfo->pLoadedCols) > 0);
+}
+
 SArray* tsdbRetrieveDataBlock(TsdbQueryHandleT* pQueryHandle, SArray* pIdList) {
   /**
    * In the following two cases, the data has been loaded to SColumnInfoData.
@@ -2233,30 +2525,26 @@ SArray* tsdbRetrieveDataBlock(TsdbQueryHandleT* pQueryHandle, SArray* pIdList) {
 
       // data block has been loaded, todo extract method
       SDataBlockLoadInfo* pBlockLoadInfo = &pHandle->dataBlockLoadInfo;
+      SCompBlock*         pBlock = pBlockInfo->compBlock;
+
+      if (isCurrentFileBlockLoaded(pHandle, pCheckInfo)) {
+        // only part of the columns are loaded, and more columns are required now
+        bool partial = (pBlockLoadInfo->pLoadedCols != NULL) && (taosArrayGetSize(pBlockLoadInfo->pLoadedCols) > 0);
+        if (partial && (pIdList == NULL || !isAllColumnsLoaded(pBlockLoadInfo, pIdList))) {
+          if (doLoadRemainColumns(pHandle, pBlock) != TSDB_CODE_SUCCESS) {
+            return NULL;
+          }
 
-      if (pBlockLoadInfo->slot == pHandle->cur.slot && pBlockLoadInfo->fileGroup->fileId == pHandle->cur.fid &&
-          pBlockLoadInfo->tid == pCheckInfo->pTableObj->tableId.tid) {
-        return pHandle->pColumns;
-      } else {  // only load the file block
-        SCompBlock* pBlock = pBlockInfo->compBlock;
-        if (doLoadFileDataBlock(pHandle, pBlock, pCheckInfo, pHandle->cur.slot) != TSDB_CODE_SUCCESS) {
-          return NULL;
+          doCopyFileBlockToColumns(pHandle, pBlock);
         }
 
-        // todo refactor
-        int32_t numOfRows = doCopyRowsFromFileBlock(pHandle, pHandle->outputCapacity, 0, 0, pBlock->numOfRows - 1);
-
-        // if the buffer is not full in case of descending order query, move the data in the front of the buffer
-        if (!ASCENDING_TRAVERSE(pHandle->order) && numOfRows < pHandle->outputCapacity) {
-          int32_t emptySize = pHandle->outputCapacity - numOfRows;
-          int32_t reqNumOfCols = (int32_t)taosArrayGetSize(pHandle->pColumns);
-
-          for(int32_t i = 0; i < reqNumOfCols; ++i) {
-            SColumnInfoData* pColInfo = taosArrayGet(pHandle->pColumns, i);
-            memmove((char*)pColInfo->pData, (char*)pColInfo->pData + emptySize * pColInfo->info.bytes, numOfRows * pColInfo->info.bytes);
-          }
+        return pHandle->pColumns;
+      } else {  // only load the file block, or the columns in pIdList of it
+        if (doLoadFileDataBlock(pHandle, pBlock, pCheckInfo, pHandle->cur.slot, pIdList) != TSDB_CODE_SUCCESS) {
+          return NULL;
         }
 
+        doCopyFileBlockToColumns(pHandle, pBlock);
         return pHandle->pColumns;
       }
     }
@@ -2430,10 +2718,10 @@ SArray* createTableGroup(SArray* pTableList, STSchema* pTagSchema, SColIndex* pC
   return pTableGroup;
 }
 
-static bool indexedNodeFilterFp(const void* pNode, void* param) {
+static bool indexedNodeFilterFp(const void* pItem, void* param) {
   tQueryInfo* pInfo = (tQueryInfo*) param;
 
-  STable* pTable = *(STable**)(SL_GET_NODE_DATA((SSkipListNode*)pNode));
+  STable* pTable = (STable*) pItem;
 
   char*  val = NULL;
 
@@ -2491,16 +2779,70 @@ static bool indexedNodeFilterFp(const void* pNode, void* param) {
   return true;
 }
 
+typedef struct {
+  STable* pSTable;
+  bool    used;
+} STagIndexQuerySupp;
+
+// the tag indexes hand out the candidate tables, which are checked by the condition again
+static bool tagIndexQueryFp(void* param, tQueryInfo* pInfo, SArray* pRes) {
+  STagIndexQuerySupp* pSupp = (STagIndexQuerySupp*) param;
+
+  SArray* pTables = taosArrayInit(32, POINTER_BYTES);
+  if (pTables == NULL) return false;
+
+  if (!tsdbQueryTagIndex(pSupp->pSTable, pInfo, pTables)) {
+    taosArrayDestroy(pTables);
+    return false;
+  }
+
+  for (int32_t i = 0; i < taosArrayGetSize(pTables); ++i) {
+    STable* pTable = taosArrayGetP(pTables, i);
+    if (indexedNodeFilterFp(pTable, pInfo)) {
+      STableKeyInfo info = {.pTable = pTable, .lastKey = TSKEY_INITIAL_VAL};
+      taosArrayPush(pRes, &info);
+    }
+  }
+
+  taosArrayDestroy(pTables);
+  pSupp->used = true;
+  return true;
+}
+
+// order the tables by the first tag as the skip list index does, the tables with the same first tag are ordered by tid
+// rather than by the order they are put into the skip list
+static int32_t tableKeyInfoIndexComparFn(const void* p1, const void* p2, const void* param) {
+  STable* pTable1 = ((STableKeyInfo*) p1)->pTable;
+  STable* pTable2 = ((STableKeyInfo*) p2)->pTable;
+  STable* pSTable = (STable*) param;
+
+  SSkipList* pIndex = pSTable->pIndex;
+
+  int32_t ret = pIndex->comparFn(pIndex->keyFn(&pTable1), pIndex->keyFn(&pTable2));
+  if (ret != 0) return ret;
+  if (TABLE_TID(pTable1) == TABLE_TID(pTable2)) return 0;
+  return (TABLE_TID(pTable1) < TABLE_TID(pTable2)) ? -1 : 1;
+}
+
 static int32_t doQueryTableList(STable* pSTable, SArray* pRes, tExprNode* pExpr) {
+  STagIndexQuerySupp indexSupp = {.pSTable = pSTable, .used = false};
+
   // query according to the expression tree
   SExprTraverseSupp supp = {
       .nodeFilterFn = (__result_filter_fn_t) indexedNodeFilterFp,
       .setupInfoFn = filterPrepare,
       .pExtInfo = pSTable->tagSchema,
+      .indexQueryFn = tagIndexQueryFp,
+      .pIndexInfo = &indexSupp,
       };
 
   tExprTreeTraverse(pExpr, pSTable->pIndex, pRes, &supp);
   tExprTreeDestroy(&pExpr, destroyHelper);
+
+  if (indexSupp.used) {
+    taosqsort(pRes->pData, taosArrayGetSize(pRes), sizeof(STableKeyInfo), pSTable, tableKeyInfoIndexComparFn);
+  }
+
   return TSDB_CODE_SUCCESS;
 }
 
@@ -2671,6 +3013,32 @@ int32_t tsdbGetTableGroupFromIdList(TSDB_REPO_T* tsdb, SArray* pTableIdList, STa
   return TSDB_CODE_SUCCESS;
 }
 
+int64_t tsdbGetQueryHandleMemSize(TsdbQueryHandleT queryHandle) {
+  STsdbQueryHandle* pQueryHandle = (STsdbQueryHandle*)queryHandle;
+  return (pQueryHandle == NULL) ? 0 : pQueryHandle->memSize;
+}
+
+void tsdbRetrieveQueryCost(TsdbQueryHandleT queryHandle, STsdbQueryCost* pCost) {
+  STsdbQueryHandle* pQueryHandle = (STsdbQueryHandle*)queryHandle;
+  if (pQueryHandle == NULL) {
+    return;
+  }
+
+  SIOCostSummary* pSummary = &pQueryHandle->cost;
+  STsdbQueryCost* pRetrieved = &pQueryHandle->retrievedCost;
+
+  pCost->blockLoadTime  += pSummary->blockLoadTime - pRetrieved->blockLoadTime;
+  pCost->readTime       += pQueryHandle->rhelper.readTime - pRetrieved->readTime;
+  pCost->prefetchBlocks += pSummary->prefetchBlocks - pRetrieved->prefetchBlocks;
+  pCost->prefetchBytes  += pSummary->prefetchBytes - pRetrieved->prefetchBytes;
+  pCost->prefetchDepth   = MAX(pCost->prefetchDepth, pSummary->prefetchDepth);
+
+  pRetrieved->blockLoadTime  = pSummary->blockLoadTime;
+  pRetrieved->readTime       = pQueryHandle->rhelper.readTime;
+  pRetrieved->prefetchBlocks = pSummary->prefetchBlocks;
+  pRetrieved->prefetchBytes  = pSummary->prefetchBytes;
+}
+
 void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   STsdbQueryHandle* pQueryHandle = (STsdbQueryHandle*)queryHandle;
   if (pQueryHandle == NULL) {
@@ -2700,17 +3068,24 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   }
 
   taosArrayDestroy(pQueryHandle->defaultLoadColumn);
+  taosArrayDestroy(pQueryHandle->dataBlockLoadInfo.pLoadedCols);
   taosTFree(pQueryHandle->pDataBlockInfo);
   taosTFree(pQueryHandle->statis);
 
   // todo check error
-  tsdbUnTakeMemSnapShot(pQueryHandle->pTsdb, pQueryHandle->mem, pQueryHandle->imem);
+  if (pQueryHandle->sharedMem) {
+    tsdbUnRefMemTable(pQueryHandle->pTsdb, pQueryHandle->mem);
+    tsdbUnRefMemTable(pQueryHandle->pTsdb, pQueryHandle->imem);
+  } else {
+    tsdbUnTakeMemSnapShot(pQueryHandle->pTsdb, pQueryHandle->mem, pQueryHandle->imem);
+  }
 
   tsdbDestroyHelper(&pQueryHandle->rhelper);
 
   SIOCostSummary* pCost = &pQueryHandle->cost;
-  tsdbDebug("%p :io-cost summary: statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, %p",
-      pQueryHandle, pCost->statisInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pQueryHandle->qinfo);
+  tsdbDebug("%p :io-cost summary: statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, "
+      "prefetch blocks:%"PRId64", prefetch depth:%d, %p", pQueryHandle, pCost->statisInfoLoadTime,
+      pCost->blockLoadTime, pCost->checkForNextTime, pCost->prefetchBlocks, pCost->prefetchDepth, pQueryHandle->qinfo);
 
   taosTFree(pQueryHandle);
 }
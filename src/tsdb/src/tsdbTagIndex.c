@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "hash.h"
+#include "taoserror.h"
+#include "tsdbMain.h"
+#include "../../query/inc/qAst.h"  // todo move to common module
+
+/*
+ * Secondary indexes of the tags of a super table, besides the skip list index on its first tag. The index of a tag,
+ * or of the table name, is built the first time a query filters on it, and is maintained as child tables are added,
+ * removed or have their tag values updated, all with the meta write lock held.
+ *
+ * The index of a column has
+ *   - a hash of the tag value for equal and in, except for float and double columns;
+ *   - a skip list sorted by the tag value for ranges on numeric columns, and sorted case-insensitively on binary
+ *     columns and table names for the literal prefix of like patterns;
+ *   - the list of the tables whose tag value is NULL or missing, which are handed out with every lookup.
+ * A lookup returns a superset of the qualified tables, the caller filters them by the condition again.
+ */
+typedef struct {
+  STable *pTable;
+  int16_t colId;
+  int8_t  type;
+} STagIndexElem;
+
+typedef struct {
+  int16_t    colId;
+  int8_t     type;
+  SHashObj * pHash;    // tag value -> SArray<STable *>
+  SSkipList *pSorted;  // STagIndexElem sorted by tag value
+  SArray *   pNulls;   // SArray<STable *>
+} STagColIndex;
+
+typedef struct STagIndex {
+  pthread_mutex_t mutex;  // serialize the building of indexes by queries, which only hold the meta read lock
+  SArray *        pCols;  // SArray<STagColIndex *>
+} STagIndex;
+
+static char *tsdbGetTagIndexVal(STable *pTable, int16_t colId, int8_t type) {
+  if (colId == TSDB_TBNAME_COLUMN_INDEX) return (char *)TABLE_NAME(pTable);
+
+  char *val = tdGetKVRowValOfCol(pTable->tagVal, colId);
+  if (val == NULL || isNull(val, type)) return NULL;
+  return val;
+}
+
+static size_t tsdbGetTagIndexValLen(const char *val, int8_t type) {
+  return IS_VAR_DATA_TYPE(type) ? varDataTLen(val) : (size_t)tDataTypeDesc[type].nSize;
+}
+
+static char *tsdbGetTagIndexKey(const void *pData) {
+  STagIndexElem *pElem = (STagIndexElem *)pData;
+
+  char *val = tsdbGetTagIndexVal(pElem->pTable, pElem->colId, pElem->type);
+  return (val == NULL) ? getNullValue(pElem->type) : val;
+}
+
+// the order of like, which matches the pattern case-insensitively
+static int32_t tsdbCompareTagStrNoCase(const void *pLeft, const void *pRight) {
+  int32_t len1 = varDataLen(pLeft);
+  int32_t len2 = varDataLen(pRight);
+
+  int32_t ret = strncasecmp(varDataVal(pLeft), varDataVal(pRight), MIN(len1, len2));
+  if (ret != 0) return (ret > 0) ? 1 : -1;
+  if (len1 == len2) return 0;
+  return (len1 > len2) ? 1 : -1;
+}
+
+static bool tsdbTagColHasHash(int8_t type) { return type != TSDB_DATA_TYPE_FLOAT && type != TSDB_DATA_TYPE_DOUBLE; }
+
+static bool tsdbTagColHasSorted(int8_t type) { return type != TSDB_DATA_TYPE_NCHAR; }
+
+static void tsdbFreeTagColIndex(STagColIndex *pIdx) {
+  if (pIdx == NULL) return;
+
+  if (pIdx->pHash != NULL) {
+    SHashMutableIterator *pIter = taosHashCreateIter(pIdx->pHash);
+    while (taosHashIterNext(pIter)) {
+      SArray **ppTables = taosHashIterGet(pIter);
+      taosArrayDestroy(*ppTables);
+    }
+    taosHashDestroyIter(pIter);
+    taosHashCleanup(pIdx->pHash);
+  }
+
+  tSkipListDestroy(pIdx->pSorted);
+  taosArrayDestroy(pIdx->pNulls);
+  free(pIdx);
+}
+
+static STagColIndex *tsdbNewTagColIndex(int16_t colId, int8_t type) {
+  STagColIndex *pIdx = calloc(1, sizeof(STagColIndex));
+  if (pIdx == NULL) goto _err;
+
+  pIdx->colId = colId;
+  pIdx->type = type;
+
+  pIdx->pNulls = taosArrayInit(4, POINTER_BYTES);
+  if (pIdx->pNulls == NULL) goto _err;
+
+  if (tsdbTagColHasHash(type)) {
+    pIdx->pHash = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+    if (pIdx->pHash == NULL) goto _err;
+  }
+
+  if (tsdbTagColHasSorted(type)) {
+    pIdx->pSorted = tSkipListCreate(TSDB_SUPER_TABLE_SL_LEVEL, type, (uint8_t)tDataTypeDesc[type].nSize, 1, 0, 1,
+                                    tsdbGetTagIndexKey);
+    if (pIdx->pSorted == NULL) goto _err;
+    if (type == TSDB_DATA_TYPE_BINARY) pIdx->pSorted->comparFn = tsdbCompareTagStrNoCase;
+  }
+
+  return pIdx;
+
+_err:
+  terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+  tsdbFreeTagColIndex(pIdx);
+  return NULL;
+}
+
+static int tsdbAddTableIntoTagColIndex(STagColIndex *pIdx, STable *pTable) {
+  char *val = tsdbGetTagIndexVal(pTable, pIdx->colId, pIdx->type);
+  if (val == NULL) {
+    if (taosArrayPush(pIdx->pNulls, &pTable) == NULL) goto _err;
+    return 0;
+  }
+
+  if (pIdx->pHash != NULL) {
+    size_t   len = tsdbGetTagIndexValLen(val, pIdx->type);
+    SArray **ppTables = taosHashGet(pIdx->pHash, val, len);
+    if (ppTables == NULL) {
+      SArray *pTables = taosArrayInit(4, POINTER_BYTES);
+      if (pTables == NULL) goto _err;
+      if (taosHashPut(pIdx->pHash, val, len, &pTables, POINTER_BYTES) < 0) {
+        taosArrayDestroy(pTables);
+        goto _err;
+      }
+      ppTables = taosHashGet(pIdx->pHash, val, len);
+    }
+
+    if (taosArrayPush(*ppTables, &pTable) == NULL) goto _err;
+  }
+
+  if (pIdx->pSorted != NULL) {
+    int32_t level = 0;
+    int32_t headSize = 0;
+    tSkipListNewNodeInfo(pIdx->pSorted, &level, &headSize);
+
+    SSkipListNode *pNode = calloc(1, headSize + sizeof(STagIndexElem));
+    if (pNode == NULL) goto _err;
+    pNode->level = level;
+
+    STagIndexElem elem = {.pTable = pTable, .colId = pIdx->colId, .type = pIdx->type};
+    memcpy(SL_GET_NODE_DATA(pNode), &elem, sizeof(elem));
+    tSkipListPut(pIdx->pSorted, pNode);
+  }
+
+  return 0;
+
+_err:
+  terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+  return -1;
+}
+
+static void tsdbRemoveTableFromArray(SArray *pTables, STable *pTable) {
+  size_t size = taosArrayGetSize(pTables);
+  for (size_t i = 0; i < size; ++i) {
+    if (taosArrayGetP(pTables, i) == pTable) {
+      memcpy(taosArrayGet(pTables, i), taosArrayGet(pTables, size - 1), POINTER_BYTES);
+      taosArrayPop(pTables);
+      return;
+    }
+  }
+}
+
+static void tsdbRemoveTableFromTagColIndex(STagColIndex *pIdx, STable *pTable) {
+  char *val = tsdbGetTagIndexVal(pTable, pIdx->colId, pIdx->type);
+  if (val == NULL) {
+    tsdbRemoveTableFromArray(pIdx->pNulls, pTable);
+    return;
+  }
+
+  if (pIdx->pHash != NULL) {
+    size_t   len = tsdbGetTagIndexValLen(val, pIdx->type);
+    SArray **ppTables = taosHashGet(pIdx->pHash, val, len);
+    if (ppTables != NULL) {
+      tsdbRemoveTableFromArray(*ppTables, pTable);
+      if (taosArrayGetSize(*ppTables) == 0) {
+        taosArrayDestroy(*ppTables);
+        taosHashRemove(pIdx->pHash, val, len);
+      }
+    }
+  }
+
+  if (pIdx->pSorted != NULL) {
+    SArray *res = tSkipListGet(pIdx->pSorted, val);
+    for (int32_t i = 0; i < taosArrayGetSize(res); ++i) {
+      SSkipListNode *pNode = taosArrayGetP(res, i);
+      if (((STagIndexElem *)SL_GET_NODE_DATA(pNode))->pTable == pTable) {
+        tSkipListRemoveNode(pIdx->pSorted, pNode);
+        break;
+      }
+    }
+    taosArrayDestroy(res);
+  }
+}
+
+static STagColIndex *tsdbBuildTagColIndex(STable *pSTable, int16_t colId, int8_t type) {
+  STagColIndex *pIdx = tsdbNewTagColIndex(colId, type);
+  if (pIdx == NULL) return NULL;
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pSTable->pIndex);
+  while (tSkipListIterNext(pIter)) {
+    STable *pTable = *(STable **)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    if (tsdbAddTableIntoTagColIndex(pIdx, pTable) < 0) {
+      tSkipListDestroyIter(pIter);
+      tsdbFreeTagColIndex(pIdx);
+      return NULL;
+    }
+  }
+  tSkipListDestroyIter(pIter);
+
+  tsdbDebug("super table %s, index of tag %d is built over %" PRIzu " tables", TABLE_CHAR_NAME(pSTable),
+            colId, tSkipListGetSize(pSTable->pIndex));
+  return pIdx;
+}
+
+// Called with the meta read lock held at least
+static STagColIndex *tsdbGetTagColIndex(STable *pSTable, int16_t colId, int8_t type) {
+  if (tsTagIndexMinTables <= 0 || tSkipListGetSize(pSTable->pIndex) < tsTagIndexMinTables) return NULL;
+
+  if (pSTable->pTagIndex == NULL) {
+    // the meta read lock is taken by more than one query
+    STagIndex *pTagIndex = calloc(1, sizeof(STagIndex));
+    if (pTagIndex == NULL) return NULL;
+    pTagIndex->pCols = taosArrayInit(4, POINTER_BYTES);
+    if (pTagIndex->pCols == NULL) {
+      free(pTagIndex);
+      return NULL;
+    }
+    pthread_mutex_init(&pTagIndex->mutex, NULL);
+
+    if (atomic_val_compare_exchange_ptr(&pSTable->pTagIndex, NULL, pTagIndex) != NULL) {
+      pthread_mutex_destroy(&pTagIndex->mutex);
+      taosArrayDestroy(pTagIndex->pCols);
+      free(pTagIndex);
+    }
+  }
+
+  STagIndex *   pTagIndex = pSTable->pTagIndex;
+  STagColIndex *pIdx = NULL;
+
+  pthread_mutex_lock(&pTagIndex->mutex);
+  for (int32_t i = 0; i < taosArrayGetSize(pTagIndex->pCols); ++i) {
+    STagColIndex *p = taosArrayGetP(pTagIndex->pCols, i);
+    if (p->colId == colId) {
+      pIdx = p;
+      break;
+    }
+  }
+
+  if (pIdx == NULL) {
+    pIdx = tsdbBuildTagColIndex(pSTable, colId, type);
+    if (pIdx != NULL && taosArrayPush(pTagIndex->pCols, &pIdx) == NULL) {
+      tsdbFreeTagColIndex(pIdx);
+      pIdx = NULL;
+    }
+  }
+  pthread_mutex_unlock(&pTagIndex->mutex);
+
+  return pIdx;
+}
+
+// Called with the meta write lock held
+int tsdbAddTableIntoTagIndex(STable *pSTable, STable *pTable, int16_t colId) {
+  STagIndex *pTagIndex = pSTable->pTagIndex;
+  if (pTagIndex == NULL) return 0;
+
+  for (int32_t i = 0; i < taosArrayGetSize(pTagIndex->pCols);) {
+    STagColIndex *pIdx = taosArrayGetP(pTagIndex->pCols, i);
+    if ((colId != TSDB_TAG_INDEX_ALL_COLS && pIdx->colId != colId) || tsdbAddTableIntoTagColIndex(pIdx, pTable) == 0) {
+      i++;
+      continue;
+    }
+
+    // an incomplete index can not be used, drop it and build it again when it is queried
+    tsdbWarn("super table %s, index of tag %d is dropped since %s", TABLE_CHAR_NAME(pSTable), pIdx->colId,
+             tstrerror(terrno));
+    tsdbFreeTagColIndex(pIdx);
+    taosArrayRemove(pTagIndex->pCols, i);
+  }
+
+  return 0;
+}
+
+// Called with the meta write lock held
+void tsdbRemoveTableFromTagIndex(STable *pSTable, STable *pTable, int16_t colId) {
+  STagIndex *pTagIndex = pSTable->pTagIndex;
+  if (pTagIndex == NULL) return;
+
+  for (int32_t i = 0; i < taosArrayGetSize(pTagIndex->pCols); ++i) {
+    STagColIndex *pIdx = taosArrayGetP(pTagIndex->pCols, i);
+    if (colId == TSDB_TAG_INDEX_ALL_COLS || pIdx->colId == colId) {
+      tsdbRemoveTableFromTagColIndex(pIdx, pTable);
+    }
+  }
+}
+
+void tsdbFreeTagIndex(STable *pSTable) {
+  STagIndex *pTagIndex = pSTable->pTagIndex;
+  if (pTagIndex == NULL) return;
+
+  for (int32_t i = 0; i < taosArrayGetSize(pTagIndex->pCols); ++i) {
+    tsdbFreeTagColIndex(taosArrayGetP(pTagIndex->pCols, i));
+  }
+
+  taosArrayDestroy(pTagIndex->pCols);
+  pthread_mutex_destroy(&pTagIndex->mutex);
+  free(pTagIndex);
+  pSTable->pTagIndex = NULL;
+}
+
+static void tsdbPushTables(SArray *pTables, SArray *pSrc) {
+  for (size_t i = 0; i < taosArrayGetSize(pSrc); ++i) {
+    taosArrayPush(pTables, taosArrayGet(pSrc, i));
+  }
+}
+
+static int tsdbCompareTablePtr(const void *p1, const void *p2) {
+  STable *pTable1 = *(STable **)p1;
+  STable *pTable2 = *(STable **)p2;
+  if (pTable1 == pTable2) return 0;
+  return (pTable1 > pTable2) ? 1 : -1;
+}
+
+static void tsdbPushSortedTables(SSkipListIterator *pIter, SArray *pTables, const char *val, __compar_fn_t comparFn) {
+  while (tSkipListIterNext(pIter)) {
+    SSkipListNode *pNode = tSkipListIterGet(pIter);
+    if (val != NULL && comparFn(SL_GET_NODE_KEY(pIter->pSkipList, pNode), val) != 0) break;
+
+    taosArrayPush(pTables, &((STagIndexElem *)SL_GET_NODE_DATA(pNode))->pTable);
+  }
+}
+
+static void tsdbQueryTagColIndexByPrefix(STagColIndex *pIdx, const char *prefix, int32_t len, SArray *pTables) {
+  char key[TSDB_MAX_TAGS_LEN + VARSTR_HEADER_SIZE];
+  STR_WITH_SIZE_TO_VARSTR(key, prefix, len);
+
+  SSkipListIterator *pIter = tSkipListCreateIterFromVal(pIdx->pSorted, key, pIdx->type, TSDB_ORDER_ASC);
+  while (tSkipListIterNext(pIter)) {
+    SSkipListNode *pNode = tSkipListIterGet(pIter);
+    char *         val = SL_GET_NODE_KEY(pIdx->pSorted, pNode);
+    if (varDataLen(val) < len || strncasecmp(varDataVal(val), prefix, len) != 0) break;
+
+    taosArrayPush(pTables, &((STagIndexElem *)SL_GET_NODE_DATA(pNode))->pTable);
+  }
+  tSkipListDestroyIter(pIter);
+}
+
+// the literal characters of a like pattern before its first wildcard
+static int32_t tsdbGetPatternPrefixLen(const char *pattern) {
+  int32_t len = 0;
+  while (len < varDataLen(pattern)) {
+    char c = ((char *)varDataVal(pattern))[len];
+    if (c == '%' || c == '_' || c == '\\' || c == 0) break;
+    len++;
+  }
+
+  return len;
+}
+
+bool tsdbQueryTagIndex(STable *pSTable, tQueryInfo *pInfo, SArray *pTables) {
+  int16_t colId = pInfo->sch.colId;
+  int8_t  type = pInfo->sch.type;
+  int32_t optr = pInfo->optr;
+  int32_t prefixLen = 0;
+
+  switch (optr) {
+    case TSDB_RELATION_EQUAL:
+      break;
+    case TSDB_RELATION_LESS:
+    case TSDB_RELATION_LESS_EQUAL:
+    case TSDB_RELATION_GREATER:
+    case TSDB_RELATION_GREATER_EQUAL:
+      if (IS_VAR_DATA_TYPE(type)) return false;
+      break;
+    case TSDB_RELATION_IN:
+      if (type != TSDB_DATA_TYPE_BINARY) return false;
+      break;
+    case TSDB_RELATION_LIKE:
+      if (type != TSDB_DATA_TYPE_BINARY) return false;
+      prefixLen = tsdbGetPatternPrefixLen(pInfo->q);
+      if (prefixLen == 0) return false;
+      break;
+    default:
+      return false;
+  }
+
+  STagColIndex *pIdx = tsdbGetTagColIndex(pSTable, colId, type);
+  if (pIdx == NULL) return false;
+
+  if (optr == TSDB_RELATION_IN) {
+    SArray *pNames = (SArray *)pInfo->q;
+    for (int32_t i = 0; i < taosArrayGetSize(pNames); ++i) {
+      char *   name = taosArrayGetP(pNames, i);
+      SArray **ppTables = taosHashGet(pIdx->pHash, name, varDataTLen(name));
+      if (ppTables != NULL) tsdbPushTables(pTables, *ppTables);
+    }
+
+    // the same name may be given more than once
+    taosArraySort(pTables, tsdbCompareTablePtr);
+    size_t num = 0;
+    for (size_t i = 0; i < taosArrayGetSize(pTables); ++i) {
+      if (num == 0 || taosArrayGetP(pTables, i) != taosArrayGetP(pTables, num - 1)) {
+        memcpy(taosArrayGet(pTables, num++), taosArrayGet(pTables, i), POINTER_BYTES);
+      }
+    }
+    while (taosArrayGetSize(pTables) > num) taosArrayPop(pTables);
+  } else if (optr == TSDB_RELATION_LIKE) {
+    tsdbQueryTagColIndexByPrefix(pIdx, varDataVal(pInfo->q), prefixLen, pTables);
+  } else if (optr == TSDB_RELATION_EQUAL && pIdx->pHash != NULL) {
+    SArray **ppTables = taosHashGet(pIdx->pHash, pInfo->q, tsdbGetTagIndexValLen(pInfo->q, type));
+    if (ppTables != NULL) tsdbPushTables(pTables, *ppTables);
+  } else {
+    int32_t order = (optr == TSDB_RELATION_LESS || optr == TSDB_RELATION_LESS_EQUAL) ? TSDB_ORDER_DESC : TSDB_ORDER_ASC;
+    SSkipListIterator *pIter = tSkipListCreateIterFromVal(pIdx->pSorted, pInfo->q, type, order);
+    tsdbPushSortedTables(pIter, pTables, (optr == TSDB_RELATION_EQUAL) ? pInfo->q : NULL, pIdx->pSorted->comparFn);
+    tSkipListDestroyIter(pIter);
+  }
+
+  tsdbPushTables(pTables, pIdx->pNulls);
+  return true;
+}
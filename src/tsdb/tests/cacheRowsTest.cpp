@@ -0,0 +1,373 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tsdb.h"
+#include "tsdbMain.h"
+
+namespace {
+
+const int      TEST_VNODE = 5;
+const int      TEST_TID = 1;
+const uint64_t TEST_UID = 7302385610923;
+const TSKEY    TEST_INTERVAL = 1000;
+const int      TEST_MAX_ROWS = 300;  // max rows per file block, also the output capacity of a query
+
+// ts, c1 int and c3 bigint are in all versions, c2 binary is dropped by version 1, c4 smallint is added by version 1,
+// and version 2 adds c2 back
+const int16_t C1_COLID = 1;
+const int16_t C2_COLID = 2;
+const int16_t C3_COLID = 3;
+const int16_t C4_COLID = 4;
+const int16_t C2_BYTES = 16 + VARSTR_HEADER_SIZE;
+
+// the rows [0, 300) are of version 0, the rows [300, 700) of version 1 and the rows [700, 1000) of version 2
+const int TEST_ROWS = 1000;
+const int TEST_VERSIONS = 3;
+int       rowVersion(int i) { return (i < 300) ? 0 : ((i < 700) ? 1 : 2); }
+bool      hasColumn(int version, int16_t colId) {
+  return (colId != C2_COLID || version != 1) && (colId != C4_COLID || version != 0);
+}
+
+STSchema *buildSchema(int version) {
+  STSchemaBuilder schemaBuilder = {0};
+  tdInitTSchemaBuilder(&schemaBuilder, version);
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]);
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, C1_COLID, TYPE_BYTES[TSDB_DATA_TYPE_INT]);
+  if (hasColumn(version, C2_COLID)) tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_BINARY, C2_COLID, C2_BYTES);
+  tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_BIGINT, C3_COLID, TYPE_BYTES[TSDB_DATA_TYPE_BIGINT]);
+  if (hasColumn(version, C4_COLID)) {
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_SMALLINT, C4_COLID, TYPE_BYTES[TSDB_DATA_TYPE_SMALLINT]);
+  }
+  STSchema *pSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  return pSchema;
+}
+
+// each column has NULLs at its own period, so that the rows of a batch mix NULL and non-NULL values
+bool isNullAt(int i, int16_t colId) {
+  switch (colId) {
+    case C1_COLID: return i % 3 == 0;
+    case C2_COLID: return i % 4 == 1;
+    case C3_COLID: return i % 5 == 2;
+    case C4_COLID: return i % 7 == 3;
+    default:       return false;
+  }
+}
+
+std::string binaryAt(int i) { return "s" + std::to_string(i); }
+
+void buildRow(SDataRow row, STSchema *pSchema, TSKEY startKey, int i) {
+  tdInitDataRow(row, pSchema);
+  for (int j = 0; j < schemaNCols(pSchema); j++) {
+    STColumn *pTCol = schemaColAt(pSchema, j);
+    void *    value = NULL;
+    TSKEY     key = startKey + i * TEST_INTERVAL;
+    int32_t   v1 = i;
+    int64_t   v3 = (int64_t)i * 10;
+    int16_t   v4 = (int16_t)(i % 1000);
+    char      v2[C2_BYTES] = {0};
+    STR_WITH_SIZE_TO_VARSTR(v2, binaryAt(i).c_str(), (VarDataLenT)binaryAt(i).size());
+    char      nullVal[C2_BYTES] = {0};
+
+    if (colColId(pTCol) != 0 && isNullAt(i, colColId(pTCol))) {
+      if (IS_VAR_DATA_TYPE(colType(pTCol))) {
+        setVardataNull(nullVal, colType(pTCol));
+      } else {
+        setNull(nullVal, colType(pTCol), colBytes(pTCol));
+      }
+      value = nullVal;
+    } else {
+      switch (colColId(pTCol)) {
+        case 0:        value = &key; break;
+        case C1_COLID: value = &v1; break;
+        case C2_COLID: value = v2; break;
+        case C3_COLID: value = &v3; break;
+        case C4_COLID: value = &v4; break;
+      }
+    }
+    tdAppendColVal(row, value, colType(pTCol), colBytes(pTCol), colOffset(pTCol));
+  }
+}
+
+// Check the value of the column of row i, it is NULL if the version of the row does not have the column
+void checkValue(const void *value, int8_t type, int16_t colId, int i) {
+  if (!hasColumn(rowVersion(i), colId) || isNullAt(i, colId)) {
+    ASSERT_TRUE(isNull((const char *)value, type)) << "row:" << i << " colId:" << colId;
+    return;
+  }
+
+  ASSERT_FALSE(isNull((const char *)value, type)) << "row:" << i << " colId:" << colId;
+  switch (colId) {
+    case C1_COLID: ASSERT_EQ(*(int32_t *)value, i); break;
+    case C2_COLID:
+      ASSERT_EQ(std::string((char *)varDataVal(value), varDataLen(value)), binaryAt(i)) << "row:" << i;
+      break;
+    case C3_COLID: ASSERT_EQ(*(int64_t *)value, (int64_t)i * 10); break;
+    case C4_COLID: ASSERT_EQ(*(int16_t *)value, (int16_t)(i % 1000)); break;
+  }
+}
+
+// Check the rows of pCols are the rows [from, from + pCols->numOfRows)
+void checkDataCols(SDataCols *pCols, TSKEY startKey, int from) {
+  for (int r = 0; r < pCols->numOfRows; r++) {
+    int i = from + r;
+    ASSERT_EQ(dataColsKeyAt(pCols, r), startKey + i * TEST_INTERVAL);
+    for (int c = 1; c < pCols->numOfCols; c++) {
+      SDataCol *pCol = pCols->cols + c;
+      checkValue(tdGetColDataOfRow(pCol, r), pCol->type, pCol->colId, i);
+    }
+  }
+}
+
+class CacheRowsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (int v = 0; v < TEST_VERSIONS; v++) schemas[v] = buildSchema(v);
+    // the last version has all the columns, the columns a row does not have are read as NULL
+    pAllColsSchema = schemas[TEST_VERSIONS - 1];
+    startKey = taosGetTimestamp(TSDB_TIME_PRECISION_MILLI) - 3600 * 1000;
+  }
+
+  void TearDown() override {
+    if (repo) tsdbCloseRepo(repo, 0);
+    if (rootDir) {
+      taosRemoveDir(rootDir);
+      free(rootDir);
+    }
+    for (int v = 0; v < TEST_VERSIONS; v++) tdFreeSchema(schemas[v]);
+  }
+
+  void openRepo() {
+    rootDir = strdup("./cache_rows_vnode");
+    taosRemoveDir(rootDir);
+
+    STsdbCfg tsdbCfg;
+    memset((void *)&tsdbCfg, 0, sizeof(tsdbCfg));
+    tsdbCfg.tsdbId = TEST_VNODE;
+    tsdbCfg.cacheBlockSize = 16;
+    tsdbCfg.totalBlocks = 4;
+    tsdbCfg.daysPerFile = 10;
+    tsdbCfg.keep = 3650;
+    tsdbCfg.minRowsPerFileBlock = 100;
+    tsdbCfg.maxRowsPerFileBlock = TEST_MAX_ROWS;
+    tsdbCfg.precision = TSDB_TIME_PRECISION_MILLI;
+    tsdbCfg.compression = 2;
+    ASSERT_EQ(tsdbCreateRepo(rootDir, &tsdbCfg), 0);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    STableCfg tableCfg;
+    memset((void *)&tableCfg, 0, sizeof(tableCfg));
+    tableCfg.type = TSDB_NORMAL_TABLE;
+    tableCfg.superUid = TSDB_INVALID_SUPER_TABLE_ID;
+    tableCfg.tableId.tid = TEST_TID;
+    tableCfg.tableId.uid = TEST_UID;
+    tableCfg.schema = schemas[0];
+    tableCfg.name = (char *)"cache_t1";
+    ASSERT_EQ(tsdbCreateTable(repo, &tableCfg), 0);
+  }
+
+  // Insert the rows [from, to), all of the same version
+  void insertRows(int from, int to) {
+    STSchema *  pSchema = schemas[rowVersion(from)];
+    SSubmitMsg *pMsg = (SSubmitMsg *)calloc(
+        1, sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * (to - from));
+    ASSERT_NE(pMsg, nullptr);
+
+    SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+    for (int i = from; i < to; i++) {
+      SDataRow row = (SDataRow)(pBlock->data + pBlock->dataLen);
+      buildRow(row, pSchema, startKey, i);
+      pBlock->dataLen += dataRowLen(row);
+      pBlock->numOfRows++;
+    }
+
+    pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->dataLen);
+    pMsg->numOfBlocks = htonl(1);
+    pBlock->dataLen = htonl(pBlock->dataLen);
+    pBlock->numOfRows = htons(pBlock->numOfRows);
+    pBlock->uid = htobe64(TEST_UID);
+    pBlock->tid = htonl(TEST_TID);
+    pBlock->sversion = htonl(schemaVersion(pSchema));
+
+    int code = tsdbInsertData(repo, pMsg, NULL);
+    free(pMsg);
+    ASSERT_EQ(code, 0);
+  }
+
+  // Put all the rows in the memory table, the table schema is updated to the version of the rows before they are
+  // inserted
+  void insertAllRows() {
+    openRepo();
+    insertRows(0, 300);
+    tsdbUpdateTableSchema((STsdbRepo *)repo, getTable(), tdDupSchema(schemas[1]), false);
+    insertRows(300, 700);
+    tsdbUpdateTableSchema((STsdbRepo *)repo, getTable(), tdDupSchema(schemas[2]), false);
+    insertRows(700, TEST_ROWS);
+  }
+
+  STable *getTable() { return ((STsdbRepo *)repo)->tsdbMeta->tables[TEST_TID]; }
+
+  // Read the rows in the window from the memory table, the rows of each block must follow the ones before
+  void checkQuery(TSKEY skey, TSKEY ekey, int32_t order) {
+    std::vector<SColumnInfo> colList;
+    for (int c = 0; c < schemaNCols(pAllColsSchema); c++) {
+      STColumn *  pTCol = schemaColAt(pAllColsSchema, c);
+      SColumnInfo info = {0};
+      info.colId = colColId(pTCol);
+      info.type = colType(pTCol);
+      info.bytes = colBytes(pTCol);
+      colList.push_back(info);
+    }
+
+    STsdbQueryCond cond = {0};
+    cond.twindow = (order == TSDB_ORDER_ASC) ? STimeWindow{skey, ekey} : STimeWindow{ekey, skey};
+    cond.order = order;
+    cond.numOfCols = (int32_t)colList.size();
+    cond.colList = colList.data();
+
+    STableGroupInfo groupInfo = {0};
+    ASSERT_EQ(tsdbGetOneTableGroup(repo, TEST_UID, cond.twindow.skey, &groupInfo), 0);
+    TsdbQueryHandleT *pHandle = tsdbQueryTables(repo, &cond, &groupInfo, NULL);
+    ASSERT_NE(pHandle, nullptr);
+
+    int step = (order == TSDB_ORDER_ASC) ? 1 : -1;
+    int first = (int)(((order == TSDB_ORDER_ASC) ? skey : ekey) - startKey) / TEST_INTERVAL;
+    int last = (int)(((order == TSDB_ORDER_ASC) ? ekey : skey) - startKey) / TEST_INTERVAL;
+    int next = first;
+    int numOfBlocks = 0;
+    while (tsdbNextDataBlock(pHandle)) {
+      SDataBlockInfo blockInfo;
+      tsdbRetrieveDataBlockInfo(pHandle, &blockInfo);
+      ASSERT_LE(blockInfo.rows, TEST_MAX_ROWS);
+
+      SArray *pCols = tsdbRetrieveDataBlock(pHandle, NULL);
+      ASSERT_NE(pCols, nullptr);
+      // the rows of a block are in ascending order in both orders, a descending query reads them from the end
+      for (int r = 0; r < blockInfo.rows; r++, next += step) {
+        int pos = (order == TSDB_ORDER_ASC) ? r : (blockInfo.rows - 1 - r);
+        for (int c = 0; c < (int)taosArrayGetSize(pCols); c++) {
+          SColumnInfoData *pColInfo = (SColumnInfoData *)taosArrayGet(pCols, c);
+          char *           value = (char *)pColInfo->pData + pos * pColInfo->info.bytes;
+          if (c == 0) {
+            ASSERT_EQ(*(TSKEY *)value, startKey + next * TEST_INTERVAL);
+          } else {
+            checkValue(value, (int8_t)pColInfo->info.type, pColInfo->info.colId, next);
+          }
+        }
+      }
+      numOfBlocks++;
+    }
+    EXPECT_EQ(next, last + step);
+    EXPECT_EQ(numOfBlocks, (std::abs(last - first) + TEST_MAX_ROWS) / TEST_MAX_ROWS);
+
+    tsdbCleanupQueryHandle(pHandle);
+    tsdbDestroyTableGroup(&groupInfo);
+  }
+
+  STSchema *   schemas[TEST_VERSIONS] = {NULL};
+  STSchema *   pAllColsSchema = NULL;
+  TSKEY        startKey = 0;
+  char *       rootDir = NULL;
+  TSDB_REPO_T *repo = NULL;
+};
+
+}  // namespace
+
+TEST_F(CacheRowsTest, appendRowsInBatches) {
+  std::vector<SDataRow> rows;
+  for (int i = 0; i < TEST_ROWS; i++) {
+    STSchema *pSchema = schemas[rowVersion(i)];
+    SDataRow  row = (SDataRow)calloc(1, dataRowMaxBytesFromSchema(pSchema));
+    buildRow(row, pSchema, startKey, i);
+    rows.push_back(row);
+  }
+
+  SDataCols *pBatchCols = tdNewDataCols(schemaTLen(pAllColsSchema), schemaNCols(pAllColsSchema), TEST_ROWS);
+  SDataCols *pRowCols = tdNewDataCols(schemaTLen(pAllColsSchema), schemaNCols(pAllColsSchema), TEST_ROWS);
+  ASSERT_EQ(tdInitDataCols(pBatchCols, pAllColsSchema), 0);
+  ASSERT_EQ(tdInitDataCols(pRowCols, pAllColsSchema), 0);
+
+  // the batches are cut at the version changes and at a size that does not divide the versions
+  const int batchSize = 128;
+  for (int i = 0; i < TEST_ROWS;) {
+    int n = 1;
+    while (n < batchSize && i + n < TEST_ROWS && rowVersion(i + n) == rowVersion(i)) n++;
+    tdAppendDataRowsToDataCol(&rows[i], n, schemas[rowVersion(i)], pBatchCols);
+    i += n;
+  }
+  for (int i = 0; i < TEST_ROWS; i++) {
+    tdAppendDataRowToDataCol(rows[i], schemas[rowVersion(i)], pRowCols);
+  }
+
+  ASSERT_EQ(pBatchCols->numOfRows, TEST_ROWS);
+  checkDataCols(pBatchCols, startKey, 0);
+
+  // the columns are the same as the ones appended row by row
+  ASSERT_EQ(pRowCols->numOfRows, TEST_ROWS);
+  for (int c = 0; c < pBatchCols->numOfCols; c++) {
+    SDataCol *pBatchCol = pBatchCols->cols + c;
+    SDataCol *pRowCol = pRowCols->cols + c;
+    ASSERT_EQ(pBatchCol->len, pRowCol->len) << "colId:" << pBatchCol->colId;
+    EXPECT_EQ(memcmp(pBatchCol->pData, pRowCol->pData, pBatchCol->len), 0) << "colId:" << pBatchCol->colId;
+  }
+
+  tdFreeDataCols(pBatchCols);
+  tdFreeDataCols(pRowCols);
+  for (size_t i = 0; i < rows.size(); i++) free(rows[i]);
+}
+
+TEST_F(CacheRowsTest, loadFromCacheUpToKeyAndRows) {
+  insertAllRows();
+
+  STableData *pTableData = ((STsdbRepo *)repo)->mem->tData[TEST_TID];
+  ASSERT_NE(pTableData, nullptr);
+  ASSERT_EQ(pTableData->numOfRows, TEST_ROWS);
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pTableData->pData);
+  ASSERT_TRUE(tSkipListIterNext(pIter));
+
+  // the rows are loaded in pieces of maxRows, which cut the batches, until the key of row 899
+  const int  maxRows = 333;
+  const int  lastRow = 899;
+  TSKEY      maxKey = startKey + lastRow * TEST_INTERVAL;
+  SDataCols *pCols = tdNewDataCols(schemaTLen(pAllColsSchema), schemaNCols(pAllColsSchema), maxRows);
+  ASSERT_EQ(tdInitDataCols(pCols, pAllColsSchema), 0);
+
+  int from = 0;
+  while (true) {
+    tdResetDataCols(pCols);
+    int rowsRead = tsdbLoadDataFromCache(getTable(), pIter, maxKey, maxRows, pCols, NULL, 0);
+    ASSERT_EQ(rowsRead, std::min(maxRows, lastRow + 1 - from));
+    ASSERT_EQ(pCols->numOfRows, rowsRead);
+    checkDataCols(pCols, startKey, from);
+    from += rowsRead;
+    if (rowsRead < maxRows) break;
+  }
+  EXPECT_EQ(from, lastRow + 1);
+
+  // the rows after the key are left for the next load
+  EXPECT_EQ(tsdbNextIterKey(pIter), maxKey + TEST_INTERVAL);
+
+  tdFreeDataCols(pCols);
+  tSkipListDestroyIter(pIter);
+}
+
+TEST_F(CacheRowsTest, readFromCacheInWindow) {
+  insertAllRows();
+
+  // more rows than the output capacity, the window starts and ends in the middle of a version
+  TSKEY skey = startKey + 150 * TEST_INTERVAL;
+  TSKEY ekey = startKey + 949 * TEST_INTERVAL;
+  checkQuery(skey, ekey, TSDB_ORDER_ASC);
+  checkQuery(skey, ekey, TSDB_ORDER_DESC);
+
+  // less rows than the output capacity, the descending rows are moved to the front of the output
+  skey = startKey + 290 * TEST_INTERVAL;
+  ekey = startKey + 409 * TEST_INTERVAL;
+  checkQuery(skey, ekey, TSDB_ORDER_ASC);
+  checkQuery(skey, ekey, TSDB_ORDER_DESC);
+}
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string>
+
+#include "tsdb.h"
+#include "tsdbMain.h"
+
+namespace {
+
+const int      TEST_VNODE = 2;
+const int      TEST_TID = 1;
+const uint64_t TEST_UID = 4384978201845;
+const int      TEST_ROWS_PER_COMMIT = 10;
+const int      TEST_COMMITS = 6;
+const TSKEY    TEST_INTERVAL = 1000;
+
+void setCompactCfg(STsdbCfg *pCfg) {
+  memset((void *)pCfg, 0, sizeof(*pCfg));
+  pCfg->tsdbId = TEST_VNODE;
+  pCfg->cacheBlockSize = 16;
+  pCfg->totalBlocks = 4;
+  pCfg->daysPerFile = 10;
+  pCfg->keep = 3650;
+  pCfg->minRowsPerFileBlock = 100;
+  pCfg->maxRowsPerFileBlock = 4096;
+  pCfg->precision = TSDB_TIME_PRECISION_MILLI;
+  pCfg->compression = 2;
+}
+
+void setCompactTableCfg(STableCfg *pCfg) {
+  STSchemaBuilder schemaBuilder = {0};
+
+  memset((void *)pCfg, 0, sizeof(*pCfg));
+  pCfg->type = TSDB_NORMAL_TABLE;
+  pCfg->superUid = TSDB_INVALID_SUPER_TABLE_ID;
+  pCfg->tableId.tid = TEST_TID;
+  pCfg->tableId.uid = TEST_UID;
+  tdInitTSchemaBuilder(&schemaBuilder, 0);
+  for (int colId = 0; colId < 3; colId++) {
+    tdAddColToSchema(&schemaBuilder, (colId == 0) ? TSDB_DATA_TYPE_TIMESTAMP : TSDB_DATA_TYPE_INT, colId, 0);
+  }
+  pCfg->schema = tdGetSchemaFromBuilder(&schemaBuilder);
+  pCfg->name = strdup("compact_t1");
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+}
+
+// Row i has the key startKey + i * TEST_INTERVAL and the value i in all int columns
+int insertRows(TSDB_REPO_T *repo, STSchema *pSchema, TSKEY startKey, int from, int nRows) {
+  SSubmitMsg *pMsg =
+      (SSubmitMsg *)calloc(1, sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + dataRowMaxBytesFromSchema(pSchema) * nRows);
+  if (pMsg == NULL) return -1;
+
+  SSubmitBlk *pBlock = (SSubmitBlk *)pMsg->blocks;
+  for (int i = from; i < from + nRows; i++) {
+    SDataRow row = (SDataRow)(pBlock->data + pBlock->dataLen);
+    tdInitDataRow(row, pSchema);
+    for (int j = 0; j < schemaNCols(pSchema); j++) {
+      STColumn *pTCol = schemaColAt(pSchema, j);
+      if (j == 0) {
+        TSKEY key = startKey + i * TEST_INTERVAL;
+        tdAppendColVal(row, (void *)(&key), pTCol->type, pTCol->bytes, pTCol->offset);
+      } else {
+        int32_t val = i;
+        tdAppendColVal(row, (void *)(&val), pTCol->type, pTCol->bytes, pTCol->offset);
+      }
+    }
+    pBlock->dataLen += dataRowLen(row);
+    pBlock->numOfRows++;
+  }
+
+  pMsg->length = htonl(sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + pBlock->dataLen);
+  pMsg->numOfBlocks = htonl(1);
+  pBlock->dataLen = htonl(pBlock->dataLen);
+  pBlock->numOfRows = htons(pBlock->numOfRows);
+  pBlock->uid = htobe64(TEST_UID);
+  pBlock->tid = htonl(TEST_TID);
+  pBlock->sversion = htonl(0);
+
+  int code = tsdbInsertData(repo, pMsg, NULL);
+  free(pMsg);
+  return code;
+}
+
+SFileGroup *getOnlyFGroup(STsdbRepo *pRepo) {
+  STsdbFileH *pFileH = pRepo->tsdbFileH;
+  if (pFileH->nFGroups != 1) return NULL;
+  return pFileH->pFGroup;
+}
+
+// Read all rows of the table in the file group back and check they are the rows inserted
+void checkRows(STsdbRepo *pRepo, TSKEY startKey, int nRows) {
+  SFileGroup *pGroup = getOnlyFGroup(pRepo);
+  ASSERT_NE(pGroup, nullptr);
+
+  SRWHelper rhelper;
+  ASSERT_EQ(tsdbInitReadHelper(&rhelper, pRepo), 0);
+  ASSERT_EQ(tsdbSetAndOpenHelperFile(&rhelper, pGroup), 0);
+  ASSERT_EQ(tsdbLoadCompIdx(&rhelper, NULL), 0);
+
+  STable *pTable = pRepo->tsdbMeta->tables[TEST_TID];
+  ASSERT_NE(pTable, nullptr);
+  ASSERT_EQ(tsdbSetHelperTable(&rhelper, pTable, pRepo), 0);
+  ASSERT_EQ(tsdbLoadCompInfo(&rhelper, NULL), 0);
+
+  int nRead = 0;
+  for (int i = 0; i < (int)rhelper.curCompIdx.numOfBlocks; i++) {
+    ASSERT_EQ(tsdbLoadBlockData(&rhelper, blockAtIdx(&rhelper, i), NULL), 0);
+    SDataCols *pCols = rhelper.pDataCols[0];
+    for (int r = 0; r < pCols->numOfRows; r++, nRead++) {
+      ASSERT_EQ(((TSKEY *)pCols->cols[0].pData)[r], startKey + nRead * TEST_INTERVAL);
+      ASSERT_EQ(((int32_t *)pCols->cols[1].pData)[r], nRead);
+      ASSERT_EQ(((int32_t *)pCols->cols[2].pData)[r], nRead);
+    }
+  }
+  ASSERT_EQ(nRead, nRows);
+
+  tsdbDestroyHelper(&rhelper);
+}
+
+bool fileExists(STsdbRepo *pRepo, int fid, int type) {
+  char fname[TSDB_FILENAME_LEN] = "\0";
+  tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, type, fname);
+  return access(fname, F_OK) == 0;
+}
+
+void copyFile(STsdbRepo *pRepo, int fid, int from, int to) {
+  char fname[TSDB_FILENAME_LEN] = "\0";
+  char tname[TSDB_FILENAME_LEN] = "\0";
+  tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, from, fname);
+  tsdbGetDataFileName(pRepo->rootDir, REPO_ID(pRepo), fid, to, tname);
+  std::string cmd = std::string("cp ") + fname + " " + tname;
+  ASSERT_EQ(system(cmd.c_str()), 0);
+}
+
+class CompactTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rootDir = strdup("./compact_vnode");
+    taosRemoveDir(rootDir);
+
+    // put the rows in a file group before the current one, which is the only kind compacted
+    startKey = taosGetTimestamp(TSDB_TIME_PRECISION_MILLI) - 30 * tsMsPerDay[TSDB_TIME_PRECISION_MILLI];
+
+    STsdbCfg tsdbCfg;
+    setCompactCfg(&tsdbCfg);
+    ASSERT_EQ(tsdbCreateRepo(rootDir, &tsdbCfg), 0);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    setCompactTableCfg(&tableCfg);
+    ASSERT_EQ(tsdbCreateTable(repo, &tableCfg), 0);
+  }
+
+  void TearDown() override {
+    if (repo) tsdbCloseRepo(repo, 0);
+    tdFreeSchema(tableCfg.schema);
+    free(tableCfg.name);
+    taosRemoveDir(rootDir);
+    free(rootDir);
+  }
+
+  void reopen() {
+    tsdbCloseRepo(repo, 1);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+  }
+
+  // Commit the rows in small batches, each one appends a sub-block to the last block of the table. The last
+  // batch is committed by closing the repository.
+  void writeFragmentedGroup() {
+    // no background compaction, so the file group stays fragmented
+    ((STsdbRepo *)repo)->compactStop = 1;
+    for (int i = 0; i < TEST_COMMITS; i++) {
+      ASSERT_EQ(insertRows(repo, tableCfg.schema, startKey, i * TEST_ROWS_PER_COMMIT, TEST_ROWS_PER_COMMIT), 0);
+      if (i < TEST_COMMITS - 1) ASSERT_EQ(tsdbAsyncCommit((STsdbRepo *)repo), 0);
+    }
+    reopen();
+  }
+
+  char *       rootDir = NULL;
+  TSKEY        startKey = 0;
+  STableCfg    tableCfg;
+  TSDB_REPO_T *repo = NULL;
+};
+
+}  // namespace
+
+TEST_F(CompactTest, compactFragmentedGroup) {
+  const int nRows = TEST_COMMITS * TEST_ROWS_PER_COMMIT;
+
+  writeFragmentedGroup();
+  STsdbRepo *pRepo = (STsdbRepo *)repo;
+
+  SFileGroup *pGroup = getOnlyFGroup(pRepo);
+  ASSERT_NE(pGroup, nullptr);
+  ASSERT_GT(pGroup->files[TSDB_FILE_TYPE_HEAD].info.totalSubBlocks, 0u);
+  checkRows(pRepo, startKey, nRows);
+
+  ASSERT_EQ(tsdbCompact(pRepo), 0);
+
+  pGroup = getOnlyFGroup(pRepo);
+  ASSERT_NE(pGroup, nullptr);
+  int fid = pGroup->fileId;
+  EXPECT_EQ(pGroup->files[TSDB_FILE_TYPE_HEAD].info.totalSubBlocks, 0u);
+  EXPECT_EQ(pGroup->files[TSDB_FILE_TYPE_HEAD].info.totalBlocks, 1u);
+  for (int type = TSDB_FILE_TYPE_CHEAD; type <= TSDB_FILE_TYPE_CMARK; type++) EXPECT_FALSE(fileExists(pRepo, fid, type));
+  checkRows(pRepo, startKey, nRows);
+
+  // the compacted files are read back from disk
+  reopen();
+  pRepo = (STsdbRepo *)repo;
+  EXPECT_EQ(getOnlyFGroup(pRepo)->files[TSDB_FILE_TYPE_HEAD].info.totalSubBlocks, 0u);
+  checkRows(pRepo, startKey, nRows);
+}
+
+TEST_F(CompactTest, recoverCompleteCompaction) {
+  const int nRows = TEST_COMMITS * TEST_ROWS_PER_COMMIT;
+
+  writeFragmentedGroup();
+  STsdbRepo *pRepo = (STsdbRepo *)repo;
+  int        fid = getOnlyFGroup(pRepo)->fileId;
+
+  // a crash after the mark file is written and only the .data file is renamed
+  tsdbCloseRepo(repo, 0);
+  repo = NULL;
+  char fname[TSDB_FILENAME_LEN] = "\0";
+  STsdbRepo fakeRepo;
+  fakeRepo.rootDir = rootDir;
+  fakeRepo.config.tsdbId = TEST_VNODE;
+  copyFile(&fakeRepo, fid, TSDB_FILE_TYPE_HEAD, TSDB_FILE_TYPE_CHEAD);
+  copyFile(&fakeRepo, fid, TSDB_FILE_TYPE_LAST, TSDB_FILE_TYPE_CLAST);
+  tsdbGetDataFileName(rootDir, TEST_VNODE, fid, TSDB_FILE_TYPE_CMARK, fname);
+  FILE *fp = fopen(fname, "w");
+  ASSERT_NE(fp, nullptr);
+  fclose(fp);
+
+  repo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(repo, nullptr);
+  pRepo = (STsdbRepo *)repo;
+  for (int type = TSDB_FILE_TYPE_CHEAD; type <= TSDB_FILE_TYPE_CMARK; type++) EXPECT_FALSE(fileExists(pRepo, fid, type));
+  checkRows(pRepo, startKey, nRows);
+}
+
+TEST_F(CompactTest, dropUnfinishedCompaction) {
+  const int nRows = TEST_COMMITS * TEST_ROWS_PER_COMMIT;
+
+  writeFragmentedGroup();
+  STsdbRepo *pRepo = (STsdbRepo *)repo;
+  int        fid = getOnlyFGroup(pRepo)->fileId;
+
+  // a crash before the mark file is written, the compacted files may be incomplete
+  tsdbCloseRepo(repo, 0);
+  repo = NULL;
+  STsdbRepo fakeRepo;
+  fakeRepo.rootDir = rootDir;
+  fakeRepo.config.tsdbId = TEST_VNODE;
+  copyFile(&fakeRepo, fid, TSDB_FILE_TYPE_LAST, TSDB_FILE_TYPE_CHEAD);
+  copyFile(&fakeRepo, fid, TSDB_FILE_TYPE_LAST, TSDB_FILE_TYPE_CDATA);
+
+  repo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(repo, nullptr);
+  pRepo = (STsdbRepo *)repo;
+  for (int type = TSDB_FILE_TYPE_CHEAD; type <= TSDB_FILE_TYPE_CMARK; type++) EXPECT_FALSE(fileExists(pRepo, fid, type));
+  EXPECT_GT(getOnlyFGroup(pRepo)->files[TSDB_FILE_TYPE_HEAD].info.totalSubBlocks, 0u);
+  checkRows(pRepo, startKey, nRows);
+}
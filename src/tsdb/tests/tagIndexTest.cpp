@@ -0,0 +1,328 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tglobal.h"
+#include "tsdb.h"
+#include "tsdbMain.h"
+
+#include "../../query/inc/qAst.h"
+
+namespace {
+
+const int      TEST_VNODE = 4;
+const uint64_t TEST_SUPER_UID = 9001;
+const int      TEST_TABLES = 200;
+
+// t1 is the first tag, indexed by the super table itself, t2 and t3 are indexed by the tag index
+const int16_t T1_COLID = 2;
+const int16_t T2_COLID = 3;
+const int16_t T3_COLID = 4;
+const int16_t T3_BYTES = 16;
+
+void setTagIndexCfg(STsdbCfg *pCfg) {
+  memset((void *)pCfg, 0, sizeof(*pCfg));
+  pCfg->tsdbId = TEST_VNODE;
+  pCfg->cacheBlockSize = 16;
+  pCfg->totalBlocks = 4;
+  pCfg->daysPerFile = 10;
+  pCfg->keep = 3650;
+  pCfg->minRowsPerFileBlock = 100;
+  pCfg->maxRowsPerFileBlock = 4096;
+  pCfg->precision = TSDB_TIME_PRECISION_MILLI;
+  pCfg->compression = 2;
+}
+
+uint64_t tableUid(int tid) { return TEST_SUPER_UID + tid; }
+
+std::string tableName(int tid) { return "idx_t" + std::to_string(tid); }
+
+// t2 is missing from every 13th table, t3 is NULL in every 11th table
+bool t2IsNull(int tid) { return tid % 13 == 0; }
+int32_t t2Value(int tid) { return tid % 17; }
+bool t3IsNull(int tid) { return tid % 11 == 0; }
+
+std::string t3Value(int tid) {
+  const char *prefix[] = {"Alpha", "beta", "BETA", "gamma"};
+  return prefix[tid % 4] + std::to_string(tid);
+}
+
+// the tags are in network order as the update tag message is decoded in place
+int updateTagValue(TSDB_REPO_T *repo, int tid, int16_t colId, int8_t type, const void *val, int32_t len) {
+  SUpdateTableTagValMsg *pMsg = (SUpdateTableTagValMsg *)calloc(1, sizeof(SUpdateTableTagValMsg) + len);
+  if (pMsg == NULL) return -1;
+
+  pMsg->uid = htobe64(tableUid(tid));
+  pMsg->tid = htonl(tid);
+  pMsg->tversion = htons(0);
+  pMsg->colId = htons(colId);
+  pMsg->type = type;
+  pMsg->bytes = htons((int16_t)len);
+  pMsg->tagValLen = htonl(len);
+  memcpy(pMsg->data, val, len);
+
+  int code = tsdbUpdateTableTagValue(repo, pMsg);
+  free(pMsg);
+  return code;
+}
+
+tExprNode *createColNode(int16_t colId, int8_t type, int16_t bytes) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_COL;
+  pNode->pSchema = (SSchema *)calloc(1, sizeof(SSchema));
+  pNode->pSchema->colId = colId;
+  pNode->pSchema->type = type;
+  pNode->pSchema->bytes = bytes;
+  snprintf(pNode->pSchema->name, sizeof(pNode->pSchema->name), "t%d", colId - 1);
+  return pNode;
+}
+
+tExprNode *createExprNode(uint8_t optr, tExprNode *pLeft, tExprNode *pRight) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_EXPR;
+  pNode->_node.optr = optr;
+  pNode->_node.pLeft = pLeft;
+  pNode->_node.pRight = pRight;
+  return pNode;
+}
+
+// t2 <optr> val
+tExprNode *intTagExpr(uint8_t optr, int64_t val) {
+  tExprNode *pRight = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+  pRight->pVal->nType = TSDB_DATA_TYPE_BIGINT;
+  pRight->pVal->i64Key = val;
+
+  return createExprNode(optr, createColNode(T2_COLID, TSDB_DATA_TYPE_INT, sizeof(int32_t)), pRight);
+}
+
+// t3 <optr> val
+tExprNode *strTagExpr(uint8_t optr, const char *val) {
+  tExprNode *pRight = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+  pRight->pVal->nType = TSDB_DATA_TYPE_BINARY;
+  pRight->pVal->pz = strdup(val);
+  pRight->pVal->nLen = (int32_t)strlen(val);
+
+  return createExprNode(optr, createColNode(T3_COLID, TSDB_DATA_TYPE_BINARY, T3_BYTES), pRight);
+}
+
+// t2 is null
+tExprNode *nullTagExpr() {
+  tExprNode *pRight = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pRight->nodeType = TSQL_NODE_VALUE;
+  pRight->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+  pRight->pVal->nType = TSDB_DATA_TYPE_NULL;
+
+  return createExprNode(TSDB_RELATION_ISNULL, createColNode(T2_COLID, TSDB_DATA_TYPE_INT, sizeof(int32_t)), pRight);
+}
+
+class TagIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rootDir = strdup("./tag_index_vnode");
+    taosRemoveDir(rootDir);
+
+    STsdbCfg tsdbCfg;
+    setTagIndexCfg(&tsdbCfg);
+    ASSERT_EQ(tsdbCreateRepo(rootDir, &tsdbCfg), 0);
+    repo = tsdbOpenRepo(rootDir, NULL);
+    ASSERT_NE(repo, nullptr);
+
+    STSchemaBuilder schemaBuilder = {0};
+    tdInitTSchemaBuilder(&schemaBuilder, 0);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_TIMESTAMP, 0, 8);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, 1, 4);
+    schema = tdGetSchemaFromBuilder(&schemaBuilder);
+    tdResetTSchemaBuilder(&schemaBuilder, 0);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, T1_COLID, 4);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_INT, T2_COLID, 4);
+    tdAddColToSchema(&schemaBuilder, TSDB_DATA_TYPE_BINARY, T3_COLID, T3_BYTES);
+    tagSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+    tdDestroyTSchemaBuilder(&schemaBuilder);
+
+    for (int tid = 1; tid <= TEST_TABLES; tid++) {
+      createTable(tid);
+    }
+  }
+
+  void TearDown() override {
+    if (repo) tsdbCloseRepo(repo, 0);
+    tdFreeSchema(schema);
+    tdFreeSchema(tagSchema);
+    taosRemoveDir(rootDir);
+    free(rootDir);
+    tsTagIndexMinTables = 1000;
+  }
+
+  void createTable(int tid) {
+    SKVRowBuilder kvBuilder;
+    ASSERT_EQ(tdInitKVRowBuilder(&kvBuilder), 0);
+
+    int32_t t1 = tid % 5;
+    tdAddColToKVRow(&kvBuilder, T1_COLID, TSDB_DATA_TYPE_INT, &t1);
+    if (!t2IsNull(tid)) {
+      int32_t t2 = t2Value(tid);
+      tdAddColToKVRow(&kvBuilder, T2_COLID, TSDB_DATA_TYPE_INT, &t2);
+    }
+
+    char t3[T3_BYTES + VARSTR_HEADER_SIZE];
+    if (t3IsNull(tid)) {
+      memcpy(t3, getNullValue(TSDB_DATA_TYPE_BINARY), VARSTR_HEADER_SIZE + 1);
+    } else {
+      STR_TO_VARSTR(t3, t3Value(tid).c_str());
+    }
+    tdAddColToKVRow(&kvBuilder, T3_COLID, TSDB_DATA_TYPE_BINARY, t3);
+
+    std::string name = tableName(tid);
+
+    STableCfg cfg;
+    memset((void *)&cfg, 0, sizeof(cfg));
+    cfg.type = TSDB_CHILD_TABLE;
+    cfg.name = (char *)name.c_str();
+    cfg.sname = (char *)"idx_st";
+    cfg.tableId.tid = tid;
+    cfg.tableId.uid = tableUid(tid);
+    cfg.superUid = TEST_SUPER_UID;
+    cfg.schema = schema;
+    cfg.tagSchema = tagSchema;
+    cfg.tagValues = tdGetKVRowFromBuilder(&kvBuilder);
+    tdDestroyKVRowBuilder(&kvBuilder);
+
+    ASSERT_EQ(tsdbCreateTable(repo, &cfg), 0);
+    kvRowFree(cfg.tagValues);
+  }
+
+  // the qualified tables in the order they are returned
+  std::vector<STable *> queryTables(tExprNode *pExpr, const char *tbnameCond, bool indexed) {
+    tsTagIndexMinTables = indexed ? 1 : 0;
+
+    SBufferWriter bw = tbufInitWriter(NULL, false);
+    if (pExpr != NULL) exprTreeToBinary(&bw, pExpr);
+
+    STableGroupInfo groupInfo = {0};
+    int32_t         code = tsdbQuerySTableByTagCond(repo, TEST_SUPER_UID, 0, tbufGetData(&bw, false), tbufTell(&bw),
+                                            TSDB_RELATION_AND, tbnameCond, &groupInfo, NULL, 0);
+    EXPECT_EQ(code, TSDB_CODE_SUCCESS);
+
+    std::vector<STable *> tables;
+    for (size_t i = 0; groupInfo.pGroupList != NULL && i < taosArrayGetSize(groupInfo.pGroupList); ++i) {
+      SArray *pGroup = (SArray *)taosArrayGetP(groupInfo.pGroupList, i);
+      for (size_t j = 0; j < taosArrayGetSize(pGroup); ++j) {
+        tables.push_back((STable *)((STableKeyInfo *)taosArrayGet(pGroup, j))->pTable);
+      }
+    }
+
+    // the tables are still referred to by the meta
+    tsdbDestroyTableGroup(&groupInfo);
+    tbufCloseWriter(&bw);
+    return tables;
+  }
+
+  static int32_t firstTag(STable *pTable) { return *(int32_t *)tdGetKVRowValOfCol(pTable->tagVal, T1_COLID); }
+
+  static std::vector<int> sortedTids(const std::vector<STable *> &tables) {
+    std::vector<int> tids;
+    for (STable *pTable : tables) tids.push_back(TABLE_TID(pTable));
+    std::sort(tids.begin(), tids.end());
+    return tids;
+  }
+
+  // the lookup by the tag index gives the same tables as a scan over all the child tables, both are ordered by the
+  // first tag, but the tables with the same first tag may come in different orders
+  void checkAgainstFullScan(tExprNode *pExpr, const char *tbnameCond, size_t minTables) {
+    std::vector<STable *> indexed = queryTables(pExpr, tbnameCond, true);
+    std::vector<STable *> scanned = queryTables(pExpr, tbnameCond, false);
+
+    EXPECT_EQ(sortedTids(indexed), sortedTids(scanned));
+    EXPECT_GE(scanned.size(), minTables);
+    for (size_t i = 1; i < indexed.size(); ++i) {
+      EXPECT_LE(firstTag(indexed[i - 1]), firstTag(indexed[i]));
+    }
+
+    tExprTreeDestroy(&pExpr, NULL);
+  }
+
+  void checkLookups() {
+    checkAgainstFullScan(intTagExpr(TSDB_RELATION_EQUAL, 5), NULL, 1);
+    checkAgainstFullScan(intTagExpr(TSDB_RELATION_GREATER, 10), NULL, 1);
+    checkAgainstFullScan(intTagExpr(TSDB_RELATION_LESS_EQUAL, 3), NULL, 1);
+
+    // the tables whose t2 is missing compare less than any value
+    checkAgainstFullScan(intTagExpr(TSDB_RELATION_LESS, 4), NULL, 1);
+    checkAgainstFullScan(nullTagExpr(), NULL, 1);
+
+    // a range is a conjunction, a disjunction with a side not served by the index falls back to the scan
+    checkAgainstFullScan(createExprNode(TSDB_RELATION_AND, intTagExpr(TSDB_RELATION_GREATER_EQUAL, 3),
+                                        intTagExpr(TSDB_RELATION_LESS, 9)),
+                         NULL, 1);
+    checkAgainstFullScan(
+        createExprNode(TSDB_RELATION_OR, intTagExpr(TSDB_RELATION_EQUAL, 2), intTagExpr(TSDB_RELATION_EQUAL, 16)),
+        NULL, 1);
+    checkAgainstFullScan(createExprNode(TSDB_RELATION_OR, intTagExpr(TSDB_RELATION_EQUAL, 2), nullTagExpr()), NULL, 1);
+
+    // like on the literal prefix, in any case
+    checkAgainstFullScan(strTagExpr(TSDB_RELATION_EQUAL, t3Value(6).c_str()), NULL, 1);
+    checkAgainstFullScan(strTagExpr(TSDB_RELATION_LIKE, "beta%"), NULL, 1);
+    checkAgainstFullScan(strTagExpr(TSDB_RELATION_LIKE, "BETA1%"), NULL, 1);
+    checkAgainstFullScan(strTagExpr(TSDB_RELATION_LIKE, "Alp_a%"), NULL, 1);
+    checkAgainstFullScan(createExprNode(TSDB_RELATION_AND, strTagExpr(TSDB_RELATION_LIKE, "gamma%"),
+                                        intTagExpr(TSDB_RELATION_GREATER, 8)),
+                         NULL, 1);
+
+    // the table name, alone and with a tag condition, the names in the list are prefixed by the database
+    checkAgainstFullScan(NULL, "IN|db.idx_t3,db.idx_t50,db.idx_t7,db.idx_t3,db.idx_t1000", 3);
+    checkAgainstFullScan(NULL, "LIKE|idx_t1%", 1);
+    checkAgainstFullScan(intTagExpr(TSDB_RELATION_GREATER_EQUAL, 4), "IN|db.idx_t5,db.idx_t6,db.idx_t13,db.idx_t4", 1);
+  }
+
+  char *       rootDir = NULL;
+  STSchema *   schema = NULL;
+  STSchema *   tagSchema = NULL;
+  TSDB_REPO_T *repo = NULL;
+};
+
+}  // namespace
+
+TEST_F(TagIndexTest, lookupMatchesFullScan) {
+  checkLookups();
+
+  STable *pSTable = tsdbGetTableByUid(tsdbGetMeta(repo), TEST_SUPER_UID);
+  ASSERT_NE(pSTable, nullptr);
+  EXPECT_NE(pSTable->pTagIndex, nullptr);
+}
+
+TEST_F(TagIndexTest, lookupAfterTablesChange) {
+  // build the indexes first
+  checkLookups();
+
+  // tables added and dropped after the indexes are built
+  for (int tid = TEST_TABLES + 1; tid <= TEST_TABLES + 30; tid++) {
+    createTable(tid);
+  }
+  for (int tid = 2; tid <= TEST_TABLES; tid += 9) {
+    STableId tableId = {.uid = tableUid(tid), .tid = tid};
+    ASSERT_EQ(tsdbDropTable(repo, tableId), 0);
+  }
+
+  // tag values set after the indexes are built, from and to NULL as well, a missing tag can not be set
+  for (int tid = 1; tid <= TEST_TABLES; tid += 7) {
+    if (tid % 9 == 2) continue;  // dropped
+
+    if (!t2IsNull(tid)) {
+      int32_t t2 = (tid % 3 == 0) ? TSDB_DATA_INT_NULL : t2Value(tid) + 5;
+      ASSERT_EQ(updateTagValue(repo, tid, T2_COLID, TSDB_DATA_TYPE_INT, &t2, sizeof(t2)), 0);
+    }
+
+    char        t3[T3_BYTES + VARSTR_HEADER_SIZE];
+    std::string val = "Beta" + std::to_string(tid * 3);
+    STR_TO_VARSTR(t3, val.c_str());
+    ASSERT_EQ(updateTagValue(repo, tid, T3_COLID, TSDB_DATA_TYPE_BINARY, t3, varDataTLen(t3)), 0);
+  }
+
+  checkLookups();
+}
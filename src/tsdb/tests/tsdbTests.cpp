@@ -68,7 +68,7 @@ static int insertData(SInsertInfo *pInfo) {
     pMsg->numOfBlocks = 1;
 
     pBlock->dataLen = htonl(pBlock->dataLen);
-    pBlock->numOfRows = htonl(pBlock->numOfRows);
+    pBlock->numOfRows = htons(pBlock->numOfRows);
     pBlock->schemaLen = htonl(pBlock->schemaLen);
     pBlock->uid = htobe64(pBlock->uid);
     pBlock->tid = htonl(pBlock->tid);
@@ -95,6 +95,7 @@ static int insertData(SInsertInfo *pInfo) {
 static void tsdbSetCfg(STsdbCfg *pCfg, int32_t tsdbId, int32_t cacheBlockSize, int32_t totalBlocks, int32_t maxTables,
                        int32_t daysPerFile, int32_t keep, int32_t minRows, int32_t maxRows, int8_t precision,
                        int8_t compression) {
+  memset((void *)pCfg, 0, sizeof(*pCfg));
   pCfg->tsdbId = tsdbId;
   pCfg->cacheBlockSize = cacheBlockSize;
   pCfg->totalBlocks = totalBlocks;
@@ -133,7 +134,7 @@ TEST(TsdbTest, testInsertSpeed) {
   int         ret = 0;
   STsdbCfg    tsdbCfg;
   STableCfg   tableCfg;
-  std::string testDir = "./test";
+  std::string testDir = ".";
   char *      rootDir = strdup((testDir + "/vnode" + std::to_string(vnode)).c_str());
 
   tsdbDebugFlag = 131; //NOTE: you must set the flag
@@ -148,14 +149,75 @@ TEST(TsdbTest, testInsertSpeed) {
 
   // Create table
   tsdbSetTableCfg(&tableCfg);
-  tsdbCreateTable(repo, &tableCfg);
+  ASSERT_EQ(tsdbCreateTable(repo, &tableCfg), 0);
 
   // Insert data
-  SInsertInfo iInfo = {repo, true, 1, 5849583783847394, 0, 1590000000000, 10, 10000000, 100, tableCfg.schema};
+  SInsertInfo iInfo = {repo, true, 1, 5849583783847394, 0, 1590000000000, 10, 1000000, 100, tableCfg.schema};
 
-  insertData(&iInfo);
+  ASSERT_EQ(insertData(&iInfo), 0);
 
   tsdbCloseRepo(repo, 1);
+  tdFreeSchema(tableCfg.schema);
+  free(tableCfg.name);
+  taosRemoveDir(rootDir);
+  free(rootDir);
+}
+
+TEST(TsdbTest, appendRowsInKeyOrder) {
+  STsdbCfg  tsdbCfg;
+  STableCfg tableCfg;
+  char *    rootDir = strdup("./vnode_append");
+
+  taosRemoveDir(rootDir);
+
+  tsdbSetCfg(&tsdbCfg, 1, 16, 4, -1, -1, -1, -1, -1, -1, -1);
+  ASSERT_EQ(tsdbCreateRepo(rootDir, &tsdbCfg), 0);
+  TSDB_REPO_T *repo = tsdbOpenRepo(rootDir, NULL);
+  ASSERT_NE(repo, nullptr);
+
+  tsdbSetTableCfg(&tableCfg);
+  ASSERT_EQ(tsdbCreateTable(repo, &tableCfg), 0);
+
+  // rows above the last key of the table are appended, the rows put in the gaps between them are not
+  TSKEY       start = 1590000000000;
+  SInsertInfo iInfo = {repo, true, 1, 5849583783847394, 0, start, 10, 1000, 100, tableCfg.schema};
+  ASSERT_EQ(insertData(&iInfo), 0);
+
+  iInfo.startTime = start + 5;
+  iInfo.totalRows = 100;
+  ASSERT_EQ(insertData(&iInfo), 0);
+
+  iInfo.startTime = start + 20000;
+  ASSERT_EQ(insertData(&iInfo), 0);
+
+  int64_t pointsWritten = 0, totalStorage = 0, compStorage = 0, rowsAppended = 0, rowsInserted = 0;
+  tsdbReportStat(repo, &pointsWritten, &totalStorage, &compStorage, &rowsAppended, &rowsInserted);
+  EXPECT_EQ(rowsAppended, 1100);
+  EXPECT_EQ(rowsInserted, 100);
+
+  STableData *pTableData = ((STsdbRepo *)repo)->mem->tData[1];
+  ASSERT_NE(pTableData, nullptr);
+  EXPECT_EQ(pTableData->numOfRows, 1200);
+  EXPECT_EQ(pTableData->keyFirst, start + 10);
+  EXPECT_EQ(pTableData->keyLast, start + 21000);
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pTableData->pData);
+  TSKEY              lastKey = 0;
+  int                numOfRows = 0;
+  while (tSkipListIterNext(pIter)) {
+    SDataRow row = *(SDataRow *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    EXPECT_GT(dataRowKey(row), lastKey);
+    lastKey = dataRowKey(row);
+    numOfRows++;
+  }
+  tSkipListDestroyIter(pIter);
+  EXPECT_EQ(numOfRows, 1200);
+
+  tsdbCloseRepo(repo, 0);
+  tdFreeSchema(tableCfg.schema);
+  free(tableCfg.name);
+  taosRemoveDir(rootDir);
+  free(rootDir);
 }
 
 static char *getTKey(const void *data) {
@@ -38,6 +38,8 @@ extern int tsCompressINTImp(const char *const input, const int nelements, char *
 extern int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsCompressBoolImp(const char *const input, const int nelements, char *const output);
 extern int tsDecompressBoolImp(const char *const input, const int nelements, char *const output);
+extern int tsCompressBoolRLEImp(const char *const input, const int nelements, char *const output);
+extern int tsDecompressBoolRLEImp(const char *const input, const int nelements, char *const output);
 extern int tsCompressStringImp(const char *const input, int inputSize, char *const output, int outputSize);
 extern int tsDecompressStringImp(const char *const input, int compressedSize, char *const output, int outputSize);
 extern int tsCompressTimestampImp(const char *const input, const int nelements, char *const output);
@@ -47,6 +49,9 @@ extern int tsDecompressDoubleImp(const char *const input, const int nelements, c
 extern int tsCompressFloatImp(const char *const input, const int nelements, char *const output);
 extern int tsDecompressFloatImp(const char *const input, const int nelements, char *const output);
 
+// pick the SIMD decode kernels if useSimd is set and the CPU supports them, returns true if they are used
+extern bool taosResolveDecompress(bool useSimd);
+
 static FORCE_INLINE int tsCompressTinyint(const char *const input, int inputSize, const int nelements, char *const output, int outputSize, char algorithm,
                       char *const buffer, int bufferSize) {
   if (algorithm == ONE_STAGE_COMP) {
@@ -53,6 +53,11 @@
 #include "tscompression.h"
 #include "tulog.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TSDB_DECODE_AVX2
+#include <immintrin.h>
+#endif
+
 static const int TEST_NUMBER = 1;
 #define is_bigendian() ((*(char *)&TEST_NUMBER) == 0)
 #define SIMPLE8B_MAX_INT64 ((uint64_t)2305843009213693951L)
@@ -61,6 +66,15 @@ static const int TEST_NUMBER = 1;
 #define ZIGZAG_ENCODE(T, v) ((u##T)((v) >> (sizeof(T) * 8 - 1))) ^ (((u##T)(v)) << 1)  // zigzag encode
 #define ZIGZAG_DECODE(T, v) ((v) >> 1) ^ -((T)((v)&1))                                 // zigzag decode
 
+// Decode kernels, switched to the SIMD versions by taosResolveDecompress if the CPU supports them
+static void tsDecodeSimple8bScalar(const char *ip, const int nelements, char *const output, const char type);
+static int  tsDecodeTimestampScalar(const char *const input, const int nelements, char *const output);
+
+static void (*tsDecodeSimple8b)(const char *ip, const int nelements, char *const output,
+                                const char type) = tsDecodeSimple8bScalar;
+static int (*tsDecodeTimestamp)(const char *const input, const int nelements,
+                                char *const output) = tsDecodeTimestampScalar;
+
 /*
  * Compress Integer (Simple8B).
  */
@@ -220,12 +234,16 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
     return nelements * word_length;
   }
 
+  (*tsDecodeSimple8b)(input + 1, nelements, output, type);
+  return nelements * word_length;
+}
+
+static void tsDecodeSimple8bScalar(const char *ip, const int nelements, char *const output, const char type) {
   // Selector value:              0    1   2   3   4   5   6   7   8  9  10  11
   // 12  13  14  15
   char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
   int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
 
-  const char *ip = input + 1;
   int         count = 0;
   int         _pos = 0;
   int64_t     prev_value = 0;
@@ -269,19 +287,163 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
           *((int8_t *)output + _pos) = (int8_t)curr_value;
           _pos++;
           break;
-        default:
-          perror("Wrong integer types.\n");
-          return -1;
       }
       count++;
       if (count == nelements) break;
     }
     ip += LONG_BYTES;
   }
+}
 
-  return nelements * word_length;
+#ifdef TSDB_DECODE_AVX2
+/*
+ * Narrows four decoded values to the column type and stores them at output[pos], all in registers. The values of a
+ * simple8b word are stored four at a time even if the word holds fewer, the surplus lanes are overwritten by the
+ * next word, so only the last group of a block, which may not write beyond nelements, is stored one by one.
+ */
+__attribute__((target("avx2")))
+static FORCE_INLINE void tsStoreDecodedInts(char *const output, int pos, __m256i v, const char type) {
+  const __m256i lowDwords = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  __m128i       low;
+  int32_t       packed;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_BIGINT:
+      _mm256_storeu_si256((__m256i *)((int64_t *)output + pos), v);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      low = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, lowDwords));
+      _mm_storeu_si128((__m128i *)((int32_t *)output + pos), low);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      low = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, lowDwords));
+      low = _mm_shuffle_epi8(low, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+      _mm_storel_epi64((__m128i *)((int16_t *)output + pos), low);
+      break;
+    case TSDB_DATA_TYPE_TINYINT:
+      low = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, lowDwords));
+      packed = _mm_cvtsi128_si32(_mm_shuffle_epi8(low, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                                        -1, -1, -1)));
+      memcpy((int8_t *)output + pos, &packed, sizeof(packed));
+      break;
+  }
+}
+
+__attribute__((target("avx2")))
+static void tsStoreDecodedIntsTail(char *const output, int pos, __m256i v, int n, const char type) {
+  int64_t values[4];
+  _mm256_storeu_si256((__m256i *)values, v);
+
+  for (int i = 0; i < n; i++) {
+    switch (type) {
+      case TSDB_DATA_TYPE_BIGINT:
+        *((int64_t *)output + pos + i) = values[i];
+        break;
+      case TSDB_DATA_TYPE_INT:
+        *((int32_t *)output + pos + i) = (int32_t)values[i];
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        *((int16_t *)output + pos + i) = (int16_t)values[i];
+        break;
+      case TSDB_DATA_TYPE_TINYINT:
+        *((int8_t *)output + pos + i) = (int8_t)values[i];
+        break;
+    }
+  }
 }
 
+/*
+ * Four values of a simple8b word are extracted with variable shifts, zigzag decoded and prefix summed in one
+ * 256-bit register, instead of one by one. It is inlined once per column type, so the stores are not dispatched
+ * per group.
+ */
+__attribute__((target("avx2")))
+static FORCE_INLINE void tsDecodeSimple8bAVX2Impl(const char *ip, const int nelements, char *const output,
+                                                  const char type) {
+  static const char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+  static const int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi64x(1);
+  int           count = 0;
+  __m256i       prev = zero;
+
+  // broadcast the n-th value of a group as the base of the next group
+  const __m256i lastLane[4] = {_mm256_setr_epi32(0, 1, 0, 1, 0, 1, 0, 1), _mm256_setr_epi32(2, 3, 2, 3, 2, 3, 2, 3),
+                               _mm256_setr_epi32(4, 5, 4, 5, 4, 5, 4, 5), _mm256_setr_epi32(6, 7, 6, 7, 6, 7, 6, 7)};
+
+  while (count < nelements) {
+    uint64_t w = 0;
+    memcpy(&w, ip, LONG_BYTES);
+    ip += LONG_BYTES;
+
+    int selector = (int)(w & INT64MASK(4));
+    int bit = bit_per_integer[selector];
+    int elems = MIN(selector_to_elems[selector], nelements - count);
+
+    if (selector == 0 || selector == 1) {
+      // all the differences are zero
+      for (int i = 0; i < elems; i += 4) {
+        if (count + i + 4 <= nelements) {
+          tsStoreDecodedInts(output, count + i, prev, type);
+        } else {
+          tsStoreDecodedIntsTail(output, count + i, prev, elems - i, type);
+        }
+      }
+
+      count += elems;
+      continue;
+    }
+
+    const __m256i word = _mm256_set1_epi64x((int64_t)w);
+    const __m256i mask = _mm256_set1_epi64x((int64_t)INT64MASK(bit));
+    const __m256i step = _mm256_set1_epi64x(4 * bit);
+    __m256i       shift = _mm256_setr_epi64x(4, 4 + bit, 4 + 2 * bit, 4 + 3 * bit);
+
+    for (int i = 0; i < elems; i += 4) {
+      __m256i v = _mm256_and_si256(_mm256_srlv_epi64(word, shift), mask);
+      v = _mm256_xor_si256(_mm256_srli_epi64(v, 1), _mm256_sub_epi64(zero, _mm256_and_si256(v, one)));
+
+      // inclusive prefix sum of the four differences
+      v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+      v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+      v = _mm256_add_epi64(v, prev);
+
+      int n = MIN(4, elems - i);
+      if (count + i + 4 <= nelements) {
+        tsStoreDecodedInts(output, count + i, v, type);
+      } else {
+        tsStoreDecodedIntsTail(output, count + i, v, n, type);
+      }
+
+      prev = (n == 4) ? _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3))
+                      : _mm256_permutevar8x32_epi32(v, lastLane[n - 1]);
+      shift = _mm256_add_epi64(shift, step);
+    }
+
+    count += elems;
+  }
+}
+
+__attribute__((target("avx2")))
+static void tsDecodeSimple8bAVX2(const char *ip, const int nelements, char *const output, const char type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BIGINT:
+      tsDecodeSimple8bAVX2Impl(ip, nelements, output, TSDB_DATA_TYPE_BIGINT);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      tsDecodeSimple8bAVX2Impl(ip, nelements, output, TSDB_DATA_TYPE_INT);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      tsDecodeSimple8bAVX2Impl(ip, nelements, output, TSDB_DATA_TYPE_SMALLINT);
+      break;
+    case TSDB_DATA_TYPE_TINYINT:
+      tsDecodeSimple8bAVX2Impl(ip, nelements, output, TSDB_DATA_TYPE_TINYINT);
+      break;
+  }
+}
+#endif
+
 /* ----------------------------------------------Bool Compression
  * ---------------------------------------------- */
 // TODO: You can also implement it using RLE method.
@@ -320,7 +482,21 @@ int tsDecompressBoolImp(const char *const input, const int nelements, char *cons
   int ipos = -1, opos = 0;
   int ele_per_byte = BITS_PER_BYTE / 2;
 
-  for (int i = 0; i < nelements; i++) {
+  // decode the four 2-bit values of each full byte at once: spread them into the four bytes of a word, then clear
+  // the ones with both bits set
+  if (!is_bigendian()) {
+    int nbytes = nelements / ele_per_byte;
+    for (int i = 0; i < nbytes; i++) {
+      uint32_t b = (uint8_t)input[i];
+      uint32_t v = (b & 0x3) | ((b & 0xc) << 6) | ((b & 0x30) << 12) | ((b & 0xc0) << 18);
+      v &= ~((v & (v >> 1) & 0x01010101) * 0x3);
+      memcpy(output + opos, &v, sizeof(v));
+      opos += ele_per_byte;
+    }
+    ipos = nbytes - 1;
+  }
+
+  for (int i = opos; i < nelements; i++) {
     if (i % ele_per_byte == 0) {
       ipos++;
     }
@@ -532,67 +708,169 @@ int tsDecompressTimestampImp(const char *const input, const int nelements, char
     memcpy(output, input + 1, nelements * LONG_BYTES);
     return nelements * LONG_BYTES;
   } else if (input[0] == 1) {  // Decompress
-    int64_t *ostream = (int64_t *)output;
-
-    int     ipos = 1, opos = 0;
-    int8_t  nbytes = 0;
-    int64_t prev_value = 0;
-    int64_t prev_delta = 0;
-    int64_t delta_of_delta = 0;
-
-    while (1) {
-      uint8_t flags = input[ipos++];
-      // Decode dd1
-      uint64_t dd1 = 0;
-      nbytes = flags & INT8MASK(4);
-      if (nbytes == 0) {
-        delta_of_delta = 0;
+    return (*tsDecodeTimestamp)(input, nelements, output);
+  } else {
+    assert(0);
+    return -1;
+  }
+}
+
+static int tsDecodeTimestampScalar(const char *const input, const int nelements, char *const output) {
+  int64_t *ostream = (int64_t *)output;
+
+  int     ipos = 1, opos = 0;
+  int8_t  nbytes = 0;
+  int64_t prev_value = 0;
+  int64_t prev_delta = 0;
+  int64_t delta_of_delta = 0;
+
+  while (1) {
+    uint8_t flags = input[ipos++];
+    // Decode dd1
+    uint64_t dd1 = 0;
+    nbytes = flags & INT8MASK(4);
+    if (nbytes == 0) {
+      delta_of_delta = 0;
+    } else {
+      if (is_bigendian()) {
+        memcpy(((char *)(&dd1)) + LONG_BYTES - nbytes, input + ipos, nbytes);
       } else {
-        if (is_bigendian()) {
-          memcpy(((char *)(&dd1)) + LONG_BYTES - nbytes, input + ipos, nbytes);
-        } else {
-          memcpy(&dd1, input + ipos, nbytes);
-        }
-        delta_of_delta = ZIGZAG_DECODE(int64_t, dd1);
+        memcpy(&dd1, input + ipos, nbytes);
       }
-      ipos += nbytes;
-      if (opos == 0) {
-        prev_value = delta_of_delta;
-        prev_delta = 0;
-        ostream[opos++] = delta_of_delta;
+      delta_of_delta = ZIGZAG_DECODE(int64_t, dd1);
+    }
+    ipos += nbytes;
+    if (opos == 0) {
+      prev_value = delta_of_delta;
+      prev_delta = 0;
+      ostream[opos++] = delta_of_delta;
+    } else {
+      prev_delta = delta_of_delta + prev_delta;
+      prev_value = prev_value + prev_delta;
+      ostream[opos++] = prev_value;
+    }
+    if (opos == nelements) return nelements * LONG_BYTES;
+
+    // Decode dd2
+    uint64_t dd2 = 0;
+    nbytes = (flags >> 4) & INT8MASK(4);
+    if (nbytes == 0) {
+      delta_of_delta = 0;
+    } else {
+      if (is_bigendian()) {
+        memcpy(((char *)(&dd2)) + LONG_BYTES - nbytes, input + ipos, nbytes);
       } else {
-        prev_delta = delta_of_delta + prev_delta;
-        prev_value = prev_value + prev_delta;
-        ostream[opos++] = prev_value;
+        memcpy(&dd2, input + ipos, nbytes);
       }
-      if (opos == nelements) return nelements * LONG_BYTES;
+      // zigzag_decoding
+      delta_of_delta = ZIGZAG_DECODE(int64_t, dd2);
+    }
+    ipos += nbytes;
+    prev_delta = delta_of_delta + prev_delta;
+    prev_value = prev_value + prev_delta;
+    ostream[opos++] = prev_value;
+    if (opos == nelements) return nelements * LONG_BYTES;
+  }
+}
 
-      // Decode dd2
-      uint64_t dd2 = 0;
-      nbytes = (flags >> 4) & INT8MASK(4);
-      if (nbytes == 0) {
-        delta_of_delta = 0;
-      } else {
-        if (is_bigendian()) {
-          memcpy(((char *)(&dd2)) + LONG_BYTES - nbytes, input + ipos, nbytes);
-        } else {
-          memcpy(&dd2, input + ipos, nbytes);
+#ifdef TSDB_DECODE_AVX2
+/*
+ * A zero flag byte holds two zero delta-of-deltas, so a run of them continues the current delta. Such runs, the
+ * common case of regularly sampled data, are found 16 flags at a time and written out as an arithmetic progression
+ * four timestamps per store. Other flags are decoded one pair at a time as in the scalar version.
+ */
+__attribute__((target("avx2")))
+static int tsDecodeTimestampAVX2(const char *const input, const int nelements, char *const output) {
+  int64_t *ostream = (int64_t *)output;
+
+  int     ipos = 1, opos = 0;
+  int8_t  nbytes = 0;
+  int64_t prev_value = 0;
+  int64_t prev_delta = 0;
+  int64_t delta_of_delta = 0;
+  uint8_t flags = 1;
+
+  while (1) {
+    // at least one flag byte exists for every two timestamps left, so 16 bytes can be read safely here
+    if (flags == 0 && nelements - opos >= 32) {
+      __m128i flags = _mm_loadu_si128((const __m128i *)(input + ipos));
+      int     zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(flags, _mm_setzero_si128()));
+      int     run = __builtin_ctz(~zeros);
+
+      if (run > 0) {
+        int     n = run * 2;
+        __m256i step = _mm256_set1_epi64x(prev_delta * 4);
+        __m256i v = _mm256_add_epi64(_mm256_set1_epi64x(prev_value),
+                                     _mm256_setr_epi64x(prev_delta, prev_delta * 2, prev_delta * 3, prev_delta * 4));
+        int k = 0;
+        for (; k + 4 <= n; k += 4) {
+          _mm256_storeu_si256((__m256i *)(ostream + opos + k), v);
+          v = _mm256_add_epi64(v, step);
         }
-        // zigzag_decoding
-        delta_of_delta = ZIGZAG_DECODE(int64_t, dd2);
+        if (k < n) _mm_storeu_si128((__m128i *)(ostream + opos + k), _mm256_castsi256_si128(v));
+
+        opos += n;
+        ipos += run;
+        prev_value = ostream[opos - 1];
+        if (opos == nelements) return nelements * LONG_BYTES;
       }
-      ipos += nbytes;
+    }
+
+    flags = input[ipos++];
+    // Decode dd1
+    uint64_t dd1 = 0;
+    nbytes = flags & INT8MASK(4);
+    if (nbytes == 0) {
+      delta_of_delta = 0;
+    } else {
+      memcpy(&dd1, input + ipos, nbytes);
+      delta_of_delta = ZIGZAG_DECODE(int64_t, dd1);
+    }
+    ipos += nbytes;
+    if (opos == 0) {
+      prev_value = delta_of_delta;
+      prev_delta = 0;
+      ostream[opos++] = delta_of_delta;
+    } else {
       prev_delta = delta_of_delta + prev_delta;
       prev_value = prev_value + prev_delta;
       ostream[opos++] = prev_value;
-      if (opos == nelements) return nelements * LONG_BYTES;
     }
+    if (opos == nelements) return nelements * LONG_BYTES;
 
-  } else {
-    assert(0);
-    return -1;
+    // Decode dd2
+    uint64_t dd2 = 0;
+    nbytes = (flags >> 4) & INT8MASK(4);
+    if (nbytes == 0) {
+      delta_of_delta = 0;
+    } else {
+      memcpy(&dd2, input + ipos, nbytes);
+      delta_of_delta = ZIGZAG_DECODE(int64_t, dd2);
+    }
+    ipos += nbytes;
+    prev_delta = delta_of_delta + prev_delta;
+    prev_value = prev_value + prev_delta;
+    ostream[opos++] = prev_value;
+    if (opos == nelements) return nelements * LONG_BYTES;
   }
 }
+#endif
+
+bool taosResolveDecompress(bool useSimd) {
+#ifdef TSDB_DECODE_AVX2
+  __builtin_cpu_init();
+  if (useSimd && __builtin_cpu_supports("avx2")) {
+    tsDecodeSimple8b = tsDecodeSimple8bAVX2;
+    tsDecodeTimestamp = tsDecodeTimestampAVX2;
+    return true;
+  }
+#endif
+
+  tsDecodeSimple8b = tsDecodeSimple8bScalar;
+  tsDecodeTimestamp = tsDecodeTimestampScalar;
+  return false;
+}
+
 /* --------------------------------------------Double Compression
  * ---------------------------------------------- */
 void encodeDoubleValue(uint64_t diff, uint8_t flag, char *const output, int *const pos) {
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tscompression.h"
+
+/*
+ * Benchmark of all the codecs in tcompression.c over generated time-series shapes, at one-stage and two-stage
+ * compression. One CSV line is printed per codec, shape and algorithm:
+ *   codec,shape,algorithm,rows,raw_bytes,compressed_bytes,ratio,compress_mbps,decompress_mbps,scalar_decompress_mbps,
+ *   verified
+ * decompress_mbps is measured with the SIMD decode kernels if the CPU supports them and -s is not given,
+ * scalar_decompress_mbps with the scalar ones. The columns of the mode not run are left empty.
+ */
+
+enum {
+  BENCH_MODE_ALL = 0,
+  BENCH_MODE_COMPRESS,
+  BENCH_MODE_DECOMPRESS,
+};
+
+typedef int (*FCompress)(const char *const input, int inputSize, const int nelements, char *const output,
+                         int outputSize, char algorithm, char *const buffer, int bufferSize);
+typedef int (*FDecompress)(const char *const input, int compressedSize, const int nelements, char *const output,
+                           int outputSize, char algorithm, char *const buffer, int bufferSize);
+typedef int (*FGenerate)(char *data, int rows);  // returns the number of bytes generated
+
+typedef struct {
+  const char *codec;
+  const char *shape;
+  FCompress   compFp;
+  FDecompress decompFp;
+  FGenerate   genFp;
+} SBenchCase;
+
+// the RLE bool codec has no wrapper in tscompression.h
+static int compressBoolRLE(const char *const input, int inputSize, const int nelements, char *const output,
+                           int outputSize, char algorithm, char *const buffer, int bufferSize) {
+  if (algorithm == ONE_STAGE_COMP) return tsCompressBoolRLEImp(input, nelements, output);
+
+  int len = tsCompressBoolRLEImp(input, nelements, buffer);
+  return tsCompressStringImp(buffer, len, output, outputSize);
+}
+
+static int decompressBoolRLE(const char *const input, int compressedSize, const int nelements, char *const output,
+                             int outputSize, char algorithm, char *const buffer, int bufferSize) {
+  if (algorithm == ONE_STAGE_COMP) return tsDecompressBoolRLEImp(input, nelements, output);
+
+  if (tsDecompressStringImp(input, compressedSize, buffer, bufferSize) < 0) return -1;
+  return tsDecompressBoolRLEImp(buffer, nelements, output);
+}
+
+static double noise(double scale) { return ((double)rand() / RAND_MAX - 0.5) * scale; }
+
+static int genCounter(char *data, int rows) {
+  int64_t *p = (int64_t *)data;
+  int64_t  v = 1000000;
+  for (int i = 0; i < rows; i++) {
+    v += rand() % 100;
+    p[i] = v;
+  }
+  return rows * sizeof(int64_t);
+}
+
+static int genIntGauge(char *data, int rows) {
+  int32_t *p = (int32_t *)data;
+  for (int i = 0; i < rows; i++) p[i] = (int32_t)(220 + 10 * sin(i / 100.0) + noise(4));
+  return rows * sizeof(int32_t);
+}
+
+static int genSmallintGauge(char *data, int rows) {
+  int16_t *p = (int16_t *)data;
+  for (int i = 0; i < rows; i++) p[i] = (int16_t)(500 + noise(50));
+  return rows * sizeof(int16_t);
+}
+
+static int genTinyintState(char *data, int rows) {
+  int8_t *p = (int8_t *)data;
+  int8_t  state = 0;
+  for (int i = 0; i < rows; i++) {
+    if (rand() % 50 == 0) state = rand() % 4;
+    p[i] = state;
+  }
+  return rows * sizeof(int8_t);
+}
+
+static int genSparseBool(char *data, int rows) {
+  for (int i = 0; i < rows; i++) data[i] = (rand() % 100 == 0) ? 1 : 0;
+  return rows;
+}
+
+static int genFloatGauge(char *data, int rows) {
+  float *p = (float *)data;
+  for (int i = 0; i < rows; i++) p[i] = (float)(25.0 + 3 * sin(i / 500.0) + noise(0.2));
+  return rows * sizeof(float);
+}
+
+static int genDoubleGauge(char *data, int rows) {
+  double *p = (double *)data;
+  for (int i = 0; i < rows; i++) p[i] = 101.325 + noise(0.05);
+  return rows * sizeof(double);
+}
+
+static int genRegularTimestamp(char *data, int rows) {
+  int64_t *p = (int64_t *)data;
+  for (int i = 0; i < rows; i++) p[i] = 1600000000000L + i * 1000L;
+  return rows * sizeof(int64_t);
+}
+
+static int genJitteredTimestamp(char *data, int rows) {
+  int64_t *p = (int64_t *)data;
+  int64_t  ts = 1600000000000L;
+  for (int i = 0; i < rows; i++) {
+    ts += 1000 + rand() % 20 - 10;
+    p[i] = ts;
+  }
+  return rows * sizeof(int64_t);
+}
+
+// binary column data as it is laid out in a block: length prefixed strings back to back
+static int genRepetitiveString(char *data, int rows) {
+  static const char *words[] = {"beijing.chaoyang", "beijing.haidian", "shanghai.pudong", "shenzhen.nanshan"};
+  char *p = data;
+  for (int i = 0; i < rows; i++) {
+    const char *w = words[(i / 64) % tListLen(words)];
+    varDataSetLen(p, strlen(w));
+    memcpy(varDataVal(p), w, strlen(w));
+    p += varDataTLen(p);
+  }
+  return (int)(p - data);
+}
+
+static SBenchCase benchCases[] = {
+    {"tinyint", "state", tsCompressTinyint, tsDecompressTinyint, genTinyintState},
+    {"smallint", "noisy_gauge", tsCompressSmallint, tsDecompressSmallint, genSmallintGauge},
+    {"int", "noisy_gauge", tsCompressInt, tsDecompressInt, genIntGauge},
+    {"bigint", "monotonic_counter", tsCompressBigint, tsDecompressBigint, genCounter},
+    {"bool", "sparse", tsCompressBool, tsDecompressBool, genSparseBool},
+    {"bool_rle", "sparse", compressBoolRLE, decompressBoolRLE, genSparseBool},
+    {"float", "noisy_gauge", tsCompressFloat, tsDecompressFloat, genFloatGauge},
+    {"double", "noisy_gauge", tsCompressDouble, tsDecompressDouble, genDoubleGauge},
+    {"timestamp", "regular", tsCompressTimestamp, tsDecompressTimestamp, genRegularTimestamp},
+    {"timestamp", "jittered", tsCompressTimestamp, tsDecompressTimestamp, genJitteredTimestamp},
+    {"string", "repetitive", tsCompressString, tsDecompressString, genRepetitiveString},
+};
+
+static int64_t timeDecompress(SBenchCase *pCase, const char *comp, int compBytes, int rows, char *output, int bufSize,
+                              char algorithm, char *buffer, int rounds, int *outBytes) {
+  int64_t st = taosGetTimestampUs();
+  for (int i = 0; i < rounds; i++) {
+    *outBytes = (*pCase->decompFp)(comp, compBytes, rows, output, bufSize, algorithm, buffer, bufSize);
+  }
+
+  return MAX(taosGetTimestampUs() - st, 1);
+}
+
+static void runCase(FILE *fp, SBenchCase *pCase, char algorithm, int rows, int rounds, int mode, bool useSimd) {
+  int   size = rows * (sizeof(int64_t) + VARSTR_HEADER_SIZE + 16);
+  int   bufSize = size * 2 + 1024;
+  char *input = calloc(1, size);
+  char *output = calloc(1, bufSize);
+  char *comp = calloc(1, bufSize);
+  char *buffer = calloc(1, bufSize);
+
+  srand(1);
+  int    rawBytes = (*pCase->genFp)(input, rows);
+  double total = (double)rawBytes * rounds / 1048576.0;
+
+  // the decompress mode still compresses once to get its input
+  int     compBytes = 0;
+  int     compRounds = (mode == BENCH_MODE_DECOMPRESS) ? 1 : rounds;
+  int64_t st = taosGetTimestampUs();
+  for (int i = 0; i < compRounds; i++) {
+    compBytes = (*pCase->compFp)(input, rawBytes, rows, comp, bufSize, algorithm, buffer, bufSize);
+  }
+  int64_t compTime = MAX(taosGetTimestampUs() - st, 1);
+
+  char compMbps[32] = {0};
+  if (mode != BENCH_MODE_DECOMPRESS) snprintf(compMbps, sizeof(compMbps), "%.2f", total / (compTime / 1000000.0));
+
+  char decompMbps[32] = {0};
+  char scalarMbps[32] = {0};
+  int  outBytes = 0;
+  bool verified = true;
+  if (mode != BENCH_MODE_COMPRESS) {
+    taosResolveDecompress(false);
+    int64_t scalarTime = timeDecompress(pCase, comp, compBytes, rows, output, bufSize, algorithm, buffer, rounds,
+                                        &outBytes);
+    verified = (outBytes == rawBytes) && (memcmp(input, output, rawBytes) == 0);
+    snprintf(scalarMbps, sizeof(scalarMbps), "%.2f", total / (scalarTime / 1000000.0));
+
+    memset(output, 0, bufSize);
+    taosResolveDecompress(useSimd);
+    int64_t decompTime = timeDecompress(pCase, comp, compBytes, rows, output, bufSize, algorithm, buffer, rounds,
+                                        &outBytes);
+    verified = verified && (outBytes == rawBytes) && (memcmp(input, output, rawBytes) == 0);
+    snprintf(decompMbps, sizeof(decompMbps), "%.2f", total / (decompTime / 1000000.0));
+  } else {  // decode once to verify the compressed data
+    taosResolveDecompress(useSimd);
+    timeDecompress(pCase, comp, compBytes, rows, output, bufSize, algorithm, buffer, 1, &outBytes);
+    verified = (outBytes == rawBytes) && (memcmp(input, output, rawBytes) == 0);
+  }
+
+  fprintf(fp, "%s,%s,%s,%d,%d,%d,%.3f,%s,%s,%s,%d\n", pCase->codec, pCase->shape,
+          (algorithm == ONE_STAGE_COMP) ? "one_stage" : "two_stage", rows, rawBytes, compBytes,
+          compBytes > 0 ? (double)rawBytes / compBytes : 0, compMbps, decompMbps, scalarMbps, verified);
+
+  free(input);
+  free(output);
+  free(comp);
+  free(buffer);
+}
+
+static void printUsage(const char *name) {
+  printf("usage: %s [-m all|compress|decompress] [-r rows] [-n rounds] [-o output.csv] [-s]\n", name);
+  printf("  -m  codec direction to measure, default all\n");
+  printf("  -r  rows of a data block, default 4096\n");
+  printf("  -n  compress and decompress rounds per case, default 2000\n");
+  printf("  -o  write the CSV to the file instead of stdout\n");
+  printf("  -s  use the scalar decode kernels for decompress_mbps too\n");
+}
+
+int main(int argc, char *argv[]) {
+  int   rows = 4096;
+  int   rounds = 2000;
+  int   mode = BENCH_MODE_ALL;
+  bool  useSimd = true;
+  FILE *fp = stdout;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-m") == 0 && i < argc - 1) {
+      ++i;
+      if (strcmp(argv[i], "all") == 0) {
+        mode = BENCH_MODE_ALL;
+      } else if (strcmp(argv[i], "compress") == 0) {
+        mode = BENCH_MODE_COMPRESS;
+      } else if (strcmp(argv[i], "decompress") == 0) {
+        mode = BENCH_MODE_DECOMPRESS;
+      } else {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-r") == 0 && i < argc - 1) {
+      rows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      rounds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-o") == 0 && i < argc - 1) {
+      fp = fopen(argv[++i], "w");
+      if (fp == NULL) {
+        printf("failed to open %s(%s)\n", argv[i], strerror(errno));
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-s") == 0) {
+      useSimd = false;
+    } else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (rows <= 0 || rounds <= 0) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  fprintf(fp, "codec,shape,algorithm,rows,raw_bytes,compressed_bytes,ratio,compress_mbps,decompress_mbps,"
+              "scalar_decompress_mbps,verified\n");
+  for (int i = 0; i < tListLen(benchCases); ++i) {
+    runCase(fp, benchCases + i, ONE_STAGE_COMP, rows, rounds, mode, useSimd);
+    runCase(fp, benchCases + i, TWO_STAGE_COMP, rows, rounds, mode, useSimd);
+  }
+
+  if (fp != stdout) fclose(fp);
+  return 0;
+}
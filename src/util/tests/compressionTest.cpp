@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tscompression.h"
+
+namespace {
+
+const int kElems = 4096 + 13;
+
+// decode with both the scalar and the SIMD kernels and compare against the input
+template <typename T>
+void checkInt(const T *data, int nelements, char type) {
+  char *comp = (char *)malloc(nelements * sizeof(T) + 64);
+  T *   out = (T *)malloc(nelements * sizeof(T));  // exact size, the kernels may not write beyond nelements
+
+  int len = tsCompressINTImp((const char *)data, nelements, comp, type);
+  ASSERT_GT(len, 0);
+
+  for (int simd = 0; simd <= 1; simd++) {
+    taosResolveDecompress(simd == 1);
+    memset(out, 0, nelements * sizeof(T));
+    ASSERT_EQ(tsDecompressINTImp(comp, nelements, (char *)out, type), (int)(nelements * sizeof(T)));
+    ASSERT_EQ(memcmp(data, out, nelements * sizeof(T)), 0) << "simd:" << simd;
+  }
+
+  free(comp);
+  free(out);
+}
+
+void checkTimestamp(const int64_t *data, int nelements) {
+  char *   comp = (char *)malloc(nelements * sizeof(int64_t) * 2 + 64);
+  int64_t *out = (int64_t *)malloc(nelements * sizeof(int64_t));
+
+  tsCompressTimestampImp((const char *)data, nelements, comp);
+
+  for (int simd = 0; simd <= 1; simd++) {
+    taosResolveDecompress(simd == 1);
+    memset(out, 0, nelements * sizeof(int64_t));
+    ASSERT_EQ(tsDecompressTimestampImp(comp, nelements, (char *)out), (int)(nelements * sizeof(int64_t)));
+    ASSERT_EQ(memcmp(data, out, nelements * sizeof(int64_t)), 0) << "simd:" << simd;
+  }
+
+  free(comp);
+  free(out);
+}
+
+}  // namespace
+
+TEST(compressionTest, integerDecode) {
+  int64_t bigint[kElems];
+  int32_t ints[kElems];
+  int16_t smallints[kElems];
+  int8_t  tinyints[kElems];
+
+  srand(1);
+  int64_t counter = 1000;
+  for (int i = 0; i < kElems; i++) {
+    counter += (i % 100 < 50) ? rand() % 3 : rand() % 100000;
+    bigint[i] = counter;
+    ints[i] = (i % 500 < 250) ? 7 : rand() - RAND_MAX / 2;
+    smallints[i] = (int16_t)(rand() % 2000 - 1000);
+    tinyints[i] = (int8_t)(i % 7);
+  }
+
+  checkInt(bigint, kElems, TSDB_DATA_TYPE_BIGINT);
+  checkInt(ints, kElems, TSDB_DATA_TYPE_INT);
+  checkInt(smallints, kElems, TSDB_DATA_TYPE_SMALLINT);
+  checkInt(tinyints, kElems, TSDB_DATA_TYPE_TINYINT);
+
+  // the last group of a block is shorter than a SIMD register
+  for (int n = 1; n <= 9; n++) {
+    checkInt(bigint, n, TSDB_DATA_TYPE_BIGINT);
+    checkInt(ints, n, TSDB_DATA_TYPE_INT);
+    checkInt(smallints, n, TSDB_DATA_TYPE_SMALLINT);
+    checkInt(tinyints, n, TSDB_DATA_TYPE_TINYINT);
+  }
+}
+
+TEST(compressionTest, timestampDecode) {
+  int64_t ts[kElems];
+
+  // regular interval with a few gaps and jittered runs
+  int64_t t = 1600000000000L;
+  for (int i = 0; i < kElems; i++) {
+    if (i % 1000 == 999) {
+      t += 3600000;
+    } else if (i % 1000 > 800) {
+      t += 1000 + rand() % 7;
+    } else {
+      t += 1000;
+    }
+    ts[i] = t;
+  }
+
+  checkTimestamp(ts, kElems);
+  checkTimestamp(ts, 33);
+  checkTimestamp(ts, 1);
+}
+
+TEST(compressionTest, boolDecode) {
+  char data[kElems];
+  char comp[kElems];
+  char out[kElems];
+
+  for (int i = 0; i < kElems; i++) {
+    int r = rand() % 3;
+    data[i] = (r == 2) ? TSDB_DATA_BOOL_NULL : r;
+  }
+
+  int len = tsCompressBoolImp(data, kElems, comp);
+  ASSERT_EQ(len, (kElems + 3) / 4);
+  ASSERT_EQ(tsDecompressBoolImp(comp, kElems, out), kElems);
+  ASSERT_EQ(memcmp(data, out, kElems), 0);
+}
@@ -332,6 +332,47 @@ void duplicatedKeyTest() {
   tSkipListDestroy(pSkipList);
 }
 
+void appendKeyTest() {
+  SSkipList* pSkipList = tSkipListCreate(10, TSDB_DATA_TYPE_INT, sizeof(int32_t), 0, false, true, getkey);
+
+  // keys greater than the maximum key, which are pushed back without searching, are mixed with keys put in the gaps
+  for (int32_t i = 0; i < 1000; ++i) {
+    int32_t level = 0;
+    int32_t size = 0;
+
+    tSkipListNewNodeInfo(pSkipList, &level, &size);
+    SSkipListNode* d = (SSkipListNode*)calloc(1, size + sizeof(int32_t));
+    d->level = level;
+
+    int32_t* key = (int32_t*)SL_GET_NODE_KEY(pSkipList, d);
+    key[0] = i * 2;
+    assert(tSkipListPut(pSkipList, d) == d);
+
+    if (i > 0) {
+      tSkipListNewNodeInfo(pSkipList, &level, &size);
+      d = (SSkipListNode*)calloc(1, size + sizeof(int32_t));
+      d->level = level;
+      key = (int32_t*)SL_GET_NODE_KEY(pSkipList, d);
+      key[0] = i * 2 - 1;
+      assert(tSkipListPut(pSkipList, d) == d);
+    }
+  }
+
+  assert(tSkipListGetSize(pSkipList) == 1999);
+
+  SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
+  int32_t            expected = 0;
+  while (tSkipListIterNext(iter)) {
+    SSkipListNode* node = tSkipListIterGet(iter);
+    assert(*(int32_t*)SL_GET_NODE_KEY(pSkipList, node) == expected);
+    expected++;
+  }
+  assert(expected == 1999);
+  tSkipListDestroyIter(iter);
+
+  tSkipListDestroy(pSkipList);
+}
+
 }  // namespace
 
 TEST(testCase, skiplist_test) {
@@ -342,6 +383,7 @@ TEST(testCase, skiplist_test) {
   doubleSkipListTest();
   skiplistPerformanceTest();
   duplicatedKeyTest();
+  appendKeyTest();
   randKeyTest();
 
   //  tSKipListQueryCond q;
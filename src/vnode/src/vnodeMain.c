@@ -69,6 +69,11 @@ int32_t vnodeInitResources() {
     return TSDB_CODE_VND_OUT_OF_MEMORY;
   }
 
+  if (tsdbInitBlockCache((int64_t)tsBlockCacheSize * 1024 * 1024) < 0) {
+    vError("failed to init block cache since %s", tstrerror(terrno));
+    return TSDB_CODE_VND_OUT_OF_MEMORY;
+  }
+
   return TSDB_CODE_SUCCESS;
 }
 
@@ -78,6 +83,7 @@ void vnodeCleanupResources() {
     tsDnodeVnodesHash = NULL;
   }
 
+  tsdbCleanupBlockCache();
   syncCleanUp();
 }
 
@@ -462,20 +468,30 @@ static void vnodeBuildVloadMsg(SVnodeObj *pVnode, SDMStatusMsg *pStatus) {
   int64_t totalStorage = 0;
   int64_t compStorage = 0;
   int64_t pointsWritten = 0;
+  int64_t rowsAppended = 0;
+  int64_t rowsInserted = 0;
 
   if (pVnode->status != TAOS_VN_STATUS_READY) return;
   if (pStatus->openVnodes >= TSDB_MAX_VNODES) return;
 
   if (pVnode->tsdb) {
-    tsdbReportStat(pVnode->tsdb, &pointsWritten, &totalStorage, &compStorage);
+    tsdbReportStat(pVnode->tsdb, &pointsWritten, &totalStorage, &compStorage, &rowsAppended, &rowsInserted);
   }
 
+  int64_t walEntries = 0, walBytes = 0, walElapsed = 0;
+  if (pVnode->wal) walGetRestoreStat(pVnode->wal, &walEntries, &walBytes, &walElapsed);
+
   SVnodeLoad *pLoad = &pStatus->load[pStatus->openVnodes++];
   pLoad->vgId = htonl(pVnode->vgId);
   pLoad->cfgVersion = htonl(pVnode->cfgVersion);
   pLoad->totalStorage = htobe64(totalStorage);
   pLoad->compStorage = htobe64(compStorage);
   pLoad->pointsWritten = htobe64(pointsWritten);
+  pLoad->rowsAppended = htobe64(rowsAppended);
+  pLoad->rowsInserted = htobe64(rowsInserted);
+  pLoad->walReplayEntries = htobe64(walEntries);
+  pLoad->walReplayBytes = htobe64(walBytes);
+  pLoad->walReplayTime = htobe64(walElapsed);
   pLoad->status = pVnode->status;
   pLoad->role = pVnode->role;
   pLoad->replica = pVnode->syncCfg.replica;  
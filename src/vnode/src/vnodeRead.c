@@ -26,6 +26,7 @@
 #include "tsdb.h"
 #include "vnode.h"
 #include "vnodeInt.h"
+#include "dnode.h"
 #include "tqueue.h"
 
 static int32_t (*vnodeProcessReadMsgFp[TSDB_MSG_TYPE_MAX])(SVnodeObj *pVnode, SReadMsg *pReadMsg);
@@ -68,6 +69,8 @@ int32_t vnodeProcessRead(void *param, SReadMsg *pReadMsg) {
 }
 
 static void vnodePutItemIntoReadQueue(SVnodeObj *pVnode, void **qhandle) {
+  int32_t workType = qIsShortQuery(*qhandle) ? TSDB_READ_SHORT_WORK : TSDB_READ_LONG_WORK;
+
   SReadMsg *pRead = (SReadMsg *)taosAllocateQitem(sizeof(SReadMsg));
   pRead->rpcMsg.msgType = TSDB_MSG_TYPE_QUERY;
   pRead->pCont = qhandle;
@@ -76,8 +79,9 @@ static void vnodePutItemIntoReadQueue(SVnodeObj *pVnode, void **qhandle) {
 
   atomic_add_fetch_32(&pVnode->refCount, 1);
 
-  vDebug("QInfo:%p add to vread queue for exec query, msg:%p", *qhandle, pRead);
-  taosWriteQitem(pVnode->rqueue, TAOS_QTYPE_QUERY, pRead);
+  vDebug("QInfo:%p add to vread queue for exec query, msg:%p, short:%d", *qhandle, pRead,
+         workType == TSDB_READ_SHORT_WORK);
+  dnodePutItemIntoReadQueue(pVnode->rqueue, pRead, workType);
 }
 
 static int32_t vnodeDumpQueryResult(SRspRet *pRet, void* pVnode, void** handle, bool* freeHandle) {
@@ -27,6 +27,10 @@
 #include "tqueue.h"
 
 #define walPrefix "wal"
+#define WAL_BUFFER_SIZE (1024 * 1024)  // entries are coalesced in memory and written out in one call
+#define WAL_RESTORE_BUF_SIZE (4 * 1024 * 1024)
+#define WAL_FLUSH_RETRIES 3
+#define WAL_FLUSH_RETRY_DELAY 10  // ms
 
 #define wFatal(...) { if (wDebugFlag & DEBUG_FATAL) { taosPrintLog("WAL FATAL ", 255, __VA_ARGS__); }}
 #define wError(...) { if (wDebugFlag & DEBUG_ERROR) { taosPrintLog("WAL ERROR ", 255, __VA_ARGS__); }}
@@ -37,6 +41,8 @@
 
 typedef struct {
   uint64_t version;
+  uint64_t flushedVer;  // version of the last entry written to the file
+  uint64_t durableVer;  // version of the last entry written out and synced as the level requires
   int      fd;
   int      keep;
   int      level;
@@ -48,9 +54,36 @@ typedef struct {
   int      num;  // number of wal files
   char     path[TSDB_FILENAME_LEN];
   char     name[TSDB_FILENAME_LEN+16];
+  char    *buffer;  // entries appended since the last flush
+  int32_t  bufLen;
+  int64_t  restoreBytes;    // bytes replayed by walRestore
+  int64_t  restoreEntries;  // entries replayed by walRestore
+  int64_t  restoreTime;     // ms spent in walRestore
   pthread_mutex_t mutex;
 } SWal;
 
+typedef struct {
+  char   *buf;
+  int32_t size;
+  int32_t len;      // length of the complete and verified entries
+  int32_t entries;
+  int8_t  filled;   // handed over to the replaying thread
+  int8_t  last;
+} SWalRestoreBuf;
+
+// a reader thread reads the WAL file with large sequential reads and verifies the
+// checksums into one buffer while the entries of the other one are replayed
+typedef struct {
+  char           *name;
+  int             fd;
+  int32_t         code;
+  int8_t          truncate;  // the file ends with an incomplete entry
+  int64_t         offset;    // end of the last verified entry
+  SWalRestoreBuf  bufs[2];
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+} SWalReader;
+
 static void    *walTmrCtrl = NULL;
 static int     tsWalNum = 0;
 static pthread_once_t walModuleInit = PTHREAD_ONCE_INIT;
@@ -60,6 +93,7 @@ static int  walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp);
 static int  walRemoveWalFiles(const char *path);
 static void walProcessFsyncTimer(void *param, void *tmrId);
 static void walRelease(SWal *pWal);
+static int  walFlushBuffer(SWal *pWal);
 
 static void walModuleInitFunc() {
   walTmrCtrl = taosTmrInit(1000, 100, 300000, "WAL");
@@ -169,6 +203,10 @@ void walClose(void *handle) {
   if (handle == NULL) return;
   
   SWal *pWal = handle;  
+  pthread_mutex_lock(&pWal->mutex);
+  walFlushBuffer(pWal);
+  pthread_mutex_unlock(&pWal->mutex);
+
   taosClose(pWal->fd);
   if (pWal->timer) taosTmrStopA(&pWal->timer);
 
@@ -198,6 +236,7 @@ int walRenew(void *handle) {
   pthread_mutex_lock(&pWal->mutex);
 
   if (pWal->fd >=0) {
+    walFlushBuffer(pWal);
     close(pWal->fd);
     pWal->id++;
     wDebug("wal:%s, it is closed", pWal->name);
@@ -247,26 +286,86 @@ int walWrite(void *handle, SWalHead *pHead) {
   taosCalcChecksumAppend(0, (uint8_t *)pHead, sizeof(SWalHead));
   int contLen = pHead->len + sizeof(SWalHead);
 
-  if(taosTWrite(pWal->fd, pHead, contLen) != contLen) {
-    wError("wal:%s, failed to write(%s)", pWal->name, strerror(errno));
-    terrno = TAOS_SYSTEM_ERROR(errno);
-  } else {
+  pthread_mutex_lock(&pWal->mutex);
+
+  // entries are only copied here, they are written out by walFsync with the rest of the batch
+  if (pWal->buffer == NULL && contLen <= WAL_BUFFER_SIZE) {
+    pWal->buffer = malloc(WAL_BUFFER_SIZE);
+    pWal->bufLen = 0;
+  }
+
+  // if the buffer can not be written out, the entry is rejected and the buffer is kept for the next flush
+  if (pWal->buffer && pWal->bufLen + contLen > WAL_BUFFER_SIZE && walFlushBuffer(pWal) != 0) {
+    pthread_mutex_unlock(&pWal->mutex);
+    return terrno;
+  }
+
+  if (terrno == 0 && pWal->buffer && contLen <= WAL_BUFFER_SIZE) {
+    memcpy(pWal->buffer + pWal->bufLen, pHead, contLen);
+    pWal->bufLen += contLen;
     pWal->version = pHead->version;
+  } else if (terrno == 0) {
+    if (taosTWrite(pWal->fd, pHead, contLen) != contLen) {
+      wError("wal:%s, failed to write(%s)", pWal->name, strerror(errno));
+      terrno = TAOS_SYSTEM_ERROR(errno);
+    } else {
+      pWal->version = pHead->version;
+      pWal->flushedVer = pHead->version;
+    }
   }
 
+  pthread_mutex_unlock(&pWal->mutex);
+
   return terrno;
 }
 
-void walFsync(void *handle) {
+int walFsync(void *handle) {
 
   SWal *pWal = handle;
-  if (pWal == NULL || pWal->level != TAOS_WAL_FSYNC || pWal->fd < 0) return;
+  if (pWal == NULL || pWal->fd < 0) return 0;
+
+  pthread_mutex_lock(&pWal->mutex);
+
+  int code = 0;
+  for (int i = 0; i < WAL_FLUSH_RETRIES; ++i) {
+    if (walFlushBuffer(pWal) == 0) {
+      code = 0;
+      break;
+    }
 
-  if (pWal->fsyncPeriod == 0) {
+    code = terrno;
+    taosMsleep(WAL_FLUSH_RETRY_DELAY);
+  }
+
+  // the entries which can not be written out are dropped, so none of them is written by a later
+  // flush after its writer has been told it failed
+  if (code != 0) {
+    wError("wal:%s, entries of version %" PRIu64 " to %" PRIu64 " are dropped since %s", pWal->name,
+           pWal->flushedVer + 1, pWal->version, tstrerror(code));
+    pWal->bufLen = 0;
+    pWal->version = pWal->flushedVer;
+  }
+
+  uint64_t version = pWal->version;
+  pthread_mutex_unlock(&pWal->mutex);
+
+  // one fsync covers all the entries written by the batch
+  if (pWal->level == TAOS_WAL_FSYNC && pWal->fsyncPeriod == 0) {
     if (fsync(pWal->fd) < 0) {
       wError("wal:%s, fsync failed(%s)", pWal->name, strerror(errno));
+      return TAOS_SYSTEM_ERROR(errno);
     }
   }
+
+  pWal->durableVer = version;
+  return code;
+}
+
+uint64_t walGetDurableVersion(void *handle) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return 0;
+
+  return pWal->durableVer;
 }
 
 int walRestore(void *handle, void *pVnode, int (*writeFp)(void *, void *, int)) {
@@ -312,11 +411,17 @@ int walRestore(void *handle, void *pVnode, int (*writeFp)(void *, void *, int))
   } else {
     wDebug("wal:%s, %d files will be restored", opath, count);
 
+    int64_t st = taosGetTimestampMs();
     for (index = minId; index<=maxId; ++index) {
       snprintf(pWal->name, sizeof(pWal->name), "%s/%s%d", opath, walPrefix, index);
       terrno = walRestoreWalFile(pWal, pVnode, writeFp);
       if (terrno < 0) break;
     }
+
+    pWal->restoreTime = taosGetTimestampMs() - st;
+    wInfo("wal:%s, %" PRId64 " entries %" PRId64 " bytes are restored in %" PRId64 "ms, throughput:%.2fMB/s", opath,
+          pWal->restoreEntries, pWal->restoreBytes, pWal->restoreTime,
+          pWal->restoreBytes / 1048576.0 / (pWal->restoreTime > 0 ? pWal->restoreTime / 1000.0 : 0.001));
   }
 
   if (terrno == 0) {
@@ -344,6 +449,15 @@ int walRestore(void *handle, void *pVnode, int (*writeFp)(void *, void *, int))
   return terrno;
 }
 
+void walGetRestoreStat(void *handle, int64_t *entries, int64_t *bytes, int64_t *elapsed) {
+  SWal *pWal = handle;
+  if (pWal == NULL) return;
+
+  *entries = pWal->restoreEntries;
+  *bytes = pWal->restoreBytes;
+  *elapsed = pWal->restoreTime;
+}
+
 int walGetWalFile(void *handle, char *name, uint32_t *index) {
   SWal   *pWal = handle;
   int     code = 1;
@@ -372,6 +486,7 @@ int walGetWalFile(void *handle, char *name, uint32_t *index) {
 static void walRelease(SWal *pWal) {
 
   pthread_mutex_destroy(&pWal->mutex);
+  taosTFree(pWal->buffer);
   pWal->signature = NULL;
   free(pWal);
 
@@ -383,88 +498,184 @@ static void walRelease(SWal *pWal) {
   }
 }
 
+static void *walReadAhead(void *param) {
+  SWalReader *pReader = param;
+  char       *carry = NULL;
+  int32_t     carryLen = 0;
+  int         idx = 0;
+  bool        eof = false;
+
+  while (!eof) {
+    SWalRestoreBuf *pBuf = pReader->bufs + idx;
+
+    pthread_mutex_lock(&pReader->mutex);
+    while (pBuf->filled) pthread_cond_wait(&pReader->cond, &pReader->mutex);
+    pthread_mutex_unlock(&pReader->mutex);
+
+    // the incomplete entry at the end of the previous buffer starts this one, the previous buffer may have grown
+    // beyond this one for a large entry
+    if (carryLen > pBuf->size) {
+      char *buf = realloc(pBuf->buf, carryLen + WAL_RESTORE_BUF_SIZE);
+      if (buf == NULL) {
+        pReader->code = TAOS_SYSTEM_ERROR(errno);
+        carryLen = 0;
+        eof = true;
+      } else {
+        pBuf->buf = buf;
+        pBuf->size = carryLen + WAL_RESTORE_BUF_SIZE;
+      }
+    }
+
+    if (carryLen > 0) memcpy(pBuf->buf, carry, carryLen);
+    int32_t avail = carryLen;
+    int32_t pos = 0;
+    int32_t entries = 0;
+
+    while (!eof) {
+      int32_t ret = taosTRead(pReader->fd, pBuf->buf + avail, pBuf->size - avail);
+      if (ret < 0) {
+        wError("wal:%s, failed to read(%s)", pReader->name, strerror(errno));
+        pReader->code = TAOS_SYSTEM_ERROR(errno);
+        eof = true;
+        break;
+      }
+
+      avail += ret;
+      if (avail < pBuf->size) eof = true;
+
+      // verify the complete entries while the previous buffer is being replayed
+      int32_t need = 0;
+      while (avail - pos >= (int32_t)sizeof(SWalHead)) {
+        SWalHead *pHead = (SWalHead *)(pBuf->buf + pos);
+        if (!taosCheckChecksumWhole((uint8_t *)pHead, sizeof(SWalHead))) {
+          wWarn("wal:%s, cksum is messed up, skip the rest of file", pReader->name);
+          pReader->code = TSDB_CODE_WAL_FILE_CORRUPTED;
+          ASSERT(false);
+          eof = true;
+          break;
+        }
+
+        need = sizeof(SWalHead) + pHead->len;
+        if (avail - pos < need) break;
+
+        pos += need;
+        entries++;
+        need = 0;
+      }
+
+      if (pos > 0 || eof) break;
+
+      // one entry is larger than the whole buffer
+      char *buf = realloc(pBuf->buf, need);
+      if (buf == NULL) {
+        pReader->code = TAOS_SYSTEM_ERROR(errno);
+        eof = true;
+        break;
+      }
+      pBuf->buf = buf;
+      pBuf->size = need;
+    }
+
+    carry = pBuf->buf + pos;
+    carryLen = avail - pos;
+    if (eof && carryLen > 0 && pReader->code == 0) {
+      wError("wal:%s, %d bytes of incomplete entry at the end, skip the rest of file", pReader->name, carryLen);
+      pReader->truncate = 1;
+    }
+
+    pReader->offset += pos;
+    pBuf->len = pos;
+    pBuf->entries = entries;
+    pBuf->last = eof;
+
+    pthread_mutex_lock(&pReader->mutex);
+    pBuf->filled = 1;
+    pthread_cond_broadcast(&pReader->cond);
+    pthread_mutex_unlock(&pReader->mutex);
+
+    idx ^= 1;
+  }
+
+  return NULL;
+}
+
 static int walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp) {
-  char *name = pWal->name;
-  int size = 1024 * 1024; // default 1M buffer size
+  char      *name = pWal->name;
+  SWalReader reader = {0};
+  pthread_t  thread;
 
   terrno = 0;
-  char *buffer = malloc(size);
-  if (buffer == NULL) {
-    terrno = TAOS_SYSTEM_ERROR(errno);   
-    return terrno;
-  }
+  reader.name = name;
 
-  SWalHead *pHead = (SWalHead *)buffer;
+  for (int i = 0; i < 2; ++i) {
+    reader.bufs[i].size = WAL_RESTORE_BUF_SIZE;
+    reader.bufs[i].buf = malloc(WAL_RESTORE_BUF_SIZE);
+    if (reader.bufs[i].buf == NULL) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+  }
 
-  int fd = open(name, O_RDWR);
-  if (fd < 0) {
+  reader.fd = open(name, O_RDWR);
+  if (reader.fd < 0) {
     wError("wal:%s, failed to open for restore(%s)", name, strerror(errno));
     terrno = TAOS_SYSTEM_ERROR(errno);
-    free(buffer);
-    return terrno;
+    goto _err;
   }
 
   wDebug("wal:%s, start to restore", name);
 
-  size_t offset = 0;
-  while (1) {
-    int ret = taosTRead(fd, pHead, sizeof(SWalHead));
-    if (ret == 0) break;
+  pthread_mutex_init(&reader.mutex, NULL);
+  pthread_cond_init(&reader.cond, NULL);
 
-    if (ret < 0) {
-      wError("wal:%s, failed to read wal head part since %s", name, strerror(errno));
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      break;
-    }
+  if (pthread_create(&thread, NULL, walReadAhead, &reader) != 0) {
+    wError("wal:%s, failed to create read ahead thread(%s)", name, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _clean;
+  }
 
-    if (ret < sizeof(SWalHead)) {
-      wError("wal:%s, failed to read head, ret:%d, skip the rest of file", name, ret);
-      taosFtruncate(fd, offset);
-      fsync(fd);
-      break;
-    }
+  for (int idx = 0;; idx ^= 1) {
+    SWalRestoreBuf *pBuf = reader.bufs + idx;
 
-    if (!taosCheckChecksumWhole((uint8_t *)pHead, sizeof(SWalHead))) {
-      wWarn("wal:%s, cksum is messed up, skip the rest of file", name);
-      terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
-      ASSERT(false);
-      break;
-    }
+    pthread_mutex_lock(&reader.mutex);
+    while (!pBuf->filled) pthread_cond_wait(&reader.cond, &reader.mutex);
+    pthread_mutex_unlock(&reader.mutex);
 
-    if (pHead->len > size - sizeof(SWalHead)) {
-      size = sizeof(SWalHead) + pHead->len;
-      buffer = realloc(buffer, size);
-      if (buffer == NULL) {
-        terrno = TAOS_SYSTEM_ERROR(errno);
-        break;
-      }
+    for (int32_t pos = 0; pos < pBuf->len;) {
+      SWalHead *pHead = (SWalHead *)(pBuf->buf + pos);
+      pos += sizeof(SWalHead) + pHead->len;
 
-      pHead = (SWalHead *)buffer;
+      if (pWal->keep) pWal->version = pWal->flushedVer = pWal->durableVer = pHead->version;
+      (*writeFp)(pVnode, pHead, TAOS_QTYPE_WAL);
     }
 
-    ret = taosTRead(fd, pHead->cont, pHead->len);
-    if (ret < 0) {
-      wError("wal:%s failed to read wal body part since %s", name, strerror(errno));
-      terrno = TAOS_SYSTEM_ERROR(errno);
-      break;
-    }
+    pWal->restoreBytes += pBuf->len;
+    pWal->restoreEntries += pBuf->entries;
 
-    if (ret < pHead->len) {
-      wError("wal:%s, failed to read body, len:%d ret:%d, skip the rest of file", name, pHead->len, ret);
-      taosFtruncate(fd, offset);
-      fsync(fd);
-      break;
-    }
+    bool last = pBuf->last;
+    pthread_mutex_lock(&reader.mutex);
+    pBuf->filled = 0;
+    pthread_cond_broadcast(&reader.cond);
+    pthread_mutex_unlock(&reader.mutex);
 
-    offset = offset + sizeof(SWalHead) + pHead->len;
+    if (last) break;
+  }
+
+  pthread_join(thread, NULL);
+  terrno = reader.code;
 
-    if (pWal->keep) pWal->version = pHead->version;
-    (*writeFp)(pVnode, pHead, TAOS_QTYPE_WAL);
+  if (reader.truncate) {
+    taosFtruncate(reader.fd, reader.offset);
+    fsync(reader.fd);
   }
 
-  close(fd);
-  free(buffer);
+_clean:
+  pthread_cond_destroy(&reader.cond);
+  pthread_mutex_destroy(&reader.mutex);
+  close(reader.fd);
 
+_err:
+  for (int i = 0; i < 2; ++i) free(reader.bufs[i].buf);
   return terrno;
 }
 
@@ -543,6 +754,26 @@ static int walRemoveWalFiles(const char *path) {
   return terrno;
 }
 
+// must be called with pWal->mutex locked. On failure the file is cut back to where the
+// write started and the buffer is kept, so the entries can be written again by the next flush
+static int walFlushBuffer(SWal *pWal) {
+  if (pWal->bufLen == 0) return 0;
+
+  off_t offset = lseek(pWal->fd, 0, SEEK_CUR);
+  if (taosTWrite(pWal->fd, pWal->buffer, pWal->bufLen) != pWal->bufLen) {
+    wError("wal:%s, failed to write %d bytes(%s)", pWal->name, pWal->bufLen, strerror(errno));
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    if (offset >= 0 && (ftruncate(pWal->fd, offset) != 0 || lseek(pWal->fd, offset, SEEK_SET) != offset)) {
+      wError("wal:%s, failed to truncate to %" PRId64 "(%s)", pWal->name, (int64_t)offset, strerror(errno));
+    }
+    return -1;
+  }
+
+  pWal->bufLen = 0;
+  pWal->flushedVer = pWal->version;
+  return 0;
+}
+
 static void walProcessFsyncTimer(void *param, void *tmrId) {
   SWal *pWal = param;
 